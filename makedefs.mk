@@ -89,6 +89,16 @@ LDFLAGS  += -lmbedx509
 endif
 endif
 
+# Allocation statistics of the CMemory implementations, dumped by CLI "MEMORY DUMP".
+ifeq ($(MEMORY_STATS), yes)
+CFLAGS   += -D__MEMORY_STATS__
+endif
+
+# Save the TLS session cache to the work path on exit and load it on start.
+ifeq ($(TLS_SESSION_PERSIST), yes)
+CFLAGS   += -D__TLS_SESSION_PERSIST__
+endif
+
 LDFLAGS  += -lreadline
 LDFLAGS  += -ldb
 
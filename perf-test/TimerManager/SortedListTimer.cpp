@@ -0,0 +1,111 @@
+/*
+ * See the file LICENSE for redistribution information.
+ *
+ * Copyright (c) 2015-2018, Yuan Qin <yuanqin2000 at outlook dot com>
+ * All rights reserved.
+ *
+ */
+
+#include "SortedListTimer.h"
+#include <time.h>
+
+CSortedListTimer::CSortedListTimer() :
+    m_TimersData(64, sizeof(TimerItem)),
+    m_Head(NIL)
+{
+}
+
+tTimerID CSortedListTimer::AddTimer(
+    ITimerContext* pContext, unsigned int millisec, bool bRepeat)
+{
+    CTable::tIndex index = 0;
+    TimerItem* pNode = reinterpret_cast<TimerItem*>(m_TimersData.Allocate(&index));
+    if (pNode == NULL) {
+        return INVALID_TIMER_ID;
+    }
+    pNode->Timeout = GetCurrentMillisec() + millisec;
+    pNode->Interval = bRepeat ? millisec : 0;
+    pNode->pHandle = pContext;
+    InsertTimer(index, pNode);
+    return static_cast<tTimerID>(index);
+}
+
+void CSortedListTimer::DeleteTimer(tTimerID timerID)
+{
+    uint32_t index = static_cast<uint32_t>(timerID);
+    TimerItem* pNode = ItemAt(index);
+    if (pNode) {
+        RemoveTimer(index, pNode);
+        pNode->pHandle->OnTimerDeleted(timerID);
+        m_TimersData.Release(index);
+    }
+}
+
+int CSortedListTimer::RefreshTimer()
+{
+    uint64_t millisec = GetCurrentMillisec();
+    while (m_Head != NIL) {
+        uint32_t index = m_Head;
+        TimerItem* pCur = ItemAt(index);
+        if (millisec < pCur->Timeout) {
+            break;
+        }
+        RemoveTimer(index, pCur);
+        pCur->pHandle->OnTimeout(static_cast<tTimerID>(index));
+        millisec = GetCurrentMillisec();
+        pCur = ItemAt(index);
+        if (pCur->Interval == 0) {
+            m_TimersData.Release(index);
+        } else {
+            pCur->Timeout = millisec + pCur->Interval;
+            InsertTimer(index, pCur);
+        }
+    }
+    if (m_Head == NIL) {
+        return -1;
+    }
+    return static_cast<int>(ItemAt(m_Head)->Timeout - millisec);
+}
+
+void CSortedListTimer::InsertTimer(uint32_t index, TimerItem* pTimer)
+{
+    uint32_t prev = NIL;
+    uint32_t cur = m_Head;
+    while (cur != NIL) {
+        TimerItem* pCur = ItemAt(cur);
+        if (pTimer->Timeout < pCur->Timeout) {
+            break;
+        }
+        prev = cur;
+        cur = pCur->Next;
+    }
+    pTimer->Prev = prev;
+    pTimer->Next = cur;
+    if (prev != NIL) {
+        ItemAt(prev)->Next = index;
+    } else {
+        m_Head = index;
+    }
+    if (cur != NIL) {
+        ItemAt(cur)->Prev = index;
+    }
+}
+
+void CSortedListTimer::RemoveTimer(uint32_t index, TimerItem* pTimer)
+{
+    if (pTimer->Prev != NIL) {
+        ItemAt(pTimer->Prev)->Next = pTimer->Next;
+    } else {
+        m_Head = pTimer->Next;
+    }
+    if (pTimer->Next != NIL) {
+        ItemAt(pTimer->Next)->Prev = pTimer->Prev;
+    }
+}
+
+uint64_t CSortedListTimer::GetCurrentMillisec()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<uint64_t>(now.tv_sec) * 1000 + now.tv_nsec / 1000000;
+}
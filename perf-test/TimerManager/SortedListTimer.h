@@ -0,0 +1,55 @@
+/*
+ * See the file LICENSE for redistribution information.
+ *
+ * Copyright (c) 2015-2018, Yuan Qin <yuanqin2000 at outlook dot com>
+ * All rights reserved.
+ *
+ */
+
+#ifndef __SORTED_LIST_TIMER_H__
+#define __SORTED_LIST_TIMER_H__
+
+#include "Thread/TimerManager.h"
+
+/**
+ * @brief The former CTimerManager, timers kept in a list sorted by the
+ *        timeout, as the baseline of the timing wheel.
+ *        The links are indices since the table may be reallocated.
+ */
+class CSortedListTimer
+{
+public:
+    CSortedListTimer();
+    ~CSortedListTimer() {}
+
+    tTimerID AddTimer(ITimerContext* pContext, unsigned int millisec, bool bRepeat);
+    void DeleteTimer(tTimerID timerID);
+    int RefreshTimer();
+
+private:
+    struct TimerItem {
+        uint64_t Timeout;  // Milliseconds, happen time.
+        unsigned int Interval;
+        ITimerContext* pHandle;
+        uint32_t Next;
+        uint32_t Prev;
+    };
+
+    TimerItem* ItemAt(uint32_t index)
+    {
+        return reinterpret_cast<TimerItem*>(m_TimersData.At(index));
+    }
+
+    void InsertTimer(uint32_t index, TimerItem* pTimer);
+    void RemoveTimer(uint32_t index, TimerItem* pTimer);
+
+    static uint64_t GetCurrentMillisec();
+
+    static const uint32_t NIL = static_cast<uint32_t>(-1);
+
+private:
+    CTable m_TimersData;
+    uint32_t m_Head;
+};
+
+#endif
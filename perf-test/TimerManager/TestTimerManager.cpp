@@ -0,0 +1,115 @@
+/*
+ * See the file LICENSE for redistribution information.
+ *
+ * Copyright (c) 2015-2018, Yuan Qin <yuanqin2000 at outlook dot com>
+ * All rights reserved.
+ *
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <time.h>
+#include <unistd.h>
+
+#include "Thread/TimerManager.h"
+#include "SortedListTimer.h"
+
+/*
+ * Compare the timing wheel with the sorted list:
+ *     Add:    add <count> timers expired in 1 second randomly.
+ *     Delete: delete half of them randomly.
+ *     Fire:   refresh until the rest are fired, CPU time only.
+ */
+
+// The sorted list is O(n) per add, too slow to run with more timers.
+static const int MAX_LIST_COUNT = 100000;
+
+class CCountContext : public ITimerContext
+{
+public:
+    CCountContext() : m_Fired(0) {}
+
+    void OnTimeout(tTimerID timerID) { ++m_Fired; }
+
+    int m_Fired;
+};
+
+static double CpuMillisec()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now);
+    return now.tv_sec * 1000.0 + now.tv_nsec / 1000000.0;
+}
+
+template <typename T>
+static void Run(const char* pName, int count, const unsigned int* pTimeouts, const int* pOrder)
+{
+    T* pManager = new T();
+    CCountContext context;
+    tTimerID* pIDs = new tTimerID[count];
+
+    double start = CpuMillisec();
+    for (int i = 0; i < count; ++i) {
+        pIDs[i] = pManager->AddTimer(&context, pTimeouts[i], false);
+    }
+    double added = CpuMillisec();
+    for (int i = 0; i < count / 2; ++i) {
+        pManager->DeleteTimer(pIDs[pOrder[i]]);
+    }
+    double deleted = CpuMillisec();
+    while (context.m_Fired < count - count / 2) {
+        int timeout = pManager->RefreshTimer();
+        if (timeout > 0) {
+            usleep(timeout * 1000);
+        }
+    }
+    double fired = CpuMillisec();
+
+    std::printf("%-12s %8d timers: add %8.1f ns/op, delete %8.1f ns/op, fire %8.1f ns/op\n",
+                pName, count,
+                (added - start) * 1000000.0 / count,
+                (deleted - added) * 1000000.0 / (count / 2),
+                (fired - deleted) * 1000000.0 / (count - count / 2));
+
+    delete [] pIDs;
+    delete pManager;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc != 2) {
+        std::printf("Usage: %s <count>\n", argv[0]);
+        std::exit(1);
+    }
+
+    int count = atoi(argv[1]);
+    if (count < 2) {
+        std::printf("The count shall be 2 at least.\n");
+        std::exit(1);
+    }
+
+    unsigned int* pTimeouts = new unsigned int[count];
+    int* pOrder = new int[count];
+    srand(1);
+    for (int i = 0; i < count; ++i) {
+        pTimeouts[i] = 1 + rand() % 1000;
+        pOrder[i] = i;
+    }
+    for (int i = count - 1; i > 0; --i) {
+        int j = rand() % (i + 1);
+        int tmp = pOrder[i];
+        pOrder[i] = pOrder[j];
+        pOrder[j] = tmp;
+    }
+
+    Run<CTimerManager>("TimingWheel", count, pTimeouts, pOrder);
+    if (count <= MAX_LIST_COUNT) {
+        Run<CSortedListTimer>("SortedList", count, pTimeouts, pOrder);
+    } else {
+        std::printf("%-12s %8d timers: skipped\n", "SortedList", count);
+    }
+
+    delete [] pTimeouts;
+    delete [] pOrder;
+    return 0;
+}
@@ -0,0 +1,125 @@
+/*
+ * See the file LICENSE for redistribution information.
+ *
+ * Copyright (c) 2015-2018, Yuan Qin <yuanqin2000 at outlook dot com>
+ * All rights reserved.
+ *
+ */
+
+#include "MemoryCmdHelper.h"
+#include <cstring>
+#include <cstdlib>
+#include "Common/Typedefs.h"
+#include "ClientIf/CliMsg.h"
+#include "Memory/MemoryRegistry.h"
+#include "Tracker/Trace.h"
+
+using std::strlen;
+using std::memcpy;
+using std::malloc;
+using std::free;
+
+// Initialize the buffer before s_pRoot which is created from it.
+uint8_t CMemoryCommandHelper::s_TreeNodeBuffer[128] = {0};
+uint8_t* CMemoryCommandHelper::s_pBufferEnd =
+    CMemoryCommandHelper::s_TreeNodeBuffer + sizeof(s_TreeNodeBuffer);
+uint8_t* CMemoryCommandHelper::s_pFreeBuffer = CMemoryCommandHelper::s_TreeNodeBuffer;
+
+const char* CMemoryCommandHelper::s_pName = "MEMORY";
+CCommandTree::tInfoNode* CMemoryCommandHelper::s_pRoot = CreateRoot();
+
+CMemoryCommandHelper::CMemoryCommandHelper()
+{
+}
+
+CMemoryCommandHelper::~CMemoryCommandHelper()
+{
+}
+
+const char* CMemoryCommandHelper::GetCommandName() const
+{
+    return s_pName;
+}
+
+CCommandTree::tInfoNode* CMemoryCommandHelper::GetHint()
+{
+    return s_pRoot;
+}
+
+void CMemoryCommandHelper::ExecuteCommand(
+    uint16_t sessionID,
+    CVector& cmdParam,
+    IResultHandler& resultHandler)
+{
+    TRACK_FUNCTION_LIFE_CYCLE;
+
+    NSCliMsg::CommandDataBlock* pCommand = NULL;
+    if (cmdParam.Count() == 1) {
+        pCommand = reinterpret_cast<NSCliMsg::CommandDataBlock*>(cmdParam.At(0));
+    }
+    if (pCommand == NULL ||
+        pCommand->Type != NSCliMsg::BT_COMMAND ||
+        pCommand->CmdID != CID_DUMP) {
+        resultHandler.OnResult(sessionID, NSCliMsg::MSC_COMMAND_NOT_FOUND);
+        return;
+    }
+
+    char* pBuffer = reinterpret_cast<char*>(malloc(DUMP_BUFFER_SIZE));
+    if (pBuffer == NULL) {
+        resultHandler.OnResult(sessionID, NSCliMsg::MSC_SERVER_ERROR);
+        return;
+    }
+    size_t len = CMemoryRegistry::Instance()->Dump(pBuffer, DUMP_BUFFER_SIZE);
+    if (len > 0) {
+        resultHandler.OnResult(
+            sessionID, NSCliMsg::MSC_OK, reinterpret_cast<uint8_t*>(pBuffer), len);
+    } else {
+        resultHandler.OnResult(sessionID, NSCliMsg::MSC_OK);
+    }
+    free(pBuffer);
+}
+
+CCommandTree::tInfoNode* CMemoryCommandHelper::CreateRoot()
+{
+    static CCommandTree::InfoElement s_Elem(CCommandTree::TYPE_COMMAND, 0, NULL);
+    static CCommandTree::tInfoNode s_Root(&s_Elem);
+
+    size_t nameLen = strlen(s_pName) + 1;
+    size_t requiredSize = sizeof(CCommandTree::CommandItem) + nameLen;
+    ASSERT(s_pFreeBuffer + requiredSize <= s_pBufferEnd);
+    CCommandTree::CommandItem* pInfo =
+        reinterpret_cast<CCommandTree::CommandItem*>(s_pFreeBuffer);
+    pInfo->CmdID = 0;
+    memcpy(pInfo->Name, s_pName, nameLen);
+    s_Elem.pItemData = pInfo;
+    s_pFreeBuffer += requiredSize;
+
+    CCommandTree::tInfoNode* pNode = CreateDumpHint();
+    if (pNode == NULL) {
+        return NULL;
+    }
+    s_Root.AddChild(pNode);
+    s_Elem.SubCount = 1;
+    return &s_Root;
+}
+
+CCommandTree::tInfoNode* CMemoryCommandHelper::CreateDumpHint()
+{
+    static CCommandTree::InfoElement s_Elem(CCommandTree::TYPE_COMMAND, 0, NULL);
+    static CCommandTree::tInfoNode s_Node(&s_Elem);
+
+    const char* s_CmdName = "DUMP";
+    size_t nameLen = strlen(s_CmdName) + 1;
+    size_t requiredSize = sizeof(CCommandTree::CommandItem) + nameLen;
+    ASSERT(s_pFreeBuffer + requiredSize <= s_pBufferEnd);
+    CCommandTree::CommandItem* pInfo =
+        reinterpret_cast<CCommandTree::CommandItem*>(s_pFreeBuffer);
+    pInfo->CmdID = CID_DUMP;
+    memcpy(pInfo->Name, s_CmdName, nameLen);
+    s_Elem.pItemData = pInfo;
+    s_pFreeBuffer += requiredSize;
+    return &s_Node;
+}
+
+
+static const CCliCmdHelperRegister g_MemoryCmdHelperReg(CMemoryCommandHelper::Instance());
@@ -0,0 +1,55 @@
+/*
+ * See the file LICENSE for redistribution information.
+ *
+ * Copyright (c) 2015-2018, Yuan Qin <yuanqin2000 at outlook dot com>
+ * All rights reserved.
+ *
+ */
+
+#ifndef __COREAPP_MEMORY_COMMAND_HELPER_H__
+#define __COREAPP_MEMORY_COMMAND_HELPER_H__
+
+#include "Common/Singleton.h"
+#include "ServerIf/CliCmdHelper.h"
+
+/**
+ * @brief CLI command to dump the statistics of the registered allocators.
+ *        MEMORY DUMP
+ */
+class CMemoryCommandHelper :
+    public ICliCommandHelper,
+    public CSingleton<CMemoryCommandHelper>
+{
+public:
+    ~CMemoryCommandHelper();
+
+    // From ICliCommandHelper
+    const char* GetCommandName() const;
+    CCommandTree::tInfoNode* GetHint();
+    void ExecuteCommand(
+        uint16_t sessionID, CVector& cmdParam, IResultHandler& resultHandler);
+
+private:
+    CMemoryCommandHelper();
+
+    enum CommandID {
+       CID_DUMP = 0,
+       CID_COUNT
+    };
+
+    static CCommandTree::tInfoNode* CreateRoot();
+    static CCommandTree::tInfoNode* CreateDumpHint();
+
+private:
+    static CCommandTree::tInfoNode* s_pRoot;
+    static const char* s_pName;
+    static uint8_t s_TreeNodeBuffer[128];
+    static uint8_t* s_pBufferEnd;
+    static uint8_t* s_pFreeBuffer;
+
+    static const size_t DUMP_BUFFER_SIZE = 16 * 1024;
+
+    friend class CSingleton<CMemoryCommandHelper>;
+};
+
+#endif
@@ -13,6 +13,7 @@
 #include "Common/Typedefs.h"
 
 #define __OS_WORD_SIZE__ 64
+#define __OS_CACHE_LINE_SIZE__ 64
 
 
 #define __OS_BIG_ENDIAN__ 0
@@ -69,4 +70,46 @@ static inline int64_t AtomicDec64(volatile int64_t *pSubValue)
     return __sync_sub_and_fetch(pSubValue, 1);
 }
 
+static inline bool AtomicCAS(volatile int32_t *pValue, int32_t oldValue, int32_t newValue)
+{
+    return __sync_bool_compare_and_swap(pValue, oldValue, newValue);
+}
+
+static inline bool AtomicCAS64(volatile int64_t *pValue, int64_t oldValue, int64_t newValue)
+{
+    return __sync_bool_compare_and_swap(pValue, oldValue, newValue);
+}
+
+static inline bool AtomicCASPtr(void* volatile *pValue, void* oldValue, void* newValue)
+{
+    return __sync_bool_compare_and_swap(pValue, oldValue, newValue);
+}
+
+/**
+ * @brief Store the new value and return the old one, acquire semantics.
+ */
+static inline void* AtomicExchangePtr(void* volatile *pValue, void* newValue)
+{
+    return __sync_lock_test_and_set(pValue, newValue);
+}
+
+/**
+ * @brief Load/Store with acquire/release semantics, for the single writer
+ *        publishing the data to the reader(s) without a full barrier.
+ */
+static inline size_t AtomicLoadAcquire(const volatile size_t *pValue)
+{
+    return __atomic_load_n(pValue, __ATOMIC_ACQUIRE);
+}
+
+static inline void AtomicStoreRelease(volatile size_t *pValue, size_t value)
+{
+    __atomic_store_n(pValue, value, __ATOMIC_RELEASE);
+}
+
+static inline bool AtomicCASSize(volatile size_t *pValue, size_t oldValue, size_t newValue)
+{
+    return __sync_bool_compare_and_swap(pValue, oldValue, newValue);
+}
+
 #endif
\ No newline at end of file
@@ -0,0 +1,298 @@
+/*
+ * See the file LICENSE for redistribution information.
+ *
+ * Copyright (c) 2015-2018, Yuan Qin <yuanqin2000 at outlook dot com>
+ * All rights reserved.
+ *
+ */
+
+#include "CharScanner.h"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define __SCAN_X86__
+#include <immintrin.h>
+#endif
+
+using std::memchr;
+
+namespace NSCharScanner
+{
+
+const uint8_t g_TokenCharTable[256] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   // 0x00
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   // 0x10
+    0, 1, 0, 1, 1, 1, 1, 1, 0, 0, 1, 1, 0, 1, 1, 0,   // 0x20
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0,   // 0x30
+    0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,   // 0x40
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 1, 1,   // 0x50
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,   // 0x60
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 1, 0, 1, 0,   // 0x70
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   // 0x80
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   // 0x90
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   // 0xA0
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   // 0xB0
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   // 0xC0
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   // 0xD0
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   // 0xE0
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   // 0xF0
+};
+
+typedef const char* (*tScanFunc)(const char*, const char*);
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Scalar Implemenation
+//
+///////////////////////////////////////////////////////////////////////////////
+static const char* FindCRLFScalar(const char* pBegin, const char* pEnd)
+{
+    const char* pCur = pBegin;
+    while (pCur + 1 < pEnd) {
+        pCur = reinterpret_cast<const char*>(memchr(pCur, '\r', pEnd - pCur - 1));
+        if (pCur == NULL) {
+            break;
+        }
+        if (pCur[1] == '\n') {
+            return pCur;
+        }
+        ++pCur;
+    }
+    return NULL;
+}
+
+static const char* FindNonTokenCharScalar(const char* pBegin, const char* pEnd)
+{
+    const char* pCur = pBegin;
+    while (pCur < pEnd && IsTokenChar(*pCur)) {
+        ++pCur;
+    }
+    return pCur;
+}
+
+#ifdef __SCAN_X86__
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// SSE2 Implemenation
+//
+///////////////////////////////////////////////////////////////////////////////
+__attribute__((target("sse2")))
+static inline __m128i InRangeSSE2(__m128i v, char low, char high)
+{
+    return _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(low - 1)),
+                         _mm_cmplt_epi8(v, _mm_set1_epi8(high + 1)));
+}
+
+/**
+ * The bytes which are not tchar: CTL, SP, DEL, the non-ASCII (negative in
+ * the signed comparison) and the delimiters "(),/:;<=>?@[\]{}
+ */
+__attribute__((target("sse2")))
+static inline int NonTokenMaskSSE2(__m128i v)
+{
+    __m128i mask = _mm_or_si128(_mm_cmplt_epi8(v, _mm_set1_epi8(0x21)),
+                                _mm_cmpgt_epi8(v, _mm_set1_epi8(0x7E)));
+    mask = _mm_or_si128(mask, InRangeSSE2(v, '(', ')'));
+    mask = _mm_or_si128(mask, InRangeSSE2(v, ':', '@'));
+    mask = _mm_or_si128(mask, InRangeSSE2(v, '[', ']'));
+    mask = _mm_or_si128(mask, _mm_cmpeq_epi8(v, _mm_set1_epi8('"')));
+    mask = _mm_or_si128(mask, _mm_cmpeq_epi8(v, _mm_set1_epi8(',')));
+    mask = _mm_or_si128(mask, _mm_cmpeq_epi8(v, _mm_set1_epi8('/')));
+    mask = _mm_or_si128(mask, _mm_cmpeq_epi8(v, _mm_set1_epi8('{')));
+    mask = _mm_or_si128(mask, _mm_cmpeq_epi8(v, _mm_set1_epi8('}')));
+    return _mm_movemask_epi8(mask);
+}
+
+__attribute__((target("sse2")))
+static const char* FindCRLFSSE2(const char* pBegin, const char* pEnd)
+{
+    const __m128i cr = _mm_set1_epi8('\r');
+    const __m128i lf = _mm_set1_epi8('\n');
+    const char* pCur = pBegin;
+
+    // Compare CR at i and LF at i + 1 of the block.
+    while (pCur + 17 <= pEnd) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pCur));
+        __m128i next = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pCur + 1));
+        int mask = _mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(block, cr), _mm_cmpeq_epi8(next, lf)));
+        if (mask) {
+            return pCur + __builtin_ctz(mask);
+        }
+        pCur += 16;
+    }
+    return FindCRLFScalar(pCur, pEnd);
+}
+
+__attribute__((target("sse2")))
+static const char* FindNonTokenCharSSE2(const char* pBegin, const char* pEnd)
+{
+    const char* pCur = pBegin;
+    while (pCur + 16 <= pEnd) {
+        int mask = NonTokenMaskSSE2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pCur)));
+        if (mask) {
+            return pCur + __builtin_ctz(mask);
+        }
+        pCur += 16;
+    }
+    return FindNonTokenCharScalar(pCur, pEnd);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// AVX2 Implemenation
+//
+///////////////////////////////////////////////////////////////////////////////
+__attribute__((target("avx2")))
+static inline __m256i InRangeAVX2(__m256i v, char low, char high)
+{
+    return _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8(low - 1)),
+                            _mm256_cmpgt_epi8(_mm256_set1_epi8(high + 1), v));
+}
+
+__attribute__((target("avx2")))
+static inline uint32_t NonTokenMaskAVX2(__m256i v)
+{
+    __m256i mask = _mm256_or_si256(_mm256_cmpgt_epi8(_mm256_set1_epi8(0x21), v),
+                                   _mm256_cmpgt_epi8(v, _mm256_set1_epi8(0x7E)));
+    mask = _mm256_or_si256(mask, InRangeAVX2(v, '(', ')'));
+    mask = _mm256_or_si256(mask, InRangeAVX2(v, ':', '@'));
+    mask = _mm256_or_si256(mask, InRangeAVX2(v, '[', ']'));
+    mask = _mm256_or_si256(mask, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')));
+    mask = _mm256_or_si256(mask, _mm256_cmpeq_epi8(v, _mm256_set1_epi8(',')));
+    mask = _mm256_or_si256(mask, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('/')));
+    mask = _mm256_or_si256(mask, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('{')));
+    mask = _mm256_or_si256(mask, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('}')));
+    return static_cast<uint32_t>(_mm256_movemask_epi8(mask));
+}
+
+__attribute__((target("avx2")))
+static const char* FindCRLFAVX2(const char* pBegin, const char* pEnd)
+{
+    const __m256i cr = _mm256_set1_epi8('\r');
+    const __m256i lf = _mm256_set1_epi8('\n');
+    const char* pCur = pBegin;
+
+    while (pCur + 33 <= pEnd) {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pCur));
+        __m256i next = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pCur + 1));
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(block, cr), _mm256_cmpeq_epi8(next, lf))));
+        if (mask) {
+            return pCur + __builtin_ctz(mask);
+        }
+        pCur += 32;
+    }
+    return FindCRLFSSE2(pCur, pEnd);
+}
+
+__attribute__((target("avx2")))
+static const char* FindNonTokenCharAVX2(const char* pBegin, const char* pEnd)
+{
+    const char* pCur = pBegin;
+    while (pCur + 32 <= pEnd) {
+        uint32_t mask = NonTokenMaskAVX2(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pCur)));
+        if (mask) {
+            return pCur + __builtin_ctz(mask);
+        }
+        pCur += 32;
+    }
+    return FindNonTokenCharSSE2(pCur, pEnd);
+}
+
+#endif  // __SCAN_X86__
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Dispatch Implemenation
+//
+///////////////////////////////////////////////////////////////////////////////
+static const char* FindCRLFResolver(const char* pBegin, const char* pEnd);
+static const char* FindNonTokenCharResolver(const char* pBegin, const char* pEnd);
+
+// Constant initialized, so they are usable before the dynamic initialization.
+static tScanFunc s_FindCRLF = FindCRLFResolver;
+static tScanFunc s_FindNonTokenChar = FindNonTokenCharResolver;
+static ScanLevel s_Level = SCAN_LEVEL_COUNT;
+
+static ScanLevel SupportedLevel()
+{
+#ifdef __SCAN_X86__
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return SCAN_AVX2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return SCAN_SSE2;
+    }
+#endif
+    return SCAN_SCALAR;
+}
+
+static void Resolve()
+{
+    if (s_Level == SCAN_LEVEL_COUNT) {
+        // The same result in every thread, no lock is needed.
+        SetScanLevel(SupportedLevel());
+    }
+}
+
+static const char* FindCRLFResolver(const char* pBegin, const char* pEnd)
+{
+    Resolve();
+    return s_FindCRLF(pBegin, pEnd);
+}
+
+static const char* FindNonTokenCharResolver(const char* pBegin, const char* pEnd)
+{
+    Resolve();
+    return s_FindNonTokenChar(pBegin, pEnd);
+}
+
+const char* FindCRLF(const char* pBegin, const char* pEnd)
+{
+    return s_FindCRLF(pBegin, pEnd);
+}
+
+const char* FindNonTokenChar(const char* pBegin, const char* pEnd)
+{
+    return s_FindNonTokenChar(pBegin, pEnd);
+}
+
+ScanLevel GetScanLevel()
+{
+    Resolve();
+    return s_Level;
+}
+
+ScanLevel SetScanLevel(ScanLevel level)
+{
+    ScanLevel supported = SupportedLevel();
+    if (level > supported) {
+        level = supported;
+    }
+
+    switch (level) {
+#ifdef __SCAN_X86__
+    case SCAN_AVX2:
+        s_FindCRLF = FindCRLFAVX2;
+        s_FindNonTokenChar = FindNonTokenCharAVX2;
+        break;
+    case SCAN_SSE2:
+        s_FindCRLF = FindCRLFSSE2;
+        s_FindNonTokenChar = FindNonTokenCharSSE2;
+        break;
+#endif
+    default:
+        level = SCAN_SCALAR;
+        s_FindCRLF = FindCRLFScalar;
+        s_FindNonTokenChar = FindNonTokenCharScalar;
+        break;
+    }
+    s_Level = level;
+    return level;
+}
+
+};
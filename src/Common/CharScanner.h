@@ -0,0 +1,64 @@
+/*
+ * See the file LICENSE for redistribution information.
+ *
+ * Copyright (c) 2015-2018, Yuan Qin <yuanqin2000 at outlook dot com>
+ * All rights reserved.
+ *
+ */
+
+#ifndef __COMMON_CHAR_SCANNER_H__
+#define __COMMON_CHAR_SCANNER_H__
+
+#include "Common/Typedefs.h"
+
+/**
+ * @brief Scan the protocol text for the line ends and the token delimiters
+ *        with the SIMD instructions (16 or 32 bytes at a time).
+ *
+ * The instruction set is selected by the CPU at the first call, the scalar
+ * implementation is used on the other architectures.
+ */
+namespace NSCharScanner
+{
+
+enum ScanLevel {
+    SCAN_SCALAR,
+    SCAN_SSE2,
+    SCAN_AVX2,
+    SCAN_LEVEL_COUNT
+};
+
+/**
+ * @brief Find the first CRLF in [pBegin, pEnd).
+ * @return The position of CR, NULL if not found.
+ */
+const char* FindCRLF(const char* pBegin, const char* pEnd);
+
+/**
+ * @brief Find the first character which is not a token character (tchar of
+ *        RFC 7230) in [pBegin, pEnd).
+ * @return The position of the character, pEnd if not found.
+ */
+const char* FindNonTokenChar(const char* pBegin, const char* pEnd);
+
+/**
+ * tchar = "!" / "#" / "$" / "%" / "&" / "'" / "*" / "+" / "-" / "." /
+ *         "^" / "_" / "`" / "|" / "~" / DIGIT / ALPHA
+ */
+inline bool IsTokenChar(char c)
+{
+    extern const uint8_t g_TokenCharTable[256];
+    return g_TokenCharTable[static_cast<uint8_t>(c)] != 0;
+}
+
+ScanLevel GetScanLevel();
+
+/**
+ * @brief Select the implementation, used by the tests and the benchmarks.
+ * @return The level actually used, not higher than the CPU supports.
+ */
+ScanLevel SetScanLevel(ScanLevel level);
+
+};
+
+#endif
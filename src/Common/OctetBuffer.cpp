@@ -15,6 +15,7 @@ COctetBuffer::COctetBuffer(
     m_pFree(pBuf),
     m_pBufferBegin(pBuf),
     m_pBufferEnd(pBuf + bufLen),
+    m_pPinned(NULL),
     m_BufferSize(bufLen),
     m_FragmentMinSize(0),
     m_BufferReleaser(releaser)
@@ -47,6 +48,7 @@ size_t COctetBuffer::Append(const uint8_t* pBuf, size_t len)
     size_t freeSize = GetTotalFreeSize();
     size_t toCopySize = len > freeSize ? freeSize : len;
     if (toCopySize > GetFreeBufferSize()) {
+        ASSERT(m_pPinned == NULL);
         size_t dataLength = GetDataLength();
         if (dataLength <= GetFrontFreeSize()) {
             memcpy(m_pBufferBegin, m_pData, dataLength);
@@ -70,7 +72,7 @@ bool COctetBuffer::Append(uint8_t octect)
         bRes = true;
     } else {
         size_t freeHole = GetFrontFreeSize();
-        if (freeHole > sizeof(octect)) {
+        if (m_pPinned == NULL && freeHole > sizeof(octect)) {
             size_t dataLength = GetDataLength();
             if (freeHole > dataLength) {
                 memcpy(m_pBufferBegin, m_pData, dataLength);
@@ -101,6 +103,10 @@ size_t COctetBuffer::SetPopOutLength(size_t len, bool bRelocationData /* = false
 
 void COctetBuffer::RelocationDataIfNecessary()
 {
+    if (m_pPinned) {
+        return;
+    }
+
     size_t holeSize = m_pData - m_pBufferBegin;
     size_t dataLength = GetDataLength();
 
@@ -114,6 +120,7 @@ void COctetBuffer::RelocationDataIfNecessary()
 
 void COctetBuffer::RelocationData()
 {
+    ASSERT(m_pPinned == NULL, "Relocate the pinned data\n");
     if (m_pData > m_pBufferBegin) {
         size_t holeSize = m_pData - m_pBufferBegin;
         size_t dataLength = GetDataLength();
@@ -27,10 +27,31 @@ public:
     uint8_t* GetFreeBuffer() const { return m_pFree < m_pBufferEnd ? m_pFree : NULL; }
     size_t GetFreeBufferSize() const { return m_pFree < m_pBufferEnd ? m_pBufferEnd - m_pFree : 0; }
 
-    size_t GetTotalFreeSize() const { return m_BufferSize - GetDataLength(); }
+    size_t GetTotalFreeSize() const
+    {
+        return m_pPinned ? GetFreeBufferSize() : m_BufferSize - GetDataLength();
+    }
     size_t GetFrontFreeSize() const { return m_pData - m_pBufferBegin; }
 
-    void Reset() { m_pData = m_pFree = m_pBufferBegin; }
+    void Reset()
+    {
+        m_pData = m_pFree = m_pBufferBegin;
+        m_pPinned = NULL;
+    }
+
+    /**
+     * @brief Keep the data from pPos in place even after it is popped out,
+     *        it is neither moved nor overwritten until Unpin or Reset.
+     *        The owner of the pinned data must release its pointers to it
+     *        before calling RelocationData.
+     */
+    void Pin(const uint8_t* pPos)
+    {
+        ASSERT(pPos >= m_pBufferBegin && pPos <= m_pFree);
+        m_pPinned = pPos;
+    }
+    void Unpin() { m_pPinned = NULL; }
+    bool IsPinned() const { return m_pPinned != NULL; }
 
     void SetPushInLength(size_t len)
     {
@@ -51,6 +72,7 @@ private:
     uint8_t* m_pFree;
     uint8_t* m_pBufferBegin;
     uint8_t* m_pBufferEnd;
+    const uint8_t* m_pPinned;
     const size_t m_BufferSize;
     size_t m_FragmentMinSize;
     tBufferReleaser m_BufferReleaser;
@@ -0,0 +1,175 @@
+/*
+ * See the file LICENSE for redistribution information.
+ *
+ * Copyright (c) 2015-2018, Yuan Qin <yuanqin2000 at outlook dot com>
+ * All rights reserved.
+ *
+ */
+
+#include "PerfectHash.h"
+#include <cstdlib>
+#include <cstring>
+#include <strings.h>
+#include "Tracker/Trace.h"
+
+using std::malloc;
+using std::calloc;
+using std::free;
+using std::memcmp;
+using std::strlen;
+
+static uint8_t s_LowerCase[256];
+static uint8_t s_SameCase[256];
+
+static bool InitCaseTables()
+{
+    for (int i = 0; i < 256; ++i) {
+        s_SameCase[i] = static_cast<uint8_t>(i);
+        s_LowerCase[i] = static_cast<uint8_t>((i >= 'A' && i <= 'Z') ? i + ('a' - 'A') : i);
+    }
+    return true;
+}
+
+CPerfectHash::CPerfectHash(bool bCaseSensitive /* = true */) :
+    m_pTable(NULL),
+    m_Mask(0),
+    m_Seed(0),
+    m_Count(0),
+    m_bCaseSensitive(bCaseSensitive)
+{
+}
+
+CPerfectHash::CPerfectHash(
+    const KeyValue* pEntries, size_t count, bool bCaseSensitive) :
+    m_pTable(NULL),
+    m_Mask(0),
+    m_Seed(0),
+    m_Count(0),
+    m_bCaseSensitive(bCaseSensitive)
+{
+    bool bRes = Initialize(pEntries, count);
+    ASSERT(bRes, "Build the perfect hash of %d keys failed.\n", count);
+    (void) bRes;
+}
+
+CPerfectHash::~CPerfectHash()
+{
+    free(m_pTable);
+}
+
+bool CPerfectHash::Initialize(const char* const pKeys[], size_t count)
+{
+    Slot* pSlots = reinterpret_cast<Slot*>(malloc(sizeof(Slot) * count));
+    if (pSlots == NULL) {
+        return false;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        pSlots[i].pKey = pKeys[i];
+        pSlots[i].Length = strlen(pKeys[i]);
+        pSlots[i].Value = static_cast<int>(i);
+    }
+    bool bRes = Build(pSlots, count);
+    free(pSlots);
+    return bRes;
+}
+
+bool CPerfectHash::Initialize(const KeyValue* pEntries, size_t count)
+{
+    Slot* pSlots = reinterpret_cast<Slot*>(malloc(sizeof(Slot) * count));
+    if (pSlots == NULL) {
+        return false;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        pSlots[i].pKey = pEntries[i].pKey;
+        pSlots[i].Length = strlen(pEntries[i].pKey);
+        pSlots[i].Value = pEntries[i].Value;
+    }
+    bool bRes = Build(pSlots, count);
+    free(pSlots);
+    return bRes;
+}
+
+int CPerfectHash::Find(const char* pKey, size_t len /* = 0 */) const
+{
+    if (m_pTable == NULL) {
+        return INVALID_VALUE;
+    }
+
+    const Slot& slot = m_pTable[Hash(pKey, len, &len) & m_Mask];
+    if (slot.Length != len || slot.pKey == NULL) {
+        return INVALID_VALUE;
+    }
+    bool bEqual = m_bCaseSensitive ?
+        memcmp(slot.pKey, pKey, len) == 0 : strncasecmp(slot.pKey, pKey, len) == 0;
+    return bEqual ? slot.Value : INVALID_VALUE;
+}
+
+bool CPerfectHash::Build(Slot* pKeys, size_t count)
+{
+    static bool s_bCaseTables = InitCaseTables();
+    (void) s_bCaseTables;
+
+    ASSERT(m_pTable == NULL);
+
+    size_t size = 8;
+    while (size < count * 2) {
+        size <<= 1;
+    }
+
+    for (; size <= (count << MAX_LOAD_SHIFT) || size == 8; size <<= 1) {
+        Slot* pTable = reinterpret_cast<Slot*>(calloc(size, sizeof(Slot)));
+        if (pTable == NULL) {
+            return false;
+        }
+        m_Mask = size - 1;
+        for (m_Seed = 1; m_Seed <= MAX_SEED_TRIES; ++m_Seed) {
+            size_t i = 0;
+            while (i < count) {
+                size_t length = 0;
+                Slot& slot = pTable[Hash(pKeys[i].pKey, pKeys[i].Length, &length) & m_Mask];
+                if (slot.pKey) {
+                    break;
+                }
+                slot = pKeys[i];
+                ++i;
+            }
+            if (i == count) {
+                m_pTable = pTable;
+                m_Count = count;
+                return true;
+            }
+            memset(pTable, 0, size * sizeof(Slot));
+        }
+        free(pTable);
+    }
+
+    OUTPUT_WARNING_TRACE("No perfect hash is found for %d keys.\n", count);
+    m_Mask = 0;
+    m_Seed = 0;
+    return false;
+}
+
+uint32_t CPerfectHash::Hash(const char* pKey, size_t len, size_t* pOutLen) const
+{
+    // FNV-1a over the folded characters, the length is mixed in at last.
+    const uint8_t* pFold = m_bCaseSensitive ? s_SameCase : s_LowerCase;
+    const uint8_t* pCur = reinterpret_cast<const uint8_t*>(pKey);
+    uint32_t hash = 2166136261u ^ m_Seed;
+    if (len) {
+        const uint8_t* pEnd = pCur + len;
+        while (pCur < pEnd) {
+            hash = (hash ^ pFold[*pCur++]) * 16777619u;
+        }
+    } else {
+        while (*pCur) {
+            hash = (hash ^ pFold[*pCur++]) * 16777619u;
+        }
+        len = pCur - reinterpret_cast<const uint8_t*>(pKey);
+    }
+    hash ^= static_cast<uint32_t>(len) * 0x9E3779B1u;
+    hash ^= hash >> 15;
+    hash *= 0x2C1B3C6Du;
+    hash ^= hash >> 13;
+    *pOutLen = len;
+    return hash;
+}
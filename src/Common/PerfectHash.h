@@ -0,0 +1,78 @@
+/*
+ * See the file LICENSE for redistribution information.
+ *
+ * Copyright (c) 2015-2018, Yuan Qin <yuanqin2000 at outlook dot com>
+ * All rights reserved.
+ *
+ */
+
+#ifndef __COMMON_PERFECT_HASH_H__
+#define __COMMON_PERFECT_HASH_H__
+
+#include "Common/Typedefs.h"
+#include "Common/Macros.h"
+
+/**
+ * @brief The perfect hash of a fixed string set.
+ *
+ * The seed and the table size are searched when it is initialized until
+ * every key has its own slot, so a lookup is one hash of the string and
+ * at most one string comparison. The keys are folded to the lower case if
+ * not case sensitive, and the length is a part of the key.
+ *
+ * @note The keys are referenced, not copied.
+ */
+class CPerfectHash
+{
+public:
+    struct KeyValue {
+        const char* pKey;
+        int Value;
+    };
+
+    explicit CPerfectHash(bool bCaseSensitive = true);
+    CPerfectHash(const KeyValue* pEntries, size_t count, bool bCaseSensitive);
+    ~CPerfectHash();
+
+    /**
+     * @brief Build the table, the value of the key is its index.
+     */
+    bool Initialize(const char* const pKeys[], size_t count);
+    bool Initialize(const KeyValue* pEntries, size_t count);
+
+    /**
+     * @param len The length of the key, 0 if it is null terminated.
+     * @return The value of the key, INVALID_VALUE if not found.
+     */
+    int Find(const char* pKey, size_t len = 0) const;
+
+    size_t Count() const { return m_Count; }
+    size_t TableSize() const { return m_Mask + 1; }
+
+    static const int INVALID_VALUE = -1;
+
+private:
+    struct Slot {
+        const char* pKey;
+        uint32_t Length;
+        int Value;
+    };
+
+    bool Build(Slot* pKeys, size_t count);
+    uint32_t Hash(const char* pKey, size_t len, size_t* pOutLen) const;
+
+    static const size_t MAX_SEED_TRIES = 64;
+    static const size_t MAX_LOAD_SHIFT = 6;     // Table size up to count * 64
+
+private:
+    Slot* m_pTable;         // Owned
+    uint32_t m_Mask;
+    uint32_t m_Seed;
+    size_t m_Count;
+    const bool m_bCaseSensitive;
+
+    DISALLOW_COPY_CONSTRUCTOR(CPerfectHash);
+    DISALLOW_ASSIGN_OPERATOR(CPerfectHash);
+};
+
+#endif
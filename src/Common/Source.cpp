@@ -8,15 +8,17 @@
 
 #include "Source.h"
 #include <cstring>
+#include <climits>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <errno.h>
+#include <stdlib.h>
 #include "Sink.h"
 #include "Tracker/Trace.h"
 
-CSource::CSource()
+CSource::CSource() : m_pSink(NULL)
 {
 }
 
@@ -73,7 +75,114 @@ int CMemorySource::Read(uint8_t* to, size_t size)
             copied = size;
         }
         std::memcpy(to, m_pCurrent, copied);
-        m_pCurrent = m_pData + copied;
+        m_pCurrent += copied;
     }
     return copied;
 }
+
+size_t CMemorySource::Peek(const uint8_t** ppData)
+{
+    ASSERT(ppData);
+
+    *ppData = m_pCurrent;
+    return m_pData + m_Length - m_pCurrent;
+}
+
+void CMemorySource::Skip(size_t len)
+{
+    ASSERT(m_pCurrent + len <= m_pData + m_Length);
+    m_pCurrent += len;
+}
+
+
+CFileSource::CFileSource(const char* pPath) :
+    m_pPath(strdup(pPath)),
+    m_hFile(INVALID_IO_HANDLE),
+    m_Offset(0),
+    m_Length(0)
+{
+    ASSERT(pPath);
+}
+
+CFileSource::~CFileSource()
+{
+    Close();
+    free(m_pPath);
+}
+
+bool CFileSource::Open()
+{
+    if (m_hFile != INVALID_IO_HANDLE) {
+        return true;
+    }
+    if (m_pPath == NULL) {
+        return false;
+    }
+
+    m_hFile = open(m_pPath, O_RDONLY | O_CLOEXEC);
+    if (m_hFile == INVALID_IO_HANDLE) {
+        OUTPUT_ERROR_TRACE("open %s: %s\n", m_pPath, strerror(errno));
+        return false;
+    }
+    struct stat fileStat;
+    if (fstat(m_hFile, &fileStat) != 0 || !S_ISREG(fileStat.st_mode)) {
+        OUTPUT_ERROR_TRACE("%s is not a regular file\n", m_pPath);
+        Close();
+        return false;
+    }
+    if (fileStat.st_size > INT_MAX) {
+        // The length is reported in int by Length().
+        OUTPUT_ERROR_TRACE("%s is too large: %ld\n",
+                           m_pPath, static_cast<long>(fileStat.st_size));
+        Close();
+        return false;
+    }
+    m_Offset = 0;
+    m_Length = fileStat.st_size;
+    return true;
+}
+
+void CFileSource::Close()
+{
+    if (m_hFile != INVALID_IO_HANDLE) {
+        close(m_hFile);
+        m_hFile = INVALID_IO_HANDLE;
+    }
+    m_Offset = 0;
+    m_Length = 0;
+}
+
+int CFileSource::Read(uint8_t* to, size_t size)
+{
+    ASSERT(to && size > 0);
+
+    ssize_t readLen = 0;
+    do {
+        readLen = pread(m_hFile, to, size, m_Offset);
+    } while (readLen < 0 && errno == EINTR);
+    if (readLen < 0) {
+        OUTPUT_ERROR_TRACE("read %s: %s\n", m_pPath, strerror(errno));
+        return -1;
+    }
+    m_Offset += readLen;
+    return readLen;
+}
+
+bool CFileSource::GetFileRegion(tIOHandle* pFile, off_t* pOffset, size_t* pLen)
+{
+    ASSERT(pFile && pOffset && pLen);
+
+    if (m_hFile == INVALID_IO_HANDLE || m_Offset >= m_Length) {
+        return false;
+    }
+    *pFile = m_hFile;
+    *pOffset = m_Offset;
+    *pLen = m_Length - m_Offset;
+    return true;
+}
+
+void CFileSource::Skip(size_t len)
+{
+    ASSERT(m_Offset + static_cast<off_t>(len) <= m_Length);
+    m_Offset += len;
+}
@@ -10,6 +10,7 @@
 #define __UTITLITY_PRODUCER_H__
 
 #include <sys/epoll.h>
+#include <sys/types.h>
 #include "Common/Typedefs.h"
 #include "Tracker/Trace.h"
 #include "IO/PollClient.h"
@@ -80,6 +81,29 @@ public:
      */
     virtual bool IsEOF() const = 0;
 
+    /**
+     * @brief Get the continuous data in memory from the current position
+     *        without copying, the position is not moved.
+     * @return The length of the data, 0 if it is not supported or EOF.
+     */
+    virtual size_t Peek(const uint8_t** ppData) { return 0; }
+
+    /**
+     * @brief Get the file region from the current position, so the data can
+     *        be sent by the kernel without copying into user space.
+     * @return false if the source is not backed by a file or EOF.
+     */
+    virtual bool GetFileRegion(tIOHandle* pFile, off_t* pOffset, size_t* pLen)
+    {
+        return false;
+    }
+
+    /**
+     * @brief Move the position forward after the data got by Peek or
+     *        GetFileRegion is consumed.
+     */
+    virtual void Skip(size_t len) {}
+
 public:
     CSource();
     ~CSource();
@@ -100,9 +124,12 @@ public:
 
     bool Open()  { return true;          }
     void Close() { m_pCurrent = m_pData; }
+    void Reset() { m_pCurrent = m_pData; }
 
     // From CSource
     int  Read(uint8_t* to, size_t size);
+    size_t Peek(const uint8_t** ppData);
+    void Skip(size_t len);
     int  Length() const { return m_Length; }
     bool IsReadable() const { return true; }
     bool IsEOF() const { return m_pCurrent == m_pData + m_Length; }
@@ -115,4 +142,37 @@ private:
     uint8_t* m_pCurrent;
 };
 
+
+/**
+ * @brief The content of a regular file, less than 2 GiB.
+ * @note Open it before passing to the request, the request closes it.
+ */
+class CFileSource : public CSource
+{
+public:
+    CFileSource(const char* pPath);
+    ~CFileSource();
+
+    // From CSource
+    bool Open();
+    void Close();
+    void Reset() { m_Offset = 0; }
+    int  Read(uint8_t* to, size_t size);
+    int  Length() const { return static_cast<int>(m_Length); }
+    bool IsReadable() const { return m_hFile != INVALID_IO_HANDLE; }
+    bool IsEOF() const { return m_Offset == m_Length; }
+    bool GetFileRegion(tIOHandle* pFile, off_t* pOffset, size_t* pLen);
+    void Skip(size_t len);
+
+private:
+    char* m_pPath;      // Owned
+    tIOHandle m_hFile;
+    off_t m_Offset;
+    off_t m_Length;
+
+    DISALLOW_COPY_CONSTRUCTOR(CFileSource);
+    DISALLOW_ASSIGN_OPERATOR(CFileSource);
+    DISALLOW_DEFAULT_CONSTRUCTOR(CFileSource);
+};
+
 #endif
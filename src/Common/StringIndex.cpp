@@ -10,8 +10,7 @@
 #include <cstring>
 #include "Tracker/Trace.h"
 
-using std::memcmp;
-using std::pair;
+using std::strncmp;
 
 CStringIndex* CStringIndex::CreateInstance(
     size_t count, const char* pStrings[], bool bCaseSensitive /* = true */)
@@ -43,8 +42,9 @@ int CDynamicArrayStringIndex::GetIndexByString(
     if (len) {
         int (*pCmpFunc)(const char*, const char*, size_t) =
             m_bCaseSensitive ? strncmp : strncasecmp;
+        // The whole string shall match, not only its prefix.
         while (i < m_Count) {
-            if (pCmpFunc(m_pStrings[i], pString, len) == 0) {
+            if (strlen(m_pStrings[i]) == len && pCmpFunc(m_pStrings[i], pString, len) == 0) {
                 index = static_cast<int>(i);
                 break;
             }
@@ -68,31 +68,21 @@ int CDynamicArrayStringIndex::GetIndexByString(
 CMapStringIndex::CMapStringIndex(
     size_t count, const char* pStrings[], bool bCaseSensitive) :
     CStringIndex(count, pStrings, bCaseSensitive),
-    m_IndexMap()
+    m_Index(bCaseSensitive)
 {
 }
 
 int CMapStringIndex::GetIndexByString(
     const char* pString, size_t len /* = 0 */) const
 {
-    int res = -1;
-    CLenString lenString(pString, m_bCaseSensitive, len);
-    map<CLenString, int>::const_iterator iter = m_IndexMap.find(lenString);
-    if (iter != m_IndexMap.end()) {
-        res = iter->second;
-    }
-    return res;
+    return m_Index.Find(pString, len);
 }
 
 bool CMapStringIndex::Initialized()
 {
-    for (int i = 0; i < static_cast<int>(m_Count); ++i) {
-        pair<map<CLenString, int>::iterator, bool> ret =
-            m_IndexMap.insert(pair<CLenString, int>(CLenString(m_pStrings[i], m_bCaseSensitive), i));
-        if (!ret.second) {
-            OUTPUT_WARNING_TRACE("Map insert failed at %d (%s)\n", i, m_pStrings[i]);
-            return false;
-        }
+    if (!m_Index.Initialize(m_pStrings, m_Count)) {
+        OUTPUT_WARNING_TRACE("Build the index of %d strings failed.\n", m_Count);
+        return false;
     }
     return true;
 }
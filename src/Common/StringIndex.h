@@ -9,13 +9,11 @@
 #ifndef __COMMON_STRING_INDEX_H__
 #define __COMMON_STRING_INDEX_H__
 
-#include <map>
 #include <cstring>
 #include "Common/Typedefs.h"
-#include "LenString.h"
+#include "PerfectHash.h"
 #include "Tracker/Trace.h"
 
-using std::map;
 using std::strlen;
 
 class CStringIndex
@@ -74,7 +72,7 @@ public:
 private:
     bool Initialized();
 
-    map<CLenString, int> m_IndexMap;
+    CPerfectHash m_Index;
 };
 
 #endif
\ No newline at end of file
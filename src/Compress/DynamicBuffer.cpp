@@ -17,15 +17,17 @@ using std::memset;
 using std::malloc;
 using std::free;
 
-CDynamicBuffer* CDynamicBuffer::CreateInstance(size_t len)
+CDynamicBuffer* CDynamicBuffer::CreateInstance(
+    size_t len, CMemory* pAllocator /* = CMemory::GetDefaultMemory() */)
 {
     ASSERT(len > 0);
+    ASSERT(pAllocator);
 
     CDynamicBuffer* pInstance = NULL;
-    void* pMem = malloc(sizeof(CDynamicBuffer) + len);
+    void* pMem = pAllocator->Malloc(sizeof(CDynamicBuffer) + len);
     if (pMem) {
         pInstance = new (pMem) CDynamicBuffer(reinterpret_cast<uint8_t*>(
-                                        pMem) + sizeof(CDynamicBuffer), len);
+                                        pMem) + sizeof(CDynamicBuffer), len, pAllocator);
     }
     return pInstance;
 }
@@ -34,13 +36,14 @@ void CDynamicBuffer::DestroyInstance(CDynamicBuffer* pInstance)
 {
     ASSERT(pInstance);
 
+    CMemory* pAllocator = pInstance->m_pAllocator;
     DataBlock* pBlock = pInstance->m_First.pNext;
     while (pBlock) {
         DataBlock* pNext = pBlock->pNext;
-        free(pBlock);
+        pAllocator->Free(pBlock);
         pBlock = pNext;
     }
-    free(pInstance);
+    pAllocator->Free(pInstance);
 }
 
 CDynamicBuffer::DataBlock* CDynamicBuffer::CreateBlock(size_t len)
@@ -48,7 +51,7 @@ CDynamicBuffer::DataBlock* CDynamicBuffer::CreateBlock(size_t len)
     ASSERT(len > 0);
 
     DataBlock* pBlock = NULL;
-    void* pMem = malloc(sizeof(DataBlock) + len);
+    void* pMem = m_pAllocator->Malloc(sizeof(DataBlock) + len);
     if (pMem) {
         pBlock = new (pMem) DataBlock(reinterpret_cast<uint8_t*>(pMem) + sizeof(DataBlock), len);
         m_pLast->pNext = pBlock;
@@ -57,8 +60,9 @@ CDynamicBuffer::DataBlock* CDynamicBuffer::CreateBlock(size_t len)
     return pBlock;
 }
 
-CDynamicBuffer::CDynamicBuffer(uint8_t* pBuffer, size_t len) :
-    m_First(pBuffer, len)
+CDynamicBuffer::CDynamicBuffer(uint8_t* pBuffer, size_t len, CMemory* pAllocator) :
+    m_First(pBuffer, len),
+    m_pAllocator(pAllocator)
 {
     m_pLast = &m_First;
 }
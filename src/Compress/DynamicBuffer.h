@@ -10,6 +10,7 @@
 #define __DYNAMIC_BUFFER_H__
 
 #include "Common/Typedefs.h"
+#include "Memory/Memory.h"
 
 class CDynamicBuffer
 {
@@ -23,7 +24,8 @@ public:
     };
 
 public:
-    static CDynamicBuffer* CreateInstance(size_t len);
+    static CDynamicBuffer* CreateInstance(
+        size_t len, CMemory* pAllocator = CMemory::GetDefaultMemory());
     static void DestroyInstance(CDynamicBuffer* pInstance);
 
     DataBlock* CreateBlock(size_t len);
@@ -31,12 +33,13 @@ public:
     DataBlock* GetFirstBlock() { return &m_First; }
 
 private:
-    CDynamicBuffer(uint8_t* pBuffer, size_t len);
+    CDynamicBuffer(uint8_t* pBuffer, size_t len, CMemory* pAllocator);
     ~CDynamicBuffer();
 
 private:
     DataBlock m_First;
     DataBlock* m_pLast;
+    CMemory* m_pAllocator;  // Not owned
 
     DISALLOW_COPY_CONSTRUCTOR(CDynamicBuffer);
     DISALLOW_ASSIGN_OPERATOR(CDynamicBuffer);
@@ -16,18 +16,47 @@ class CController;
 class CConfigure
 {
 public:
-    CConfigure(size_t inBufSize, size_t outBufSize) :
-        m_InBufferSize(inBufSize), m_OutBufferSize(outBufSize) {}
+    /**
+     * @param pipelineDepth The max count of the requests waiting for the
+     *        response on one connection, 0 if unlimited.
+     * @param maxRequests The count of the requests served by one connection,
+     *        then it is closed once idle, 0 if unlimited.
+     * @param idleTimeout Milliseconds to keep the idle connection,
+     *        0 if kept until the peer closes it.
+     * @param maxConnections The max count of the connections to one origin,
+     *        0 if unlimited.
+     */
+    CConfigure(
+        size_t inBufSize,
+        size_t outBufSize,
+        size_t pipelineDepth = 0,
+        size_t maxRequests = 0,
+        unsigned int idleTimeout = 0,
+        size_t maxConnections = 1) :
+        m_InBufferSize(inBufSize),
+        m_OutBufferSize(outBufSize),
+        m_PipelineDepth(pipelineDepth),
+        m_MaxRequests(maxRequests),
+        m_IdleTimeout(idleTimeout),
+        m_MaxConnections(maxConnections) {}
     virtual ~CConfigure() {}
 
     size_t InBufferSize() const { return m_InBufferSize; }
     size_t OutBufferSize() const { return m_OutBufferSize; }
+    size_t PipelineDepth() const { return m_PipelineDepth; }
+    size_t MaxRequests() const { return m_MaxRequests; }
+    unsigned int IdleTimeout() const { return m_IdleTimeout; }
+    size_t MaxConnections() const { return m_MaxConnections; }
 
     virtual bool CreateController(CController** pOutController, CRequest* pRequest) = 0;
 
 private:
     const size_t m_InBufferSize;
     const size_t m_OutBufferSize;
+    const size_t m_PipelineDepth;
+    const size_t m_MaxRequests;
+    const unsigned int m_IdleTimeout;
+    const size_t m_MaxConnections;
 };
 
 #endif
\ No newline at end of file
@@ -17,6 +17,7 @@
 CConnection::CConnection(
     CConnectionRunner& runContext,
     CPoller& poller,
+    CConfigure& configure,
     CIOContext* pIO,
     CController* pController,
     const sockaddr* pAddr) :
@@ -30,8 +31,13 @@ CConnection::CConnection(
     m_pIdleController(NULL),
     m_RunContext(runContext),
     m_Poller(poller),
+    m_Configure(configure),
+    m_AcceptedCount(0),
+    m_IdleTimerID(INVALID_TIMER_ID),
     m_Error(EC_SUCCESS),
     m_PeerAddress(),
+    m_bReceiveAborted(false),
+    m_bReusable(true),
     m_pInBuffer(NULL),
     m_pOutBuffer(NULL)
 {
@@ -39,6 +45,10 @@ CConnection::CConnection(
     ASSERT(pAddr);
 
     memcpy(&m_PeerAddress, pAddr, sizeof(m_PeerAddress));
+
+#ifdef __MEMORY_STATS__
+    m_MemPool.EnableStats("Connection");
+#endif
 }
 
 CConnection::~CConnection()
@@ -46,6 +56,7 @@ CConnection::~CConnection()
     ASSERT_IF(m_pController != NULL, m_pIdleController == NULL);
     ASSERT_IF(m_pIdleController != NULL, m_pController == NULL);
 
+    StopIdleTimer();
     m_Poller.RemoveClient(this);
 
     delete m_pIO;
@@ -66,7 +77,8 @@ CConnection* CConnection::CreateInstance(
     CIOContext* pIO = pRequest->CreateIOContext(pAddr);
     CConfigure& configure(pRequest->GetConfigure());
     if (configure.CreateController(&pController, pRequest) && pIO) {
-        pInstance = new CConnection(runContext, poller, pIO, pController, pAddr);
+        pInstance = new CConnection(
+            runContext, poller, configure, pIO, pController, pAddr);
     }
 
     if (pInstance) {
@@ -165,12 +177,45 @@ void CConnection::OnPeerClosed()
     }
 }
 
+void CConnection::OnTimeout(tTimerID timerID)
+{
+    ASSERT(timerID == m_IdleTimerID);
+
+    m_IdleTimerID = INVALID_TIMER_ID;
+    if (IsIdle()) {
+        OUTPUT_DEBUG_TRACE("Close the idle connection: %p\n", this);
+        m_RunContext.RemoveConnection(this);
+    }
+}
+
+void CConnection::OnTimeCreated(int sessionID, tTimerID timerID)
+{
+    m_IdleTimerID = timerID;
+}
+
+bool CConnection::AcceptRequest(CRequest* pReq, bool bFront)
+{
+    bool bRes = bFront ?
+        m_PendingRequests.PushFront(pReq) : m_PendingRequests.PushBack(pReq);
+    if (!bRes) {
+        return false;
+    }
+    ++m_AcceptedCount;
+    StopIdleTimer();
+
+    // The edge-triggered poller does not report the idle IO writable again.
+    if (m_pIO->IsWritable()) {
+        DoSend();
+    }
+    return true;
+}
+
 bool CConnection::ActivateSecure()
 {
     ASSERT(m_pIO);
 
     bool bRes = false;
-    CSSLClient* pIO = CSSLClient::CreateInstance(m_pIO, false);
+    CSSLClient* pIO = CSSLClient::CreateInstance(m_pIO, false, &m_PeerAddress);
     if (pIO) {
         if (pIO->Open()) {
             bRes = true;
@@ -212,15 +257,32 @@ CRequest* CConnection::PrepareSendRequest()
         return m_pSendingRequest;
     }
 
+    CRequest* pReq = reinterpret_cast<CRequest*>(m_PendingRequests.First());
+    if (pReq && CanPipeline(pReq)) {
+        m_pSendingRequest = pReq;
+        m_PendingRequests.PopFront();
+    }
+    return m_pSendingRequest;
+}
+
+bool CConnection::CanPipeline(CRequest* pReq)
+{
+    if (!m_bReusable) {
+        return false;
+    }
+
     CRequest* pLastRecvRequest =
         reinterpret_cast<CRequest*>(m_WaitingRequests.Last());
-    if (pLastRecvRequest == NULL || pLastRecvRequest->IsPipeline()) {
-        m_pSendingRequest = reinterpret_cast<CRequest*>(m_PendingRequests.First());
-        if (m_pSendingRequest) {
-            m_PendingRequests.PopFront();
-        }
+    if (pLastRecvRequest == NULL) {
+        return true;
     }
-    return m_pSendingRequest;
+
+    // Only the idempotent requests are pipelined (RFC 7230, 6.3.2).
+    if (!pLastRecvRequest->IsPipeline() || !pReq->IsPipeline()) {
+        return false;
+    }
+    size_t depth = m_Configure.PipelineDepth();
+    return depth == 0 || m_WaitingRequests.Count() < depth;
 }
 
 void CConnection::DoSend()
@@ -254,13 +316,19 @@ void CConnection::DoSend()
                         bool bRes = m_WaitingRequests.PushBack(pReq);
                         ASSERT(bRes);
                         m_pSendingRequest = NULL;
+                        if (m_PendingRequests.Count() == 0) {
+                            m_RunContext.OnConnectionAvailable(this);
+                        }
+                        if (dataLength == 0) {
+                            // The payload blocks are all sent, try the next request.
+                            continue;
+                        }
                     }
                 }
             }
-            if (dataLength == 0) {
-                break;
+            if (dataLength > 0) {
+                m_pOutBuffer->SetPushInLength(dataLength);
             }
-            m_pOutBuffer->SetPushInLength(dataLength);
         }
         if (!SendData()) {
             break;
@@ -270,9 +338,37 @@ void CConnection::DoSend()
 
 bool CConnection::SendData()
 {
+    // Gather the serialized data and the payload blocks of the request,
+    // the payload in memory is not copied into the output buffer.
+    struct iovec ioVec[SEND_IOVEC_COUNT];
+    size_t count = 0;
+    size_t bufferLength = m_pOutBuffer->GetDataLength();
+    if (bufferLength > 0) {
+        ioVec[0].iov_base = m_pOutBuffer->GetData();
+        ioVec[0].iov_len = bufferLength;
+        ++count;
+    }
+    if (m_pSendingRequest) {
+        count += m_pSendingRequest->GetPayloadIOVec(
+            &ioVec[count], SEND_IOVEC_COUNT - count);
+    }
+
     bool bRes = false;
-    size_t writeBytes = m_pIO->Write(
-        m_pOutBuffer->GetData(), m_pOutBuffer->GetDataLength());
+    size_t writeBytes = 0;
+    tIOHandle hFile = INVALID_IO_HANDLE;
+    off_t offset = 0;
+    size_t fileLength = 0;
+    if (count > 1) {
+        writeBytes = m_pIO->WriteV(ioVec, count);
+    } else if (count == 1) {
+        writeBytes = m_pIO->Write(ioVec[0].iov_base, ioVec[0].iov_len);
+    } else if (m_pSendingRequest &&
+               m_pSendingRequest->GetPayloadFile(&hFile, &offset, &fileLength)) {
+        // The file payload goes after all the data in memory.
+        writeBytes = m_pIO->SendFile(hFile, offset, fileLength);
+    } else {
+        return false;
+    }
     CIOContext::IOStatus writeStatus = m_pIO->GetStatus();
     switch (writeStatus) {
     case CIOContext::IOS_LOCAL_ERROR:
@@ -285,7 +381,13 @@ bool CConnection::SendData()
         break;
     }
     if (writeBytes > 0) {
-        m_pOutBuffer->SetPopOutLength(writeBytes, true);
+        size_t bufferSent = writeBytes < bufferLength ? writeBytes : bufferLength;
+        if (bufferSent > 0) {
+            m_pOutBuffer->SetPopOutLength(bufferSent, true);
+        }
+        if (writeBytes > bufferSent) {
+            m_pSendingRequest->OnPayloadSent(writeBytes - bufferSent);
+        }
         bRes = true;
     }
     return bRes;
@@ -293,12 +395,26 @@ bool CConnection::SendData()
 
 void CConnection::DoReceive()
 {
-    while (m_pIO->IsReadable()) {
+    size_t receivedBytes = 0;
+    size_t receivedCount = 0;
+    while (m_pIO->IsReadable() && !m_bReceiveAborted) {
+        if (receivedBytes >= RECEIVE_BYTES_BUDGET ||
+            receivedCount >= RECEIVE_COUNT_BUDGET) {
+            // Yield to the other connections, continue in the next round.
+            m_Poller.ScheduleReady(this);
+            return;
+        }
+
         size_t freeSize = m_pInBuffer->GetFreeBufferSize();
         if (freeSize == 0) {
+            if (m_pInBuffer->IsPinned()) {
+                ReleaseReferredData();
+            }
             if (m_pInBuffer->GetTotalFreeSize() == 0) {
-                // TODO: Handle the input buffer full.
-                ASSERT(false);
+                // The consumer takes nothing from the full buffer, e.g. the
+                // response header is larger than the buffer.
+                OUTPUT_WARNING_TRACE("Input buffer is full, abort the response.\n");
+                AbortReceive(EC_PROTOCOL_ERROR);
                 return;
             }
             m_pInBuffer->RelocationData();
@@ -321,6 +437,8 @@ void CConnection::DoReceive()
         }
 
         if (dataLength > 0) {
+            receivedBytes += dataLength;
+            ++receivedCount;
             m_pInBuffer->SetPushInLength(dataLength);
             if (m_pInBuffer->GetDataLength() == 0) {
                 break;
@@ -337,6 +455,7 @@ void CConnection::ReceiveData()
     size_t dataLen = m_pInBuffer->GetDataLength();
     ErrorCode error = EC_UNKNOWN;
     CRequest* pReq = reinterpret_cast<CRequest*>(m_WaitingRequests.First());
+    size_t waitingCount = m_WaitingRequests.Count();
 
     do {
         size_t used = 0;
@@ -369,6 +488,9 @@ void CConnection::ReceiveData()
             if (error == EC_INPROGRESS) {
                 continue;
             }
+            if (pReq->IsConnectionClose()) {
+                m_bReusable = false;
+            }
             m_WaitingRequests.PopFront();
             pReq->OnTerminated(error);
             pReq = reinterpret_cast<CRequest*>(m_WaitingRequests.First());
@@ -383,9 +505,76 @@ void CConnection::ReceiveData()
 
     if (error == EC_SUCCESS || error == EC_INPROGRESS) {
         m_pInBuffer->SetPopOutLength(consumed);
+
+        // The response in progress may refer to the consumed data.
+        const uint8_t* pReferred = pReq ? pReq->GetReferredData() : NULL;
+        if (pReferred) {
+            m_pInBuffer->Pin(pReferred);
+        } else {
+            m_pInBuffer->Unpin();
+        }
     } else {
         m_pInBuffer->Reset();
     }
+    if (m_WaitingRequests.Count() < waitingCount) {
+        m_RunContext.OnConnectionAvailable(this);
+    }
+    if (!m_bReusable && !m_bReceiveAborted && m_WaitingRequests.Count() == 0 &&
+        (m_pSendingRequest || m_PendingRequests.Count() > 0)) {
+        // The peer closes the connection after the response, replay the
+        // requests not sent yet on the new IO.
+        m_bReceiveAborted = true;
+        m_Poller.PostAsynTask(ResendRequests, this);
+    }
+    CheckIdle();
+}
+
+void CConnection::AbortReceive(ErrorCode ec)
+{
+    CRequest* pReq = reinterpret_cast<CRequest*>(m_WaitingRequests.First());
+    if (pReq) {
+        m_WaitingRequests.PopFront();
+        pReq->OnTerminated(ec);
+    }
+    m_pInBuffer->Reset();
+
+    // The rest of the response is left in the IO, stop receiving and
+    // replay the other requests on the new IO.
+    m_bReceiveAborted = true;
+    m_Error = ec;
+    m_Poller.PostAsynTask(ResendRequests, this);
+}
+
+void CConnection::ReleaseReferredData()
+{
+    // Only the request receiving its response refers to the data.
+    CRequest* pReq = reinterpret_cast<CRequest*>(m_WaitingRequests.First());
+    if (pReq) {
+        pReq->ReleaseReferredData();
+    }
+    m_pInBuffer->Unpin();
+}
+
+void CConnection::CheckIdle()
+{
+    if (!IsIdle() || m_IdleTimerID != INVALID_TIMER_ID) {
+        return;
+    }
+
+    // The exhausted connection is closed in the next tick,
+    // instead of in the middle of handling its IO.
+    unsigned int timeout = IsExhausted() ? 1 : m_Configure.IdleTimeout();
+    if (timeout > 0) {
+        m_Poller.GetContext()->StartTimer(this, 0, timeout);
+    }
+}
+
+void CConnection::StopIdleTimer()
+{
+    if (m_IdleTimerID != INVALID_TIMER_ID) {
+        m_Poller.GetContext()->StopTimer(m_IdleTimerID);
+        m_IdleTimerID = INVALID_TIMER_ID;
+    }
 }
 
 bool CConnection::ResetIO()
@@ -448,33 +637,33 @@ void CConnection::ResendRequests(void* pConn)
     CConnection* pObject = reinterpret_cast<CConnection*>(pConn);
     ASSERT(pObject);
 
-    if (pObject->m_pSendingRequest) {
-        pObject->m_pSendingRequest->OnReset();
-    }
+    // The requests have been sent (waiting for the response and the sending
+    // one) are replayed ahead of the pending ones, in the original order.
+    CDuplexList::Iterator posIter = pObject->m_PendingRequests.Begin();
     CDuplexList::Iterator iter = pObject->m_WaitingRequests.Begin();
     CDuplexList::Iterator iterEnd = pObject->m_WaitingRequests.End();
     while (iter != iterEnd) {
-        CRequest* pRequest = reinterpret_cast<CRequest*>(
-            pObject->m_WaitingRequests.DataAt(iter));
-        pRequest->OnReset();
-        if (!pObject->m_PendingRequests.PushBack(pRequest)) {
-            pRequest->OnTerminated(pObject->m_Error);
-        }
+        pObject->ReplayRequest(
+            reinterpret_cast<CRequest*>(pObject->m_WaitingRequests.DataAt(iter)),
+            posIter);
         ++iter;
     }
     pObject->m_WaitingRequests.Reset();
-    CRequest* pSendingReq = pObject->m_pSendingRequest;
-    if (pSendingReq) {
-        pSendingReq->OnReset();
-        if (!pObject->m_PendingRequests.PushBack(pSendingReq)) {
-            pSendingReq->OnTerminated(pObject->m_Error);
-        }
+    pObject->m_pInBuffer->Unpin();
+    if (pObject->m_pSendingRequest) {
+        pObject->ReplayRequest(pObject->m_pSendingRequest, posIter);
+        pObject->m_pSendingRequest = NULL;
     }
+    pObject->m_pOutBuffer->Reset();
 
     bool bToClosed = (pObject->m_PendingRequests.Count() == 0);
     if (!bToClosed) {
         ErrorCode error = EC_SUCCESS;
         if (pObject->ResetIO()) {
+            pObject->m_AcceptedCount = pObject->m_PendingRequests.Count();
+            pObject->m_pInBuffer->Reset();
+            pObject->m_bReceiveAborted = false;
+            pObject->m_bReusable = true;
             if (pObject->m_pController) {
                 pObject->m_pController->Reset();
             }
@@ -498,6 +687,21 @@ void CConnection::ResendRequests(void* pConn)
     }
 }
 
+void CConnection::ReplayRequest(CRequest* pReq, CDuplexList::Iterator posIter)
+{
+    // The server may have processed the request, only the idempotent
+    // (pipeline) request is safe to be sent again.
+    if (!pReq->IsPipeline()) {
+        OUTPUT_NOTICE_TRACE("Request %p is not idempotent, not replayed.\n", pReq);
+        pReq->OnTerminated(m_Error);
+        return;
+    }
+    pReq->OnReset();
+    if (!m_PendingRequests.InsertBefore(posIter, pReq)) {
+        pReq->OnTerminated(m_Error);
+    }
+}
+
 void CConnection::ReleaseBuffer(void* pBuf)
 {
     if (pBuf) {
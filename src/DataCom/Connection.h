@@ -14,18 +14,21 @@
 #include "Common/ErrorNo.h"
 #include "Memory/MemoryPool.h"
 #include "Request.h"
+#include "Configure.h"
 #include "IO/IOContext.h"
 #include "IO/Poller.h"
 #include "IO/PollClient.h"
+#include "Thread/TimerManager.h"
 #include "Tracker/Trace.h"
 #include <sys/socket.h>
 
 class CConnectionRunner;
-class CConfigure;
 class CController;
 class CRequest;
 class COctetBuffer;
-class CConnection : public CPollClient
+class CConnection :
+    public CPollClient,
+    public ITimerContext
 {
 public:
     ~CConnection();
@@ -37,21 +40,62 @@ public:
     void OnOutgoingReady();
     void OnPeerClosed();
 
+    // From ITimerContext
+    void OnTimeout(tTimerID timerID);
+    void OnTimeCreated(int sessionID, tTimerID timerID);
+
     bool ActivateSecure();
     bool TryPopRequest(CRequest* pReq);
 
-    bool PushRequest(CRequest* pReq)
+    /**
+     * @warning Only called in the loop of the poller.
+     */
+    bool PushRequest(CRequest* pReq) { return AcceptRequest(pReq, false); }
+    bool PushInstantRequest(CRequest* pReq) { return AcceptRequest(pReq, true); }
+
+    /**
+     * @brief Check if the request can be sent at once, without waiting
+     *        behind the other requests to send.
+     */
+    bool IsAvailable(CRequest* pReq)
     {
-        return m_PendingRequests.PushBack(pReq);
+        return !IsExhausted() &&
+               m_pSendingRequest == NULL &&
+               m_PendingRequests.Count() == 0 &&
+               CanPipeline(pReq);
+    }
+
+    // The count of the requests waiting for the response.
+    size_t Load() const { return m_WaitingRequests.Count(); }
+
+    bool IsIdle() const
+    {
+        return m_PendingRequests.Count() == 0 &&
+               m_WaitingRequests.Count() == 0 &&
+               m_pSendingRequest == NULL;
     }
 
-    bool PushInstantRequest(CRequest* pReq)
+    /**
+     * @brief If the connection has taken the max requests of the configure,
+     *        or the peer closes it after a response, the later requests to
+     *        the peer go to a new connection.
+     */
+    bool IsExhausted() const
     {
-        return m_PendingRequests.PushFront(pReq);
+        return !m_bReusable ||
+               (m_Configure.MaxRequests() > 0 &&
+                m_AcceptedCount >= m_Configure.MaxRequests());
     }
 
     const sockaddr* GetPeerAddress() const { return &m_PeerAddress; }
 
+    // The budget of one connection in one round of the poller.
+    static const size_t RECEIVE_BYTES_BUDGET = 64 * 1024;
+    static const size_t RECEIVE_COUNT_BUDGET = 16;
+
+    // The output buffer and the payload blocks of the request in one write.
+    static const size_t SEND_IOVEC_COUNT = 8;
+
     static CConnection* CreateInstance(
         CConnectionRunner& runContext,
         CPoller& poller,
@@ -62,28 +106,29 @@ private:
     CConnection(
         CConnectionRunner& runContext,
         CPoller& poller,
+        CConfigure& configure,
         CIOContext* pIO,
         CController* pController,
         const sockaddr* pAddr);
     
+    bool AcceptRequest(CRequest* pReq, bool bFront);
     CRequest* PrepareSendRequest();
+    bool CanPipeline(CRequest* pReq);
+    void ReplayRequest(CRequest* pReq, CDuplexList::Iterator posIter);
+    void CheckIdle();
+    void StopIdleTimer();
 
     void DoSend();
     bool SendData();
     void DoReceive();
     void ReceiveData();
+    void ReleaseReferredData();
+    void AbortReceive(ErrorCode ec);
 
     bool ResetIO();
     void Terminate(ErrorCode ec);
     void HandleLocalError(int err = 0);
 
-    bool IsIdle() const
-    {
-        return m_PendingRequests.Count() == 0 &&
-               m_WaitingRequests.Count() == 0 &&
-               m_pSendingRequest == NULL;
-    }
-
     static void ResendRequests(void* pConn);
     static void ReleaseBuffer(void* pBuf);
 
@@ -97,8 +142,13 @@ private:
     CController* m_pIdleController; // Owned
     CConnectionRunner& m_RunContext;
     CPoller& m_Poller;
+    CConfigure& m_Configure;
+    size_t m_AcceptedCount;     // The requests taken since the IO is opened.
+    tTimerID m_IdleTimerID;
     ErrorCode m_Error;
     sockaddr m_PeerAddress;
+    bool m_bReceiveAborted;     // Wait for ResendRequests to reset the IO.
+    bool m_bReusable;           // false after a response closing the connection.
 
     COctetBuffer* m_pInBuffer;      // Buffer for input (receive), owned
     COctetBuffer* m_pOutBuffer;     // Buffer for output (send), owned
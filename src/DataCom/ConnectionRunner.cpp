@@ -9,147 +9,357 @@
 #include "ConnectionRunner.h"
 #include "Request.h"
 #include "Thread/Looper.h"
+#include "Common/Arch.h"
 #include "Tracker/Trace.h"
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
 
-CConnectionRunner::CConnectionRunner() :
-    m_Connections(),
-    m_pPoller(NULL),
-    m_pLoop(NULL)
+using std::malloc;
+using std::free;
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// CConnectionRunner Implemenation
+//
+///////////////////////////////////////////////////////////////////////////////
+CConnectionRunner::CConnectionRunner(
+    CShard** pShards, size_t count, size_t maxConnections) :
+    m_pShards(pShards),
+    m_ShardCount(count),
+    m_MaxConnections(maxConnections),
+    m_ConnectionCount(0),
+    m_bReclaiming(0)
 {
+    ASSERT(pShards);
+    ASSERT(count > 0);
 }
 
 CConnectionRunner::~CConnectionRunner()
 {
-    delete m_pPoller;
-    delete m_pLoop;
+    for (size_t i = 0; i < m_ShardCount; ++i) {
+        delete m_pShards[i];
+    }
+    free(m_pShards);
 }
 
-CConnectionRunner* CConnectionRunner::CreateInstance(const char* pName)
+CConnectionRunner* CConnectionRunner::CreateInstance(
+    const char* pName,
+    size_t shardCount /* = 1 */,
+    bool bPinned /* = false */,
+    CPollBackend::Type backend /* = CPollBackend::PB_EPOLL */,
+    size_t maxConnections /* = 0 */)
 {
     ASSERT(pName);
 
-    CConnectionRunner* pInstance = new CConnectionRunner();
-    if (pInstance) {
-        CPoller* pPoller = CPoller::CreateInstance(pInstance);
-        if (pPoller) {
-            pInstance->m_pLoop = CLooper::CreateInstance(pName, *pPoller, *pPoller);
-            pInstance->m_pPoller = pPoller;
-        }
-        if (pInstance->m_pLoop == NULL) {
+    long cpuCount = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpuCount <= 0) {
+        cpuCount = 1;
+    }
+    if (shardCount == 0) {
+        shardCount = cpuCount;
+    }
+
+    CShard** pShards = reinterpret_cast<CShard**>(malloc(sizeof(CShard*) * shardCount));
+    if (pShards == NULL) {
+        return NULL;
+    }
+    memset(pShards, 0, sizeof(CShard*) * shardCount);
+
+    CConnectionRunner* pInstance = new CConnectionRunner(pShards, shardCount, maxConnections);
+    if (pInstance == NULL) {
+        free(pShards);
+        return NULL;
+    }
+    for (size_t i = 0; i < shardCount; ++i) {
+        pShards[i] = new CShard(*pInstance);
+        if (pShards[i] == NULL ||
+            !pShards[i]->Initialize(pName, i, bPinned ? i % cpuCount : -1, backend)) {
+            OUTPUT_ERROR_TRACE("Create shard %lu of %s failed.\n", static_cast<unsigned long>(i), pName);
             delete pInstance;
-            pInstance = NULL;
+            return NULL;
         }
     }
     return pInstance;
 }
 
-void CConnectionRunner::OnMessage(void* pMsg)
+bool CConnectionRunner::AddConnection(CConnection* pConn)
+{
+    ASSERT(pConn);
+
+    return ShardOf(pConn->GetPeerAddress())->AddConnection(pConn);
+}
+
+bool CConnectionRunner::RemoveConnection(CConnection* pConn)
+{
+    ASSERT(pConn);
+
+    return ShardOf(pConn->GetPeerAddress())->RemoveConnection(pConn);
+}
+
+bool CConnectionRunner::PushRequest(CRequest* pReq, const sockaddr* pTarget)
+{
+    ASSERT(pReq);
+    ASSERT(pTarget);
+
+    return ShardOf(pTarget)->PushRequest(pReq, pTarget);
+}
+
+bool CConnectionRunner::SetPeerWeight(const sockaddr* pTarget, unsigned int weight)
+{
+    ASSERT(pTarget);
+
+    return ShardOf(pTarget)->SetPeerWeight(pTarget, weight);
+}
+
+void CConnectionRunner::OnConnectionAvailable(CConnection* pConn)
+{
+    ASSERT(pConn);
+
+    ShardOf(pConn->GetPeerAddress())->OnConnectionAvailable(pConn);
+}
+
+bool CConnectionRunner::AcquireConnectionSlot()
+{
+    if (m_MaxConnections == 0) {
+        AtomicInc(&m_ConnectionCount);
+        return true;
+    }
+
+    int32_t count = m_ConnectionCount;
+    while (count < static_cast<int32_t>(m_MaxConnections)) {
+        if (AtomicCAS(&m_ConnectionCount, count, count + 1)) {
+            return true;
+        }
+        count = m_ConnectionCount;
+    }
+    return false;
+}
+
+void CConnectionRunner::ReleaseConnectionSlot()
+{
+    int32_t count = AtomicDec(&m_ConnectionCount);
+    ASSERT(count >= 0);
+    (void) count;
+
+    // The shards blocked by the limit try again.
+    if (m_MaxConnections > 0) {
+        for (size_t i = 0; i < m_ShardCount; ++i) {
+            m_pShards[i]->Wakeup();
+        }
+    }
+}
+
+void CConnectionRunner::ReclaimIdleConnection(const sockaddr* pPeer)
+{
+    ASSERT(pPeer);
+
+    if (m_ShardCount == 1 || !AtomicCAS(&m_bReclaiming, 0, 1)) {
+        return;
+    }
+    size_t issuer = ShardIndexOf(pPeer);
+    if (!m_pShards[(issuer + 1) % m_ShardCount]->ReclaimIdle(issuer)) {
+        EndReclaim();
+    }
+}
+
+bool CConnectionRunner::IsCapped() const
+{
+    for (size_t i = 0; i < m_ShardCount; ++i) {
+        if (m_pShards[i]->IsCapped()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t CConnectionRunner::ShardIndexOf(const sockaddr* pAddr) const
+{
+    ASSERT(pAddr);
+
+    if (m_ShardCount == 1) {
+        return 0;
+    }
+
+    // FNV-1a, the whole address is the key of the connection map as well.
+    const uint8_t* pData = reinterpret_cast<const uint8_t*>(pAddr);
+    uint32_t hash = 2166136261U;
+    for (size_t i = 0; i < sizeof(sockaddr); ++i) {
+        hash = (hash ^ pData[i]) * 16777619U;
+    }
+    return hash % m_ShardCount;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// CConnectionRunner::CShard Implemenation
+//
+///////////////////////////////////////////////////////////////////////////////
+CConnectionRunner::CShard::CShard(CConnectionRunner& runner) :
+    m_Runner(runner),
+    m_pScheduler(NULL),
+    m_pPoller(NULL),
+    m_pLoop(NULL),
+    m_Index(0)
+{
+    m_Name[0] = '\0';
+}
+
+CConnectionRunner::CShard::~CShard()
+{
+    // Stop the loop before deleting the objects it runs on.
+    if (m_pLoop) {
+        m_pLoop->Exit();
+        delete m_pLoop;
+    }
+    delete m_pScheduler;
+    delete m_pPoller;
+}
+
+bool CConnectionRunner::CShard::Initialize(
+    const char* pName, size_t index, int cpu, CPollBackend::Type backend)
+{
+    int len = snprintf(m_Name, sizeof(m_Name), "%s-%lu", pName, index);
+    ASSERT(len > 0);
+    (void) len;
+    m_Index = index;
+
+    m_pPoller = CPoller::CreateInstance(this, backend);
+    if (m_pPoller == NULL) {
+        return false;
+    }
+    m_pScheduler = new CRequestScheduler(m_Runner, *m_pPoller);
+    if (m_pScheduler == NULL) {
+        return false;
+    }
+    m_pLoop = CLooper::CreateInstance(
+        m_Name, *m_pPoller, *m_pPoller, CPoller::MSG_BATCH_SIZE);
+    if (m_pLoop == NULL) {
+        return false;
+    }
+    if (cpu >= 0 && !m_pLoop->SetAffinity(cpu)) {
+        OUTPUT_WARNING_TRACE("%s is not pinned to CPU %d.\n", m_Name, cpu);
+    }
+    return true;
+}
+
+void CConnectionRunner::CShard::OnMessage(void* pMsg)
 {
     ASSERT(pMsg);
 
     Command* pCmd = reinterpret_cast<Command*>(pMsg);
-    ASSERT(pCmd && pCmd->pData);
+    ASSERT(pCmd && (pCmd->pData ||
+                    pCmd->ID == CID_SET_PEER_WEIGHT || pCmd->ID == CID_RECLAIM_IDLE));
 
     switch (pCmd->ID) {
     case CID_ADD_CONNECTION:
-        DoAddConnection(reinterpret_cast<CConnection*>(pCmd->pData));
+        m_pScheduler->AddConnection(reinterpret_cast<CConnection*>(pCmd->pData));
         break;
     case CID_REMOVE_CONNECTION:
-        DoRemoveConnection(reinterpret_cast<CConnection*>(pCmd->pData));
+        m_pScheduler->RemoveConnection(reinterpret_cast<CConnection*>(pCmd->pData));
         break;
     case CID_PUSH_REQUEST:
-        DoPushRequest(
+        m_pScheduler->PushRequest(
             reinterpret_cast<CRequest*>(pCmd->pData),
             reinterpret_cast<sockaddr*>(pCmd->DataAddress));
         break;
+    case CID_SET_PEER_WEIGHT:
+        m_pScheduler->SetWeight(
+            reinterpret_cast<sockaddr*>(pCmd->DataAddress), pCmd->Value);
+        break;
+    case CID_RECLAIM_IDLE:
+        ReclaimIdle(pCmd->Value);
+        break;
     default:
         ASSERT(false, "Unknown Message: %d\n", pCmd->ID);
         break;
     }
 }
 
-bool CConnectionRunner::AddConnection(CConnection* pConn)
+bool CConnectionRunner::CShard::AddConnection(CConnection* pConn)
 {
-    ASSERT(pConn);
-
     if (m_pLoop->IsInLoop()) {
-        DoAddConnection(pConn);
-        return true;
+        return m_pScheduler->AddConnection(pConn);
     }
 
     Command cmd;
     cmd.ID = CID_ADD_CONNECTION;
     cmd.pData = pConn;
+    cmd.Value = 0;
     return m_pPoller->SendExtCommand(&cmd, sizeof(cmd));
 }
 
-bool CConnectionRunner::PushRequest(CRequest* pReq, const sockaddr* pTarget)
+bool CConnectionRunner::CShard::PushRequest(CRequest* pReq, const sockaddr* pTarget)
 {
-    ASSERT(pReq);
-    ASSERT(pTarget);
-
     if (m_pLoop->IsInLoop()) {
-        return DoPushRequest(pReq, pTarget);
+        return m_pScheduler->PushRequest(pReq, pTarget);
     }
 
     uint8_t cmdBuffer[sizeof(Command) + sizeof(sockaddr)];
     Command* pCmd = reinterpret_cast<Command*>(cmdBuffer);
     pCmd->ID = CID_PUSH_REQUEST;
     pCmd->pData = pReq;
+    pCmd->Value = 0;
     memcpy(pCmd->DataAddress, pTarget, sizeof(sockaddr));
     return m_pPoller->SendExtCommand(pCmd, sizeof(cmdBuffer));
 }
 
-bool CConnectionRunner::RemoveConnection(CConnection* pConn)
+bool CConnectionRunner::CShard::SetPeerWeight(const sockaddr* pTarget, unsigned int weight)
 {
-    ASSERT(pConn);
+    if (m_pLoop->IsInLoop()) {
+        m_pScheduler->SetWeight(pTarget, weight);
+        return true;
+    }
 
+    uint8_t cmdBuffer[sizeof(Command) + sizeof(sockaddr)];
+    Command* pCmd = reinterpret_cast<Command*>(cmdBuffer);
+    pCmd->ID = CID_SET_PEER_WEIGHT;
+    pCmd->pData = NULL;
+    pCmd->Value = weight;
+    memcpy(pCmd->DataAddress, pTarget, sizeof(sockaddr));
+    return m_pPoller->SendExtCommand(pCmd, sizeof(cmdBuffer));
+}
+
+bool CConnectionRunner::CShard::RemoveConnection(CConnection* pConn)
+{
     if (m_pLoop->IsInLoop()) {
-        DoRemoveConnection(pConn);
+        m_pScheduler->RemoveConnection(pConn);
         return true;
     }
 
     Command cmd;
     cmd.ID = CID_REMOVE_CONNECTION;
     cmd.pData = pConn;
+    cmd.Value = 0;
     return m_pPoller->SendExtCommand(&cmd, sizeof(cmd));
 }
 
-void CConnectionRunner::DoRemoveConnection(CConnection* pConn)
+void CConnectionRunner::CShard::OnConnectionAvailable(CConnection* pConn)
 {
-    CPointer address(pConn->GetPeerAddress(), sizeof(sockaddr));
-    map<CPointer, CConnection*>::iterator iter = m_Connections.find(address);
-    if (iter != m_Connections.end()) {
-        m_Connections.erase(iter);
-        delete pConn;
-    } else {
-        ASSERT(false);
-    }
+    ASSERT(m_pLoop->IsInLoop());
+
+    m_pScheduler->OnConnectionAvailable(pConn);
 }
 
-bool CConnectionRunner::DoPushRequest(CRequest* pReq, const sockaddr* pTarget)
+bool CConnectionRunner::CShard::ReclaimIdle(size_t issuer)
 {
-    CConnection* pConn = FindConnection(pTarget);
-    if (pConn == NULL) {
-        pConn = CConnection::CreateInstance(*this, *m_pPoller, pReq, pTarget);
-        if (pConn) {
-            if (!DoAddConnection(pConn)) {
-                delete pConn;   // pIO has been transferred ownership
-                pConn = NULL;
-            }
-        }
+    if (!m_pLoop->IsInLoop()) {
+        Command cmd;
+        cmd.ID = CID_RECLAIM_IDLE;
+        cmd.pData = NULL;
+        cmd.Value = static_cast<unsigned int>(issuer);
+        return m_pPoller->SendExtCommand(&cmd, sizeof(cmd));
     }
 
-    return pConn ? pConn->PushRequest(pReq) : false;
-}
-
-CConnection* CConnectionRunner::FindConnection(const sockaddr* pTarget)
-{
-    CConnection* pConnection = NULL;
-    CPointer address(pTarget, sizeof(sockaddr));
-    map<CPointer, CConnection*>::iterator iter = m_Connections.find(address);
-    if (iter != m_Connections.end()) {
-        pConnection = iter->second;
+    // The slot released meanwhile has woken the issuer up.
+    if (!m_Runner.IsCapped() || m_pScheduler->ReclaimIdleConnection()) {
+        m_Runner.EndReclaim();
+        return true;
+    }
+    size_t next = (m_Index + 1) % m_Runner.ShardCount();
+    if (next == issuer || !m_Runner.m_pShards[next]->ReclaimIdle(issuer)) {
+        m_Runner.EndReclaim();
     }
-    return pConnection;
+    return true;
 }
@@ -10,26 +10,29 @@
 #define __DATA_COM_CONNNECTION_RUNNER_H__
 
 #include "Common/Typedefs.h"
-#include "Common/Pointer.h"
 #include "IO/Poller.h"
 #include "Connection.h"
-#include <utility>
-#include <map>
+#include "RequestScheduler.h"
 #include <sys/socket.h>
 
-using std::pair;
-using std::map;
-
 class CLooper;
 class CRequest;
-class CConnectionRunner : public CPoller::IExtCmdHandler
+
+/**
+ * @brief Run the connections on one or more pollers (shards).
+ *
+ * Every shard has its own poller thread and request scheduler, the
+ * connection is assigned to the shard by the hash of its peer address,
+ * so the connections of a peer are always handled in the same thread.
+ * The shard capped by the connection limit asks the other shards in turn
+ * to close one of their idle connections, and the shards close their
+ * connections once idle while a shard is capped.
+ */
+class CConnectionRunner
 {
 public:
     ~CConnectionRunner();
 
-    // From CPoller::IExtCmdHandler
-    void OnMessage(void* pMsg);
-
     bool AddConnection(CConnection* pConn);
     bool RemoveConnection(CConnection* pConn);
 
@@ -41,40 +44,121 @@ public:
      */
     bool PushRequest(CRequest* pReq, const sockaddr* pTarget);
 
-    static CConnectionRunner* CreateInstance(const char* pName);
+    /**
+     * @brief Set the weight of the peer in the fair queuing of the requests,
+     *        the default weight is CRequestScheduler::DEFAULT_WEIGHT.
+     */
+    bool SetPeerWeight(const sockaddr* pTarget, unsigned int weight);
 
-private:
-    CConnectionRunner();
+    /**
+     * @brief The connection can take more requests, only called in the loop.
+     */
+    void OnConnectionAvailable(CConnection* pConn);
 
-    bool DoAddConnection(CConnection* pConn)
-    {
-        CPointer address(pConn->GetPeerAddress(), sizeof(sockaddr));
-        pair<map<CPointer, CConnection*>::iterator, bool> res = 
-            m_Connections.insert(map<CPointer, CConnection*>::value_type(address, pConn));
-        return res.second;
-    }
+    /**
+     * @brief Count the connection in the limit of the runner.
+     * @return false if the limit is reached.
+     */
+    bool AcquireConnectionSlot();
+    void ReleaseConnectionSlot();
 
-    void DoRemoveConnection(CConnection* pConn);
-    bool DoPushRequest(CRequest* pReq, const sockaddr* pTarget);
-    CConnection* FindConnection(const sockaddr* pTarget);
+    /**
+     * @brief Ask the other shards than the one of the peer to close an
+     *        idle connection, only one request is in progress at a time.
+     */
+    void ReclaimIdleConnection(const sockaddr* pPeer);
+
+    // Some shard is blocked by the limit, can be called in any thread.
+    bool IsCapped() const;
+
+    // The shard which the connections of the peer are assigned to.
+    size_t ShardIndexOf(const sockaddr* pAddr) const;
+
+    size_t ShardCount() const { return m_ShardCount; }
+    size_t ConnectionCount() const { return m_ConnectionCount; }
+
+    /**
+     * @param shardCount The count of the pollers, the CPU count if it is 0.
+     * @param bPinned Pin the poller thread of shard i to CPU (i % CPU count).
+     * @param backend The poll mechanism of the pollers.
+     * @param maxConnections The max count of the connections of all the
+     *        shards, 0 if unlimited.
+     */
+    static CConnectionRunner* CreateInstance(
+        const char* pName,
+        size_t shardCount = 1,
+        bool bPinned = false,
+        CPollBackend::Type backend = CPollBackend::PB_EPOLL,
+        size_t maxConnections = 0);
 
 private:
-    enum CmdID {
-        CID_ADD_CONNECTION = 0,
-        CID_REMOVE_CONNECTION,
-        CID_PUSH_REQUEST,
+    class CShard : public CPoller::IExtCmdHandler
+    {
+    public:
+        CShard(CConnectionRunner& runner);
+        ~CShard();
+
+        // From CPoller::IExtCmdHandler
+        void OnMessage(void* pMsg);
+
+        bool Initialize(
+            const char* pName, size_t index, int cpu, CPollBackend::Type backend);
+
+        bool AddConnection(CConnection* pConn);
+        bool RemoveConnection(CConnection* pConn);
+        bool PushRequest(CRequest* pReq, const sockaddr* pTarget);
+        bool SetPeerWeight(const sockaddr* pTarget, unsigned int weight);
+        void OnConnectionAvailable(CConnection* pConn);
+        void Wakeup() { m_pScheduler->Wakeup(); }
+        bool IsCapped() const { return m_pScheduler->IsCapped(); }
+
+        /**
+         * @brief Close an idle connection, or pass the request to the next
+         *        shard until it is back to the shard which issued it.
+         */
+        bool ReclaimIdle(size_t issuer);
+
+    private:
+        enum CmdID {
+            CID_ADD_CONNECTION = 0,
+            CID_REMOVE_CONNECTION,
+            CID_PUSH_REQUEST,
+            CID_SET_PEER_WEIGHT,
+            CID_RECLAIM_IDLE,
+        };
+
+        struct Command {
+            CmdID ID;
+            void* pData;
+            unsigned int Value;
+            sockaddr DataAddress[0];
+        };
+
+        CConnectionRunner& m_Runner;
+        CRequestScheduler* m_pScheduler;    // Owned, only accessed in the loop
+        CPoller* m_pPoller; // Owned
+        CLooper* m_pLoop;   // Owned
+        size_t m_Index;
+        char m_Name[32];
+
+        DISALLOW_DEFAULT_CONSTRUCTOR(CShard);
+        DISALLOW_COPY_CONSTRUCTOR(CShard);
+        DISALLOW_ASSIGN_OPERATOR(CShard);
     };
 
-    struct Command {
-        CmdID ID;
-        void* pData;
-        sockaddr DataAddress[0];
-    };
+    CConnectionRunner(CShard** pShards, size_t count, size_t maxConnections);
+
+    CShard* ShardOf(const sockaddr* pAddr) { return m_pShards[ShardIndexOf(pAddr)]; }
+    void EndReclaim() { m_bReclaiming = 0; }
 
-    map<CPointer, CConnection*> m_Connections;
-    CPoller* m_pPoller; // Owned
-    CLooper* m_pLoop;   // Owned
+private:
+    CShard** m_pShards; // Owned
+    const size_t m_ShardCount;
+    const size_t m_MaxConnections;
+    volatile int32_t m_ConnectionCount;
+    volatile int32_t m_bReclaiming;     // The reclaim request goes round the shards.
 
+    DISALLOW_DEFAULT_CONSTRUCTOR(CConnectionRunner);
     DISALLOW_COPY_CONSTRUCTOR(CConnectionRunner);
     DISALLOW_ASSIGN_OPERATOR(CConnectionRunner);
 };
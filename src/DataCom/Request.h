@@ -12,10 +12,12 @@
 #include "Common/Typedefs.h"
 #include "Common/ErrorNo.h"
 #include "Common/Macros.h"
+#include <sys/types.h>
 
 class CConfigure;
 class CIOContext;
 struct sockaddr;
+struct iovec;
 
 class CRequest
 {
@@ -28,12 +30,66 @@ public:
     virtual void OnTerminated(ErrorCode err) = 0;
     virtual void OnReset() = 0;
 
+    /**
+     * @brief Get the payload blocks which are sent after the serialized
+     *        data directly, without copying them into the output buffer.
+     * @return The count of the filled blocks, 0 if there is none.
+     */
+    virtual size_t GetPayloadIOVec(struct iovec* pIOVec, size_t count) { return 0; }
+
+    /**
+     * @brief Get the file region of the payload, which is sent by the
+     *        kernel after the serialized data and the payload blocks.
+     * @return false if there is none.
+     */
+    virtual bool GetPayloadFile(tIOHandle* pFile, off_t* pOffset, size_t* pLen)
+    {
+        return false;
+    }
+
+    /**
+     * @brief The leading bytes of the payload blocks or file region are sent.
+     */
+    virtual void OnPayloadSent(size_t len) {}
+
+    /**
+     * @brief Get the start of the consumed response data which the request
+     *        still refers to, the connection keeps the data from there in
+     *        place until it returns NULL.
+     */
+    virtual const uint8_t* GetReferredData() const { return NULL; }
+
+    /**
+     * @brief The connection is going to move the received data, copy the
+     *        part which is still referred to.
+     */
+    virtual void ReleaseReferredData() {}
+
     virtual CIOContext* CreateIOContext(const sockaddr* pTarget) = 0;
     virtual CConfigure& GetConfigure() = 0;
 
     bool HasResponse() const { return TEST_FLAG(m_Flags, HAS_RESPONSE_FLAG); }
     bool IsPipeline() const { return TEST_FLAG(m_Flags, SUPPORT_PIPE_LINE_FLAG); }
 
+    /**
+     * @brief The response closes the connection (e.g. "Connection: close"),
+     *        no more request is sent on the connection.
+     */
+    bool IsConnectionClose() const { return TEST_FLAG(m_Flags, CONNECTION_CLOSE_FLAG); }
+
+    /**
+     * @brief The urgent request is scheduled ahead of the others.
+     */
+    bool IsUrgent() const { return TEST_FLAG(m_Flags, URGENT_FLAG); }
+    void SetUrgent(bool bUrgent)
+    {
+        if (bUrgent) {
+            SET_FLAG(m_Flags, URGENT_FLAG);
+        } else {
+            CLEAR_FLAG(m_Flags, URGENT_FLAG);
+        }
+    }
+
 protected:
     CRequest(bool bHasResp, bool bPipeline) : m_Flags(0)
     {
@@ -45,11 +101,22 @@ protected:
         }
     }
 
+    void SetConnectionClose(bool bClose)
+    {
+        if (bClose) {
+            SET_FLAG(m_Flags, CONNECTION_CLOSE_FLAG);
+        } else {
+            CLEAR_FLAG(m_Flags, CONNECTION_CLOSE_FLAG);
+        }
+    }
+
 private:
     uint8_t m_Flags;
 
     static const uint8_t HAS_RESPONSE_FLAG = 0x01;
     static const uint8_t SUPPORT_PIPE_LINE_FLAG = 0x02;
+    static const uint8_t URGENT_FLAG = 0x04;
+    static const uint8_t CONNECTION_CLOSE_FLAG = 0x08;
 
     DISALLOW_COPY_CONSTRUCTOR(CRequest);
     DISALLOW_ASSIGN_OPERATOR(CRequest);
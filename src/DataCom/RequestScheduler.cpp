@@ -0,0 +1,353 @@
+/*
+ * See the file LICENSE for redistribution information.
+ *
+ * Copyright (c) 2015-2018, Yuan Qin <yuanqin2000 at outlook dot com>
+ * All rights reserved.
+ *
+ */
+
+#include "RequestScheduler.h"
+#include "Connection.h"
+#include "ConnectionRunner.h"
+#include "Configure.h"
+#include "Request.h"
+#include "IO/Poller.h"
+#include "Common/Arch.h"
+#include "Tracker/Trace.h"
+#include <cstring>
+
+using std::memcpy;
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// CRequestScheduler::Origin Implemenation
+//
+///////////////////////////////////////////////////////////////////////////////
+CRequestScheduler::Origin::Origin(const sockaddr* pAddr, CMemory* pAllocator) :
+    Address(),
+    Connections(),
+    Requests(pAllocator),
+    Weight(DEFAULT_WEIGHT),
+    Tag(0)
+{
+    memcpy(&Address, pAddr, sizeof(Address));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// CRequestScheduler Implemenation
+//
+///////////////////////////////////////////////////////////////////////////////
+CRequestScheduler::CRequestScheduler(CConnectionRunner& runner, CPoller& poller) :
+    m_Runner(runner),
+    m_Poller(poller),
+    m_MemPool(CDuplexList::ListNodeSize()),
+    m_Origins(),
+    m_Backlog(),
+    m_VirtualTime(0),
+    m_QueuedCount(0),
+    m_bSchedulePosted(false),
+    m_bCapped(0)
+{
+#ifdef __MEMORY_STATS__
+    m_MemPool.EnableStats("RequestScheduler");
+#endif
+}
+
+CRequestScheduler::~CRequestScheduler()
+{
+    map<CPointer, Origin*>::iterator iter = m_Origins.begin();
+    map<CPointer, Origin*>::iterator iterEnd = m_Origins.end();
+    while (iter != iterEnd) {
+        delete iter->second;
+        ++iter;
+    }
+}
+
+bool CRequestScheduler::AddConnection(CConnection* pConn)
+{
+    if (!m_Runner.AcquireConnectionSlot()) {
+        OUTPUT_WARNING_TRACE("Connection limit is reached, %p is not added.\n", pConn);
+        return false;
+    }
+    Origin* pOrigin = GetOrigin(pConn->GetPeerAddress());
+    if (pOrigin == NULL) {
+        m_Runner.ReleaseConnectionSlot();
+        return false;
+    }
+    pOrigin->Connections.push_back(pConn);
+    return true;
+}
+
+void CRequestScheduler::RemoveConnection(CConnection* pConn)
+{
+    Origin* pOrigin = FindOrigin(pConn->GetPeerAddress());
+    ASSERT(pOrigin);
+    if (pOrigin == NULL) {
+        return;
+    }
+
+    vector<CConnection*>::iterator iter = pOrigin->Connections.begin();
+    vector<CConnection*>::iterator iterEnd = pOrigin->Connections.end();
+    while (iter != iterEnd && *iter != pConn) {
+        ++iter;
+    }
+    ASSERT(iter != iterEnd);
+    if (iter == iterEnd) {
+        return;
+    }
+    pOrigin->Connections.erase(iter);
+    delete pConn;
+    ReleaseOrigin(pOrigin);
+
+    // The slot is given to the other origins, or a new connection to this one.
+    m_Runner.ReleaseConnectionSlot();
+    if (m_QueuedCount > 0) {
+        PostSchedule();
+    }
+}
+
+bool CRequestScheduler::PushRequest(CRequest* pReq, const sockaddr* pTarget)
+{
+    Origin* pOrigin = GetOrigin(pTarget);
+    if (pOrigin == NULL) {
+        return false;
+    }
+
+    bool bBacklogged = pOrigin->Requests.Count() > 0;
+    bool bRes = pReq->IsUrgent() ?
+        pOrigin->Requests.PushFront(pReq) : pOrigin->Requests.PushBack(pReq);
+    if (!bRes) {
+        ReleaseOrigin(pOrigin);
+        return false;
+    }
+    ++m_QueuedCount;
+    if (!bBacklogged) {
+        // The idle origin does not accumulate credits.
+        if (pOrigin->Tag < m_VirtualTime) {
+            pOrigin->Tag = m_VirtualTime;
+        }
+        m_Backlog.insert(BacklogKey(pOrigin->Tag, pOrigin));
+    }
+
+    // Dispatch in the task, the request may be pushed in the callback of
+    // the connection which is handling its IO.
+    PostSchedule();
+    return true;
+}
+
+void CRequestScheduler::SetWeight(const sockaddr* pTarget, unsigned int weight)
+{
+    Origin* pOrigin = GetOrigin(pTarget);
+    if (pOrigin) {
+        pOrigin->Weight = weight > 0 ? weight : DEFAULT_WEIGHT;
+        ReleaseOrigin(pOrigin);
+    }
+}
+
+void CRequestScheduler::OnConnectionAvailable(CConnection* pConn)
+{
+    if (m_QueuedCount > 0) {
+        PostSchedule();
+    } else if (m_Runner.IsCapped()) {
+        // Give the slot of the idle connection to the capped shard,
+        // out of the callback of the connection.
+        m_Poller.PostAsynTask(ReclaimTask, this);
+    }
+}
+
+void CRequestScheduler::Wakeup()
+{
+    if (AtomicCAS(&m_bCapped, 1, 0)) {
+        m_Poller.PostAsynTask(ScheduleTask, this);
+    }
+}
+
+CRequestScheduler::Origin* CRequestScheduler::FindOrigin(const sockaddr* pTarget)
+{
+    Origin* pOrigin = NULL;
+    CPointer address(pTarget, sizeof(sockaddr));
+    map<CPointer, Origin*>::iterator iter = m_Origins.find(address);
+    if (iter != m_Origins.end()) {
+        pOrigin = iter->second;
+    }
+    return pOrigin;
+}
+
+CRequestScheduler::Origin* CRequestScheduler::GetOrigin(const sockaddr* pTarget)
+{
+    Origin* pOrigin = FindOrigin(pTarget);
+    if (pOrigin == NULL) {
+        pOrigin = new Origin(pTarget, &m_MemPool);
+        if (pOrigin) {
+            CPointer address(&pOrigin->Address, sizeof(sockaddr));
+            m_Origins.insert(map<CPointer, Origin*>::value_type(address, pOrigin));
+        }
+    }
+    return pOrigin;
+}
+
+void CRequestScheduler::ReleaseOrigin(Origin* pOrigin)
+{
+    if (pOrigin->IsUnused()) {
+        m_Origins.erase(CPointer(&pOrigin->Address, sizeof(sockaddr)));
+        delete pOrigin;
+    }
+}
+
+void CRequestScheduler::Schedule()
+{
+    // Serve the urgent requests first, then the others, in the order of
+    // the virtual start time, until no request can be dispatched.
+    while (!m_Backlog.empty()) {
+        if (!DispatchNext(true) && !DispatchNext(false)) {
+            break;
+        }
+    }
+    if (m_Backlog.empty()) {
+        AtomicCAS(&m_bCapped, 1, 0);
+    }
+}
+
+bool CRequestScheduler::DispatchNext(bool bUrgentOnly)
+{
+    set<BacklogKey>::iterator iter = m_Backlog.begin();
+    set<BacklogKey>::iterator iterEnd = m_Backlog.end();
+    while (iter != iterEnd) {
+        Origin* pOrigin = iter->second;
+        CRequest* pReq = reinterpret_cast<CRequest*>(pOrigin->Requests.First());
+        ASSERT(pReq);
+        if (bUrgentOnly && !pReq->IsUrgent()) {
+            ++iter;
+            continue;
+        }
+
+        bool bFailed = false;
+        CConnection* pConn = SelectConnection(pOrigin, pReq, &bFailed);
+        if (pConn == NULL && !bFailed) {
+            ++iter;
+            continue;
+        }
+
+        // Advance the virtual time of the origin by its weight.
+        m_Backlog.erase(iter);
+        pOrigin->Requests.PopFront();
+        --m_QueuedCount;
+        m_VirtualTime = pOrigin->Tag;
+        pOrigin->Tag += WEIGHT_SCALE / pOrigin->Weight;
+        if (pOrigin->Requests.Count() > 0) {
+            m_Backlog.insert(BacklogKey(pOrigin->Tag, pOrigin));
+        }
+
+        // The connection may be removed while pushing the request,
+        // the origin is not touched after that.
+        if (bFailed) {
+            ReleaseOrigin(pOrigin);
+            pReq->OnTerminated(EC_CONNECT_FAILED);
+        } else if (!(pReq->IsUrgent() ?
+                     pConn->PushInstantRequest(pReq) : pConn->PushRequest(pReq))) {
+            pReq->OnTerminated(EC_NO_MEMORY);
+        }
+        return true;
+    }
+    return false;
+}
+
+CConnection* CRequestScheduler::SelectConnection(
+    Origin* pOrigin, CRequest* pReq, bool* pFailed)
+{
+    // Prefer the idle connection, then a new one, then pipelining on the
+    // least loaded one. The exhausted connections only finish their requests.
+    CConnection* pCandidate = NULL;
+    size_t activeCount = 0;
+    for (size_t i = 0; i < pOrigin->Connections.size(); ++i) {
+        CConnection* pConn = pOrigin->Connections[i];
+        if (pConn->IsExhausted()) {
+            continue;
+        }
+        ++activeCount;
+        if (pConn->IsAvailable(pReq) &&
+            (pCandidate == NULL || pConn->Load() < pCandidate->Load())) {
+            pCandidate = pConn;
+        }
+    }
+    if (pCandidate && pCandidate->Load() == 0) {
+        return pCandidate;
+    }
+
+    size_t maxCount = pReq->GetConfigure().MaxConnections();
+    if (maxCount > 0 && activeCount >= maxCount) {
+        return pCandidate;
+    }
+
+    // Mark it before acquiring, so the slot released meanwhile wakes it up.
+    AtomicCAS(&m_bCapped, 0, 1);
+    if (!m_Runner.AcquireConnectionSlot() &&
+        (!ReclaimIdleConnection(pOrigin) || !m_Runner.AcquireConnectionSlot())) {
+        m_Runner.ReclaimIdleConnection(&pOrigin->Address);
+        return pCandidate;
+    }
+    AtomicCAS(&m_bCapped, 1, 0);
+
+    CConnection* pConn =
+        CConnection::CreateInstance(m_Runner, m_Poller, pReq, &pOrigin->Address);
+    if (pConn == NULL) {
+        m_Runner.ReleaseConnectionSlot();
+        if (pCandidate == NULL && activeCount == 0) {
+            *pFailed = true;
+        }
+        return pCandidate;
+    }
+    pOrigin->Connections.push_back(pConn);
+    return pConn;
+}
+
+bool CRequestScheduler::ReclaimIdleConnection(Origin* pExcept)
+{
+    // The idle connection of the other origin gives its slot,
+    // instead of holding it until the idle timeout.
+    // All the origins are the others if pExcept is NULL.
+    map<CPointer, Origin*>::iterator iter = m_Origins.begin();
+    map<CPointer, Origin*>::iterator iterEnd = m_Origins.end();
+    while (iter != iterEnd) {
+        Origin* pOrigin = iter->second;
+        if (pOrigin != pExcept) {
+            for (size_t i = 0; i < pOrigin->Connections.size(); ++i) {
+                if (pOrigin->Connections[i]->IsIdle()) {
+                    OUTPUT_DEBUG_TRACE(
+                        "Reclaim the idle connection %p.\n", pOrigin->Connections[i]);
+                    RemoveConnection(pOrigin->Connections[i]);
+                    return true;
+                }
+            }
+        }
+        ++iter;
+    }
+    return false;
+}
+
+void CRequestScheduler::PostSchedule()
+{
+    if (!m_bSchedulePosted) {
+        m_bSchedulePosted = m_Poller.PostAsynTask(ScheduleTask, this);
+    }
+}
+
+void CRequestScheduler::ScheduleTask(void* pScheduler)
+{
+    CRequestScheduler* pObject = reinterpret_cast<CRequestScheduler*>(pScheduler);
+    ASSERT(pObject);
+
+    pObject->m_bSchedulePosted = false;
+    pObject->Schedule();
+}
+
+void CRequestScheduler::ReclaimTask(void* pScheduler)
+{
+    CRequestScheduler* pObject = reinterpret_cast<CRequestScheduler*>(pScheduler);
+    ASSERT(pObject);
+
+    if (pObject->m_Runner.IsCapped()) {
+        pObject->ReclaimIdleConnection(NULL);
+    }
+}
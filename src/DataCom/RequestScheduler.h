@@ -0,0 +1,136 @@
+/*
+ * See the file LICENSE for redistribution information.
+ *
+ * Copyright (c) 2015-2018, Yuan Qin <yuanqin2000 at outlook dot com>
+ * All rights reserved.
+ *
+ */
+
+#ifndef __DATA_COM_REQUEST_SCHEDULER_H__
+#define __DATA_COM_REQUEST_SCHEDULER_H__
+
+#include "Common/Typedefs.h"
+#include "Common/Pointer.h"
+#include "Common/DuplexList.h"
+#include "Common/Macros.h"
+#include "Memory/MemoryPool.h"
+#include <map>
+#include <set>
+#include <vector>
+#include <utility>
+#include <sys/socket.h>
+
+using std::map;
+using std::set;
+using std::vector;
+using std::pair;
+
+class CConnection;
+class CConnectionRunner;
+class CPoller;
+class CRequest;
+
+/**
+ * @brief Dispatch the requests of one shard to the connections.
+ *
+ * The requests are queued per origin (peer address), every origin has up to
+ * CConfigure::MaxConnections connections and the connections of the runner
+ * are limited as a whole. The queued origins are served by the start-time
+ * fair queuing with their weights, the urgent requests are queued ahead of
+ * the others and go to the front of the connection (PushInstantRequest).
+ *
+ * A request is only handed to a connection which can send it at once, so a
+ * slow response does not block the requests queued behind it.
+ *
+ * @warning Only used in the loop of the shard except Wakeup.
+ */
+class CRequestScheduler
+{
+public:
+    CRequestScheduler(CConnectionRunner& runner, CPoller& poller);
+    ~CRequestScheduler();
+
+    bool AddConnection(CConnection* pConn);
+    void RemoveConnection(CConnection* pConn);
+    bool PushRequest(CRequest* pReq, const sockaddr* pTarget);
+    void SetWeight(const sockaddr* pTarget, unsigned int weight);
+
+    /**
+     * @brief The connection can take more requests.
+     */
+    void OnConnectionAvailable(CConnection* pConn);
+
+    /**
+     * @brief Schedule again if it is blocked by the connection limit of
+     *        the runner, can be called in any thread.
+     */
+    void Wakeup();
+    bool IsCapped() const { return m_bCapped != 0; }
+
+    /**
+     * @brief Close an idle connection to give its slot to the other shards.
+     * @return false if there is no idle connection.
+     */
+    bool ReclaimIdleConnection() { return ReclaimIdleConnection(NULL); }
+
+    size_t QueuedCount() const { return m_QueuedCount; }
+
+    static const unsigned int DEFAULT_WEIGHT = 1;
+
+private:
+    struct Origin {
+        Origin(const sockaddr* pAddr, CMemory* pAllocator);
+
+        bool IsUnused() const
+        {
+            return Connections.empty() &&
+                   Requests.Count() == 0 &&
+                   Weight == DEFAULT_WEIGHT;
+        }
+
+        sockaddr Address;
+        vector<CConnection*> Connections;   // Not owned
+        CDuplexList Requests;   // The queued requests, not owned
+        unsigned int Weight;
+        uint64_t Tag;           // The virtual start time of the head request
+
+        DISALLOW_DEFAULT_CONSTRUCTOR(Origin);
+        DISALLOW_COPY_CONSTRUCTOR(Origin);
+        DISALLOW_ASSIGN_OPERATOR(Origin);
+    };
+
+    typedef pair<uint64_t, Origin*> BacklogKey;
+
+    Origin* FindOrigin(const sockaddr* pTarget);
+    Origin* GetOrigin(const sockaddr* pTarget);
+    void ReleaseOrigin(Origin* pOrigin);
+
+    void Schedule();
+    bool DispatchNext(bool bUrgentOnly);
+    CConnection* SelectConnection(Origin* pOrigin, CRequest* pReq, bool* pFailed);
+    bool ReclaimIdleConnection(Origin* pExcept);
+    void PostSchedule();
+
+    static void ScheduleTask(void* pScheduler);
+    static void ReclaimTask(void* pScheduler);
+
+    // The virtual time of one request from the origin of weight 1.
+    static const uint64_t WEIGHT_SCALE = 1 << 16;
+
+private:
+    CConnectionRunner& m_Runner;
+    CPoller& m_Poller;
+    CMemoryPool m_MemPool;
+    map<CPointer, Origin*> m_Origins;   // Owned, the key is Origin::Address
+    set<BacklogKey> m_Backlog;          // The origins which have queued requests
+    uint64_t m_VirtualTime;
+    size_t m_QueuedCount;
+    bool m_bSchedulePosted;
+    volatile int32_t m_bCapped;         // Blocked by the connection limit
+
+    DISALLOW_DEFAULT_CONSTRUCTOR(CRequestScheduler);
+    DISALLOW_COPY_CONSTRUCTOR(CRequestScheduler);
+    DISALLOW_ASSIGN_OPERATOR(CRequestScheduler);
+};
+
+#endif
@@ -16,7 +16,12 @@ CHttpConnectionPref::CHttpConnectionPref(CLazyBuffer& buffer) :
     m_Buffer(buffer),
     m_pHttpProxy(NULL),
     m_SendBufferSize(4096),
-    m_RecvBufferSize(8192)
+    m_RecvBufferSize(8192),
+    m_bPersistent(true),
+    m_MaxPendingRequests(0),
+    m_MaxRequests(0),
+    m_IdleSeconds(60),
+    m_MaxConnections(6)
 {
 }
 
@@ -38,7 +43,7 @@ bool CHttpConnectionPref::Initialize(tConfigNode* pConfigData)
         return false;
     }
 
-    bool bRes = false;
+    bool bRes = true;
     tConfigRoot::CDFSTraverser traverse(pConfigData);
     tConfigNode* pNode = traverse.GetNext();
     while (pNode) {
@@ -50,6 +55,8 @@ bool CHttpConnectionPref::Initialize(tConfigNode* pConfigData)
                 OUTPUT_WARNING_TRACE("Create CHttpProxyPref failed\n");
                 bRes = false;
             }
+        } else if (strcasecmp(pElem->pName, "persistence") == 0) {
+            bRes = AnalyzePersistence(pElem->AttrList);
         }
         if (!bRes) {
             break;
@@ -73,6 +80,8 @@ bool CHttpConnectionPref::AnalyzeGlobalAttribution(CForwardList& attrList)
             m_SendBufferSize = atoi(pAttr->pValue);
         } else if (strcasecmp(pAttr->pName, "receive-buffer-bytes") == 0) {
             m_RecvBufferSize = atoi(pAttr->pValue);
+        } else if (strcasecmp(pAttr->pName, "persistent") == 0) {
+            m_bPersistent = (strcasecmp(pAttr->pValue, "true") == 0);
         } else {
             break;
         }
@@ -80,3 +89,30 @@ bool CHttpConnectionPref::AnalyzeGlobalAttribution(CForwardList& attrList)
     }
     return iter == iterEnd;
 }
+
+bool CHttpConnectionPref::AnalyzePersistence(CForwardList& attrList)
+{
+    CForwardList::Iterator iter = attrList.Begin();
+    CForwardList::Iterator iterEnd = attrList.End();
+    while (iter != iterEnd) {
+        CXMLData::XMLAttribute* pAttr =
+            reinterpret_cast<CXMLData::XMLAttribute*>(attrList.DataAt(iter));
+        if (pAttr->pName == NULL || pAttr->pValue == NULL) {
+            break;
+        }
+        if (strcasecmp(pAttr->pName, "max-pending-request") == 0) {
+            m_MaxPendingRequests = atoi(pAttr->pValue);
+        } else if (strcasecmp(pAttr->pName, "max-requests") == 0) {
+            m_MaxRequests = atoi(pAttr->pValue);
+        } else if (strcasecmp(pAttr->pName, "idle-seconds") == 0) {
+            m_IdleSeconds = atoi(pAttr->pValue);
+        } else if (strcasecmp(pAttr->pName, "max-connections") == 0) {
+            m_MaxConnections = atoi(pAttr->pValue);
+        } else {
+            OUTPUT_WARNING_TRACE("Unknown persistence attribute: %s\n", pAttr->pName);
+            break;
+        }
+        ++iter;
+    }
+    return iter == iterEnd;
+}
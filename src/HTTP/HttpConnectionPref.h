@@ -26,14 +26,27 @@ public:
     size_t SendBufferSize() const { return m_SendBufferSize; }
     size_t RecvBufferSize() const { return m_RecvBufferSize; }
 
+    // The keep-alive and pipeline policy, 0 means no limitation.
+    bool IsPersistent() const { return m_bPersistent; }
+    size_t MaxPendingRequests() const { return m_MaxPendingRequests; }
+    size_t MaxRequests() const { return m_MaxRequests; }
+    unsigned int IdleSeconds() const { return m_IdleSeconds; }
+    size_t MaxConnections() const { return m_MaxConnections; }
+
 private:
     bool AnalyzeGlobalAttribution(CForwardList& attrList);
+    bool AnalyzePersistence(CForwardList& attrList);
 
 private:
     CLazyBuffer& m_Buffer;
     CHttpProxyPref* m_pHttpProxy;
     size_t m_SendBufferSize;
     size_t m_RecvBufferSize;
+    bool m_bPersistent;
+    size_t m_MaxPendingRequests;
+    size_t m_MaxRequests;
+    unsigned int m_IdleSeconds;
+    size_t m_MaxConnections;    // Per origin
 };
 
 #endif
\ No newline at end of file
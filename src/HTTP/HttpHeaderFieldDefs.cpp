@@ -11,7 +11,6 @@
 #include "HttpToken.h"
 #include "HttpFieldValue.h"
 #include "Common/Macros.h"
-#include "Common/CharHelper.h"
 
 #define CHAR_NULL  0x00
 #define CHAR_SPACE 0x20 // ' '
@@ -32,45 +31,43 @@ s_pResponseGlobalConfig = CHttpHeaderFieldDefs::GetResponseGlobalConfig();
 
 const CHeaderField::GlobalConfig* CHttpHeaderFieldDefs::GetRequestGlobalConfig()
 {
-    static const tStringIDMap::value_type s_ReqMapInitValues[] = {
-        tStringIDMap::value_type("Host",                REQ_FN_HOST),
-        tStringIDMap::value_type("User-Agent",          REQ_FN_USER_AGENT),
-        tStringIDMap::value_type("Accept",              REQ_FN_ACCEPT),
-        tStringIDMap::value_type("Accept-Charset",      REQ_FN_ACCEPT_CHARSET),
-        tStringIDMap::value_type("Accept-Encoding",     REQ_FN_ACCEPT_ENCODING),
-        tStringIDMap::value_type("Accept-Language",     REQ_FN_ACCEPT_LANGUAGE),
-        tStringIDMap::value_type("Authorization",       REQ_FN_AUTHORIZATION),
-        tStringIDMap::value_type("Cache-Control",       REQ_FN_CACHE_CONTROL),
-        tStringIDMap::value_type("Connection",          REQ_FN_CONNECTION),
-        tStringIDMap::value_type("Content-Encoding",    REQ_FN_CONTENT_ENCODING),
-        tStringIDMap::value_type("Content-Language",    REQ_FN_CONTENT_LANGUAGE),
-        tStringIDMap::value_type("Content-Length",      REQ_FN_CONTENT_LENGTH),
-        tStringIDMap::value_type("Content-MD5",         REQ_FN_CONTENT_MD5),
-        tStringIDMap::value_type("Content-Range",       REQ_FN_CONTENT_RANGE),
-        tStringIDMap::value_type("Content-Type",        REQ_FN_CONTENT_TYPE),
-        tStringIDMap::value_type("Cookie",              REQ_FN_COOKIE),
-        tStringIDMap::value_type("Expect",              REQ_FN_EXPECT),
-        tStringIDMap::value_type("From",                REQ_FN_FROM),
-        tStringIDMap::value_type("If-Match",            REQ_FN_IF_MATCH),
-        tStringIDMap::value_type("If-Modified-Since",   REQ_FN_IF_MODIFIED_SINCE),
-        tStringIDMap::value_type("If-None-Match",       REQ_FN_IF_NONE_MATCH),
-        tStringIDMap::value_type("If-Range",            REQ_FN_IF_RANGE),
-        tStringIDMap::value_type("If-Unmodified-Since", REQ_FN_IF_UNMODIFIED_SINCE),
-        tStringIDMap::value_type("Last-Modified",       REQ_FN_LAST_MODIFIED),
-        tStringIDMap::value_type("Max-Forwards",        REQ_FN_MAX_FORWARDS),
-        tStringIDMap::value_type("Pragma",              REQ_FN_PRAGMA),
-        tStringIDMap::value_type("Proxy-Authorization", REQ_FN_PROXY_AUTHORIZATION),
-        tStringIDMap::value_type("Range",               REQ_FN_RANGE),
-        tStringIDMap::value_type("Referer",             REQ_FN_REFERER),
-        tStringIDMap::value_type("TE",                  REQ_FN_TE),
-        tStringIDMap::value_type("Trailer",             REQ_FN_TRAILER),
-        tStringIDMap::value_type("Transfer-Encoding",   REQ_FN_TRANSFER_ENCODING),
+    static const CPerfectHash::KeyValue s_ReqMapInitValues[] = {
+        { "Host",                REQ_FN_HOST },
+        { "User-Agent",          REQ_FN_USER_AGENT },
+        { "Accept",              REQ_FN_ACCEPT },
+        { "Accept-Charset",      REQ_FN_ACCEPT_CHARSET },
+        { "Accept-Encoding",     REQ_FN_ACCEPT_ENCODING },
+        { "Accept-Language",     REQ_FN_ACCEPT_LANGUAGE },
+        { "Authorization",       REQ_FN_AUTHORIZATION },
+        { "Cache-Control",       REQ_FN_CACHE_CONTROL },
+        { "Connection",          REQ_FN_CONNECTION },
+        { "Content-Encoding",    REQ_FN_CONTENT_ENCODING },
+        { "Content-Language",    REQ_FN_CONTENT_LANGUAGE },
+        { "Content-Length",      REQ_FN_CONTENT_LENGTH },
+        { "Content-MD5",         REQ_FN_CONTENT_MD5 },
+        { "Content-Range",       REQ_FN_CONTENT_RANGE },
+        { "Content-Type",        REQ_FN_CONTENT_TYPE },
+        { "Cookie",              REQ_FN_COOKIE },
+        { "Expect",              REQ_FN_EXPECT },
+        { "From",                REQ_FN_FROM },
+        { "If-Match",            REQ_FN_IF_MATCH },
+        { "If-Modified-Since",   REQ_FN_IF_MODIFIED_SINCE },
+        { "If-None-Match",       REQ_FN_IF_NONE_MATCH },
+        { "If-Range",            REQ_FN_IF_RANGE },
+        { "If-Unmodified-Since", REQ_FN_IF_UNMODIFIED_SINCE },
+        { "Last-Modified",       REQ_FN_LAST_MODIFIED },
+        { "Max-Forwards",        REQ_FN_MAX_FORWARDS },
+        { "Pragma",              REQ_FN_PRAGMA },
+        { "Proxy-Authorization", REQ_FN_PROXY_AUTHORIZATION },
+        { "Range",               REQ_FN_RANGE },
+        { "Referer",             REQ_FN_REFERER },
+        { "TE",                  REQ_FN_TE },
+        { "Trailer",             REQ_FN_TRAILER },
+        { "Transfer-Encoding",   REQ_FN_TRANSFER_ENCODING },
     };
 
-    static const tStringIDMap s_ReqFieldNameMap(
-        s_ReqMapInitValues,
-        s_ReqMapInitValues + COUNT_OF_ARRAY(s_ReqMapInitValues),
-        NSCharHelper::StringCaseCompare);
+    static const CPerfectHash s_ReqFieldNameIndex(
+        s_ReqMapInitValues, COUNT_OF_ARRAY(s_ReqMapInitValues), false);
 
     static const CHeaderField::ItemConfig s_ReqItemsConfig[] = {
         // pItemName, BitSet, DelimitedChar, CreatorFunction
@@ -175,7 +172,7 @@ const CHeaderField::GlobalConfig* CHttpHeaderFieldDefs::GetRequestGlobalConfig()
         true,
         COUNT_OF_ARRAY(s_ReqItemsConfig),
         s_ReqItemsConfig,
-        &s_ReqFieldNameMap
+        &s_ReqFieldNameIndex
     };
 
     return &s_ReqGlobalConfig;
@@ -183,46 +180,44 @@ const CHeaderField::GlobalConfig* CHttpHeaderFieldDefs::GetRequestGlobalConfig()
 
 const CHeaderField::GlobalConfig* CHttpHeaderFieldDefs::GetResponseGlobalConfig()
 {
-    static const tStringIDMap::value_type s_RespMapInitValues[] = {
-        tStringIDMap::value_type("Age",                 RESP_FN_AGE),
-        tStringIDMap::value_type("Allow",               RESP_FN_ALLOW),
-        tStringIDMap::value_type("Authorization",       RESP_FN_AUTHORIZATION),
-        tStringIDMap::value_type("Cache-Control",       RESP_FN_CACHE_CONTROL),
-        tStringIDMap::value_type("Connection",          RESP_FN_CONNECTION),
-        tStringIDMap::value_type("Content-Encoding",    RESP_FN_CONTENT_ENCODING),
-        tStringIDMap::value_type("Content-Language",    RESP_FN_CONTENT_LANGUAGE),
-        tStringIDMap::value_type("Content-Length",      RESP_FN_CONTENT_LENGTH),
-        tStringIDMap::value_type("Content-Location",    RESP_FN_CONTENT_LOCATION),
-        tStringIDMap::value_type("Content-MD5",         RESP_FN_CONTENT_MD5),
-        tStringIDMap::value_type("Content-Range",       RESP_FN_CONTENT_RANGE),
-        tStringIDMap::value_type("Content-Type",        RESP_FN_CONTENT_TYPE),
-        tStringIDMap::value_type("Date",                RESP_FN_DATE),
-        tStringIDMap::value_type("ETag",                RESP_FN_ETAG),
-        tStringIDMap::value_type("Expires",             RESP_FN_EXPIRES),
-        tStringIDMap::value_type("Last-Modified",       RESP_FN_LAST_MODIFIED),
-        tStringIDMap::value_type("Location",            RESP_FN_LOCATION),
-        tStringIDMap::value_type("Max-Forwards",        RESP_FN_MAX_FORWARDS),
-        tStringIDMap::value_type("Pragma",              RESP_FN_PRAGMA),
-        tStringIDMap::value_type("Proxy-Authenticate",  RESP_FN_PROXY_AUTHENTICATE),
-        tStringIDMap::value_type("Range",               RESP_FN_RANGE),
-        tStringIDMap::value_type("Referer",             RESP_FN_REFERER),
-        tStringIDMap::value_type("Retry-After",         RESP_FN_RETRY_AFTER),
-        tStringIDMap::value_type("Server",              RESP_FN_SERVER),
-        tStringIDMap::value_type("Set-Cookie",          RESP_FN_SET_COOKIE),
-        tStringIDMap::value_type("Set-Cookie2",         RESP_FN_SET_COOKIE2),
-        tStringIDMap::value_type("Trailer",             RESP_FN_TRAILER),
-        tStringIDMap::value_type("Transfer-Encoding",   RESP_FN_TRANSFER_ENCODING),
-        tStringIDMap::value_type("Upgrade",             RESP_FN_UPGRADE),
-        tStringIDMap::value_type("Vary",                RESP_FN_VARY),
-        tStringIDMap::value_type("Via",                 RESP_FN_VIA),
-        tStringIDMap::value_type("Warning",             RESP_FN_WARNING),
-        tStringIDMap::value_type("WWW-Authenticate",    RESP_FN_WWW_AUTHENTICATE)
+    static const CPerfectHash::KeyValue s_RespMapInitValues[] = {
+        { "Age",                 RESP_FN_AGE },
+        { "Allow",               RESP_FN_ALLOW },
+        { "Authorization",       RESP_FN_AUTHORIZATION },
+        { "Cache-Control",       RESP_FN_CACHE_CONTROL },
+        { "Connection",          RESP_FN_CONNECTION },
+        { "Content-Encoding",    RESP_FN_CONTENT_ENCODING },
+        { "Content-Language",    RESP_FN_CONTENT_LANGUAGE },
+        { "Content-Length",      RESP_FN_CONTENT_LENGTH },
+        { "Content-Location",    RESP_FN_CONTENT_LOCATION },
+        { "Content-MD5",         RESP_FN_CONTENT_MD5 },
+        { "Content-Range",       RESP_FN_CONTENT_RANGE },
+        { "Content-Type",        RESP_FN_CONTENT_TYPE },
+        { "Date",                RESP_FN_DATE },
+        { "ETag",                RESP_FN_ETAG },
+        { "Expires",             RESP_FN_EXPIRES },
+        { "Last-Modified",       RESP_FN_LAST_MODIFIED },
+        { "Location",            RESP_FN_LOCATION },
+        { "Max-Forwards",        RESP_FN_MAX_FORWARDS },
+        { "Pragma",              RESP_FN_PRAGMA },
+        { "Proxy-Authenticate",  RESP_FN_PROXY_AUTHENTICATE },
+        { "Range",               RESP_FN_RANGE },
+        { "Referer",             RESP_FN_REFERER },
+        { "Retry-After",         RESP_FN_RETRY_AFTER },
+        { "Server",              RESP_FN_SERVER },
+        { "Set-Cookie",          RESP_FN_SET_COOKIE },
+        { "Set-Cookie2",         RESP_FN_SET_COOKIE2 },
+        { "Trailer",             RESP_FN_TRAILER },
+        { "Transfer-Encoding",   RESP_FN_TRANSFER_ENCODING },
+        { "Upgrade",             RESP_FN_UPGRADE },
+        { "Vary",                RESP_FN_VARY },
+        { "Via",                 RESP_FN_VIA },
+        { "Warning",             RESP_FN_WARNING },
+        { "WWW-Authenticate",    RESP_FN_WWW_AUTHENTICATE }
     };
 
-    static const tStringIDMap s_RespFieldNameMap(
-        s_RespMapInitValues,
-        s_RespMapInitValues + COUNT_OF_ARRAY(s_RespMapInitValues),
-        NSCharHelper::StringCaseCompare);
+    static const CPerfectHash s_RespFieldNameIndex(
+        s_RespMapInitValues, COUNT_OF_ARRAY(s_RespMapInitValues), false);
 
     static const CHeaderField::ItemConfig s_RespItemsConfig[] = {
         { "Age", 0, CHAR_NULL, CIntFieldValue::CreateInstance },
@@ -307,7 +302,7 @@ const CHeaderField::GlobalConfig* CHttpHeaderFieldDefs::GetResponseGlobalConfig(
         true,
         COUNT_OF_ARRAY(s_RespItemsConfig),
         s_RespItemsConfig,
-        &s_RespFieldNameMap
+        &s_RespFieldNameIndex
     };
 
     return &s_RespGlobalConfig;
@@ -320,7 +315,7 @@ const CHeaderField::GlobalConfig* CHttpHeaderFieldDefs::GetConnectRequestGlobalC
         GetRequestGlobalConfig()->bSupportExtension,
         2,
         GetRequestGlobalConfig()->pItems,
-        GetRequestGlobalConfig()->pNamesMap);
+        GetRequestGlobalConfig()->pNamesIndex);
     return &s_ConnectRequestGlobalConfig;
 }
 
@@ -36,8 +36,15 @@ using std::memcpy;
 using std::strlen;
 using std::vector;
 
-CConnectionRunner* CHttpRequest::s_pHttpRunner =
-    CConnectionRunner::CreateInstance("default-http-client-stack");
+CConnectionRunner* CHttpRequest::GetHttpRunner()
+{
+    // Created at the first request.
+    static CConnectionRunner* s_pHttpRunner =
+        CConnectionRunner::CreateInstance(
+            "default-http-client-stack", 0, true,
+            CPollBackend::PB_EPOLL, CHttpRequest::MAX_CONNECTIONS);
+    return s_pHttpRunner;
+}
 
 CHttpRequest::CHttpRequest(
     IClient& client,
@@ -166,6 +173,7 @@ void CHttpRequest::OnReset()
     if (m_pSource) {
         m_pSource->Reset();
     }
+    SetConnectionClose(false);
     CHttpBaseRequest::OnReset();
 }
 
@@ -173,7 +181,7 @@ bool CHttpRequest::SerializePayload(
     uint8_t* pBuffer, size_t bufLen, size_t* pOutLen)
 {
     *pOutLen = 0;
-    if (m_pSource == NULL) {
+    if (m_pSource == NULL || m_pSource->IsEOF()) {
         return true;
     }
 
@@ -185,6 +193,7 @@ bool CHttpRequest::SerializePayload(
     if (m_pSource->IsReadable()) {
         int readLen = m_pSource->Read(pBuffer, bufLen);
         if (readLen > 0) {
+            *pOutLen = readLen;
             bFinished = m_pSource->IsEOF();
         } else if (readLen == 0) {
             bFinished = true;
@@ -196,6 +205,29 @@ bool CHttpRequest::SerializePayload(
     return bFinished;
 }
 
+size_t CHttpRequest::PeekPayload(struct iovec* pIOVec, size_t count)
+{
+    const uint8_t* pData = NULL;
+    size_t len = m_pSource ? m_pSource->Peek(&pData) : 0;
+    if (len == 0) {
+        return 0;
+    }
+    pIOVec->iov_base = const_cast<uint8_t*>(pData);
+    pIOVec->iov_len = len;
+    return 1;
+}
+
+bool CHttpRequest::PeekPayloadFile(tIOHandle* pFile, off_t* pOffset, size_t* pLen)
+{
+    return m_pSource && m_pSource->GetFileRegion(pFile, pOffset, pLen);
+}
+
+void CHttpRequest::SkipPayload(size_t len)
+{
+    ASSERT(m_pSource);
+    m_pSource->Skip(len);
+}
+
 ErrorCode CHttpRequest::HandleRespHeader(
     tTokenID versionID,
     int statusCode,
@@ -210,6 +242,7 @@ ErrorCode CHttpRequest::HandleRespHeader(
     if (pExtHeaderField->empty()) {
         pExtHeaderField = NULL;
     }
+    SetConnectionClose(AnalyzeConnectionClose(versionID, pHeaderField));
     ErrorCode error = HandleStatusCode(statusCode, pHeaderField);
     if (error != EC_SUCCESS) {
         return error;
@@ -282,7 +315,7 @@ CIOContext* CHttpRequest::CreateIOContext(const sockaddr* pTarget)
             if (m_bSecure && !m_bViaProxy) {
                 // Use SSL
                 CIOContext* pTmp = pIO;
-                pIO = CSSLClient::CreateInstance(pTmp, true);
+                pIO = CSSLClient::CreateInstance(pTmp, true, pTarget);
                 if (pIO == NULL) {
                     delete pTmp;
                 }
@@ -299,10 +332,22 @@ CConfigure& CHttpRequest::GetConfigure()
 {
     static CHttpConnectionPref& connPreference(
         CHttpPrefManager::Instance()->GetConnectConfig());
+    // The non-persistent connection takes only one request.
+    static size_t s_MaxRequests =
+        connPreference.IsPersistent() ? connPreference.MaxRequests() : 1;
     static CHttpConfigure s_HttpConfigure(
-        connPreference.SendBufferSize(), connPreference.RecvBufferSize());
+        connPreference.SendBufferSize(),
+        connPreference.RecvBufferSize(),
+        connPreference.IsPersistent() ? connPreference.MaxPendingRequests() : 1,
+        s_MaxRequests,
+        connPreference.IdleSeconds() * 1000,
+        connPreference.MaxConnections());
     static CHttpTunelConfigure s_HttpTunelConfigure(
-        connPreference.SendBufferSize(), connPreference.RecvBufferSize());
+        connPreference.SendBufferSize(),
+        connPreference.RecvBufferSize(),
+        s_MaxRequests,
+        connPreference.IdleSeconds() * 1000,
+        connPreference.MaxConnections());
 
     if (m_bSecure && m_bViaProxy) {
         return s_HttpTunelConfigure;
@@ -418,6 +463,33 @@ bool CHttpRequest::AnalyzeContentLength(
     return bRes;
 }
 
+bool CHttpRequest::AnalyzeConnectionClose(
+    tTokenID versionID, CHeaderField* pRespHeaderField)
+{
+    // HTTP/1.0 closes the connection unless it is kept alive (RFC 7230, 6.3).
+    bool bClose = (versionID == HTTP_VERSION_1_0);
+    CForwardList* pConnectionOpts =
+        pRespHeaderField->GetFieldValueByID(CHttpHeaderFieldDefs::RESP_FN_CONNECTION);
+    if (pConnectionOpts) {
+        CForwardList::Iterator iter = pConnectionOpts->Begin();
+        CForwardList::Iterator iterEnd = pConnectionOpts->End();
+        while (iter != iterEnd) {
+            CTokenIndexFieldValue<CHttpTokenMap::CATEGORY_CONNECTION>*
+                pValueObj = reinterpret_cast<CTokenIndexFieldValue<
+                    CHttpTokenMap::CATEGORY_CONNECTION>*>(pConnectionOpts->DataAt(iter));
+            tTokenID connectionOpts = pValueObj->GetToken();
+            if (connectionOpts == CO_CLOSE) {
+                return true;
+            }
+            if (connectionOpts == CO_KEEP_ALIVE) {
+                bClose = false;
+            }
+            ++iter;
+        }
+    }
+    return bClose;
+}
+
 bool CHttpRequest::AnalyzeTransferEncoding(
     CHeaderField* pRespHeaderField, int* pOutContentLength)
 {
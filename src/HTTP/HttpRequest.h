@@ -68,6 +68,10 @@ public:
         virtual void OnTerminated(ErrorCode status) = 0;
         virtual void OnData(uint8_t* pData, size_t len) = 0;
 
+        /**
+         * @note pStatusPhrase and pExtField are valid only in this call,
+         *       copy them to keep.
+         */
         virtual void OnHttpStatus(
             int code, const char* pStatusPhrase, const tStringMap* pExtField) = 0;
         virtual void OnHttpIndication(HttpIndication ind, void* pData = NULL) = 0;
@@ -89,8 +93,9 @@ public:
 public:
     bool Start()
     {
-        ASSERT(s_pHttpRunner);
-        return s_pHttpRunner->PushRequest(this, this->GetPeerAddress());
+        CConnectionRunner* pRunner = GetHttpRunner();
+        ASSERT(pRunner);
+        return pRunner->PushRequest(this, this->GetPeerAddress());
     }
 
     CUri* GetTarget() const { return m_Target.get(); }
@@ -125,6 +130,9 @@ private:
     // From CHttpBaseRequest
     void OnReset();
     bool SerializePayload(uint8_t* pBuffer, size_t bufLen, size_t* pOutLen);
+    size_t PeekPayload(struct iovec* pIOVec, size_t count);
+    bool PeekPayloadFile(tIOHandle* pFile, off_t* pOffset, size_t* pLen);
+    void SkipPayload(size_t len);
     ErrorCode HandleRespHeader(
         tTokenID versionID,
         int statusCode,
@@ -140,6 +148,7 @@ private:
         EncodingType* pOutType);
     bool AnalyzeEncodingType(CHeaderField* pRespHeaderField, EncodingType* pOutType);
     bool AnalyzeContentLength(tTokenID versionID, CHeaderField* pRespHeaderField, int* pOutContentLength);
+    bool AnalyzeConnectionClose(tTokenID versionID, CHeaderField* pRespHeaderField);
     bool AnalyzeTransferEncoding(CHeaderField* pRespHeaderField, int* pOutContentLength);
 
     ErrorCode HandleStatusCode(int statusCode, CHeaderField* pRespHeaderField);
@@ -165,8 +174,16 @@ private:
     class CHttpConfigure : public CConfigure
     {
     public:
-        CHttpConfigure(size_t inBufSize, size_t outBufSize) :
-            CConfigure(inBufSize, outBufSize) {}
+        CHttpConfigure(
+            size_t inBufSize,
+            size_t outBufSize,
+            size_t pipelineDepth,
+            size_t maxRequests,
+            unsigned int idleTimeout,
+            size_t maxConnections) :
+            CConfigure(
+                inBufSize, outBufSize, pipelineDepth,
+                maxRequests, idleTimeout, maxConnections) {}
 
         // From CConfigure
         bool CreateController(CController** pOutController, CRequest* pRequest);
@@ -175,8 +192,15 @@ private:
     class CHttpTunelConfigure : public CConfigure
     {
     public:
-        CHttpTunelConfigure(size_t inBufSize, size_t outBufSize) :
-            CConfigure(inBufSize, outBufSize) {}
+        CHttpTunelConfigure(
+            size_t inBufSize,
+            size_t outBufSize,
+            size_t maxRequests,
+            unsigned int idleTimeout,
+            size_t maxConnections) :
+            CConfigure(
+                inBufSize, outBufSize, 1,
+                maxRequests, idleTimeout, maxConnections) {}
 
         // From CConfigure
         bool CreateController(CController** pOutController, CRequest* pRequest);
@@ -196,7 +220,10 @@ private:
     sockaddr m_TargetAddr;   // Orignial Server address.
     sockaddr m_PeerAddr;     // Direct connected address. (next hop)
 
-    static CConnectionRunner* s_pHttpRunner;
+    // The max count of the client connections of all the origins.
+    static const size_t MAX_CONNECTIONS = 256;
+
+    static CConnectionRunner* GetHttpRunner();
 
     DISALLOW_COPY_CONSTRUCTOR(CHttpRequest);
     DISALLOW_ASSIGN_OPERATOR(CHttpRequest);
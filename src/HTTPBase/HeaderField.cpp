@@ -31,11 +31,8 @@ int CHeaderField::GlobalConfig::GetFieldID(const char* pName) const
 {
     ASSERT(pName);
 
-    tStringIDMap::const_iterator iter = pNamesMap->find(pName);
-    if (iter != pNamesMap->end()) {
-        return iter->second;
-    }
-    return INVALID_FIELD_ID;
+    int fieldID = pNamesIndex->Find(pName);
+    return fieldID == CPerfectHash::INVALID_VALUE ? INVALID_FIELD_ID : fieldID;
 }
 
 CHeaderField::FieldInitedValue::FieldInitedValue(
@@ -86,13 +83,15 @@ CForwardList* CHeaderField::FieldInitedValue::GetValue(size_t index)
 CHeaderField::CHeaderField(CLazyBuffer& buffer, const GlobalConfig* pCfg) :
     m_pConfig(pCfg),
     m_pValues(NULL),
+    m_pRawValues(NULL),
+    m_bReferRawValues(false),
     m_Extensions(),
     m_Buffer(buffer)
 {
     ASSERT(pCfg);
     ASSERT(pCfg->ItemsCount > 0);
     ASSERT(pCfg->pItems);
-    ASSERT(pCfg->pNamesMap);
+    ASSERT(pCfg->pNamesIndex);
 }
 
 CHeaderField::~CHeaderField()
@@ -101,12 +100,17 @@ CHeaderField::~CHeaderField()
         free(m_pValues);
         m_pValues = NULL;
     }
+    if (m_pRawValues) {
+        free(m_pRawValues);
+        m_pRawValues = NULL;
+    }
 }
 
 CHeaderField* CHeaderField::CreateInstance(
     const GlobalConfig* pCfg,
     CLazyBuffer& buffer,
-    FieldInitedValue* pInitValues /* = NULL */)
+    FieldInitedValue* pInitValues /* = NULL */,
+    bool bLazyDecode /* = false */)
 {
     CHeaderField* pInstance = new CHeaderField(buffer, pCfg);
     if (pInstance == NULL) {
@@ -114,6 +118,14 @@ CHeaderField* CHeaderField::CreateInstance(
     }
 
     size_t size = pCfg->ItemsCount * sizeof(CForwardList*);
+    if (bLazyDecode) {
+        pInstance->m_pRawValues = reinterpret_cast<CForwardList**>(malloc(size));
+        if (pInstance->m_pRawValues == NULL) {
+            delete pInstance;
+            return NULL;
+        }
+        memset(pInstance->m_pRawValues, 0, size);
+    }
     pInstance->m_pValues = reinterpret_cast<CForwardList**>(malloc(size));
     if (pInstance->m_pValues) {
         memset(pInstance->m_pValues, 0, size);
@@ -140,7 +152,7 @@ CForwardList* CHeaderField::GetFieldValueByName(const char* pName)
 
     int fieldID = m_pConfig->GetFieldID(pName);
     if (fieldID >= 0) {
-        return m_pValues[fieldID];
+        return GetFieldValueByID(fieldID);
     }
     return NULL;
 }
@@ -149,7 +161,7 @@ size_t CHeaderField::Count() const
 {
     size_t count = 0;
     for (size_t i = 0; i < m_pConfig->ItemsCount; ++i) {
-         if (m_pValues[i] != NULL) {
+         if (HasFieldValue(i)) {
              ++count;
          }
     }
@@ -185,7 +197,7 @@ bool CHeaderField::SetFieldValue(const char* pName, const char* pValue)
         return bRes;
     }
 
-    if (!m_pConfig->pItems[fieldID].SupportMultiItems() && m_pValues[fieldID]) {
+    if (!m_pConfig->pItems[fieldID].SupportMultiItems() && HasFieldValue(fieldID)) {
         OUTPUT_WARNING_TRACE("Set item is existed: %s\n", pName);
         return false;
     }
@@ -195,6 +207,9 @@ bool CHeaderField::SetFieldValue(const char* pName, const char* pValue)
         OUTPUT_WARNING_TRACE("No create function for header field: %s\n", pValue);
         return false;
     }
+    if (m_pRawValues) {
+        return StoreRawValue(fieldID, pValue);
+    }
 
     CForwardList* pValueObjects = CreateFieldValueList(
         pValue,
@@ -217,7 +232,7 @@ bool CHeaderField::SetFieldValue(int fieldID, const char* pValue)
     ASSERT(fieldID >= 0);
     ASSERT(pValue);
 
-    if (!m_pConfig->pItems[fieldID].SupportMultiItems() && m_pValues[fieldID]) {
+    if (!m_pConfig->pItems[fieldID].SupportMultiItems() && HasFieldValue(fieldID)) {
         OUTPUT_WARNING_TRACE("Set item is existed: %d\n", fieldID);
         return false;
     }
@@ -226,6 +241,9 @@ bool CHeaderField::SetFieldValue(int fieldID, const char* pValue)
         OUTPUT_WARNING_TRACE("No create function for header field: %s\n", pValue);
         return false;
     }
+    if (m_pRawValues) {
+        return StoreRawValue(fieldID, pValue);
+    }
 
     CForwardList* pValueObjects = CreateFieldValueList(
         pValue,
@@ -249,6 +267,9 @@ bool CHeaderField::SetFieldValueByID(int fieldID, CForwardList* pValues)
     ASSERT(fieldID >= 0);
     ASSERT(static_cast<unsigned int>(fieldID) < m_pConfig->ItemsCount);
 
+    if (m_pRawValues && m_pRawValues[fieldID]) {
+        DecodeRawValues(fieldID);
+    }
     if (m_pValues[fieldID]) {
         if (!m_pConfig->pItems[fieldID].SupportMultiItems()) {
             OUTPUT_WARNING_TRACE("Set item is existed: %d\n", fieldID);
@@ -280,6 +301,101 @@ bool CHeaderField::AppendFieldValue(int fieldID, IFieldValue* pValue)
     return false;
 }
 
+bool CHeaderField::StoreRawValue(int fieldID, const char* pValue)
+{
+    // The value may be in the receiving buffer, keep a copy
+    // unless the caller keeps it.
+    const char* pRaw = pValue;
+    if (!m_bReferRawValues) {
+        pRaw = m_Buffer.StoreString(pValue);
+        if (pRaw == NULL) {
+            return false;
+        }
+    }
+
+    CForwardList* pList = m_pRawValues[fieldID];
+    if (pList == NULL) {
+        void* pMem = m_Buffer.Malloc(sizeof(CForwardList));
+        if (pMem == NULL) {
+            return false;
+        }
+        pList = new (pMem) CForwardList(&m_Buffer);
+        m_pRawValues[fieldID] = pList;
+    }
+    return pList->PushBack(const_cast<char*>(pRaw));
+}
+
+void CHeaderField::DecodeRawValues(int fieldID)
+{
+    CForwardList* pRawList = m_pRawValues[fieldID];
+    m_pRawValues[fieldID] = NULL;
+
+    // Same as setting the values one by one, the failed one is dropped.
+    const ItemConfig* pItemConfig = &m_pConfig->pItems[fieldID];
+    CForwardList::Iterator iter = pRawList->Begin();
+    CForwardList::Iterator iterEnd = pRawList->End();
+    while (iter != iterEnd) {
+        const char* pRaw = reinterpret_cast<const char*>(pRawList->DataAt(iter));
+        CForwardList* pValueObjects = CreateFieldValueList(
+            pRaw,
+            pItemConfig->DelimitedChar,
+            pItemConfig->CreatorFunction,
+            m_Buffer);
+        if (pValueObjects) {
+            if (m_pValues[fieldID]) {
+                m_pValues[fieldID]->PushBack(*pValueObjects);
+            } else {
+                m_pValues[fieldID] = pValueObjects;
+            }
+        }
+        ++iter;
+    }
+}
+
+void CHeaderField::DecodeAllRawValues()
+{
+    for (size_t i = 0; i < m_pConfig->ItemsCount; ++i) {
+        if (m_pRawValues[i]) {
+            DecodeRawValues(i);
+        }
+    }
+}
+
+void CHeaderField::DetachRawValues()
+{
+    if (!m_bReferRawValues) {
+        return;
+    }
+    m_bReferRawValues = false;
+
+    for (size_t i = 0; i < m_pConfig->ItemsCount; ++i) {
+        CForwardList* pRawList = m_pRawValues[i];
+        if (pRawList == NULL) {
+            continue;
+        }
+        m_pRawValues[i] = NULL;
+
+        CForwardList::Iterator iter = pRawList->Begin();
+        CForwardList::Iterator iterEnd = pRawList->End();
+        while (iter != iterEnd) {
+            const char* pRaw = reinterpret_cast<const char*>(pRawList->DataAt(iter));
+            if (!StoreRawValue(i, pRaw)) {
+                OUTPUT_WARNING_TRACE(
+                    "Drop the value of %s: %s\n", m_pConfig->pItems[i].pItemName, pRaw);
+            }
+            ++iter;
+        }
+    }
+}
+
+void CHeaderField::DropRawValues()
+{
+    if (m_pRawValues) {
+        memset(m_pRawValues, 0, m_pConfig->ItemsCount * sizeof(CForwardList*));
+    }
+    m_bReferRawValues = false;
+}
+
 CHeaderField::tSerializeAnchor CHeaderField::Serialize(
     char* pBuffer,
     size_t len,
@@ -301,6 +417,10 @@ CHeaderField::tSerializeAnchor CHeaderField::Serialize(
     char* pCur = pBuffer;
     const char* pEnd = pBuffer + len;
 
+    if (m_pRawValues) {
+        DecodeAllRawValues();
+    }
+
     *pOutLen = 0;
     size_t curIndex;
     for (curIndex = anchor; curIndex < m_pConfig->ItemsCount; ++curIndex) {
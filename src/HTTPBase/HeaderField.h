@@ -15,6 +15,7 @@
 #include "Memory/LazyBuffer.h"
 #include "Common/ForwardList.h"
 #include "Common/StringMap.h"
+#include "Common/PerfectHash.h"
 #include "Tracker/Trace.h"
 
 using std::strchr;
@@ -30,7 +31,6 @@ class IFieldValue;
 //
 ///////////////////////////////////////////////////////////////////////////////
 
-typedef map<const char*, int, tStringCompareFunc> tStringIDMap;
 typedef IFieldValue* (*tValueCreator)(
         const char* pString, size_t len, CLazyBuffer& buffer);
 
@@ -55,17 +55,17 @@ public:
         bool bSupportExtension;
         size_t ItemsCount;
         const ItemConfig* pItems;
-        const tStringIDMap* pNamesMap;
+        const CPerfectHash* pNamesIndex;   // Field name to ID
 
         GlobalConfig(
             bool bSupExt,
             size_t count,
             const ItemConfig* pConf,
-            const tStringIDMap* pMap) :
+            const CPerfectHash* pIndex) :
             bSupportExtension(bSupExt),
             ItemsCount(count),
             pItems(pConf),
-            pNamesMap(pMap) {}
+            pNamesIndex(pIndex) {}
 
         int GetFieldID(const char* pName) const;
     };
@@ -93,8 +93,11 @@ public:
     CForwardList* GetFieldValueByName(const char* pName);
     CForwardList* GetFieldValueByID(int fieldID)
     {
-        ASSERT(fieldID > 0);
+        ASSERT(fieldID >= 0);
         ASSERT(static_cast<unsigned int>(fieldID) < m_pConfig->ItemsCount);
+        if (m_pRawValues && m_pRawValues[fieldID]) {
+            DecodeRawValues(fieldID);
+        }
         return m_pValues[fieldID];
     }
 
@@ -110,10 +113,38 @@ public:
         return SetFieldValueByID(fieldID, pValues);
     }
 
+    /**
+     * @brief Refer to the raw values set later in place instead of copying
+     *        them, the caller keeps the strings until DetachRawValues or
+     *        DropRawValues. Only for the lazy decoding.
+     */
+    void ReferRawValues()
+    {
+        ASSERT(m_pRawValues);
+        m_bReferRawValues = true;
+    }
+
+    /**
+     * @brief Copy the raw values which are referred in place.
+     */
+    void DetachRawValues();
+
+    /**
+     * @brief Forget the raw values which are not decoded yet,
+     *        the fields are regarded as not set.
+     */
+    void DropRawValues();
+
+    /**
+     * @param bLazyDecode Only keep the raw string of the value when it is set
+     *        by the name or ID, the value objects are created when the field
+     *        is got at first.
+     */
     static CHeaderField* CreateInstance(
         const GlobalConfig* pCfg,
         CLazyBuffer& buffer,
-        FieldInitedValue* pInitValues = NULL);
+        FieldInitedValue* pInitValues = NULL,
+        bool bLazyDecode = false);
 
 public:
     typedef size_t tSerializeAnchor;
@@ -135,6 +166,14 @@ private:
     bool SetFieldValueByID(int fieldID, CForwardList* pValues);
     bool AppendFieldValue(int fieldID, IFieldValue* pValue);
 
+    bool HasFieldValue(int fieldID) const
+    {
+        return m_pValues[fieldID] || (m_pRawValues && m_pRawValues[fieldID]);
+    }
+    bool StoreRawValue(int fieldID, const char* pValue);
+    void DecodeRawValues(int fieldID);
+    void DecodeAllRawValues();
+
     static CForwardList* CreateFieldValueList(
         const char* pString,
         char delimitor,
@@ -144,6 +183,8 @@ private:
 private:
     const GlobalConfig* m_pConfig;     // Not owned
     CForwardList** m_pValues;      // Field Values, Owned
+    CForwardList** m_pRawValues;   // Raw strings not decoded yet, Owned (lazy decode only)
+    bool m_bReferRawValues;        // The raw strings are not copied
     CStringMap m_Extensions;
     CLazyBuffer& m_Buffer;
 
@@ -12,23 +12,27 @@
 #include "StatusLine.h"
 #include "HeaderField.h"
 #include "Memory/LazyBuffer.h"
-#include "Common/CharHelper.h"
+#include "Common/CharScanner.h"
 #include "Tracker/Trace.h"
 
 using std::isspace;
-using std::isalnum;
 
 const char* CHeaderParser::s_pTokenDelimiters = "\"(),/:;<=>?@[\\]{}";
 
 CHeaderParser::CHeaderParser(
-    char* pData, size_t len, CLazyBuffer* pBuffer /* = NULL */) :
+    char* pData,
+    size_t len,
+    CLazyBuffer* pBuffer /* = NULL */,
+    ResumeState* pState /* = NULL */) :
     m_pData(pData),
     m_DataLength(len),
     m_pBuffer(pBuffer),
+    m_pState(pState),
     m_ConsumedSize(0)
 {
     ASSERT(pData);
     ASSERT(len > 0);
+    ASSERT_IF(pState, pState->ScannedSize <= len);
 }
 
 CHeaderParser::~CHeaderParser()
@@ -40,14 +44,18 @@ void* CHeaderParser::BuildStartedLine(
 {
     ASSERT(creator);
 
-    const char* pCRLF =
-        NSCharHelper::FindSubStr("\r\n", 2, m_pData, m_pData + m_DataLength);
+    char* pEnd = m_pData + m_DataLength;
+    char* pCRLF = const_cast<char*>(NSCharScanner::FindCRLF(GetScanBegin(), pEnd));
     if (pCRLF == NULL) {
-        // Need more data to parse.
+        // Need more data to parse, the last CR may be followed by LF.
+        SaveScanned(m_pData, pEnd[-1] == '\r' ? pEnd - 1 : pEnd);
         SET_ERROR_CODE(EC_INPROGRESS);
         return NULL;
     }
+    SaveScanned(m_pData, m_pData);
 
+    // Terminate the line in place, as the field values.
+    *pCRLF = '\0';
     size_t lineLen = pCRLF - m_pData;
     void* pLineObject = creator(m_pData, lineLen, m_pBuffer);
     m_ConsumedSize = lineLen + 2; // Add CRLF
@@ -58,57 +66,59 @@ ErrorCode CHeaderParser::BuildHeaderField(CHeaderField* pHeaderField)
 {
     ASSERT(pHeaderField);
 
-    char* pCur = m_pData;
+    /*
+    * field-name     = token
+    * token          = 1*tchar
+    * tchar          = "!" / "#" / "$" / "%" / "&" / "'" / "*" /
+    *                  "+" / "-" / "." / "^" / "_" / "`" / "|" /
+    *                  "~" / DIGIT / ALPHA
+    *                  ; any VCHAR, except delimiters
+    *
+    * field-value    = *( field-content / obs-fold )
+    * field-content  = field-vchar [ 1*( SP / HTAB ) field-vchar ]
+    * field-vchar    = VCHAR / obs-text
+    * obs-fold       = CRLF 1*( SP / HTAB )
+    */
+    char* pCur = m_pData;   // The begin of the line
     char* pEnd = m_pData + m_DataLength;
-    char* pCRLF = const_cast<char*>(
-        NSCharHelper::FindSubStr("\r\n", 2, pCur, pEnd));
-    ErrorCode resErr = EC_UNKNOWN;
-
-    while (pCRLF) {
-        char* pNewline = pCRLF + 2;
+    char* pScan = GetScanBegin();
+    ErrorCode resErr = EC_INPROGRESS;
+
+    while (true) {
+        char* pCRLF = const_cast<char*>(NSCharScanner::FindCRLF(pScan, pEnd));
+        if (pCRLF == NULL) {
+            // Need more data, the last CR may be followed by LF.
+            SaveScanned(pCur, pEnd[-1] == '\r' ? pEnd - 1 : pEnd);
+            break;
+        }
         if (pCRLF == pCur) {
             // Empty line with only CRLF, which means we reach the end of Header Field.
             m_ConsumedSize += 2;
+            SaveScanned(pCur, pCur);
             resErr = EC_SUCCESS;
             break;
         }
 
-        /* 
-        * field-name     = token
-        * token          = 1*tchar
-        * tchar          = "!" / "#" / "$" / "%" / "&" / "'" / "*" /
-        *                  "+" / "-" / "." / "^" / "_" / "`" / "|" /
-        *                  "~" / DIGIT / ALPHA
-        *                  ; any VCHAR, except delimiters
-        * 
-        * field-value    = *( field-content / obs-fold )
-        * field-content  = field-vchar [ 1*( SP / HTAB ) field-vchar ]
-        * field-vchar    = VCHAR / obs-text
-        * obs-fold       = CRLF 1*( SP / HTAB )
-        */
-        bool bSpaceBegin = false;
-        while (pNewline < pEnd && (bSpaceBegin = (*pNewline == ' ' || *pNewline == '\t'))) {
-            // Obsolete fold: Replace CRLF by SPs
-            *pCRLF = ' ';
-            *++pCRLF = ' ';
-            pCRLF = const_cast<char*>(NSCharHelper::FindSubStr("\r\n", 2, pNewline, pEnd));
-            if (!pCRLF) {
-                // We need more data to identify if this obs-fold
-                resErr = EC_INPROGRESS;
-                break;
-            }
-            pNewline = pCRLF + 2;
-        }
+        char* pNewline = pCRLF + 2;
         if (pNewline == pEnd) {
-            // We need more data to identify if this obs-fold
-            resErr = EC_INPROGRESS;
+            // We need more data to identify if this is obs-fold,
+            // start from the CRLF next time.
+            SaveScanned(pCur, pCRLF);
             break;
         }
-
-        m_ConsumedSize += pCRLF - pCur + 2;
+        if (*pNewline == ' ' || *pNewline == '\t') {
+            // Obsolete fold: Replace CRLF by SPs and go on with the line.
+            pCRLF[0] = ' ';
+            pCRLF[1] = ' ';
+            pScan = pNewline;
+            continue;
+        }
 
         // A normal field value or reach the end of obs-fold.
         // Start to decode it.
+        m_ConsumedSize += pNewline - pCur;
+        SaveScanned(pCur, pCur);
+
         char* pName = NULL;
         char* pValue = NULL;
         resErr = DecodeHeaderField(pCur, pCRLF, &pName, &pValue);
@@ -117,7 +127,6 @@ ErrorCode CHeaderParser::BuildHeaderField(CHeaderField* pHeaderField)
                 "DecodeHeaderField failed: %s\n", GetErrorPhrase(resErr));
             break;
         }
-
         if (pName && pValue) {
             pHeaderField->SetFieldValue(pName, pValue);
         } else {
@@ -128,10 +137,8 @@ ErrorCode CHeaderParser::BuildHeaderField(CHeaderField* pHeaderField)
         }
 
         // Prepare the next
-        pCur = pNewline;
-        if (pCur < pEnd) {
-            pCRLF = const_cast<char*>(NSCharHelper::FindSubStr("\r\n", 2, pCur, pEnd));
-        }
+        resErr = EC_INPROGRESS;
+        pCur = pScan = pNewline;
     }
 
     return resErr;
@@ -146,17 +153,13 @@ ErrorCode CHeaderParser::DecodeHeaderField(
     *pKey = *pValue = NULL;
 
     // Find Field Name.
-    while (pCur < pEnd) {
-        if (IsTokenChar(*pCur)) {
-            ++pCur;
-            continue;
-        }
+    pCur = const_cast<char*>(NSCharScanner::FindNonTokenChar(pCur, pEnd));
+    if (pCur < pEnd) {
         if (*pCur != ':') {
             OUTPUT_WARNING_TRACE("Expect ':' while get %d\n", *pCur);
             return EC_PROTOCOL_MALFORMAT;
         }
         *pCur++ = '\0';
-        break;
     }
     *pKey = pBegin;
 
@@ -188,8 +191,5 @@ ErrorCode CHeaderParser::DecodeHeaderField(
 
 bool CHeaderParser::IsTokenChar(char c)
 {
-    return isalnum(c) ||
-           c == '!' || c == '#' || c == '$' || c == '%' || c == '&' ||
-           c == '\'' || c =='*' || c == '+' || c == '-' || c == '.' ||
-           c == '^' || c == '_' || c == '`' || c == '|' || c == '~';
+    return NSCharScanner::IsTokenChar(c);
 }
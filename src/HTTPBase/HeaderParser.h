@@ -23,7 +23,23 @@ class CRequestLine;
 class CHeaderParser
 {
 public:
-    CHeaderParser(char* pData, size_t len, CLazyBuffer* pBuffer = NULL);
+    /**
+     * @brief The progress on the data which is not consumed, kept by the
+     *        caller between the parsers created on the same data with more
+     *        received, so the scanned octets are not scanned again.
+     */
+    struct ResumeState {
+        size_t ScannedSize;     // No line end in the leading octets
+
+        ResumeState() : ScannedSize(0) {}
+        void Reset() { ScannedSize = 0; }
+    };
+
+    CHeaderParser(
+        char* pData,
+        size_t len,
+        CLazyBuffer* pBuffer = NULL,
+        ResumeState* pState = NULL);
     ~CHeaderParser();
 
     size_t GetConsumedSize() { return m_ConsumedSize; }
@@ -35,10 +51,14 @@ public:
         return EC_UNKNOWN;
     }
 
-    ErrorCode CreateStatusLine(CStatusLine** pStatusLine)
+    /**
+     * @param bReferPhrase Refer to the status phrase in the parsed data
+     *        instead of copying it into the buffer.
+     */
+    ErrorCode CreateStatusLine(CStatusLine** pStatusLine, bool bReferPhrase = false)
     {
-        *pStatusLine = reinterpret_cast<CStatusLine*>(
-            BuildStartedLine(CStatusLine::CreateInstance1));
+        *pStatusLine = reinterpret_cast<CStatusLine*>(BuildStartedLine(
+            bReferPhrase ? CStatusLine::CreateInstance2 : CStatusLine::CreateInstance1));
         return GetStandardErrorCode(ERROR_CODE);
     }
 
@@ -49,6 +69,17 @@ public:
 private:
     void* BuildStartedLine(void* (*creator)(const char*, size_t, CLazyBuffer*));
 
+    char* GetScanBegin() const
+    {
+        return m_pState ? m_pData + m_pState->ScannedSize : m_pData;
+    }
+    void SaveScanned(const char* pLine, const char* pScanned)
+    {
+        if (m_pState) {
+            m_pState->ScannedSize = pScanned - pLine;
+        }
+    }
+
     static ErrorCode DecodeHeaderField(char* pBegin, char* pEnd,
                                        char** pKey, char** pValue);
 
@@ -56,6 +87,7 @@ private:
     char* m_pData;
     size_t m_DataLength;
     CLazyBuffer* m_pBuffer;
+    ResumeState* m_pState;      // Not owned
     size_t m_ConsumedSize;
 
     static const char* s_pTokenDelimiters;
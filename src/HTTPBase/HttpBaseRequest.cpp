@@ -12,6 +12,7 @@
 #include "Common/CharHelper.h"
 #include "Tracker/Trace.h"
 #include <cstdio>
+#include <sys/uio.h>
 
 CHttpBaseRequest::CHttpBaseRequest(
     tTokenID method,
@@ -26,10 +27,15 @@ CHttpBaseRequest::CHttpBaseRequest(
     m_pRespHFConfig(pRespHFConfig),
     m_pStatusLine(NULL),
     m_pRespHeaderField(NULL),
+    m_pReferredData(NULL),
+    m_RespParseState(),
     m_State(SR_INITAITED),
     m_SerializeStatus(SERIALIZE_START_LINE),
     m_ProcessRespStatus(PROCESS_RESP_STATUS_LINE)
 {
+#ifdef __MEMORY_STATS__
+    m_Buffer.EnableStats("HttpMessage");
+#endif
 }
 
 CHttpBaseRequest::CHttpBaseRequest(
@@ -46,10 +52,15 @@ CHttpBaseRequest::CHttpBaseRequest(
     m_pRespHFConfig(pRespHFConfig),
     m_pStatusLine(NULL),
     m_pRespHeaderField(NULL),
+    m_pReferredData(NULL),
+    m_RespParseState(),
     m_State(SR_INITAITED),
     m_SerializeStatus(SERIALIZE_START_LINE),
     m_ProcessRespStatus(PROCESS_RESP_STATUS_LINE)
 {
+#ifdef __MEMORY_STATS__
+    m_Buffer.EnableStats("HttpMessage");
+#endif
 }
 
 CHttpBaseRequest::CHttpBaseRequest(
@@ -68,10 +79,15 @@ CHttpBaseRequest::CHttpBaseRequest(
     m_pRespHFConfig(pRespHFConfig),
     m_pStatusLine(NULL),
     m_pRespHeaderField(NULL),
+    m_pReferredData(NULL),
+    m_RespParseState(),
     m_State(SR_INITAITED),
     m_SerializeStatus(SERIALIZE_START_LINE),
     m_ProcessRespStatus(PROCESS_RESP_STATUS_LINE)
 {
+#ifdef __MEMORY_STATS__
+    m_Buffer.EnableStats("HttpMessage");
+#endif
 }
 
 CHttpBaseRequest::~CHttpBaseRequest()
@@ -125,12 +141,25 @@ bool CHttpBaseRequest::Serialize(uint8_t* pBuffer, size_t bufLen, size_t* pOutLe
         m_SerializeStatus = SERIALIZE_PAYLOAD;
         // Fall Through
     case SERIALIZE_PAYLOAD:
+    {
+        // The payload in memory or file is sent by the connection
+        // (GetPayloadIOVec, GetPayloadFile).
+        struct iovec ioVec;
+        tIOHandle hFile = INVALID_IO_HANDLE;
+        off_t offset = 0;
+        size_t fileLength = 0;
+        if (PeekPayload(&ioVec, 1) > 0 ||
+            PeekPayloadFile(&hFile, &offset, &fileLength)) {
+            return false;
+        }
         bFinished = SerializePayload(pCur, pEnd - pCur, &curPrintLen);
+        *pOutLen += curPrintLen;
         if (bFinished) {
             m_SerializeStatus = SERIALIZE_COMPLETE;
             m_State = SR_RECVING;
         }
         break;
+    }
     case SERIALIZE_COMPLETE:
         bFinished = true;
         break;
@@ -161,12 +190,15 @@ ErrorCode CHttpBaseRequest::OnResponse(
     case PROCESS_RESP_STATUS_LINE:
     {
         ASSERT(m_pStatusLine == NULL);
-        CHeaderParser parser(pCur, dataLen, &m_Buffer);
-        resErr = parser.CreateStatusLine(&m_pStatusLine);
+        CHeaderParser parser(pCur, dataLen, &m_Buffer, &m_RespParseState);
+        resErr = parser.CreateStatusLine(&m_pStatusLine, true);
         statusLineLen = parser.GetConsumedSize();
         if (m_pStatusLine == NULL) {
             break;
         }
+        // The status phrase and the field values refer to the received data
+        // until the header is handled, instead of being copied.
+        m_pReferredData = pData;
         m_ProcessRespStatus = PROCESS_RESP_HEADER_FIELD;
         pCur += statusLineLen;
         if (pCur == pEnd) {
@@ -178,18 +210,27 @@ ErrorCode CHttpBaseRequest::OnResponse(
     {
         CHeaderField* pHeaderField = m_pRespHeaderField;
         if (m_pRespHFConfig && pHeaderField == NULL) {
-            pHeaderField = CHeaderField::CreateInstance(m_pRespHFConfig, m_Buffer);
+            // Most of the received fields are never read, decode them on demand.
+            pHeaderField = CHeaderField::CreateInstance(m_pRespHFConfig, m_Buffer, NULL, true);
             if (pHeaderField == NULL) {
                 resErr = EC_NO_MEMORY;
                 break;
             }
             m_pRespHeaderField = pHeaderField;
         }
-        CHeaderParser parser(pCur, pEnd - pCur, &m_Buffer);
+        if (m_pReferredData == NULL) {
+            m_pReferredData = reinterpret_cast<uint8_t*>(pCur);
+        }
+        m_pRespHeaderField->ReferRawValues();
+
+        CHeaderParser parser(pCur, pEnd - pCur, &m_Buffer, &m_RespParseState);
         resErr = parser.BuildHeaderField(m_pRespHeaderField);
         headerFieldLen = parser.GetConsumedSize();
         pCur += headerFieldLen;
         if (resErr != EC_SUCCESS) {
+            if (resErr != EC_INPROGRESS) {
+                DropReferredData();
+            }
             break;
         }
         m_ProcessRespStatus = PROCESS_RESP_PAYLOAD;
@@ -198,12 +239,17 @@ ErrorCode CHttpBaseRequest::OnResponse(
             m_pStatusLine->GetStatusCode(),
             m_pStatusLine->GetStatusPhrase(),
             m_pRespHeaderField);
+
+        // The received header is only valid in HandleRespHeader,
+        // the values not decoded by then are not copied at all.
+        DropReferredData();
         if (resErr != EC_SUCCESS) {
             break;
         }
         // Fall through
     }
     case PROCESS_RESP_PAYLOAD:
+        ASSERT(m_pStatusLine == NULL && m_pReferredData == NULL);
         resErr = ReceiveRespPayload(
             reinterpret_cast<uint8_t*>(pCur), pEnd - pCur, &payloadLen);
         if (resErr == EC_SUCCESS) {
@@ -219,10 +265,61 @@ ErrorCode CHttpBaseRequest::OnResponse(
     return resErr;
 }
 
+size_t CHttpBaseRequest::GetPayloadIOVec(struct iovec* pIOVec, size_t count)
+{
+    if (m_SerializeStatus != SERIALIZE_PAYLOAD || count == 0) {
+        return 0;
+    }
+    return PeekPayload(pIOVec, count);
+}
+
+bool CHttpBaseRequest::GetPayloadFile(tIOHandle* pFile, off_t* pOffset, size_t* pLen)
+{
+    if (m_SerializeStatus != SERIALIZE_PAYLOAD) {
+        return false;
+    }
+    return PeekPayloadFile(pFile, pOffset, pLen);
+}
+
+void CHttpBaseRequest::OnPayloadSent(size_t len)
+{
+    ASSERT(m_SerializeStatus == SERIALIZE_PAYLOAD);
+    SkipPayload(len);
+}
+
+void CHttpBaseRequest::ReleaseReferredData()
+{
+    if (m_pReferredData == NULL) {
+        return;
+    }
+    if (m_pStatusLine && !m_pStatusLine->DetachPhrase(&m_Buffer)) {
+        OUTPUT_WARNING_TRACE("Drop the status phrase.\n");
+    }
+    if (m_pRespHeaderField) {
+        m_pRespHeaderField->DetachRawValues();
+    }
+    m_pReferredData = NULL;
+}
+
+void CHttpBaseRequest::DropReferredData()
+{
+    // Nothing reads the status line after the header is handled.
+    if (m_pStatusLine) {
+        m_pStatusLine->DropPhrase();
+        m_pStatusLine = NULL;
+    }
+    if (m_pReferredData && m_pRespHeaderField) {
+        m_pRespHeaderField->DropRawValues();
+    }
+    m_pReferredData = NULL;
+}
+
 void CHttpBaseRequest::OnReset()
 {
+    DropReferredData();
     m_State = SR_INITAITED;
     m_SerializeStatus = SERIALIZE_START_LINE;
     m_ProcessRespStatus = PROCESS_RESP_STATUS_LINE;
+    m_RespParseState.Reset();
     m_ReqHFAnchor = m_pReqHeaderField->AnchorBegin();
 }
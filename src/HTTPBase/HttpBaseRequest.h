@@ -14,6 +14,7 @@
 #include "DataCom/Request.h"
 #include "RequestLine.h"
 #include "HeaderField.h"
+#include "HeaderParser.h"
 #include "Token.h"
 #include "URI/URI.h"
 
@@ -34,6 +35,11 @@ public:
     bool Serialize(uint8_t* pBuf, size_t bufLen, size_t* pOutLen);
     ErrorCode OnResponse(uint8_t* pData, size_t dataLen, size_t* pConsumedLen);
     virtual void OnReset();
+    size_t GetPayloadIOVec(struct iovec* pIOVec, size_t count);
+    bool GetPayloadFile(tIOHandle* pFile, off_t* pOffset, size_t* pLen);
+    void OnPayloadSent(size_t len);
+    const uint8_t* GetReferredData() const { return m_pReferredData; }
+    void ReleaseReferredData();
 
     // Leave implemenation to the derived class.
     // virtual ErrorCode OnPeerClosed() = 0;
@@ -97,6 +103,24 @@ protected:
 private:
     virtual bool SerializePayload(
         uint8_t* pBuffer, size_t bufLen, size_t* pOutLen) = 0;
+
+    /**
+     * @brief Expose the payload in memory to be sent without copying,
+     *        SerializePayload is called after all of them are sent.
+     * @return The count of the filled blocks.
+     */
+    virtual size_t PeekPayload(struct iovec* pIOVec, size_t count) { return 0; }
+    virtual bool PeekPayloadFile(tIOHandle* pFile, off_t* pOffset, size_t* pLen)
+    {
+        return false;
+    }
+    virtual void SkipPayload(size_t len) {}
+
+    /**
+     * @note pStatusPhrase and the values of pHeaderField not decoded yet
+     *       refer to the received data, they are valid only in this call.
+     *       Decode (read) the fields needed later before returning.
+     */
     virtual ErrorCode HandleRespHeader(
         tTokenID versionID,
         int statusCode,
@@ -106,6 +130,8 @@ private:
         uint8_t* pData, size_t dataLen, size_t* pConsumedLen) = 0;
 
 private:
+    void DropReferredData();
+
     enum SerializeStatus {
         SERIALIZE_START_LINE,
         SERIALIZE_HEADER_FIELD,
@@ -126,6 +152,8 @@ private:
     const CHeaderField::GlobalConfig* m_pRespHFConfig;  // Not owned
     CStatusLine* m_pStatusLine;         // Not Owned directly (owned by m_Buffer)
     CHeaderField* m_pRespHeaderField;   // Owned
+    const uint8_t* m_pReferredData;     // The received response header referred in place
+    CHeaderParser::ResumeState m_RespParseState;
 
     SendRecvState m_State;
     SerializeStatus m_SerializeStatus;
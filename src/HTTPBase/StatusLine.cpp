@@ -44,9 +44,13 @@ CStatusLine::~CStatusLine()
 }
 
 CStatusLine* CStatusLine::CreateInstance(
-    const char* pString, size_t len, CLazyBuffer* pBuffer /* = NULL */)
+    const char* pString,
+    size_t len,
+    CLazyBuffer* pBuffer,
+    bool bReferPhrase /* = false */)
 {
     ASSERT(len > 0);
+    ASSERT_IF(bReferPhrase, pBuffer && pString[len] == '\0');
 
     tTokenID versionID;
     const char* pPhrase;
@@ -91,7 +95,13 @@ CStatusLine* CStatusLine::CreateInstance(
 
     uint8_t* pMem = NULL;
     char* pPhraseStr = NULL;
-    if (pPhrase) {
+    if (pPhrase && bReferPhrase) {
+        pMem = reinterpret_cast<uint8_t*>(pBuffer->Malloc(sizeof(CStatusLine)));
+        if (!pMem) {
+            return NULL;
+        }
+        pPhraseStr = const_cast<char*>(pPhrase);
+    } else if (pPhrase) {
         pMem = reinterpret_cast<uint8_t*>(
             pBuffer->Malloc(sizeof(CStatusLine) + phraseLen + 1));
         if (pMem == NULL) {
@@ -99,7 +109,7 @@ CStatusLine* CStatusLine::CreateInstance(
         }
         pPhraseStr = reinterpret_cast<char*>(pMem + sizeof(CStatusLine));
         memcpy(pPhraseStr, pPhrase, phraseLen);
-        pMem[phraseLen] = '\0';
+        pPhraseStr[phraseLen] = '\0';
     } else {
         pMem = reinterpret_cast<uint8_t*>(pBuffer->Malloc(sizeof(CStatusLine)));
         if (!pMem) {
@@ -110,6 +120,18 @@ CStatusLine* CStatusLine::CreateInstance(
     return new (pMem) CStatusLine(versionID, code, pPhraseStr, false);
 }
 
+bool CStatusLine::DetachPhrase(CLazyBuffer* pBuffer)
+{
+    ASSERT(pBuffer);
+    ASSERT(!m_bOwnPhrase);
+
+    if (m_pPhrase == NULL) {
+        return true;
+    }
+    m_pPhrase = const_cast<char*>(pBuffer->StoreString(m_pPhrase));
+    return m_pPhrase != NULL;
+}
+
 bool CStatusLine::Print(char* pBuffer, size_t len, size_t* pOutPrintLen)
 {
     ASSERT(len > 0);
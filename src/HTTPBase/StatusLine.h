@@ -26,11 +26,29 @@ public:
     int GetStatusCode() const { return m_StatusCode; }
     const char* GetStatusPhrase() const { return m_pPhrase; }
 
-    static CStatusLine* CreateInstance(const char* pString, size_t len, CLazyBuffer* pBuffer);
+    /**
+     * @brief Copy the phrase which is referred in place.
+     */
+    bool DetachPhrase(CLazyBuffer* pBuffer);
+    void DropPhrase() { m_pPhrase = NULL; }
+
+    /**
+     * @param bReferPhrase Refer to the phrase in pString instead of copying
+     *        it, pString must be terminated by '\0' and kept by the caller.
+     */
+    static CStatusLine* CreateInstance(
+        const char* pString,
+        size_t len,
+        CLazyBuffer* pBuffer,
+        bool bReferPhrase = false);
     static void* CreateInstance1(const char* pString, size_t len, CLazyBuffer* pBuffer)
     {
         return CreateInstance(pString, len, pBuffer);
     }
+    static void* CreateInstance2(const char* pString, size_t len, CLazyBuffer* pBuffer)
+    {
+        return CreateInstance(pString, len, pBuffer, true);
+    }
 
 private:
     tTokenID m_VersionID;
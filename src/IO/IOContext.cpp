@@ -29,6 +29,24 @@ size_t CIOContext::DoWrite(void* pBuf, size_t len)
     return writeLen;
 }
 
+size_t CIOContext::DoWriteV(const struct iovec* pIOVec, int count)
+{
+    size_t writeLen = NSIOHelper::WriteV(m_hIO, pIOVec, count);
+    if (writeLen == 0) {
+        HandleError(ERROR_CODE);
+    }
+    return writeLen;
+}
+
+size_t CIOContext::DoSendFile(tIOHandle hFile, off_t offset, size_t len)
+{
+    size_t sendLen = NSIOHelper::SendFile(m_hIO, hFile, offset, len);
+    if (sendLen == 0) {
+        HandleError(ERROR_CODE);
+    }
+    return sendLen;
+}
+
 void CIOContext::HandleError(int errorCode)
 {
     switch (errorCode) {
@@ -12,6 +12,7 @@
 #include "Common/Typedefs.h"
 #include "Tracker/Trace.h"
 #include <unistd.h>
+#include <sys/uio.h>
 
 class CIOContext
 {
@@ -53,6 +54,32 @@ public:
         return writeBytes;
     }
 
+    /**
+     * @brief Write the buffers in order with as few calls as possible.
+     * @return The written bytes, the buffers may be partially written.
+     */
+    size_t WriteV(const struct iovec* pIOVec, int count)
+    {
+        size_t writeBytes = DoWriteV(pIOVec, count);
+        if (m_Status != IOS_OK) {
+            m_bWritable = false;
+        }
+        return writeBytes;
+    }
+
+    /**
+     * @brief Send the file region to the IO.
+     * @return The sent bytes.
+     */
+    size_t SendFile(tIOHandle hFile, off_t offset, size_t len)
+    {
+        size_t sendBytes = DoSendFile(hFile, offset, len);
+        if (m_Status != IOS_OK) {
+            m_bWritable = false;
+        }
+        return sendBytes;
+    }
+
     IOStatus GetStatus() const { return m_Status; }
     tIOHandle GetHandle() const { return m_hIO; } 
     bool IsBlockMode() const { return m_bBlockMode; }
@@ -86,11 +113,13 @@ public:
         m_hIO = INVALID_IO_HANDLE;
     }
 
-
-private:
+protected:
     virtual size_t DoRead(void* pBuf, size_t len);
     virtual size_t DoWrite(void* pBuf, size_t len);
+    virtual size_t DoWriteV(const struct iovec* pIOVec, int count);
+    virtual size_t DoSendFile(tIOHandle hFile, off_t offset, size_t len);
 
+private:
     void HandleError(int errorCode);
 
 protected:
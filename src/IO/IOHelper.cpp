@@ -11,6 +11,7 @@
 #include <cstring>
 #include <unistd.h>
 #include <fcntl.h>
+#include <sys/sendfile.h>
 #include <errno.h>
 #include "Common/ErrorNo.h"
 #include "Tracker/Trace.h"
@@ -67,7 +68,7 @@ size_t NSIOHelper::Write(tIOHandle io, void* buf, size_t len)
     while (totalWriteBytes < len) {
         size_t toWriteBytes = len - totalWriteBytes;
 
-        res = write(io, buf, toWriteBytes);
+        res = write(io, reinterpret_cast<uint8_t*>(buf) + totalWriteBytes, toWriteBytes);
         if (res < 0) {
             if (errno == EINTR) {
                 continue;
@@ -80,6 +81,47 @@ size_t NSIOHelper::Write(tIOHandle io, void* buf, size_t len)
     return totalWriteBytes;
 }
 
+size_t NSIOHelper::WriteV(tIOHandle io, const struct iovec* pIOVec, int count)
+{
+    ssize_t res = 0;
+    do {
+        res = writev(io, pIOVec, count);
+        if (res >= 0) {
+            break;
+        }
+        if (errno != EINTR) {
+            SET_ERROR_CODE(errno);
+            res = 0;
+            break;
+        }
+        // EINTR
+    } while (true);
+    return static_cast<size_t>(res);
+}
+
+size_t NSIOHelper::SendFile(tIOHandle io, tIOHandle file, off_t offset, size_t len)
+{
+    ssize_t res = 0;
+    do {
+        res = sendfile(io, file, &offset, len);
+        if (res == 0 && len > 0) {
+            // The file ends before the region, e.g. it is truncated.
+            SET_ERROR_CODE(EIO);
+            break;
+        }
+        if (res >= 0) {
+            break;
+        }
+        if (errno != EINTR) {
+            SET_ERROR_CODE(errno);
+            res = 0;
+            break;
+        }
+        // EINTR
+    } while (true);
+    return static_cast<size_t>(res);
+}
+
 long int NSIOHelper::GetFileSize(FILE* fp)
 {
     ASSERT(fp != NULL);
@@ -11,6 +11,8 @@
 
 #include "Common/Typedefs.h"
 #include <stdio.h>
+#include <sys/uio.h>
+#include <sys/types.h>
 
 namespace NSIOHelper
 {
@@ -19,6 +21,19 @@ namespace NSIOHelper
     size_t Read(tIOHandle io, void* buf, size_t bytes);
     size_t Write(tIOHandle io, void* buf, size_t bytes);
 
+    /**
+     * @brief Gather write, one writev call.
+     * @return The written bytes, 0 if failed (error code is set).
+     */
+    size_t WriteV(tIOHandle io, const struct iovec* pIOVec, int count);
+
+    /**
+     * @brief Send the file region by the kernel (sendfile), one call.
+     * @return The sent bytes, 0 if failed (error code is set). If the file
+     *         ends before the region, 0 is returned and the error code is EIO.
+     */
+    size_t SendFile(tIOHandle io, tIOHandle file, off_t offset, size_t len);
+
     long int GetFileSize(FILE* fp);
 };
 
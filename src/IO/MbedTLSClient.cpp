@@ -10,44 +10,41 @@
 
 #include "MbedTLSClient.h"
 #include "TLS/CertManager.h"
+#include "TLS/SessionCache.h"
 #include <cstring>
 
 using std::strlen;
+using std::memcpy;
 
-const char* CMbedTLSClient::s_pCustomerString = "mbed TLS client";
-const size_t CMbedTLSClient::s_CustStrLen = strlen(s_pCustomerString);
+///////////////////////////////////////////////////////////////////////////////
+//
+// CMbedTLSClient::CTLSConfig Implemenation
+//
+///////////////////////////////////////////////////////////////////////////////
+const char* CMbedTLSClient::CTLSConfig::s_pCustomerString = "mbed TLS client";
+const size_t CMbedTLSClient::CTLSConfig::s_CustStrLen = strlen(s_pCustomerString);
 
-CMbedTLSClient::CMbedTLSClient(CIOContext* pIO, bool bCheckPeerCert) :
-    CSSLClient(pIO),
-    m_bCheckPeerCert(bCheckPeerCert),
-    m_Flags(0)
+CMbedTLSClient::CTLSConfig::CTLSConfig() : m_RandomCS()
 {
-    mbedtls_ssl_init(&m_SSL);
-    mbedtls_ssl_config_init(&m_Config);
+    mbedtls_entropy_init(&m_Entropy);
     mbedtls_ctr_drbg_init(&m_CtrDrbg);
-    mbedtls_x509_crt_init(&m_RootCA);
-    mbedtls_x509_crt_init(&m_MyCert);
     mbedtls_pk_init(&m_Privatekey);
-    m_NetContext.fd = INVALID_IO_HANDLE;
+    mbedtls_ssl_config_init(&m_Config);
+    mbedtls_ssl_config_init(&m_VerifyConfig);
 }
 
-CMbedTLSClient::~CMbedTLSClient()
+CMbedTLSClient::CTLSConfig::~CTLSConfig()
 {
-    Close();
-    mbedtls_x509_crt_free(&m_MyCert);
-    mbedtls_x509_crt_free(&m_RootCA);
-    mbedtls_pk_free(&m_Privatekey);
-    mbedtls_ssl_free(&m_SSL);
+    mbedtls_ssl_config_free(&m_VerifyConfig);
     mbedtls_ssl_config_free(&m_Config);
+    mbedtls_pk_free(&m_Privatekey);
     mbedtls_ctr_drbg_free(&m_CtrDrbg);
     mbedtls_entropy_free(&m_Entropy);
 }
 
-
-bool CMbedTLSClient::Initialize()
+bool CMbedTLSClient::CTLSConfig::Initialize()
 {
     // 1) Seeding the random number generator
-    mbedtls_entropy_init(&m_Entropy);
     int res = mbedtls_ctr_drbg_seed(
         &m_CtrDrbg, mbedtls_entropy_func, &m_Entropy,
         reinterpret_cast<const unsigned char*>(s_pCustomerString), s_CustStrLen);
@@ -56,33 +53,31 @@ bool CMbedTLSClient::Initialize()
         return false;
     }
 
-    // 2) Loading the CA root certificate
-    res = mbedtls_x509_crt_parse_file(&m_RootCA, CCertManager::Instance()->RootCA());
-    if(res < 0) {
+    // 2) Loading the client private key, the certificates are parsed
+    //    by CCertManager.
+    res = mbedtls_pk_parse_keyfile(&m_Privatekey, CCertManager::Instance()->MyPrivateKey(), "");
+    if (res != 0) {
         OUTPUT_WARNING_TRACE(
-            "mbedtls_x509_crt_parse failed -0x%x while parsing root cert\n", -res);
+            "mbedtls_pk_parse_keyfile failed -0x%x while parsing client private key\n", -res);
         return false;
     }
 
-    // 3) Loading the client self certifcation.
-    res = mbedtls_x509_crt_parse_file(&m_MyCert, CCertManager::Instance()->MyCert());
-    if(res < 0) {
-        OUTPUT_WARNING_TRACE(
-            "mbedtls_x509_crt_parse failed -0x%x while parsing client self cert\n", -res);
-        return false;
-    }
+    // 3) Setting up the SSL/TLS configure structures
+    return SetupConfig(&m_Config, MBEDTLS_SSL_VERIFY_OPTIONAL) &&
+           SetupConfig(&m_VerifyConfig, MBEDTLS_SSL_VERIFY_REQUIRED);
+}
 
-    // 4) Loading the client private key.
-    res = mbedtls_pk_parse_keyfile(&m_Privatekey, CCertManager::Instance()->MyPrivateKey(), "");
-    if (res != 0) {
-        OUTPUT_WARNING_TRACE(
-            "mbedtls_pk_parse_keyfile failed -0x%x while parsing client private key\n", -res);
+bool CMbedTLSClient::CTLSConfig::SetupConfig(mbedtls_ssl_config* pConfig, int authMode)
+{
+    CX509Cert* pRootCA = CCertManager::Instance()->RootCACert();
+    CX509Cert* pMyCert = CCertManager::Instance()->MyCertChain();
+    if (pRootCA == NULL || pMyCert == NULL) {
+        OUTPUT_WARNING_TRACE("The certificates are not loaded.\n");
         return false;
     }
 
-    // 5) Setting up the SSL/TLS configure structure
-    res = mbedtls_ssl_config_defaults(
-        &m_Config,
+    int res = mbedtls_ssl_config_defaults(
+        pConfig,
         MBEDTLS_SSL_IS_CLIENT,
         MBEDTLS_SSL_TRANSPORT_STREAM,
         MBEDTLS_SSL_PRESET_DEFAULT);
@@ -91,26 +86,58 @@ bool CMbedTLSClient::Initialize()
         return false;
     }
 
-    // 6) Certificate configure options.
-//    mbedtls_ssl_conf_verify(&m_Config, VerifyCertificate, NULL);
-    mbedtls_ssl_conf_verify(&m_Config, NULL, NULL);
-    if (m_bCheckPeerCert) {
-        mbedtls_ssl_conf_authmode(&m_Config, MBEDTLS_SSL_VERIFY_REQUIRED);
-    } else {
-        mbedtls_ssl_conf_authmode(&m_Config, MBEDTLS_SSL_VERIFY_OPTIONAL);
-    }
-    mbedtls_ssl_conf_rng(&m_Config, mbedtls_ctr_drbg_random, &m_CtrDrbg);
+    // Certificate configure options.
+//    mbedtls_ssl_conf_verify(pConfig, VerifyCertificate, NULL);
+    mbedtls_ssl_conf_verify(pConfig, NULL, NULL);
+    mbedtls_ssl_conf_authmode(pConfig, authMode);
+    mbedtls_ssl_conf_rng(pConfig, Random, this);
 
-    mbedtls_ssl_conf_ca_chain(&m_Config, &m_RootCA, NULL);
+    mbedtls_ssl_conf_ca_chain(pConfig, pRootCA->GetData(), NULL);
     // Check self certifcate
-    res = mbedtls_ssl_conf_own_cert(&m_Config, &m_MyCert, &m_Privatekey);
+    res = mbedtls_ssl_conf_own_cert(pConfig, pMyCert->GetData(), &m_Privatekey);
     if (res != 0) {
         OUTPUT_WARNING_TRACE("mbedtls_ssl_conf_own_cert returned -0x%x\n", -res);
         return false;
     }
+    return true;
+}
+
+int CMbedTLSClient::CTLSConfig::Random(void* pConfig, unsigned char* pBuf, size_t len)
+{
+    CTLSConfig* pObject = reinterpret_cast<CTLSConfig*>(pConfig);
+    CSectionLock lock(pObject->m_RandomCS);
+    return mbedtls_ctr_drbg_random(&pObject->m_CtrDrbg, pBuf, len);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// CMbedTLSClient Implemenation
+//
+///////////////////////////////////////////////////////////////////////////////
+CMbedTLSClient::CMbedTLSClient(CIOContext* pIO, bool bCheckPeerCert) :
+    CSSLClient(pIO),
+    m_bCheckPeerCert(bCheckPeerCert),
+    m_Flags(0)
+{
+    mbedtls_ssl_init(&m_SSL);
+    m_NetContext.fd = INVALID_IO_HANDLE;
+}
+
+CMbedTLSClient::~CMbedTLSClient()
+{
+    Close();
+    mbedtls_ssl_free(&m_SSL);
+}
+
+bool CMbedTLSClient::Initialize()
+{
+    CTLSConfig* pConfig = CTLSConfig::GetInstance();
+    if (pConfig == NULL) {
+        return false;
+    }
 
-    // 7) Link the configuration and the SSL context
-    res = mbedtls_ssl_setup(&m_SSL, &m_Config);
+    // Link the shared configuration and the SSL context
+    int res = mbedtls_ssl_setup(&m_SSL, pConfig->GetData(m_bCheckPeerCert));
     if (res != 0) {
         OUTPUT_WARNING_TRACE("mbedtls_ssl_setup returned -0x%x\n", -res);
         return false;
@@ -152,6 +179,8 @@ int CMbedTLSClient::Handshake(IOStatus* pStatus)
             OUTPUT_WARNING_TRACE("Unable to verify peer certificate.\n");
             res = -1;
             *pStatus = IOS_LOCAL_ERROR;
+        } else {
+            SaveSession();
         }
 #ifdef __DEBUG_CERTIFICATE__
         if (!m_bCheckPeerCert) {
@@ -193,6 +222,87 @@ int CMbedTLSClient::Handshake(IOStatus* pStatus)
     return res;
 }
 
+bool CMbedTLSClient::ResumeSession(const uint8_t* pData, size_t len)
+{
+    const SessionData* pSessionData = reinterpret_cast<const SessionData*>(pData);
+    if (len < sizeof(SessionData) ||
+        len != sizeof(SessionData) + pSessionData->TicketLength ||
+        pSessionData->IDLength > sizeof(pSessionData->ID)) {
+        return false;
+    }
+
+    mbedtls_ssl_session session;
+    mbedtls_ssl_session_init(&session);
+#if defined(MBEDTLS_HAVE_TIME)
+    session.start = pSessionData->StartTime;
+#endif
+    session.ciphersuite = pSessionData->CipherSuite;
+    session.compression = pSessionData->Compression;
+    session.id_len = pSessionData->IDLength;
+    memcpy(session.id, pSessionData->ID, sizeof(session.id));
+    memcpy(session.master, pSessionData->Master, sizeof(session.master));
+    session.verify_result = pSessionData->VerifyResult;
+#if defined(MBEDTLS_SSL_SESSION_TICKETS) && defined(MBEDTLS_SSL_CLI_C)
+    if (pSessionData->TicketLength > 0) {
+        // Freed by mbedtls_ssl_session_free.
+        session.ticket = reinterpret_cast<unsigned char*>(
+            mbedtls_calloc(1, pSessionData->TicketLength));
+        if (session.ticket == NULL) {
+            return false;
+        }
+        memcpy(session.ticket, pSessionData->Ticket, pSessionData->TicketLength);
+        session.ticket_len = pSessionData->TicketLength;
+        session.ticket_lifetime = pSessionData->TicketLifetime;
+    }
+#endif
+    int res = mbedtls_ssl_set_session(&m_SSL, &session);
+    mbedtls_ssl_session_free(&session);
+    return res == 0;
+}
+
+void CMbedTLSClient::SaveSession()
+{
+    mbedtls_ssl_session session;
+    mbedtls_ssl_session_init(&session);
+    if (mbedtls_ssl_get_session(&m_SSL, &session) != 0) {
+        mbedtls_ssl_session_free(&session);
+        return;
+    }
+
+    uint8_t buffer[CTLSSessionCache::MAX_SESSION_SIZE];
+    SessionData* pSessionData = reinterpret_cast<SessionData*>(buffer);
+    size_t ticketLen = 0;
+    unsigned int lifetime = CTLSSessionCache::DEFAULT_LIFETIME;
+#if defined(MBEDTLS_SSL_SESSION_TICKETS) && defined(MBEDTLS_SSL_CLI_C)
+    ticketLen = session.ticket_len;
+    if (session.ticket_lifetime > 0 && session.ticket_lifetime < lifetime) {
+        lifetime = session.ticket_lifetime;
+    }
+#endif
+    if (sizeof(SessionData) + ticketLen <= sizeof(buffer) &&
+        (session.id_len > 0 || ticketLen > 0)) {
+        memset(pSessionData, 0, sizeof(SessionData));
+#if defined(MBEDTLS_HAVE_TIME)
+        pSessionData->StartTime = session.start;
+#endif
+        pSessionData->CipherSuite = session.ciphersuite;
+        pSessionData->Compression = session.compression;
+        pSessionData->IDLength = session.id_len;
+        memcpy(pSessionData->ID, session.id, sizeof(pSessionData->ID));
+        memcpy(pSessionData->Master, session.master, sizeof(pSessionData->Master));
+        pSessionData->VerifyResult = session.verify_result;
+#if defined(MBEDTLS_SSL_SESSION_TICKETS) && defined(MBEDTLS_SSL_CLI_C)
+        pSessionData->TicketLifetime = session.ticket_lifetime;
+        pSessionData->TicketLength = ticketLen;
+        if (ticketLen > 0) {
+            memcpy(pSessionData->Ticket, session.ticket, ticketLen);
+        }
+#endif
+        OnNewSession(buffer, sizeof(SessionData) + ticketLen, lifetime);
+    }
+    mbedtls_ssl_session_free(&session);
+}
+
 size_t CMbedTLSClient::DoRead(void* pBuf, size_t len)
 {
     int res = 0;
@@ -13,6 +13,8 @@
 
 #include "SSLClient.h"
 #include "Common/Typedefs.h"
+#include "Common/Singleton.h"
+#include "Thread/Lock.h"
 #include "TLS/X509Cert.h"
 
 #include "mbedtls/config.h"
@@ -40,37 +42,86 @@ public:
     void Close();
 
 private:
-    CMbedTLSClient(CIOContext* pIO, bool bCheckPeerCert);    
+    /**
+     * @brief The SSL configurations shared by all the clients, one for each
+     *        peer certificate checking mode, not modified after initialized.
+     */
+    class CTLSConfig : public CSingleton2<CTLSConfig>
+    {
+    public:
+        ~CTLSConfig();
+        mbedtls_ssl_config* GetData(bool bCheckPeerCert)
+        {
+            return bCheckPeerCert ? &m_VerifyConfig : &m_Config;
+        }
+
+    private:
+        CTLSConfig();
+        bool Initialize();
+        bool SetupConfig(mbedtls_ssl_config* pConfig, int authMode);
+
+        /**
+         * @brief The random generator of the configurations, the mbed TLS
+         *        threading is not enabled so the DRBG is locked here.
+         */
+        static int Random(void* pConfig, unsigned char* pBuf, size_t len);
+
+    private:
+        mbedtls_entropy_context m_Entropy;
+        mbedtls_ctr_drbg_context m_CtrDrbg;
+        mbedtls_pk_context m_Privatekey;
+        mbedtls_ssl_config m_Config;        // The peer certificate is optional
+        mbedtls_ssl_config m_VerifyConfig;  // The peer certificate is required
+        CCriticalSection m_RandomCS;
+
+        static const char* s_pCustomerString;
+        static const size_t s_CustStrLen;
+
+        friend class CSingleton2<CTLSConfig>;
+    };
+
+    CMbedTLSClient(CIOContext* pIO, bool bCheckPeerCert);
 
     // From CSSLClient
     bool Initialize();
     void SetIO(tIOHandle io);
     int Handshake(IOStatus* pStatus);
+    bool ResumeSession(const uint8_t* pData, size_t len);
 
     // From CIOContext
     size_t DoRead(void* pBuf, size_t len);
     size_t DoWrite(void* pBuf, size_t len);
 
+    void SaveSession();
+
     static IOStatus HandleError(int sslCode);
     static int VerifyCertificate(
         void* pData, mbedtls_x509_crt* pCrt, int depth, uint32_t* pFlags);
 
 private:
+    /**
+     * @brief The resumable fields of mbedtls_ssl_session, the session
+     *        serialization is not provided by mbed TLS 2.1.
+     */
+    struct SessionData {
+        int64_t StartTime;
+        int32_t CipherSuite;
+        int32_t Compression;
+        uint32_t IDLength;
+        uint8_t ID[32];
+        uint8_t Master[48];
+        uint32_t VerifyResult;
+        uint32_t TicketLifetime;
+        uint32_t TicketLength;
+        uint8_t Ticket[0];
+    };
+
     bool m_bCheckPeerCert;
 
     uint32_t m_Flags;
-    mbedtls_entropy_context m_Entropy;
-    mbedtls_ctr_drbg_context m_CtrDrbg;
     mbedtls_ssl_context m_SSL;
-    mbedtls_ssl_config m_Config;
-    mbedtls_x509_crt m_RootCA;
-    mbedtls_x509_crt m_MyCert;
-    mbedtls_pk_context m_Privatekey;
     mbedtls_net_context m_NetContext;
 
-    static const char* s_pCustomerString;
-    static const size_t s_CustStrLen;
-
     friend class CSSLClient;
 
     DISALLOW_COPY_CONSTRUCTOR(CMbedTLSClient);
@@ -14,6 +14,8 @@
 #include <cstring>
 #include <cstdlib>
 #include "Common/ErrorNo.h"
+#include "TLS/CertManager.h"
+#include "TLS/SessionCache.h"
 #include "Tracker/Trace.h"
 
 using std::strerror;
@@ -37,6 +39,7 @@ bool COpenSSLClient::Initialize()
 {
     m_pSSL = SSL_new(CSSLContext::GetInstance()->GetData());
     if (m_pSSL) {
+        SSL_set_app_data(m_pSSL, this);
         return true;
     }
 
@@ -72,6 +75,18 @@ int COpenSSLClient::Handshake(IOStatus* pStatus)
     return res;
 }
 
+bool COpenSSLClient::ResumeSession(const uint8_t* pData, size_t len)
+{
+    const unsigned char* pSessionData = pData;
+    SSL_SESSION* pSession = d2i_SSL_SESSION(NULL, &pSessionData, len);
+    if (pSession == NULL) {
+        return false;
+    }
+    int res = SSL_set_session(m_pSSL, pSession);
+    SSL_SESSION_free(pSession);     // Referenced by m_pSSL
+    return res == 1;
+}
+
 size_t COpenSSLClient::DoRead(void* pBuf, size_t len)
 {
     int res = 0;
@@ -150,6 +165,23 @@ CX509Cert::CertStatus COpenSSLClient::CheckCertificate(SSL* pSSL)
     return CX509Cert::CERT_OK;
 }
 
+int COpenSSLClient::NewSessionCallback(SSL* pSSL, SSL_SESSION* pSession)
+{
+    COpenSSLClient* pClient = reinterpret_cast<COpenSSLClient*>(SSL_get_app_data(pSSL));
+    if (pClient == NULL) {
+        return 0;
+    }
+
+    uint8_t buffer[CTLSSessionCache::MAX_SESSION_SIZE];
+    int len = i2d_SSL_SESSION(pSession, NULL);
+    if (len > 0 && static_cast<size_t>(len) <= sizeof(buffer)) {
+        unsigned char* pData = buffer;
+        i2d_SSL_SESSION(pSession, &pData);
+        pClient->OnNewSession(buffer, len, SSL_SESSION_get_timeout(pSession));
+    }
+    return 0;   // The session is not referenced.
+}
+
 
 COpenSSLClient::CSSLContext::~CSSLContext()
 {
@@ -175,7 +207,52 @@ bool COpenSSLClient::CSSLContext::Initialize()
     OpenSSL_add_all_algorithms();
     SSL_load_error_strings();
     m_pContext = SSL_CTX_new(SSLv23_client_method());
-    return m_pContext != NULL;
+    if (m_pContext == NULL) {
+        return false;
+    }
+
+    // The sessions are kept in CTLSSessionCache, not the internal cache.
+    SSL_CTX_set_session_cache_mode(
+        m_pContext, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+    SSL_CTX_sess_set_new_cb(m_pContext, NewSessionCallback);
+    LoadCertificates();
+    return true;
+}
+
+void COpenSSLClient::CSSLContext::LoadCertificates()
+{
+    // The certificates parsed by CCertManager are referenced by the context,
+    // every SSL created from it shares them.
+    CCertManager* pManager = CCertManager::Instance();
+    CX509Cert* pRootCA = pManager->RootCACert();
+    if (pRootCA) {
+        X509_STORE* pStore = SSL_CTX_get_cert_store(m_pContext);
+        STACK_OF(X509)* pChain = pRootCA->GetData();
+        for (int i = 0; i < sk_X509_num(pChain); ++i) {
+            if (!X509_STORE_add_cert(pStore, sk_X509_value(pChain, i))) {
+                OUTPUT_WARNING_TRACE("X509_STORE_add_cert failed\n");
+                ERR_print_errors_fp(stderr);
+            }
+        }
+    }
+
+    CX509Cert* pMyCert = pManager->MyCertChain();
+    if (pMyCert) {
+        STACK_OF(X509)* pChain = pMyCert->GetData();
+        bool bRes = SSL_CTX_use_certificate(m_pContext, sk_X509_value(pChain, 0)) == 1;
+        for (int i = 1; bRes && i < sk_X509_num(pChain); ++i) {
+            bRes = SSL_CTX_add1_chain_cert(m_pContext, sk_X509_value(pChain, i)) == 1;
+        }
+        if (bRes) {
+            bRes = SSL_CTX_use_PrivateKey_file(
+                m_pContext, pManager->MyPrivateKey(), SSL_FILETYPE_PEM) == 1 &&
+                SSL_CTX_check_private_key(m_pContext) == 1;
+        }
+        if (!bRes) {
+            OUTPUT_WARNING_TRACE("Failed to load the client certificate\n");
+            ERR_print_errors_fp(stderr);
+        }
+    }
 }
 
 #endif
@@ -39,6 +39,7 @@ private:
     private:
         CSSLContext() : m_pContext(NULL) {}
         bool Initialize();
+        void LoadCertificates();
 
     private:
         SSL_CTX* m_pContext;
@@ -52,6 +53,7 @@ private:
     bool Initialize();
     void SetIO(tIOHandle io);
     int Handshake(IOStatus* pStatus);
+    bool ResumeSession(const uint8_t* pData, size_t len);
 
     // From CIOContext
     size_t DoRead(void* pBuf, size_t len);
@@ -72,6 +74,12 @@ private:
      */
     static CX509Cert::CertStatus CheckCertificate(SSL* pSSL);
 
+    /**
+     * @brief The new session callback of the SSL context, the session is
+     *        issued in the handshake, or after it (TLS 1.3 tickets).
+     */
+    static int NewSessionCallback(SSL* pSSL, SSL_SESSION* pSession);
+
 private:
     SSL* m_pSSL;
     bool m_bCheckPeerCert;
@@ -0,0 +1,101 @@
+/*
+ * See the file LICENSE for redistribution information.
+ *
+ * Copyright (c) 2015-2018, Yuan Qin <yuanqin2000 at outlook dot com>
+ * All rights reserved.
+ *
+ */
+
+#include "PollBackend.h"
+#include <cstring>
+#include <errno.h>
+#include <unistd.h>
+#include "Tracker/Trace.h"
+
+using std::memset;
+using std::strerror;
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// CPollBackend Implemenation
+//
+///////////////////////////////////////////////////////////////////////////////
+CPollBackend* CPollBackend::CreateInstance(Type type /* = PB_EPOLL */)
+{
+    ASSERT(type == PB_EPOLL);
+    return CEpollBackend::CreateInstance();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// CEpollBackend Implemenation
+//
+///////////////////////////////////////////////////////////////////////////////
+CEpollBackend::CEpollBackend() :
+    CPollBackend(PB_EPOLL),
+    m_hPollIO(INVALID_IO_HANDLE)
+{
+}
+
+CEpollBackend::~CEpollBackend()
+{
+    if (m_hPollIO != INVALID_IO_HANDLE) {
+        close(m_hPollIO);
+    }
+}
+
+CEpollBackend* CEpollBackend::CreateInstance()
+{
+    CEpollBackend* pInstance = new CEpollBackend();
+    if (pInstance) {
+        pInstance->m_hPollIO = epoll_create1(0);
+        if (pInstance->m_hPollIO < 0) {
+            OUTPUT_ERROR_TRACE("epoll_create1: %s\n", strerror(errno));
+            pInstance->m_hPollIO = INVALID_IO_HANDLE;
+            delete pInstance;
+            pInstance = NULL;
+        }
+    }
+    return pInstance;
+}
+
+bool CEpollBackend::Add(tIOHandle hIO, uint32_t eventMask)
+{
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.data.fd = hIO;
+    event.events = eventMask;
+    if (epoll_ctl(m_hPollIO, EPOLL_CTL_ADD, hIO, &event) < 0) {
+        OUTPUT_ERROR_TRACE("epoll_ctl: %s\n", strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+bool CEpollBackend::Remove(tIOHandle hIO)
+{
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.data.fd = hIO;
+    if (epoll_ctl(m_hPollIO, EPOLL_CTL_DEL, hIO, &event) < 0) {
+        OUTPUT_ERROR_TRACE("epoll_ctl: %s\n", strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+int CEpollBackend::Wait(Event* pOutEvents, size_t count, int timeout)
+{
+    ASSERT(count > 0);
+
+    if (count > MAX_EVENT_COUNT) {
+        count = MAX_EVENT_COUNT;
+    }
+    int eventCount = epoll_wait(m_hPollIO, m_Events, count, timeout);
+    for (int i = 0; i < eventCount; ++i) {
+        pOutEvents[i].hIO = m_Events[i].data.fd;
+        pOutEvents[i].Events = m_Events[i].events;
+    }
+    return eventCount;
+}
@@ -0,0 +1,89 @@
+/*
+ * See the file LICENSE for redistribution information.
+ *
+ * Copyright (c) 2015-2018, Yuan Qin <yuanqin2000 at outlook dot com>
+ * All rights reserved.
+ *
+ */
+
+#ifndef __IO_POLL_BACKEND_H__
+#define __IO_POLL_BACKEND_H__
+
+#include <sys/epoll.h>
+#include "Common/Typedefs.h"
+#include "Common/Macros.h"
+
+/**
+ * @brief The readiness notification mechanism of CPoller.
+ *        The IOs are registered edge-triggered, the events are EPOLL* bits.
+ *        The poll requests of io_uring are slower than epoll for readiness,
+ *        it pays off only if the completions carry the data, which needs
+ *        CIOContext to take the received data instead of reading the IO.
+ */
+class CPollBackend
+{
+public:
+    enum Type {
+        PB_EPOLL
+    };
+
+    struct Event {
+        tIOHandle hIO;
+        uint32_t Events;
+    };
+
+    virtual ~CPollBackend() {}
+
+    virtual bool Add(tIOHandle hIO, uint32_t eventMask) = 0;
+    virtual bool Remove(tIOHandle hIO) = 0;
+
+    /**
+     * @brief Wait for the events.
+     * @param timeout milli-seconds to wait, infinit wait if less than 0.
+     * @return The count of the events, -1 if failed (errno is set).
+     */
+    virtual int Wait(Event* pOutEvents, size_t count, int timeout) = 0;
+
+    Type GetType() const { return m_Type; }
+
+    static CPollBackend* CreateInstance(Type type = PB_EPOLL);
+
+protected:
+    CPollBackend(Type type) : m_Type(type) {}
+
+private:
+    const Type m_Type;
+
+    DISALLOW_COPY_CONSTRUCTOR(CPollBackend);
+    DISALLOW_ASSIGN_OPERATOR(CPollBackend);
+    DISALLOW_DEFAULT_CONSTRUCTOR(CPollBackend);
+};
+
+
+class CEpollBackend : public CPollBackend
+{
+public:
+    ~CEpollBackend();
+
+    // From CPollBackend
+    bool Add(tIOHandle hIO, uint32_t eventMask);
+    bool Remove(tIOHandle hIO);
+    int Wait(Event* pOutEvents, size_t count, int timeout);
+
+    static CEpollBackend* CreateInstance();
+
+private:
+    CEpollBackend();
+
+    static const size_t MAX_EVENT_COUNT = 64;
+
+private:
+    tIOHandle m_hPollIO;
+    struct epoll_event m_Events[MAX_EVENT_COUNT];
+
+    DISALLOW_COPY_CONSTRUCTOR(CEpollBackend);
+    DISALLOW_ASSIGN_OPERATOR(CEpollBackend);
+};
+
+
+#endif
@@ -17,7 +17,7 @@ class CPollClient
 {
 public:
     CPollClient(tIOHandle io, uint32_t eventMask) :
-        m_hIO(io), m_EventMask(eventMask)
+        m_hIO(io), m_EventMask(eventMask), m_bReady(false)
     {
         ASSERT(io != INVALID_IO_HANDLE);
         ASSERT(eventMask != 0);
@@ -38,6 +38,9 @@ public:
 private:
     const tIOHandle m_hIO;  // Not owned
     const uint32_t m_EventMask;
+    bool m_bReady;          // In the ready list of the poller.
+
+    friend class CPoller;
 };
 
 #endif
\ No newline at end of file
@@ -15,28 +15,26 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/time.h>
+#include <sys/eventfd.h>
 #include "PollClient.h"
 #include "IOHelper.h"
 #include "Common/ErrorNo.h"
 #include "Thread/Looper.h"
 #include "Tracker/Trace.h"
 
-using std::malloc;
-using std::free;
 using std::memset;
 using std::pair;
 
 CPoller::CPoller(IExtCmdHandler* pHandler) :
-    m_hCmdIO{INVALID_IO_HANDLE, INVALID_IO_HANDLE},
-    m_hPollIO(INVALID_IO_HANDLE),
+    m_hCmdEvent(INVALID_IO_HANDLE),
+    m_bDoorbellRung(0),
+    m_CmdQueue(CMD_QUEUE_CAPACITY),
+    m_pBackend(NULL),
     m_PollCount(0),
-    m_ReservedPollEventCount(0),
-    m_pPollEvents(NULL),
     m_IOClients(),
     m_pExtMsgHandle(pHandler),
-    m_CmdReadMemPool(CForwardList::ListNodeSize(sizeof(ITMessage))),
-    m_CmdReadCache(&m_CmdReadMemPool),
-    m_CmdReadBuffer{0}
+    m_ReadyMemPool(CForwardList::ListNodeSize()),
+    m_ReadyClients(&m_ReadyMemPool)
 {
 }
 
@@ -46,26 +44,18 @@ CPoller::~CPoller()
 
     Exit();
     ClosePollHandles();
-    free(m_pPollEvents);
 }
 
-CPoller* CPoller::CreateInstance(IExtCmdHandler* pHandler)
+CPoller* CPoller::CreateInstance(
+    IExtCmdHandler* pHandler,
+    CPollBackend::Type backend /* = CPollBackend::PB_EPOLL */)
 {
     CPoller* pInstance = new CPoller(pHandler);
     if (pInstance == NULL) {
         return NULL;
     }
 
-    size_t memorySize = sizeof(struct epoll_event) * EPOLL_EVENT_COUNT_MIN;
-    pInstance->m_pPollEvents = reinterpret_cast<struct epoll_event*>(malloc(memorySize));
-    if (pInstance->m_pPollEvents == NULL) {
-        OUTPUT_ERROR_TRACE("malloc memory failed\n");
-        delete pInstance;
-        return NULL;
-    }
-    memset(pInstance->m_pPollEvents, 0, memorySize);
-    pInstance->m_ReservedPollEventCount = EPOLL_EVENT_COUNT_MIN;
-    if (!pInstance->OpenPollHandles()) {
+    if (!pInstance->OpenPollHandles(backend)) {
         delete pInstance;
         return NULL;
     }
@@ -102,59 +92,47 @@ void CPoller::HandleMessage(ITMessage* pMsg)
     }
 }
 
-bool CPoller::ReadMessage(ITMessage* pOutMsg, int timeout /* = -1 */)
+size_t CPoller::ReadMessages(
+    ITMessage* pOutMsgs, size_t count, int timeout /* = -1 */)
 {
-    // Read from cache first.
-    ITMessage* pCacheMsg = reinterpret_cast<ITMessage*>(m_CmdReadCache.First());
-    if (pCacheMsg) {
-        memcpy(pOutMsg, pCacheMsg, sizeof(ITMessage));
-        m_CmdReadCache.PopFront();
-        return true;
-    }
-
-    bool bRes = false;
-    int eventCount = epoll_wait(
-        m_hPollIO, m_pPollEvents, m_PollCount, timeout);
+    ASSERT(count > 0);
+
+    // The queued commands are drained without waiting the doorbell,
+    // do not sleep if there are commands or ready clients to serve.
+    size_t readCount = DrainCommands(pOutMsgs, count);
+    int eventCount = m_pBackend->Wait(
+        m_PollEvents, POLL_EVENT_COUNT,
+        (readCount > 0 || m_ReadyClients.Count() > 0) ? 0 : timeout);
     if (eventCount > 0) {
         for (int i = 0; i < eventCount; i++) {
-            if (m_pPollEvents[i].data.fd == m_hCmdIO[0]) {
-                bRes = GetControlMessages(m_pPollEvents[i].events, pOutMsg);
+            if (m_PollEvents[i].hIO == m_hCmdEvent) {
+                ResetDoorbell();
+                readCount += DrainCommands(pOutMsgs + readCount, count - readCount);
             } else {
-                HandleDataEvent(m_pPollEvents[i].data.fd, m_pPollEvents[i].events);
+                HandleDataEvent(m_PollEvents[i].hIO, m_PollEvents[i].Events);
             }
         }
     } else if (eventCount < 0) {
         if (errno == EINTR) {
-            OUTPUT_NOTICE_TRACE("epoll_wait exit: %s\n", strerror(errno));
+            OUTPUT_NOTICE_TRACE("Poll wait exit: %s\n", strerror(errno));
         } else {
             ASSERT(m_pContext);
             m_pContext->Exit();
-            OUTPUT_ERROR_TRACE("epoll_wait failed: %s\n", strerror(errno));
+            OUTPUT_ERROR_TRACE("Poll wait failed: %s\n", strerror(errno));
         }
     }
-    return bRes;
+    HandleReadyClients();
+    return readCount;
 }
 
 bool CPoller::WriteMessage(ITMessage* pMsg)
 {
-    bool bRes = false;
-    size_t len = NSIOHelper::Write(m_hCmdIO[1], pMsg, sizeof(ITMessage));
-    if (len > 0) {
-        /**
-         * @note The POSIX guarantee the write on the pipe are data integrity:
-         * all writen or nothing, if the bytes to write is less than the PIPE_BUF,
-         * So we don't need handle the incomplete write, and actually we can't handle,
-         * in which case, we need to save the incomplete part, and write it next time
-         * once the IO is ready. Unfortunately, this function is invoked by different
-         * threads, therefore, access to the incomplete relevant data become the
-         * critical section which needs to be locked.
-         */
-        // ASSERT(len == sizeof(ITMessage));
-        bRes = true;
-    } else {
-        OUTPUT_ERROR_TRACE("Write message failed: %s\n", strerror(ERROR_CODE));
+    if (!m_CmdQueue.TryWriteMessage(pMsg)) {
+        OUTPUT_ERROR_TRACE("Write message failed: command queue is full.\n");
+        return false;
     }
-    return bRes;
+    RingDoorbell();
+    return true;
 }
 
 bool CPoller::AddClient(
@@ -189,6 +167,22 @@ bool CPoller::RemoveClient(CPollClient* pObject)
     return WriteMessage(&msg);
 }
 
+bool CPoller::ScheduleReady(CPollClient* pObject)
+{
+    ASSERT(pObject);
+    ASSERT(m_pContext->IsInLoop());
+
+    if (pObject->m_bReady) {
+        return true;
+    }
+    if (!m_ReadyClients.PushBack(pObject)) {
+        OUTPUT_ERROR_TRACE("Schedule client %p failed.\n", pObject);
+        return false;
+    }
+    pObject->m_bReady = true;
+    return true;
+}
+
 bool CPoller::DoAddClient(
     CPollClient* pObject,
     bool bTransferOwnership /* = false */,
@@ -237,46 +231,29 @@ void CPoller::DoRemoveClient(CPollClient* pObject, bool bNotify /* = false */)
         // then the client should not be removed from outside components.
         m_IOClients.erase(iter);
     }
+    UnscheduleReady(pObject);
     RemovePollIO(hIO);
     if (bNotify) {
         pObject->OnDetached();
     }
 }
 
-bool CPoller::OpenPollHandles()
+bool CPoller::OpenPollHandles(CPollBackend::Type backend)
 {
-    if (pipe(m_hCmdIO) != 0) {
-        OUTPUT_ERROR_TRACE("pipe: %s\n", strerror(errno));
+    if (m_CmdQueue.Capacity() == 0) {
         return false;
     }
-    size_t pipeBufferSize = fcntl(m_hCmdIO[0], F_GETPIPE_SZ);
-    if (pipeBufferSize < sizeof(ITMessage)) {
-        // Make sure the Pipe buffer is larger than message to write, just in case.
-        OUTPUT_DEBUG_TRACE(
-            "Pipe buffer size: %d, ITMessage size: %d\n",
-            pipeBufferSize, sizeof(ITMessage));
-        int newPipeBufferSize = (sizeof(ITMessage) << 4);
-        if (fcntl(m_hCmdIO[0], F_SETPIPE_SZ, newPipeBufferSize) != newPipeBufferSize) {
-            OUTPUT_ERROR_TRACE("Expand pipe buffer size failed. %s\n", strerror(errno));
-            ClosePollHandles();
-            return false;
-        }
-        OUTPUT_DEBUG_TRACE("Expand pipe buffer size to %d\n", newPipeBufferSize);
-    }
-
-    if (!NSIOHelper::SetIOBlockMode(m_hCmdIO[0], false) ||
-        !NSIOHelper::SetIOBlockMode(m_hCmdIO[1], false)) {
-        OUTPUT_ERROR_TRACE("SetIOBlockMode failed: %s\n", strerror(errno));
-        ClosePollHandles();
+    m_hCmdEvent = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_hCmdEvent == INVALID_IO_HANDLE) {
+        OUTPUT_ERROR_TRACE("eventfd: %s\n", strerror(errno));
         return false;
     }
-    m_hPollIO = epoll_create1(0);
-    if (m_hPollIO < 0) {
-        OUTPUT_ERROR_TRACE("epoll_create1: %s\n", strerror(errno));
+    m_pBackend = CPollBackend::CreateInstance(backend);
+    if (m_pBackend == NULL) {
         ClosePollHandles();
         return false;
     }
-    if (!AddPollIO(m_hCmdIO[0], EPOLLIN | EPOLLET | EPOLLRDHUP | EPOLLHUP)) {
+    if (!AddPollIO(m_hCmdEvent, EPOLLIN)) {
         ClosePollHandles();
         return false;
     }
@@ -285,18 +262,12 @@ bool CPoller::OpenPollHandles()
 
 void CPoller::ClosePollHandles()
 {
-    if (m_hCmdIO[0] != INVALID_IO_HANDLE) {
-        close(m_hCmdIO[0]);
-        m_hCmdIO[0] = INVALID_IO_HANDLE;
-    }
-    if (m_hCmdIO[1] != INVALID_IO_HANDLE) {
-        close(m_hCmdIO[1]);
-        m_hCmdIO[1] = INVALID_IO_HANDLE;
-    }
-    if (m_hPollIO != INVALID_IO_HANDLE) {
-        close(m_hPollIO);
-        m_hPollIO = INVALID_IO_HANDLE;
+    if (m_hCmdEvent != INVALID_IO_HANDLE) {
+        close(m_hCmdEvent);
+        m_hCmdEvent = INVALID_IO_HANDLE;
     }
+    delete m_pBackend;
+    m_pBackend = NULL;
 }
 
 bool CPoller::AddPollIO(tIOHandle hIO, uint32_t eventMask)
@@ -305,29 +276,13 @@ bool CPoller::AddPollIO(tIOHandle hIO, uint32_t eventMask)
     ASSERT(!NSIOHelper::IsIOBlocked(hIO));
     ASSERT(eventMask != 0);
 
-    struct epoll_event event;
-    memset(&event, 0, sizeof(event));
-    event.data.fd = hIO;
-    event.events = eventMask |
+    eventMask |=
         EPOLLERR |
         EPOLLET |
         EPOLLHUP |
         EPOLLRDHUP |
         EPOLLPRI;
-    if (m_PollCount >= m_ReservedPollEventCount) {
-        void* pNew = realloc(
-            m_pPollEvents,
-            sizeof(struct epoll_event) * m_ReservedPollEventCount + EPOLL_EVENT_COUNT_MIN);
-        if (pNew) {
-            m_pPollEvents = reinterpret_cast<struct epoll_event*>(pNew);
-            m_ReservedPollEventCount += EPOLL_EVENT_COUNT_MIN;
-        } else {
-            OUTPUT_ERROR_TRACE("realloc failed\n");
-            return false;
-        }
-    }
-    if (epoll_ctl(m_hPollIO, EPOLL_CTL_ADD, hIO, &event) < 0) {
-        OUTPUT_ERROR_TRACE("epoll_ctl: %s", strerror(errno));
+    if (!m_pBackend->Add(hIO, eventMask)) {
         return false;
     }
     ++m_PollCount;
@@ -338,14 +293,10 @@ void CPoller::RemovePollIO(tIOHandle hIO)
 {
     ASSERT(hIO != INVALID_IO_HANDLE);
 
-    struct epoll_event event;
-    memset(&event, 0, sizeof(event));
-    event.data.fd = hIO;
-    if (epoll_ctl(m_hPollIO, EPOLL_CTL_DEL, hIO, &event) == 0) {
+    if (m_pBackend->Remove(hIO)) {
         ASSERT(m_PollCount > 0);
         --m_PollCount;
     } else {
-        OUTPUT_ERROR_TRACE("epoll_ctl: %s", strerror(errno));
         ASSERT(false);
     }
 }
@@ -362,49 +313,48 @@ void CPoller::Exit()
         ++iter;
     }
     m_IOClients.clear();
+    m_ReadyClients.Reset();
+    DiscardCommands();
 }
 
-bool CPoller::GetControlMessages(uint32_t events, ITMessage* pOutMsg)
+void CPoller::RingDoorbell()
 {
-    bool bRes = false;
-    if (events & EPOLLIN) {
-        size_t readLen = NSIOHelper::Read(
-            m_hCmdIO[0], m_CmdReadBuffer, sizeof(m_CmdReadBuffer));
-        if (readLen > 0) {
-            memcpy(pOutMsg, m_CmdReadBuffer, sizeof(ITMessage));
-            bRes = true;
+    // Only the writer which turns the flag on signals the eventfd,
+    // the others ride on the pending signal.
+    if (AtomicCAS(&m_bDoorbellRung, 0, 1)) {
+        uint64_t value = 1;
+        if (NSIOHelper::Write(m_hCmdEvent, &value, sizeof(value)) != sizeof(value)) {
+            OUTPUT_ERROR_TRACE("Ring doorbell failed: %s\n", strerror(errno));
         }
+    }
+}
 
-        // Read out all remain messages and cache them.
-        ITMessage* pMsgCur = &m_CmdReadBuffer[1];
-        ITMessage* pMsgEnd = reinterpret_cast<ITMessage*>(
-            reinterpret_cast<uint8_t*>(m_CmdReadBuffer) + readLen);
-        do {
-            while (pMsgCur < pMsgEnd) {
-                if (!m_CmdReadCache.PushBack(pMsgCur)) {
-                    OUTPUT_ERROR_TRACE("Push back message failed.\n");
-                }
-                ++pMsgCur;
-            }
-            if (readLen < sizeof(m_CmdReadBuffer)) {
-                break;
-            }
-            readLen = NSIOHelper::Read(
-                m_hCmdIO[0], m_CmdReadBuffer, sizeof(m_CmdReadBuffer));
-            if (readLen == 0) {
-                break;
-            }
-            pMsgCur = m_CmdReadBuffer;
-            pMsgEnd = reinterpret_cast<ITMessage*>(
-                reinterpret_cast<uint8_t*>(m_CmdReadBuffer) + readLen);
-        } while (true);
+void CPoller::ResetDoorbell()
+{
+    uint64_t value = 0;
+    NSIOHelper::Read(m_hCmdEvent, &value, sizeof(value));
+
+    // Turn off the flag (full barrier) before draining the queue,
+    // the commands written after here ring the doorbell again.
+    AtomicCAS(&m_bDoorbellRung, 1, 0);
+}
+
+size_t CPoller::DrainCommands(ITMessage* pOutMsgs, size_t count)
+{
+    if (count == 0 || m_CmdQueue.IsEmpty()) {
+        return 0;
     }
+    return m_CmdQueue.ReadMessages(pOutMsgs, count, 0);
+}
 
-    if ((events & EPOLLHUP) || (events & EPOLLRDHUP)) {
-        // Control command IO is closed.
-        m_pContext->Exit();
+void CPoller::DiscardCommands()
+{
+    ITMessage msg;
+    while (DrainCommands(&msg, 1) > 0) {
+        OUTPUT_WARNING_TRACE("Discard command: %d\n", msg.MsgID);
+        msg.SignalSourceIfNeeded();
+        msg.Destroy();
     }
-    return bRes;
 }
 
 void CPoller::HandleDataEvent(tIOHandle hIO, uint32_t events)
@@ -430,6 +380,7 @@ void CPoller::HandleDataEvent(tIOHandle hIO, uint32_t events)
         pClient->OnPeerClosed();
         if (bOwned) {
             m_IOClients.erase(iter);
+            UnscheduleReady(pClient);
             delete pClient;
         }
     }
@@ -438,6 +389,42 @@ void CPoller::HandleDataEvent(tIOHandle hIO, uint32_t events)
     }
 }
 
+void CPoller::HandleReadyClients()
+{
+    // Only serve the clients scheduled before this round,
+    // the clients rescheduled in OnIncomingData wait for the next round.
+    size_t count = m_ReadyClients.Count();
+    while (count-- > 0 && m_ReadyClients.Count() > 0) {
+        CPollClient* pClient = reinterpret_cast<CPollClient*>(m_ReadyClients.First());
+        m_ReadyClients.PopFront();
+        pClient->m_bReady = false;
+        pClient->OnIncomingData();
+    }
+}
+
+void CPoller::UnscheduleReady(CPollClient* pObject)
+{
+    if (!pObject->m_bReady) {
+        return;
+    }
+
+    CForwardList::Iterator prevIter = m_ReadyClients.End();
+    CForwardList::Iterator iter = m_ReadyClients.Begin();
+    while (iter != m_ReadyClients.End()) {
+        if (m_ReadyClients.DataAt(iter) == pObject) {
+            if (prevIter == m_ReadyClients.End()) {
+                m_ReadyClients.PopFront();
+            } else {
+                m_ReadyClients.PopAfter(prevIter);
+            }
+            break;
+        }
+        prevIter = iter;
+        ++iter;
+    }
+    pObject->m_bReady = false;
+}
+
 
 #ifdef __DEBUG__
 void CPoller::VerifyClient(CPollClient* pObject, bool bExist)
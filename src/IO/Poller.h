@@ -17,6 +17,8 @@
 #include "Memory/MemoryPool.h"
 #include "Thread/ITMessage.h"
 #include "Thread/Looper.h"
+#include "Thread/RingMsgSwitch.h"
+#include "PollBackend.h"
 
 using std::map;
 
@@ -41,12 +43,32 @@ public:
     void HandleMessage(ITMessage* pMsg);
 
     // From CMsgSwitch
-    bool ReadMessage(ITMessage* pOutMsg, int timeout = -1);
+    bool ReadMessage(ITMessage* pOutMsg, int timeout = -1)
+    {
+        return ReadMessages(pOutMsg, 1, timeout) > 0;
+    }
+    size_t ReadMessages(ITMessage* pOutMsgs, size_t count, int timeout = -1);
+
+    /**
+     * @brief Queue the command, the poller is only woken up when the
+     *        queue turns from empty.
+     * @return false if the queue is full.
+     * @warning The ownership of the message payload will be transferred
+     */
     bool WriteMessage(ITMessage* pMsg);
 
     bool AddClient(CPollClient* pObject, bool bTransferOwnership = false);
     bool RemoveClient(CPollClient* pObject);
 
+    /**
+     * @brief Call OnIncomingData of the client again in the next round.
+     *        The client which stops reading before the IO is drained
+     *        (e.g. its budget is used up) shall schedule itself, since
+     *        the edge-triggered poll will not report the IO again.
+     * @warning Only called in the loop.
+     */
+    bool ScheduleReady(CPollClient* pObject);
+
     bool PostAsynTask(tAsynTask task, void* pData)
     {
         ITMessage msg(CID_ASYN_TASK);
@@ -66,12 +88,22 @@ public:
         return false;
     }
 
-    static CPoller* CreateInstance(IExtCmdHandler* pHandler);
+    CPollBackend::Type GetBackendType() const { return m_pBackend->GetType(); }
+
+    /**
+     * @param backend The poll mechanism.
+     */
+    static CPoller* CreateInstance(
+        IExtCmdHandler* pHandler,
+        CPollBackend::Type backend = CPollBackend::PB_EPOLL);
+
+    // The batch size of the looper to drain the commands.
+    static const size_t MSG_BATCH_SIZE = 32;
 
 private:
     CPoller(IExtCmdHandler* pHandler);
 
-    bool OpenPollHandles();
+    bool OpenPollHandles(CPollBackend::Type backend);
     void ClosePollHandles();
     void Exit();
 
@@ -82,14 +114,22 @@ private:
     bool AddPollIO(tIOHandle hIO, uint32_t eventMask);
     void RemovePollIO(tIOHandle hIO);
 
-    bool GetControlMessages(uint32_t events, ITMessage* pOutMsg);
+    void RingDoorbell();
+    void ResetDoorbell();
+    size_t DrainCommands(ITMessage* pOutMsgs, size_t count);
+    void DiscardCommands();
     void HandleDataEvent(tIOHandle hIO, uint32_t events);
+    void HandleReadyClients();
+    void UnscheduleReady(CPollClient* pObject);
 
 #ifdef __DEBUG__
     void VerifyClient(CPollClient* pObject, bool bExist);
 #endif
 
 private:
+    static const size_t POLL_EVENT_COUNT = 64;
+    static const size_t CMD_QUEUE_CAPACITY = 4096;
+
     enum PollMsgID {
         CID_ADD_CLIENT = USER_MSGID_BEGIN,
         CID_REMOVE_CLIENT,
@@ -112,18 +152,16 @@ private:
         AsynTaskData(tAsynTask task, void* data) : Task(task), pData(data) {}
     };
 
-    tIOHandle m_hCmdIO[2];
-    tIOHandle m_hPollIO;
+    tIOHandle m_hCmdEvent;      // eventfd, the doorbell of m_CmdQueue
+    volatile int32_t m_bDoorbellRung;
+    CMPSCRingMsgSwitch m_CmdQueue;
+    CPollBackend* m_pBackend;   // Owned
     size_t m_PollCount;
-    size_t m_ReservedPollEventCount;
-    struct epoll_event* m_pPollEvents;
+    CPollBackend::Event m_PollEvents[POLL_EVENT_COUNT];
     map<tIOHandle, PollClientData> m_IOClients;
     IExtCmdHandler* m_pExtMsgHandle;    // Not owned
-    CMemoryPool m_CmdReadMemPool;
-    CForwardList m_CmdReadCache;
-    ITMessage m_CmdReadBuffer[256];
-
-    static const size_t EPOLL_EVENT_COUNT_MIN = 32;
+    CMemoryPool m_ReadyMemPool;
+    CForwardList m_ReadyClients;    // The clients scheduled by ScheduleReady
 
     DISALLOW_COPY_CONSTRUCTOR(CPoller);
     DISALLOW_ASSIGN_OPERATOR(CPoller);
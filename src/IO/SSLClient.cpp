@@ -9,17 +9,30 @@
 #include "SSLClient.h"
 #include "IO/OpenSSLClient.h"
 #include "IO/MbedTLSClient.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "Common/ErrorNo.h"
+#include "TLS/SessionCache.h"
+#include "Tracker/Trace.h"
 
 CSSLClient::CSSLClient(CIOContext* pIO) :
     CIOContext(pIO->IsBlockMode()),
     m_pIO(pIO),
-    m_State(STATE_CLOSED)
+    m_State(STATE_CLOSED),
+    m_pFileBuffer(NULL),
+    m_SessionPeer(),
+    m_bSessionCached(false),
+    m_bSessionVerified(false),
+    m_bSessionOffered(false)
 {
 }
 
 CSSLClient::~CSSLClient()
 {
     delete m_pIO;
+    free(m_pFileBuffer);
 }
 
 bool CSSLClient::Open()
@@ -33,12 +46,14 @@ bool CSSLClient::Open()
     }
 
     SetIO(m_hIO);
+    OfferSession();
 
     bool bRes = false;
     do {
         int status = Handshake(&m_Status);
         if (status < 0) {
             // Failed to handshake
+            DropSession();
             break;
         }
         bRes = true;
@@ -52,7 +67,92 @@ bool CSSLClient::Open()
     return bRes;
 }
 
-CSSLClient* CSSLClient::CreateInstance(CIOContext* pIO, bool bCheckPeerCert)
+void CSSLClient::OnNewSession(const uint8_t* pData, size_t len, unsigned int lifetime)
+{
+    if (m_bSessionCached) {
+        CTLSSessionCache::Instance()->Put(
+            &m_SessionPeer, m_bSessionVerified, pData, len, lifetime);
+    }
+}
+
+bool CSSLClient::ContinueHandshake(IOStatus* pStatus)
+{
+    int status = Handshake(pStatus);
+    if (status == 0) {
+        m_State = STATE_OPENED;
+    } else if (status < 0) {
+        DropSession();
+    }
+    return status == 0;
+}
+
+void CSSLClient::OfferSession()
+{
+    m_bSessionOffered = false;
+    if (!m_bSessionCached) {
+        return;
+    }
+
+    uint8_t buffer[CTLSSessionCache::MAX_SESSION_SIZE];
+    size_t len = CTLSSessionCache::Instance()->Get(
+        &m_SessionPeer, m_bSessionVerified, buffer, sizeof(buffer));
+    if (len > 0) {
+        m_bSessionOffered = ResumeSession(buffer, len);
+    }
+}
+
+void CSSLClient::DropSession()
+{
+    // The failure may be caused by the offered session, do not offer it again.
+    if (m_bSessionOffered) {
+        OUTPUT_NOTICE_TRACE("Drop the TLS session of the failed handshake.\n");
+        CTLSSessionCache::Instance()->Remove(&m_SessionPeer);
+        m_bSessionOffered = false;
+    }
+}
+
+size_t CSSLClient::DoWriteV(const struct iovec* pIOVec, int count)
+{
+    // The records are encrypted one by one, write the buffers in turn.
+    size_t totalBytes = 0;
+    for (int i = 0; i < count; ++i) {
+        size_t writeBytes = DoWrite(pIOVec[i].iov_base, pIOVec[i].iov_len);
+        totalBytes += writeBytes;
+        if (writeBytes < pIOVec[i].iov_len) {
+            break;
+        }
+    }
+    return totalBytes;
+}
+
+size_t CSSLClient::DoSendFile(tIOHandle hFile, off_t offset, size_t len)
+{
+    if (m_pFileBuffer == NULL) {
+        m_pFileBuffer = reinterpret_cast<uint8_t*>(malloc(FILE_BUFFER_SIZE));
+        if (m_pFileBuffer == NULL) {
+            m_Status = IOS_LOCAL_ERROR;
+            return 0;
+        }
+    }
+
+    // One block per call, the retry after IOS_NOT_READY reads the same
+    // block into the same buffer, as SSL write requires.
+    size_t blockLen = len < FILE_BUFFER_SIZE ? len : FILE_BUFFER_SIZE;
+    ssize_t readLen = 0;
+    do {
+        readLen = pread(hFile, m_pFileBuffer, blockLen, offset);
+    } while (readLen < 0 && errno == EINTR);
+    if (readLen <= 0) {
+        // The file ends before the region, e.g. it is truncated.
+        SET_ERROR_CODE(readLen < 0 ? errno : EIO);
+        m_Status = IOS_LOCAL_ERROR;
+        return 0;
+    }
+    return DoWrite(m_pFileBuffer, readLen);
+}
+
+CSSLClient* CSSLClient::CreateInstance(
+    CIOContext* pIO, bool bCheckPeerCert, const sockaddr* pSessionPeer /* = NULL */)
 {
     CSSLClient* pInstance = NULL;
 
@@ -68,6 +168,10 @@ CSSLClient* CSSLClient::CreateInstance(CIOContext* pIO, bool bCheckPeerCert)
         if (!pInstance->Initialize()) {
             delete pInstance;
             pInstance = NULL;
+        } else if (pSessionPeer) {
+            memcpy(&pInstance->m_SessionPeer, pSessionPeer, sizeof(sockaddr));
+            pInstance->m_bSessionCached = true;
+            pInstance->m_bSessionVerified = bCheckPeerCert;
         }
     }
     return pInstance;
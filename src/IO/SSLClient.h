@@ -9,6 +9,7 @@
 #ifndef __IO_SSL_CLIENT_H__
 #define __IO_SSL_CLIENT_H__
 
+#include <sys/socket.h>
 #include "IOContext.h"
 #include "Common/Typedefs.h"
 #include "TLS/X509Cert.h"
@@ -23,11 +24,20 @@ public:
     // From CIOContext
     bool Open();
 
-    static CSSLClient* CreateInstance(CIOContext* pIO, bool bCheckPeerCert);
+    /**
+     * @param pSessionPeer The peer address to resume the TLS session with,
+     *        the sessions are not cached if it is NULL.
+     */
+    static CSSLClient* CreateInstance(
+        CIOContext* pIO, bool bCheckPeerCert, const sockaddr* pSessionPeer = NULL);
 
 protected:
     CSSLClient(CIOContext* pTcp);
 
+    // From CIOContext
+    size_t DoWriteV(const struct iovec* pIOVec, int count);
+    size_t DoSendFile(tIOHandle hFile, off_t offset, size_t len);
+
     void BaseClose()
     {
         if (m_State != STATE_CLOSED) {
@@ -38,9 +48,17 @@ protected:
 
     bool PrepareIO(IOStatus* pStatus)
     {
-        return (m_State == STATE_OPENED) ? true : Handshake(pStatus) == 0;
+        return (m_State == STATE_OPENED) ? true : ContinueHandshake(pStatus);
     }
 
+    /**
+     * @brief Called by the implementation when the peer issues a session
+     *        (ID or ticket) which can be resumed.
+     * @param pData The session serialized by the implementation.
+     * @param lifetime Seconds the session can be resumed.
+     */
+    void OnNewSession(const uint8_t* pData, size_t len, unsigned int lifetime);
+
 private:
     /**
      * @brief Set the SSL read/write IO.
@@ -54,6 +72,16 @@ private:
      */
     virtual int Handshake(IOStatus* pStatus) = 0;
 
+    /**
+     * @brief Offer the cached session in the next handshake.
+     * @param pData The session given by OnNewSession before.
+     */
+    virtual bool ResumeSession(const uint8_t* pData, size_t len) = 0;
+
+    bool ContinueHandshake(IOStatus* pStatus);
+    void OfferSession();
+    void DropSession();
+
 private:
     enum InternalState {
         STATE_CLOSED,
@@ -61,8 +89,18 @@ private:
         STATE_OPENED
     };
 
+    // The file is encrypted in user space, read it in large blocks.
+    static const size_t FILE_BUFFER_SIZE = 256 * 1024;
+
     CIOContext* m_pIO;     // Owned
     InternalState m_State;
+    uint8_t* m_pFileBuffer; // Owned, allocated on the first DoSendFile.
+
+    // The key of the session in CTLSSessionCache.
+    sockaddr m_SessionPeer;
+    bool m_bSessionCached;
+    bool m_bSessionVerified;
+    bool m_bSessionOffered;
 
     DISALLOW_COPY_CONSTRUCTOR(CSSLClient);
     DISALLOW_ASSIGN_OPERATOR(CSSLClient);
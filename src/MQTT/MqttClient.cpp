@@ -62,7 +62,7 @@ CMqttClient* CMqttClient::CreateInstance(MqttParam* pParam)
         CSSLClient* pSSL = NULL;
         CTcpClient* pTcp = new CTcpClient(&pInstance->m_ServerAddr, false); // non-blocking mode
         if (pTcp) {
-            pSSL = CSSLClient::CreateInstance(pTcp, true);
+            pSSL = CSSLClient::CreateInstance(pTcp, true, &pInstance->m_ServerAddr);
         }
         if (pSSL && pSSL->Open()) {
             pInstance->m_pLink = new CConnection();
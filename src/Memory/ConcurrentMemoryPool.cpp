@@ -0,0 +1,251 @@
+/*
+ * See the file LICENSE for redistribution information.
+ *
+ * Copyright (c) 2015-2018, Yuan Qin <yuanqin2000 at outlook dot com>
+ * All rights reserved.
+ *
+ */
+
+#include "ConcurrentMemoryPool.h"
+#include <cstring>
+#include "MemoryPool.h"
+#include "Tracker/Trace.h"
+
+using std::memset;
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// CConcurrentMemoryPool Implemenation
+//
+///////////////////////////////////////////////////////////////////////////////
+CConcurrentMemoryPool::CConcurrentMemoryPool(
+    size_t cellSize,
+    size_t poolSize /* = 0 */,
+    size_t cacheSize /* = DEFAULT_CACHE_SIZE */) :
+    CMemory(CMemoryPool::ReformCellSize(cellSize)),
+    m_pFree(NULL),
+    m_pBlocks(NULL),
+    m_pCaches(NULL),
+    m_BlockCount(0),
+    m_MaxBlockCount(0),
+    m_CacheSize(cacheSize > 0 ? cacheSize : 1),
+    m_CacheKey(),
+    m_bKeyValid(false)
+{
+    ASSERT(cellSize > 0);
+    ASSERT(cellSize <= DEFAULT_BLOCK_SIZE);
+
+    // The ceiling is on the blocks, see the note of the class.
+    size_t cellsPerBlock = DEFAULT_BLOCK_SIZE / MaxChunkSize();
+    if (poolSize > 0) {
+        m_MaxBlockCount = (poolSize + cellsPerBlock - 1) / cellsPerBlock;
+    } else {
+        m_MaxBlockCount = 0x7FFFFFFF;
+    }
+
+    int res = pthread_key_create(&m_CacheKey, ReleaseThreadCache);
+    if (res != 0) {
+        OUTPUT_ERROR_TRACE("pthread_key_create: %s\n", strerror(res));
+        return;
+    }
+    m_bKeyValid = true;
+}
+
+CConcurrentMemoryPool::~CConcurrentMemoryPool()
+{
+    if (m_bKeyValid) {
+        // The exiting threads will not touch the caches any more.
+        pthread_key_delete(m_CacheKey);
+    }
+
+    ThreadCache* pCache = m_pCaches;
+    while (pCache) {
+        ThreadCache* pTemp = pCache;
+        pCache = pCache->pNext;
+        free(pTemp);
+    }
+    Block* pBlock = m_pBlocks;
+    while (pBlock) {
+        Block* pTemp = pBlock;
+        pBlock = pBlock->pNext;
+        free(pTemp);
+    }
+}
+
+void* CConcurrentMemoryPool::Malloc(size_t size)
+{
+    ASSERT(size <= MaxChunkSize());
+
+    ThreadCache* pCache = GetThreadCache();
+    if (pCache == NULL || (pCache->pFree == NULL && !Refill(pCache))) {
+        RecordMalloc(NULL, size);
+        return NULL;
+    }
+
+    List* pCell = pCache->pFree;
+    pCache->pFree = pCell->pNext;
+    --pCache->Count;
+    pCell->pNext = NULL;
+    RecordMalloc(pCell, MaxChunkSize());
+    return pCell;
+}
+
+void CConcurrentMemoryPool::Free(void* pMem)
+{
+    ASSERT(pMem);
+
+    RecordFree(MaxChunkSize());
+    memset(pMem, 0, MaxChunkSize());
+    List* pCell = reinterpret_cast<List*>(pMem);
+    ThreadCache* pCache = GetThreadCache();
+    if (pCache == NULL) {
+        PushFreeCells(pCell, pCell);
+        return;
+    }
+
+    pCell->pNext = pCache->pFree;
+    pCache->pFree = pCell;
+    if (++pCache->Count >= (m_CacheSize << 1)) {
+        Flush(pCache, m_CacheSize);
+    }
+}
+
+CConcurrentMemoryPool::ThreadCache* CConcurrentMemoryPool::GetThreadCache()
+{
+    if (!m_bKeyValid) {
+        return NULL;
+    }
+
+    ThreadCache* pCache =
+        reinterpret_cast<ThreadCache*>(pthread_getspecific(m_CacheKey));
+    if (pCache) {
+        return pCache;
+    }
+
+    // Reuse the cache released by an exited thread at first.
+    for (pCache = m_pCaches; pCache; pCache = pCache->pNext) {
+        if (pCache->InUse == 0 && AtomicCAS(&pCache->InUse, 0, 1)) {
+            break;
+        }
+    }
+    if (pCache == NULL) {
+        void* pMem = NULL;
+        if (posix_memalign(&pMem, __OS_CACHE_LINE_SIZE__, sizeof(ThreadCache)) != 0) {
+            OUTPUT_ERROR_TRACE("Can not allocate the thread cache\n");
+            return NULL;
+        }
+        pCache = reinterpret_cast<ThreadCache*>(pMem);
+        pCache->pPool = this;
+        pCache->pFree = NULL;
+        pCache->Count = 0;
+        pCache->InUse = 1;
+        ThreadCache* pHead = NULL;
+        do {
+            pHead = m_pCaches;
+            pCache->pNext = pHead;
+        } while (!AtomicCASPtr(
+            reinterpret_cast<void* volatile*>(&m_pCaches), pHead, pCache));
+    }
+
+    if (pthread_setspecific(m_CacheKey, pCache) != 0) {
+        pCache->InUse = 0;
+        return NULL;
+    }
+    return pCache;
+}
+
+bool CConcurrentMemoryPool::Refill(ThreadCache* pCache)
+{
+    ASSERT(pCache->pFree == NULL);
+
+    List* pHead = reinterpret_cast<List*>(
+        AtomicExchangePtr(reinterpret_cast<void* volatile*>(&m_pFree), NULL));
+    if (pHead) {
+        size_t count = 0;
+        for (List* p = pHead; p; p = p->pNext) {
+            ++count;
+        }
+        pCache->pFree = pHead;
+        pCache->Count = count;
+        return true;
+    }
+
+    if (AtomicInc(&m_BlockCount) > m_MaxBlockCount) {
+        AtomicDec(&m_BlockCount);
+        return false;
+    }
+    pHead = AllocateBlock();
+    if (pHead == NULL) {
+        AtomicDec(&m_BlockCount);
+        return false;
+    }
+    pCache->pFree = pHead;
+    pCache->Count = DEFAULT_BLOCK_SIZE / MaxChunkSize();
+    return true;
+}
+
+void CConcurrentMemoryPool::Flush(ThreadCache* pCache, size_t keepCount)
+{
+    if (pCache->Count <= keepCount) {
+        return;
+    }
+
+    size_t count = pCache->Count - keepCount;
+    List* pHead = pCache->pFree;
+    List* pTail = pHead;
+    for (size_t i = 1; i < count; ++i) {
+        pTail = pTail->pNext;
+    }
+    pCache->pFree = pTail->pNext;
+    pCache->Count = keepCount;
+    PushFreeCells(pHead, pTail);
+}
+
+void CConcurrentMemoryPool::PushFreeCells(List* pHead, List* pTail)
+{
+    ASSERT(pHead && pTail);
+
+    List* pOld = NULL;
+    do {
+        pOld = m_pFree;
+        pTail->pNext = pOld;
+    } while (!AtomicCASPtr(
+        reinterpret_cast<void* volatile*>(&m_pFree), pOld, pHead));
+}
+
+CConcurrentMemoryPool::List* CConcurrentMemoryPool::AllocateBlock()
+{
+    Block* pBlock = reinterpret_cast<Block*>(
+        calloc(1, sizeof(Block) + DEFAULT_BLOCK_SIZE));
+    if (pBlock == NULL) {
+        OUTPUT_ERROR_TRACE("Can not allocate memory %lu Bytes", DEFAULT_BLOCK_SIZE);
+        return NULL;
+    }
+
+    Block* pOld = NULL;
+    do {
+        pOld = m_pBlocks;
+        pBlock->pNext = pOld;
+    } while (!AtomicCASPtr(
+        reinterpret_cast<void* volatile*>(&m_pBlocks), pOld, pBlock));
+
+    size_t cellSize = MaxChunkSize();
+    size_t count = DEFAULT_BLOCK_SIZE / cellSize;
+    List* ptr = reinterpret_cast<List*>(pBlock->Buffer);
+    for (size_t i = 1; i < count; ++i) {
+        ptr->pNext = reinterpret_cast<List*>(reinterpret_cast<uint8_t*>(ptr) + cellSize);
+        ptr = ptr->pNext;
+    }
+    ptr->pNext = NULL;
+    return reinterpret_cast<List*>(pBlock->Buffer);
+}
+
+void CConcurrentMemoryPool::ReleaseThreadCache(void* pData)
+{
+    ThreadCache* pCache = reinterpret_cast<ThreadCache*>(pData);
+    ASSERT(pCache && pCache->InUse);
+
+    pCache->pPool->Flush(pCache, 0);
+    __sync_synchronize();
+    pCache->InUse = 0;
+}
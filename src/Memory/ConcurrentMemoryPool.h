@@ -0,0 +1,106 @@
+/*
+ * See the file LICENSE for redistribution information.
+ *
+ * Copyright (c) 2015-2018, Yuan Qin <yuanqin2000 at outlook dot com>
+ * All rights reserved.
+ *
+ */
+
+#ifndef __COMMON_CONCURRENT_MEMORY_POOL_H__
+#define __COMMON_CONCURRENT_MEMORY_POOL_H__
+
+#include <pthread.h>
+#include "Common/Arch.h"
+#include "Common/Typedefs.h"
+#include "Common/Macros.h"
+#include "Memory.h"
+
+/**
+ * @brief Thread safe memory pool for cells of a fixed size.
+ *
+ * Every thread keeps a private free list (the cache), Malloc and Free only
+ * touch the cache of the calling thread. A cell can be freed by a thread
+ * other than the one which allocated it.
+ * The caches exchange cells with a lock-free global free list:
+ *     - Free flushes the surplus cells when the cache is over the high water.
+ *     - Malloc takes the whole global list when the cache is empty.
+ * Cells are only pushed to or taken entirely from the global list,
+ * so that there is no ABA issue.
+ * The cached cells are returned to the global list when the thread exits.
+ *
+ * @note The memory returned by Malloc is zeroed.
+ * @note The pool size caps the blocks instead of the cells. Malloc fails
+ *       when no more block is allowed and both the calling cache and the
+ *       global list are empty, even if the other threads still cache the
+ *       free cells (less than 2 * cacheSize each). The caches are private
+ *       to their threads and are never stolen from.
+ */
+class CConcurrentMemoryPool : public CMemory
+{
+public:
+    /**
+     * @param cellSize: The size of the cell
+     * @param poolSize: The max count of the cells, rounded up to whole
+     *                  blocks, 0 means unlimited.
+     * @param cacheSize: The count of the cells kept by the cache
+     *                   after flushing.
+     */
+    CConcurrentMemoryPool(
+        size_t cellSize,
+        size_t poolSize = 0,
+        size_t cacheSize = DEFAULT_CACHE_SIZE);
+    ~CConcurrentMemoryPool();
+
+    // From CMemory
+    void* Malloc(size_t size);
+    void Free(void* pMem);
+
+    static const size_t DEFAULT_CACHE_SIZE = 64;
+
+private:
+    struct List {
+        List* pNext;
+    };
+
+    struct Block {
+        Block* pNext;
+        uint8_t Buffer[0];
+    };
+
+    struct ThreadCache {
+        CConcurrentMemoryPool* pPool;
+        ThreadCache* pNext;     // Link of all caches of the pool
+        List* pFree;
+        size_t Count;
+        volatile int32_t InUse;
+    } __ALIGN__(__OS_CACHE_LINE_SIZE__);
+
+    ThreadCache* GetThreadCache();
+    bool Refill(ThreadCache* pCache);
+    void Flush(ThreadCache* pCache, size_t keepCount);
+    void PushFreeCells(List* pHead, List* pTail);
+    List* AllocateBlock();
+
+    static void ReleaseThreadCache(void* pData);
+
+private:
+    // Shared by all threads, so keep it in its own cache line.
+    List* volatile m_pFree __ALIGN__(__OS_CACHE_LINE_SIZE__);
+    uint8_t m_Padding[__OS_CACHE_LINE_SIZE__ - sizeof(List*)];
+
+    Block* volatile m_pBlocks;
+    ThreadCache* volatile m_pCaches;
+    volatile int32_t m_BlockCount;
+    int32_t m_MaxBlockCount;
+    const size_t m_CacheSize;
+    pthread_key_t m_CacheKey;
+    bool m_bKeyValid;
+
+    static const size_t DEFAULT_BLOCK_SIZE = 4 * 1024; /* 4KB */
+
+    DISALLOW_COPY_CONSTRUCTOR(CConcurrentMemoryPool);
+    DISALLOW_ASSIGN_OPERATOR(CConcurrentMemoryPool);
+    DISALLOW_DEFAULT_CONSTRUCTOR(CConcurrentMemoryPool);
+};
+
+#endif
@@ -21,7 +21,8 @@ CLazyBuffer::CLazyBuffer(uint8_t* pBuffer, size_t length) :
     CMemory(length),
     m_pHeader(NULL),
     m_MinBlockSize(length),
-    m_bExtentable(false)
+    m_bExtentable(false),
+    m_pAllocator(NULL)
 {
     ASSERT(pBuffer);
     ASSERT(length > sizeof(BlockList));
@@ -36,7 +37,7 @@ CLazyBuffer::~CLazyBuffer()
         BlockList* pList = m_pHeader;
         while (pList) {
             BlockList* pTmp = pList->pNext;
-            free(pList);
+            m_pAllocator->Free(pList);
             pList = pTmp;
         }
     }
@@ -51,6 +52,7 @@ void* CLazyBuffer::Malloc(size_t length)
         pList->pFree += length;
         pList->FreeSize -= length;
     }
+    RecordMalloc(pMem, length);
     return pMem;
 }
 
@@ -94,7 +96,7 @@ CLazyBuffer::BlockList* CLazyBuffer::FindFreeBlock(size_t length)
 
         size_t actualSize = (length > m_MinBlockSize) ? length : m_MinBlockSize;
         uint8_t* pMem =
-            reinterpret_cast<uint8_t*>(malloc(sizeof(BlockList) + actualSize));
+            reinterpret_cast<uint8_t*>(m_pAllocator->Malloc(sizeof(BlockList) + actualSize));
         if (!pMem) {
             OUTPUT_ERROR_TRACE("Can't not allocate memory for store\n");
             return NULL;
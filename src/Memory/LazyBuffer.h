@@ -19,11 +19,14 @@ class CLazyBuffer : public CMemory
 {
 public:
     CLazyBuffer(uint8_t* pBuffer, size_t length);
-    CLazyBuffer(size_t length = DEFAULT_SIZE_OF_BUFFER) :
+    CLazyBuffer(
+        size_t length = DEFAULT_SIZE_OF_BUFFER,
+        CMemory* pAllocator = CMemory::GetDefaultMemory()) :
         CMemory(~0),
         m_pHeader(NULL),
         m_MinBlockSize(length),
-        m_bExtentable(true) {}
+        m_bExtentable(true),
+        m_pAllocator(pAllocator) {}
     ~CLazyBuffer();
 
     // From CMemory
@@ -61,6 +64,7 @@ private:
     BlockList* m_pHeader;
     const size_t m_MinBlockSize;
     const bool m_bExtentable;
+    CMemory* m_pAllocator;  // Not owned, allocator of the extented blocks.
 
     static const size_t DEFAULT_SIZE_OF_BUFFER = 1024;
 
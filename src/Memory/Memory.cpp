@@ -7,17 +7,69 @@
  */
 
 #include "Memory.h"
+#include <malloc.h>
+#include "MemoryRegistry.h"
+#include "Tracker/Trace.h"
 
 class CSystemMemory : public CMemory
 {
 public:
     CSystemMemory() : CMemory(~0) {}
-    void* Malloc(size_t size) { return malloc(size); }
-    void Free(void* pMem) { free(pMem); }
+
+    void* Malloc(size_t size)
+    {
+        void* pMem = malloc(size);
+        if (IsStatsEnabled()) {
+            RecordMalloc(pMem, pMem ? malloc_usable_size(pMem) : size);
+        }
+        return pMem;
+    }
+
+    void Free(void* pMem)
+    {
+        if (IsStatsEnabled() && pMem) {
+            RecordFree(malloc_usable_size(pMem));
+        }
+        free(pMem);
+    }
 };
 
+CMemory::~CMemory()
+{
+    DisableStats();
+}
+
+bool CMemory::EnableStats(const char* pName)
+{
+    ASSERT(pName);
+
+    if (m_pStats) {
+        return true;
+    }
+    m_LiveBytes = 0;
+    m_pStats = CMemoryRegistry::Instance()->Attach(pName);
+    return m_pStats != NULL;
+}
+
+void CMemory::DisableStats()
+{
+    if (m_pStats) {
+        CMemoryRegistry::Instance()->Detach(m_pStats, m_LiveBytes);
+        m_pStats = NULL;
+    }
+}
+
 CMemory* CMemory::GetDefaultMemory()
 {
+#ifdef __MEMORY_STATS__
+    // Construct the registry at first, it is destroyed after the system memory.
+    static CMemoryRegistry* s_pRegistry = CMemoryRegistry::Instance();
+    static CSystemMemory s_SystemMemory;
+    static bool s_bStatsEnabled = s_SystemMemory.EnableStats("System");
+    (void)s_pRegistry;
+    (void)s_bStatsEnabled;
+#else
     static CSystemMemory s_SystemMemory;
+#endif
     return &s_SystemMemory;
 }
@@ -10,6 +10,7 @@
 #define __COMMON_MEMORY_H__
 
 #include "Common/Typedefs.h"
+#include "MemoryStats.h"
 #include <cstdlib>
 
 using std::malloc;
@@ -18,18 +19,55 @@ using std::free;
 class CMemory
 {
 public:
-    CMemory(size_t maxChunkSize) : m_MaxChunkSize(maxChunkSize) {}
-    virtual ~CMemory() {}
+    CMemory(size_t maxChunkSize) :
+        m_MaxChunkSize(maxChunkSize), m_pStats(NULL), m_LiveBytes(0) {}
+    virtual ~CMemory();
 
     virtual void* Malloc(size_t size) = 0;
     virtual void Free(void* pMem) = 0;
 
     size_t MaxChunkSize() const { return m_MaxChunkSize; }
 
+    /**
+     * @brief Start to collect the allocation statistics into the ones
+     *        of the name in CMemoryRegistry, shared by the allocators
+     *        of the same name.
+     * @param pName: The name shown in the dump, it is not copied.
+     */
+    bool EnableStats(const char* pName);
+    void DisableStats();
+    const CMemoryStats* GetStats() const { return m_pStats; }
+
     static CMemory* GetDefaultMemory();
 
+protected:
+    // Invoked by the implementations, nothing to do if the statistics disabled.
+    void RecordMalloc(void* pMem, size_t size)
+    {
+        if (m_pStats) {
+            if (pMem) {
+                AtomicAdd64(&m_LiveBytes, static_cast<int64_t>(size));
+                m_pStats->OnAllocated(size);
+            } else {
+                m_pStats->OnFailed(size);
+            }
+        }
+    }
+
+    void RecordFree(size_t size)
+    {
+        if (m_pStats) {
+            AtomicSub64(&m_LiveBytes, static_cast<int64_t>(size));
+            m_pStats->OnReleased(size);
+        }
+    }
+
+    bool IsStatsEnabled() const { return m_pStats != NULL; }
+
 private:
     const size_t m_MaxChunkSize;
+    CMemoryStats* m_pStats;     // Not owned, kept by CMemoryRegistry
+    volatile int64_t m_LiveBytes;   // The part of this allocator in m_pStats
 };
 
 #endif
\ No newline at end of file
@@ -86,6 +86,7 @@ void* CMemoryPool::Malloc(size_t size)
             m_pBlocks = pBlock;
             m_pFree = pBlock->Initialize(MaxChunkSize(), DEFAULT_BLOCK_SIZE);
             if (m_pFree == NULL) {
+                RecordMalloc(NULL, size);
                 return NULL;
             }
         }
@@ -94,6 +95,7 @@ void* CMemoryPool::Malloc(size_t size)
         m_pFree = m_pFree->pNext;
         ++m_PoolSize;
     }
+    RecordMalloc(pCell, MaxChunkSize());
     return pCell;
 }
 
@@ -106,6 +108,7 @@ void CMemoryPool::Free(void* pMem)
     m_pFree = pCellSpace;
     memset(pMem, 0, MaxChunkSize());
     --m_PoolSize;
+    RecordFree(MaxChunkSize());
 }
 
 size_t CMemoryPool::ReformCellSize(size_t cellSize)
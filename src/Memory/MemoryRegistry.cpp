@@ -0,0 +1,72 @@
+/*
+ * See the file LICENSE for redistribution information.
+ *
+ * Copyright (c) 2015-2018, Yuan Qin <yuanqin2000 at outlook dot com>
+ * All rights reserved.
+ *
+ */
+
+#include "MemoryRegistry.h"
+#include <utility>
+#include "MemoryStats.h"
+#include "Tracker/Trace.h"
+
+using std::pair;
+
+CMemoryRegistry::CMemoryRegistry() : m_Stats(), m_CS()
+{
+}
+
+CMemoryRegistry::~CMemoryRegistry()
+{
+    map<const char*, CMemoryStats*, NameLess>::iterator iter = m_Stats.begin();
+    map<const char*, CMemoryStats*, NameLess>::iterator iterEnd = m_Stats.end();
+    while (iter != iterEnd) {
+        delete iter->second;
+        ++iter;
+    }
+}
+
+CMemoryStats* CMemoryRegistry::Attach(const char* pName)
+{
+    ASSERT(pName);
+
+    CSectionLock lock(m_CS);
+    CMemoryStats* pStats = NULL;
+    map<const char*, CMemoryStats*, NameLess>::iterator iter = m_Stats.find(pName);
+    if (iter != m_Stats.end()) {
+        pStats = iter->second;
+    } else {
+        pStats = new CMemoryStats(pName);
+        if (pStats == NULL) {
+            return NULL;
+        }
+        m_Stats.insert(pair<const char*, CMemoryStats*>(pName, pStats));
+    }
+    pStats->OnAttached();
+    return pStats;
+}
+
+void CMemoryRegistry::Detach(CMemoryStats* pStats, int64_t liveBytes)
+{
+    ASSERT(pStats);
+
+    pStats->OnDetached(liveBytes);
+}
+
+size_t CMemoryRegistry::Dump(char* pBuffer, size_t len)
+{
+    ASSERT(pBuffer);
+    ASSERT(len > 0);
+
+    CSectionLock lock(m_CS);
+    size_t offset = 0;
+    pBuffer[0] = '\0';
+    map<const char*, CMemoryStats*, NameLess>::const_iterator iter = m_Stats.begin();
+    map<const char*, CMemoryStats*, NameLess>::const_iterator iterEnd = m_Stats.end();
+    while (iter != iterEnd && offset + 1 < len) {
+        offset += iter->second->Dump(pBuffer + offset, len - offset);
+        ++iter;
+    }
+    return offset;
+}
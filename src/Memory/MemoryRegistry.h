@@ -0,0 +1,63 @@
+/*
+ * See the file LICENSE for redistribution information.
+ *
+ * Copyright (c) 2015-2018, Yuan Qin <yuanqin2000 at outlook dot com>
+ * All rights reserved.
+ *
+ */
+
+#ifndef __COMMON_MEMORY_REGISTRY_H__
+#define __COMMON_MEMORY_REGISTRY_H__
+
+#include <map>
+#include <cstring>
+#include "Common/Typedefs.h"
+#include "Common/Singleton.h"
+#include "Thread/Lock.h"
+
+using std::map;
+
+class CMemoryStats;
+
+/**
+ * @brief Registry of the allocation statistics by name.
+ *        The allocators enabled the statistics with the same name share
+ *        one CMemoryStats, which is kept after the allocators are destroyed,
+ *        so the peak and the failures of the short-lived ones are not lost.
+ */
+class CMemoryRegistry : public CSingleton<CMemoryRegistry>
+{
+public:
+    /**
+     * @brief Get the statistics of the name, created at the first time.
+     * @param pName The name shown in the dump, it is not copied.
+     * @return NULL if failed.
+     */
+    CMemoryStats* Attach(const char* pName);
+    void Detach(CMemoryStats* pStats, int64_t liveBytes);
+
+    /**
+     * @brief Print the statistics of all names as text.
+     * @return The length of the text, it is truncated if exceed len.
+     */
+    size_t Dump(char* pBuffer, size_t len);
+
+protected:
+    CMemoryRegistry();
+    ~CMemoryRegistry();
+
+private:
+    struct NameLess {
+        bool operator()(const char* pLeft, const char* pRight) const
+        {
+            return std::strcmp(pLeft, pRight) < 0;
+        }
+    };
+
+    map<const char*, CMemoryStats*, NameLess> m_Stats;  // Owned
+    CCriticalSection m_CS;
+
+    friend class CSingleton<CMemoryRegistry>;
+};
+
+#endif
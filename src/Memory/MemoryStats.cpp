@@ -0,0 +1,61 @@
+/*
+ * See the file LICENSE for redistribution information.
+ *
+ * Copyright (c) 2015-2018, Yuan Qin <yuanqin2000 at outlook dot com>
+ * All rights reserved.
+ *
+ */
+
+#include "MemoryStats.h"
+#include <cstdio>
+#include "Tracker/Trace.h"
+
+using std::snprintf;
+
+CMemoryStats::CMemoryStats(const char* pName) :
+    m_pName(pName),
+    m_LiveBytes(0),
+    m_PeakBytes(0),
+    m_AllocCount(0),
+    m_FreeCount(0),
+    m_FailedCount(0),
+    m_InstanceCount(0),
+    m_Histogram{0}
+{
+    ASSERT(pName);
+}
+
+size_t CMemoryStats::Dump(char* pBuffer, size_t len) const
+{
+    ASSERT(pBuffer);
+    ASSERT(len > 0);
+
+    size_t offset = 0;
+    int res = snprintf(pBuffer, len,
+        "%s: live %lld, peak %lld, alloc %lld, free %lld, failed %lld, instances %lld\n",
+        m_pName,
+        static_cast<long long>(m_LiveBytes),
+        static_cast<long long>(m_PeakBytes),
+        static_cast<long long>(m_AllocCount),
+        static_cast<long long>(m_FreeCount),
+        static_cast<long long>(m_FailedCount),
+        static_cast<long long>(m_InstanceCount));
+    if (res < 0) {
+        return 0;
+    }
+    offset += res;
+    for (size_t i = 0; i < HISTOGRAM_SIZE && offset < len; ++i) {
+        if (m_Histogram[i] == 0) {
+            continue;
+        }
+        res = snprintf(pBuffer + offset, len - offset,
+            i + 1 < HISTOGRAM_SIZE ? "    <= %lu: %lld\n" : "    >  %lu: %lld\n",
+            i + 1 < HISTOGRAM_SIZE ? 16UL << i : 16UL << (i - 1),
+            static_cast<long long>(m_Histogram[i]));
+        if (res < 0) {
+            break;
+        }
+        offset += res;
+    }
+    return offset < len ? offset : len - 1;
+}
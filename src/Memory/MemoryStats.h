@@ -0,0 +1,104 @@
+/*
+ * See the file LICENSE for redistribution information.
+ *
+ * Copyright (c) 2015-2018, Yuan Qin <yuanqin2000 at outlook dot com>
+ * All rights reserved.
+ *
+ */
+
+#ifndef __COMMON_MEMORY_STATS_H__
+#define __COMMON_MEMORY_STATS_H__
+
+#include "Common/Arch.h"
+#include "Common/Typedefs.h"
+#include "Common/Macros.h"
+
+/**
+ * @brief Allocation statistics of the CMemory instances of a name.
+ *        The counters are updated atomically, so that the statistics
+ *        of the thread safe allocator can be dumped from other threads.
+ */
+class CMemoryStats
+{
+public:
+    CMemoryStats(const char* pName);
+    ~CMemoryStats() {}
+
+    void OnAllocated(size_t size)
+    {
+        int64_t live = AtomicAdd64(&m_LiveBytes, static_cast<int64_t>(size));
+        int64_t peak = m_PeakBytes;
+        while (live > peak && !AtomicCAS64(&m_PeakBytes, peak, live)) {
+            peak = m_PeakBytes;
+        }
+        AtomicInc64(&m_AllocCount);
+        AtomicInc64(&m_Histogram[HistogramIndex(size)]);
+    }
+
+    void OnReleased(size_t size)
+    {
+        AtomicSub64(&m_LiveBytes, static_cast<int64_t>(size));
+        AtomicInc64(&m_FreeCount);
+    }
+
+    void OnFailed(size_t size)
+    {
+        AtomicInc64(&m_FailedCount);
+    }
+
+    void OnAttached()
+    {
+        AtomicInc64(&m_InstanceCount);
+    }
+
+    // The bytes still live in the detached instance are not counted any more.
+    void OnDetached(int64_t liveBytes)
+    {
+        AtomicSub64(&m_LiveBytes, liveBytes);
+        AtomicDec64(&m_InstanceCount);
+    }
+
+    const char* Name() const { return m_pName; }
+    int64_t LiveBytes() const { return m_LiveBytes; }
+    int64_t PeakBytes() const { return m_PeakBytes; }
+    int64_t AllocCount() const { return m_AllocCount; }
+    int64_t FreeCount() const { return m_FreeCount; }
+    int64_t FailedCount() const { return m_FailedCount; }
+    int64_t InstanceCount() const { return m_InstanceCount; }
+
+    /**
+     * @brief Print the statistics as text.
+     * @return The length of the text, it is truncated if exceed len.
+     */
+    size_t Dump(char* pBuffer, size_t len) const;
+
+    // Bucket i counts the sizes in (2^(i + 3), 2^(i + 4)], the first one is [0, 16]
+    // and the last one counts all the larger sizes.
+    static const size_t HISTOGRAM_SIZE = 18;
+
+private:
+    static size_t HistogramIndex(size_t size)
+    {
+        if (size <= 16) {
+            return 0;
+        }
+        size_t index = (sizeof(unsigned long) << 3) - 4 - __builtin_clzl(size - 1);
+        return index < HISTOGRAM_SIZE ? index : HISTOGRAM_SIZE - 1;
+    }
+
+private:
+    const char* m_pName;
+    volatile int64_t m_LiveBytes;
+    volatile int64_t m_PeakBytes;
+    volatile int64_t m_AllocCount;
+    volatile int64_t m_FreeCount;
+    volatile int64_t m_FailedCount;
+    volatile int64_t m_InstanceCount;
+    volatile int64_t m_Histogram[HISTOGRAM_SIZE];
+
+    DISALLOW_COPY_CONSTRUCTOR(CMemoryStats);
+    DISALLOW_ASSIGN_OPERATOR(CMemoryStats);
+    DISALLOW_DEFAULT_CONSTRUCTOR(CMemoryStats);
+};
+
+#endif
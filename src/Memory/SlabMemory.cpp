@@ -0,0 +1,243 @@
+/*
+ * See the file LICENSE for redistribution information.
+ *
+ * Copyright (c) 2015-2018, Yuan Qin <yuanqin2000 at outlook dot com>
+ * All rights reserved.
+ *
+ */
+
+#include "SlabMemory.h"
+#include <sys/mman.h>
+#include <malloc.h>
+#include <cstddef>
+#include <cstring>
+#include <cerrno>
+#include "Tracker/Trace.h"
+
+using std::strerror;
+using std::max_align_t;
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// CSlabMemory Implemenation
+//
+///////////////////////////////////////////////////////////////////////////////
+CSlabMemory::CSlabMemory(
+    size_t retainedLimit /* = DEFAULT_RETAINED_LIMIT */,
+    bool bHugePage /* = false */) :
+    CMemory(~0),
+    m_RetainedSize(0),
+    m_MappedSize(0),
+    m_RetainedLimit(retainedLimit),
+    m_bHugePage(bHugePage)
+{
+    for (size_t i = 0; i < CLASS_COUNT; ++i) {
+        SizeClass* pClass = &m_Classes[i];
+        pClass->ChunkSize = ClassSize(i);
+        pClass->pPartial = NULL;
+        pClass->pFull = NULL;
+
+        // A slab holds 8 chunks at least, but no more than MAX_SLAB_SIZE,
+        // so the slab of MAX_CLASS_SIZE holds 7 only.
+        ASSERT(pClass->ChunkSize % ALIGNMENT == 0);
+        size_t slabSize = MIN_SLAB_SIZE;
+        while (slabSize < MAX_SLAB_SIZE &&
+               slabSize < sizeof(Slab) + (pClass->ChunkSize << 3)) {
+            slabSize <<= 1;
+        }
+        pClass->SlabSize = slabSize;
+    }
+    ASSERT(ClassSize(CLASS_COUNT - 1) == MAX_CLASS_SIZE);
+    ASSERT(ALIGNMENT % alignof(max_align_t) == 0);
+    ASSERT(sizeof(ChunkHeader) % ALIGNMENT == 0 && sizeof(Slab) % ALIGNMENT == 0);
+}
+
+CSlabMemory::~CSlabMemory()
+{
+    for (size_t i = 0; i < CLASS_COUNT; ++i) {
+        while (m_Classes[i].pPartial) {
+            Slab* pSlab = m_Classes[i].pPartial;
+            UnlinkSlab(&m_Classes[i].pPartial, pSlab);
+            ReleaseSlab(pSlab);
+        }
+        while (m_Classes[i].pFull) {
+            Slab* pSlab = m_Classes[i].pFull;
+            UnlinkSlab(&m_Classes[i].pFull, pSlab);
+            ReleaseSlab(pSlab);
+        }
+    }
+}
+
+void* CSlabMemory::Malloc(size_t size)
+{
+    size_t chunkSize = size + sizeof(ChunkHeader);
+    if (chunkSize > MAX_CLASS_SIZE) {
+        ChunkHeader* pHeader = reinterpret_cast<ChunkHeader*>(malloc(chunkSize));
+        if (pHeader == NULL) {
+            RecordMalloc(NULL, size);
+            return NULL;
+        }
+        pHeader->pSlab = NULL;
+        if (IsStatsEnabled()) {
+            RecordMalloc(pHeader, malloc_usable_size(pHeader) - sizeof(ChunkHeader));
+        }
+        return pHeader + 1;
+    }
+
+    SizeClass* pClass = &m_Classes[SizeClassIndex(chunkSize)];
+    Slab* pSlab = pClass->pPartial;
+    if (pSlab == NULL) {
+        pSlab = CreateSlab(pClass);
+        if (pSlab == NULL) {
+            RecordMalloc(NULL, size);
+            return NULL;
+        }
+        LinkSlab(&pClass->pPartial, pSlab);
+    }
+
+    ChunkHeader* pHeader = NULL;
+    if (pSlab->pFree) {
+        pHeader = reinterpret_cast<ChunkHeader*>(pSlab->pFree);
+        pSlab->pFree = pSlab->pFree->pNext;
+    } else {
+        pHeader = reinterpret_cast<ChunkHeader*>(pSlab->pUnused);
+        pSlab->pUnused += pClass->ChunkSize;
+    }
+    if (pSlab->InUse++ == 0) {
+        m_RetainedSize -= pClass->SlabSize;
+    }
+    if (pSlab->InUse == pSlab->Capacity) {
+        UnlinkSlab(&pClass->pPartial, pSlab);
+        LinkSlab(&pClass->pFull, pSlab);
+    }
+    pHeader->pSlab = pSlab;
+    RecordMalloc(pHeader, pClass->ChunkSize - sizeof(ChunkHeader));
+    return pHeader + 1;
+}
+
+void CSlabMemory::Free(void* pMem)
+{
+    ASSERT(pMem);
+
+    ChunkHeader* pHeader = reinterpret_cast<ChunkHeader*>(pMem) - 1;
+    Slab* pSlab = pHeader->pSlab;
+    if (pSlab == NULL) {
+        if (IsStatsEnabled()) {
+            RecordFree(malloc_usable_size(pHeader) - sizeof(ChunkHeader));
+        }
+        free(pHeader);
+        return;
+    }
+
+    ASSERT(pSlab->InUse > 0);
+    SizeClass* pClass = pSlab->pClass;
+    RecordFree(pClass->ChunkSize - sizeof(ChunkHeader));
+    if (pSlab->InUse == pSlab->Capacity) {
+        UnlinkSlab(&pClass->pFull, pSlab);
+        LinkSlab(&pClass->pPartial, pSlab);
+    }
+    List* pCell = reinterpret_cast<List*>(pHeader);
+    pCell->pNext = pSlab->pFree;
+    pSlab->pFree = pCell;
+    if (--pSlab->InUse == 0) {
+        m_RetainedSize += pClass->SlabSize;
+        if (m_RetainedSize > m_RetainedLimit) {
+            UnlinkSlab(&pClass->pPartial, pSlab);
+            ReleaseSlab(pSlab);
+        }
+    }
+}
+
+CSlabMemory::Slab* CSlabMemory::CreateSlab(SizeClass* pClass)
+{
+    size_t slabSize = pClass->SlabSize;
+    void* pMem = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+    if (m_bHugePage && slabSize == MAX_SLAB_SIZE) {
+        pMem = mmap(NULL, slabSize, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (pMem == MAP_FAILED) {
+            OUTPUT_DEBUG_TRACE("Huge page is unavailable: %s\n", strerror(errno));
+        }
+    }
+#endif
+    if (pMem == MAP_FAILED) {
+        pMem = mmap(NULL, slabSize, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (pMem == MAP_FAILED) {
+            OUTPUT_ERROR_TRACE("mmap %lu bytes: %s\n", slabSize, strerror(errno));
+            return NULL;
+        }
+    }
+
+    Slab* pSlab = reinterpret_cast<Slab*>(pMem);
+    pSlab->pPrev = NULL;
+    pSlab->pNext = NULL;
+    pSlab->pClass = pClass;
+    pSlab->pFree = NULL;
+    pSlab->pUnused = reinterpret_cast<uint8_t*>(pSlab) + sizeof(Slab);
+    pSlab->InUse = 0;
+    pSlab->Capacity = (slabSize - sizeof(Slab)) / pClass->ChunkSize;
+    m_MappedSize += slabSize;
+    m_RetainedSize += slabSize;
+    return pSlab;
+}
+
+void CSlabMemory::ReleaseSlab(Slab* pSlab)
+{
+    size_t slabSize = pSlab->pClass->SlabSize;
+    if (pSlab->InUse == 0) {
+        m_RetainedSize -= slabSize;
+    }
+    m_MappedSize -= slabSize;
+    munmap(pSlab, slabSize);
+}
+
+void CSlabMemory::LinkSlab(Slab** ppHead, Slab* pSlab)
+{
+    pSlab->pPrev = NULL;
+    pSlab->pNext = *ppHead;
+    if (*ppHead) {
+        (*ppHead)->pPrev = pSlab;
+    }
+    *ppHead = pSlab;
+}
+
+void CSlabMemory::UnlinkSlab(Slab** ppHead, Slab* pSlab)
+{
+    if (pSlab->pPrev) {
+        pSlab->pPrev->pNext = pSlab->pNext;
+    } else {
+        ASSERT(*ppHead == pSlab);
+        *ppHead = pSlab->pNext;
+    }
+    if (pSlab->pNext) {
+        pSlab->pNext->pPrev = pSlab->pPrev;
+    }
+    pSlab->pPrev = NULL;
+    pSlab->pNext = NULL;
+}
+
+size_t CSlabMemory::SizeClassIndex(size_t size)
+{
+    if (size <= MIN_CLASS_SIZE) {
+        return 0;
+    }
+
+    // 2^p < size <= 2^(p + 1), MIN_CLASS_SIZE is 2^5
+    size_t p = (sizeof(unsigned long) << 3) - 1 - __builtin_clzl(size - 1);
+    size_t base = static_cast<size_t>(1) << p;
+    if (size <= base + (base >> 1)) {
+        return ((p - 5) << 1) + 1;
+    }
+    return (p - 4) << 1;
+}
+
+size_t CSlabMemory::ClassSize(size_t index)
+{
+    if ((index & 1) == 0) {
+        return MIN_CLASS_SIZE << (index >> 1);
+    }
+    return (MIN_CLASS_SIZE + (MIN_CLASS_SIZE >> 1)) << (index >> 1);
+}
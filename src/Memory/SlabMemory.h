@@ -0,0 +1,107 @@
+/*
+ * See the file LICENSE for redistribution information.
+ *
+ * Copyright (c) 2015-2018, Yuan Qin <yuanqin2000 at outlook dot com>
+ * All rights reserved.
+ *
+ */
+
+#ifndef __COMMON_SLAB_MEMORY_H__
+#define __COMMON_SLAB_MEMORY_H__
+
+#include "Common/Typedefs.h"
+#include "Common/Macros.h"
+#include "Memory.h"
+
+/**
+ * @brief General purpose allocator based on size classes.
+ *
+ * The size classes are geometric, two classes per power of two
+ * (32, 48, 64, 96, 128, ...) up to MAX_CLASS_SIZE. The classes and the
+ * chunk header are multiples of ALIGNMENT, so every chunk returned is
+ * aligned for any type, as malloc does.
+ * Every class carves its chunks from page-backed slabs (4KB to 2MB),
+ * the 2MB slabs can be mapped from huge pages if required.
+ * The chunk larger than MAX_CLASS_SIZE is allocated from the system.
+ *
+ * A slab is released to the system when all of its chunks are free and
+ * the empty slabs already retained exceed the retained limit.
+ *
+ * @warning: Not thread safe.
+ */
+class CSlabMemory : public CMemory
+{
+public:
+    /**
+     * @param retainedLimit: The max bytes of the empty slabs kept by the allocator.
+     * @param bHugePage: Map the 2MB slabs from huge pages if possible.
+     */
+    CSlabMemory(
+        size_t retainedLimit = DEFAULT_RETAINED_LIMIT,
+        bool bHugePage = false);
+    ~CSlabMemory();
+
+    // From CMemory
+    void* Malloc(size_t size);
+    void Free(void* pMem);
+
+    size_t RetainedSize() const { return m_RetainedSize; }
+    size_t MappedSize() const { return m_MappedSize; }
+
+    static const size_t ALIGNMENT = 16;    // alignof(max_align_t)
+    static const size_t MIN_CLASS_SIZE = 32;
+    static const size_t MAX_CLASS_SIZE = 256 * 1024;       /* 256KB */
+    static const size_t MIN_SLAB_SIZE = 4 * 1024;          /* 4KB */
+    static const size_t MAX_SLAB_SIZE = 2 * 1024 * 1024;   /* 2MB */
+    static const size_t DEFAULT_RETAINED_LIMIT = 4 * 1024 * 1024;  /* 4MB */
+
+private:
+    struct Slab;
+
+    struct ChunkHeader {
+        Slab* pSlab;    // NULL if the chunk is allocated from the system
+    } __ALIGN__(ALIGNMENT);
+
+    struct List {
+        List* pNext;
+    };
+
+    struct SizeClass {
+        size_t ChunkSize;   // Including the ChunkHeader
+        size_t SlabSize;
+        Slab* pPartial;     // Slabs which have free chunk(s)
+        Slab* pFull;        // Slabs which have no free chunk
+    };
+
+    struct Slab {
+        Slab* pPrev;
+        Slab* pNext;
+        SizeClass* pClass;
+        List* pFree;
+        uint8_t* pUnused;   // Never carved space
+        size_t InUse;
+        size_t Capacity;
+    } __ALIGN__(ALIGNMENT);
+
+    Slab* CreateSlab(SizeClass* pClass);
+    void ReleaseSlab(Slab* pSlab);
+    static void LinkSlab(Slab** ppHead, Slab* pSlab);
+    static void UnlinkSlab(Slab** ppHead, Slab* pSlab);
+
+    static size_t SizeClassIndex(size_t size);
+    static size_t ClassSize(size_t index);
+
+    static const size_t CLASS_COUNT = 27;  // 32B ... 256KB
+
+private:
+    SizeClass m_Classes[CLASS_COUNT];
+    size_t m_RetainedSize;
+    size_t m_MappedSize;
+    const size_t m_RetainedLimit;
+    const bool m_bHugePage;
+
+    DISALLOW_COPY_CONSTRUCTOR(CSlabMemory);
+    DISALLOW_ASSIGN_OPERATOR(CSlabMemory);
+};
+
+#endif
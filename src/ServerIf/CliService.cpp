@@ -88,7 +88,8 @@ bool CCliService::Start()
     if (pPoller == NULL) {
         return false;
     }
-    CLooper* pLoop = CLooper::CreateInstance("CliService", *pPoller, *pPoller);
+    CLooper* pLoop = CLooper::CreateInstance(
+        "CliService", *pPoller, *pPoller, CPoller::MSG_BATCH_SIZE);
     if (pLoop == NULL) {
         delete pPoller;
         return false;
@@ -20,8 +20,18 @@ public:
      * @param pIndata The data to be processed.
      * @return The output data if generated, NULL otherwise.
      * @warning The Bolt object is response to release @pIndata
+     * @note @pIndata may be shared with the other bolts, call
+     *       ArrayDataFrames::MakeWritable before modify it.
      */
     virtual ArrayDataFrames* Process(ArrayDataFrames* pInData) = 0;
+
+    /**
+     * @brief Create the bolt for another parallel instance.
+     * @return NULL if the bolt is shared by the instances (the default),
+     *         then Process is called concurrently and shall be stateless
+     *         or thread safe. The clone is owned by the instance.
+     */
+    virtual IBolt* Clone() { return NULL; }
 };
 
 #endif
\ No newline at end of file
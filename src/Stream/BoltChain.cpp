@@ -10,11 +10,19 @@
 #include "Bolt.h"
 #include "Thread/ArrayDataFrames.h"
 #include <cstdlib>
+#include <cstring>
 
+using std::calloc;
 using std::free;
 
 CBoltChain::~CBoltChain()
 {
+    if (m_pClonedArray) {
+        for (size_t i = 0; i < m_ArrayLen; ++i) {
+            delete m_pClonedArray[i];
+        }
+        free(m_pClonedArray);
+    }
     if (m_pBoltArray) {
         free(m_pBoltArray);
     }
@@ -53,6 +61,33 @@ CBoltChain* CBoltChain::CreateInstance(va_list args)
     return pInstance;
 }
 
+CBoltChain* CBoltChain::Duplicate()
+{
+    IBolt** pArray = reinterpret_cast<IBolt**>(malloc(m_ArrayLen * sizeof(IBolt*)));
+    if (pArray == NULL) {
+        return NULL;
+    }
+    CBoltChain* pInstance = new CBoltChain(pArray, m_ArrayLen);
+    if (pInstance == NULL) {
+        free(pArray);
+        return NULL;
+    }
+    pInstance->m_pClonedArray =
+        reinterpret_cast<IBolt**>(calloc(m_ArrayLen, sizeof(IBolt*)));
+    if (pInstance->m_pClonedArray == NULL) {
+        delete pInstance;
+        return NULL;
+    }
+
+    // The stateful bolt is cloned, the stateless one is shared.
+    for (size_t i = 0; i < m_ArrayLen; ++i) {
+        IBolt* pClone = m_pBoltArray[i]->Clone();
+        pInstance->m_pClonedArray[i] = pClone;
+        pArray[i] = pClone ? pClone : m_pBoltArray[i];
+    }
+    return pInstance;
+}
+
 ArrayDataFrames* CBoltChain::Process(ArrayDataFrames* pData)
 {
     size_t index = 0;
@@ -30,13 +30,21 @@ public:
      */
     ArrayDataFrames* Process(ArrayDataFrames* pData);
 
+    /**
+     * @brief Create a chain for the parallel instance, with the clones of
+     *        the bolts (IBolt::Clone), or the same bolts if not cloned.
+     */
+    CBoltChain* Duplicate();
+
 private:
     CBoltChain(IBolt** pBoltArray, size_t arrayLen) :
         m_pBoltArray(pBoltArray),
+        m_pClonedArray(NULL),
         m_ArrayLen(arrayLen) {}
 
 private:
-    IBolt** m_pBoltArray;    // Owned
+    IBolt** m_pBoltArray;    // Owned, the bolts are not owned.
+    IBolt** m_pClonedArray;  // Owned, the cloned bolts (owned) or NULL.
     size_t m_ArrayLen;
 
     DISALLOW_DEFAULT_CONSTRUCTOR(CBoltChain);
@@ -0,0 +1,206 @@
+/*
+ * See the file LICENSE for redistribution information.
+ *
+ * Copyright (c) 2015-2018, Yuan Qin <yuanqin2000 at outlook dot com>
+ * All rights reserved.
+ *
+ */
+
+#include "BoltGroup.h"
+#include "BoltChain.h"
+#include "BoltRunner.h"
+#include "MsgDefs.h"
+#include "Common/Arch.h"
+#include "Thread/ArrayDataFrames.h"
+#include "Thread/ITMessage.h"
+#include "Tracker/Trace.h"
+#include <cstdlib>
+
+using std::malloc;
+using std::free;
+
+CBoltGroup::CBoltGroup(
+    CBoltRunner** pRunners, size_t count, Grouping grouping, size_t fieldIndex) :
+    CDGNode(),
+    m_pRunners(pRunners),
+    m_Count(count),
+    m_Grouping(grouping),
+    m_FieldIndex(fieldIndex),
+    m_NextIndex(0)
+{
+}
+
+CBoltGroup::~CBoltGroup()
+{
+    for (size_t i = 0; i < m_Count; ++i) {
+        delete m_pRunners[i];
+    }
+    free(m_pRunners);
+}
+
+CBoltGroup* CBoltGroup::CreateInstance(
+    const char* pName,
+    CBoltChain* pChain,
+    size_t parallelism /* = 1 */,
+    Grouping grouping /* = GROUPING_SHUFFLE */,
+    size_t fieldIndex /* = 0 */,
+    CTaskExecutor* pExecutor /* = NULL */,
+    size_t queueCapacity /* = CRingMsgSwitch::DEFAULT_CAPACITY */)
+{
+    ASSERT(pName);
+    ASSERT(pChain);
+    ASSERT(parallelism > 0);
+    ASSERT(queueCapacity > 0);
+
+    CBoltRunner** pRunners = reinterpret_cast<CBoltRunner**>(
+        malloc(sizeof(CBoltRunner*) * parallelism));
+    if (pRunners == NULL) {
+        return NULL;
+    }
+
+    size_t count = 0;
+    while (count < parallelism) {
+        CBoltChain* pInstChain = count == 0 ? pChain : pChain->Duplicate();
+        if (pInstChain == NULL) {
+            break;
+        }
+        pRunners[count] = new CBoltRunner(
+            pName, pInstChain, queueCapacity, pExecutor, count);
+        if (pRunners[count] == NULL) {
+            if (count > 0) {
+                delete pInstChain;
+            }
+            break;
+        }
+        ++count;
+    }
+
+    CBoltGroup* pInstance = NULL;
+    if (count == parallelism) {
+        pInstance = new CBoltGroup(pRunners, count, grouping, fieldIndex);
+    }
+    if (pInstance == NULL) {
+        OUTPUT_WARNING_TRACE("Create %d instances of %s failed.\n", parallelism, pName);
+        // The chain is owned by the caller if failed.
+        for (size_t i = 0; i < count; ++i) {
+            if (i == 0) {
+                pRunners[i]->DetachBoltChain();
+            }
+            delete pRunners[i];
+        }
+        free(pRunners);
+    }
+    return pInstance;
+}
+
+bool CBoltGroup::Start()
+{
+    for (size_t i = 0; i < m_Count; ++i) {
+        if (!m_pRunners[i]->Start()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool CBoltGroup::Stop()
+{
+    bool bRes = true;
+    for (size_t i = 0; i < m_Count; ++i) {
+        if (!m_pRunners[i]->Stop()) {
+            bRes = false;
+        }
+    }
+    return bRes;
+}
+
+bool CBoltGroup::AddForwardNode(CDGNode* pNode)
+{
+    if (!CDGNode::AddForwardNode(pNode)) {
+        return false;
+    }
+    for (size_t i = 0; i < m_Count; ++i) {
+        if (!m_pRunners[i]->AddForwardNode(pNode)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool CBoltGroup::Dispatch(ArrayDataFrames* pFrames, size_t sourceIndex)
+{
+    ASSERT(pFrames);
+
+    if (m_Grouping != GROUPING_BROADCAST) {
+        return Push(SelectInstance(pFrames, sourceIndex), pFrames);
+    }
+
+    bool bRes = true;
+    for (size_t i = 0; i + 1 < m_Count; ++i) {
+        if (!Push(i, pFrames->AddRef())) {
+            bRes = false;
+        }
+    }
+    return Push(m_Count - 1, pFrames) && bRes;
+}
+
+bool CBoltGroup::WaitCredit(int timeout)
+{
+    // Any instance may be selected, so wait for all of them.
+    for (size_t i = 0; i < m_Count; ++i) {
+        if (!m_pRunners[i]->WaitCredit(timeout)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t CBoltGroup::SelectInstance(ArrayDataFrames* pFrames, size_t sourceIndex)
+{
+    if (m_Count == 1) {
+        return 0;
+    }
+
+    size_t index = 0;
+    switch (m_Grouping) {
+    case GROUPING_SHUFFLE:
+        index = static_cast<uint32_t>(AtomicInc(&m_NextIndex)) % m_Count;
+        break;
+    case GROUPING_FIELD:
+        if (m_FieldIndex < pFrames->Count) {
+            // FNV-1a
+            DataFrame* pFrame = &pFrames->Frames[m_FieldIndex];
+            const uint8_t* pData = reinterpret_cast<const uint8_t*>(pFrame->GetData());
+            uint32_t hash = 2166136261U;
+            for (size_t i = 0; pData && i < pFrame->Length; ++i) {
+                hash = (hash ^ pData[i]) * 16777619U;
+            }
+            index = hash % m_Count;
+        }
+        break;
+    case GROUPING_LOCAL:
+        index = sourceIndex % m_Count;
+        break;
+    default:
+        ASSERT(false, "Unknown grouping: %d\n", m_Grouping);
+        break;
+    }
+    return index;
+}
+
+bool CBoltGroup::Push(size_t index, ArrayDataFrames* pFrames)
+{
+    ITMessage msg(STREAM_USER_DATA);
+    msg.SetExtData(
+        pFrames,
+        pFrames->Count,
+        ArrayDataFrames::DeleteInstance,
+        ArrayDataFrames::Share,
+        true);
+    if (!m_pRunners[index]->PushMessage(&msg)) {
+        ArrayDataFrames::DeleteInstance(pFrames);
+        OUTPUT_WARNING_TRACE("Push Message to bolt failed.\n");
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,108 @@
+/*
+ * See the file LICENSE for redistribution information.
+ *
+ * Copyright (c) 2015-2018, Yuan Qin <yuanqin2000 at outlook dot com>
+ * All rights reserved.
+ *
+ */
+
+#ifndef __STREAM_BOLT_GROUP_H__
+#define __STREAM_BOLT_GROUP_H__
+
+#include "Common/Typedefs.h"
+#include "Common/Macros.h"
+#include "Common/DiGraph.h"
+#include "Thread/RingMsgSwitch.h"
+
+struct ArrayDataFrames;
+class CBoltChain;
+class CBoltRunner;
+class CTaskExecutor;
+
+/**
+ * @brief The parallel instances of a bolt declared in the topology,
+ *        and how the upstream messages are distributed to them.
+ *
+ * Every instance runs the clones of the bolts (IBolt::Clone), the bolt
+ * which is not cloned is shared by the instances and its IBolt::Process
+ * may be called concurrently if the parallelism is greater than 1.
+ */
+class CBoltGroup : public CDGNode
+{
+public:
+    enum Grouping {
+        GROUPING_SHUFFLE,       // Round robin to one of the instances.
+        GROUPING_FIELD,         // Hash of the specified frame, same frame to same instance.
+        GROUPING_BROADCAST,     // Every instance gets a copy.
+        GROUPING_LOCAL          // The instance with the same index as the upstream.
+    };
+
+    ~CBoltGroup();
+
+    /**
+     * @param pChain The bolt chain of the first instance, owned by the group.
+     * @param parallelism The count of the instances.
+     * @param fieldIndex The frame to hash for GROUPING_FIELD.
+     * @param pExecutor Run the instances on the executor if not NULL.
+     * @param queueCapacity The bounded message queue of each instance.
+     */
+    static CBoltGroup* CreateInstance(
+        const char* pName,
+        CBoltChain* pChain,
+        size_t parallelism = 1,
+        Grouping grouping = GROUPING_SHUFFLE,
+        size_t fieldIndex = 0,
+        CTaskExecutor* pExecutor = NULL,
+        size_t queueCapacity = CRingMsgSwitch::DEFAULT_CAPACITY);
+
+    bool Start();
+    bool Stop();
+
+    /**
+     * @brief Follow the upstream node, all of the instances share
+     *        the downstream of the group.
+     */
+    bool AddForwardNode(CDGNode* pNode);
+
+    /**
+     * @brief Dispatch the frames to the instance(s).
+     * @param sourceIndex The instance index of the upstream runner.
+     * @return true if the frames are pushed to the instance(s).
+     * @warning The ownership of @pFrames will be transferred.
+     */
+    bool Dispatch(ArrayDataFrames* pFrames, size_t sourceIndex);
+
+    /**
+     * @brief Wait until every instance has credit.
+     * @param timeout milli-seconds to wait for each instance.
+     * @return false if timeout.
+     */
+    bool WaitCredit(int timeout);
+
+    size_t Count() const { return m_Count; }
+    CBoltRunner* At(size_t index)
+    {
+        ASSERT(index < m_Count);
+        return m_pRunners[index];
+    }
+
+private:
+    CBoltGroup(
+        CBoltRunner** pRunners, size_t count, Grouping grouping, size_t fieldIndex);
+
+    size_t SelectInstance(ArrayDataFrames* pFrames, size_t sourceIndex);
+    bool Push(size_t index, ArrayDataFrames* pFrames);
+
+private:
+    CBoltRunner** m_pRunners;   // Owned
+    const size_t m_Count;
+    const Grouping m_Grouping;
+    const size_t m_FieldIndex;
+    volatile int32_t m_NextIndex;
+
+    DISALLOW_DEFAULT_CONSTRUCTOR(CBoltGroup);
+    DISALLOW_COPY_CONSTRUCTOR(CBoltGroup);
+    DISALLOW_ASSIGN_OPERATOR(CBoltGroup);
+};
+
+#endif
@@ -8,18 +8,39 @@
 
 #include "BoltRunner.h"
 #include "BoltChain.h"
+#include "BoltGroup.h"
 #include "Thread/ArrayDataFrames.h"
 #include "Thread/ITMessage.h"
 #include "Thread/Looper.h"
+#include "Tracker/Time.h"
 #include "Tracker/Trace.h"
 
 CBoltRunner::CBoltRunner(
-    const char* pName, CBoltChain* pChain, size_t msgBufSize /* = 0 */) :
-    CStreamRunner(pName, pChain),
+    const char* pName,
+    CBoltChain* pChain,
+    size_t msgBufSize /* = CRingMsgSwitch::DEFAULT_CAPACITY */,
+    CTaskExecutor* pExecutor /* = NULL */,
+    size_t index /* = 0 */) :
+    CStreamRunner(pName, pChain, index),
     m_pLoop(NULL),
     m_MsgSwitch(msgBufSize),
-    m_RunnerObject(this)
+    m_RunnerObject(this),
+    m_pExecutor(pExecutor),
+    m_TaskObject(this),
+    m_Scheduled(0),
+    m_OverflowCS(),
+    m_Overflow(),
+    m_OverflowCount(0),
+    m_Credits(static_cast<int32_t>(m_MsgSwitch.Capacity())),
+    m_CreditEvent(),
+    m_StallCount(0),
+    m_StallNanosec(0),
+    m_bCreditWait(0),
+    m_WaiterCS(),
+    m_CreditWaiters(),
+    m_WaiterCount(0)
 {
+    ASSERT(msgBufSize > 0);
 }
 
 CBoltRunner::~CBoltRunner()
@@ -30,8 +51,10 @@ CBoltRunner::~CBoltRunner()
 bool CBoltRunner::Start()
 {
     bool bRes = true;
-    if (m_pLoop == NULL) {
-        m_pLoop = CLooper::CreateInstance(GetName(), m_RunnerObject, m_MsgSwitch);
+    if (m_pExecutor == NULL && m_pLoop == NULL) {
+        m_MsgSwitch.Open();
+        m_pLoop = CLooper::CreateInstance(
+            GetName(), m_RunnerObject, m_MsgSwitch, MSG_BATCH_SIZE);
         if (m_pLoop == NULL) {
             OUTPUT_WARNING_TRACE("Create LoopRunner failed.\n");
             bRes = false;
@@ -47,11 +70,117 @@ bool CBoltRunner::Stop()
         bRes = m_pLoop->Exit();
         if (bRes) {
             delete m_pLoop;
+            m_pLoop = NULL;
+
+            // Nothing consumes the ring, release the blocked producers.
+            m_MsgSwitch.Close();
+            m_CreditEvent.Notify(true);
         }
     }
     return bRes;
 }
 
+bool CBoltRunner::PushMessage(ITMessage* pMsg, bool bSync /* = false */)
+{
+    if (!AcquireCredit()) {
+        return false;
+    }
+
+    bool bRes = false;
+    if (m_pExecutor) {
+        bRes = PushTaskMessage(pMsg, bSync);
+    } else {
+        bRes = bSync ?
+            m_MsgSwitch.WriteMessageSync(pMsg) :
+            m_MsgSwitch.WriteMessage(pMsg);
+    }
+    if (!bRes) {
+        ReturnCredit();
+    }
+    return bRes;
+}
+
+bool CBoltRunner::WaitCredit(int timeout /* = -1 */)
+{
+    if (m_Credits > 0) {
+        return true;
+    }
+
+    int64_t deadline = timeout > 0 ? GetMonotonicNanosec() + timeout * 1000000LL : 0;
+    while (true) {
+        uint32_t key = m_CreditEvent.PrepareWait();
+        if (m_Credits > 0) {
+            m_CreditEvent.CancelWait();
+            return true;
+        }
+        int remain = timeout;
+        if (timeout > 0) {
+            remain = static_cast<int>((deadline - GetMonotonicNanosec()) / 1000000);
+        }
+        if (m_MsgSwitch.IsClosed() || timeout == 0 || (timeout > 0 && remain <= 0)) {
+            m_CreditEvent.CancelWait();
+            return false;
+        }
+        m_CreditEvent.Wait(key, remain);
+    }
+}
+
+void CBoltRunner::GetFlowStats(FlowStats* pOutStats) const
+{
+    ASSERT(pOutStats);
+
+    pOutStats->Capacity = m_MsgSwitch.Capacity();
+    pOutStats->QueueDepth = QueueDepth();
+    pOutStats->StallCount = static_cast<uint64_t>(m_StallCount);
+    pOutStats->StallNanosec = static_cast<uint64_t>(m_StallNanosec);
+}
+
+bool CBoltRunner::TryAcquireCredit()
+{
+    int32_t credits = m_Credits;
+    while (credits > 0) {
+        if (AtomicCAS(&m_Credits, credits, credits - 1)) {
+            return true;
+        }
+        credits = m_Credits;
+    }
+    return false;
+}
+
+bool CBoltRunner::AcquireCredit()
+{
+    if (TryAcquireCredit()) {
+        return true;
+    }
+
+    if (m_pExecutor && m_pExecutor->InWorker()) {
+        // The worker never waits, overdraw the credit. The producer task
+        // yields before its next batch until the credits are returned.
+        AtomicDec(&m_Credits);
+        return true;
+    }
+
+    // The stopped runner returns no credit, give up.
+    int64_t start = GetMonotonicNanosec();
+    bool bRes = true;
+    while (!TryAcquireCredit()) {
+        uint32_t key = m_CreditEvent.PrepareWait();
+        if (m_Credits > 0) {
+            m_CreditEvent.CancelWait();
+            continue;
+        }
+        if (m_MsgSwitch.IsClosed()) {
+            m_CreditEvent.CancelWait();
+            bRes = false;
+            break;
+        }
+        m_CreditEvent.Wait(key);
+    }
+    AtomicInc64(&m_StallCount);
+    AtomicAdd64(&m_StallNanosec, GetMonotonicNanosec() - start);
+    return bRes;
+}
+
 void CBoltRunner::CRunnerObject::HandleMessage(ITMessage* pMsg)
 {
     ArrayDataFrames* pFrames = reinterpret_cast<ArrayDataFrames*>(pMsg->GetData());
@@ -66,4 +195,159 @@ void CBoltRunner::CRunnerObject::HandleMessage(ITMessage* pMsg)
                 "Forward to %d bolt runner while have %d count.\n", sentCount, count);
         }
     }
+    m_pContext->ReturnCredit();
+}
+
+bool CBoltRunner::PushTaskMessage(ITMessage* pMsg, bool bSync)
+{
+    ASSERT(m_pExecutor);
+
+    if (m_pExecutor->InWorker()) {
+        // The consumer task may be pending on the calling worker,
+        // never block nor wait for it.
+        if (bSync) {
+            OUTPUT_WARNING_TRACE("Refuse the sync push from the worker.\n");
+            return false;
+        }
+        m_OverflowCS.Lock();
+        if (m_OverflowCount > 0 || !m_MsgSwitch.TryWriteMessage(pMsg)) {
+            // Keep the order after the parked messages.
+            m_Overflow.push_back(*pMsg);
+            ++m_OverflowCount;
+        }
+        m_OverflowCS.Unlock();
+    } else {
+        if (bSync && !pMsg->SetSync(true)) {
+            return false;
+        }
+        if (!m_MsgSwitch.WriteMessage(pMsg)) {
+            return false;
+        }
+    }
+    if (AtomicCAS(&m_Scheduled, 0, 1)) {
+        m_pExecutor->Submit(&m_TaskObject);
+    }
+    if (bSync) {
+        pMsg->WaitSink();
+    }
+    return true;
+}
+
+size_t CBoltRunner::PopOverflow(ITMessage* pOutMsgs, size_t count)
+{
+    size_t index = 0;
+    m_OverflowCS.Lock();
+    // The messages parked later than those in the ring wait for the ring.
+    if (m_MsgSwitch.IsEmpty()) {
+        while (index < count && !m_Overflow.empty()) {
+            pOutMsgs[index++] = m_Overflow.front();
+            m_Overflow.pop_front();
+        }
+        m_OverflowCount -= static_cast<int32_t>(index);
+    }
+    m_OverflowCS.Unlock();
+    return index;
+}
+
+void CBoltRunner::RunTask()
+{
+    if (!WaitForwardCredit(0) && ParkForCredit()) {
+        // Keep scheduled, the downstream submits the task with its credit.
+        return;
+    }
+
+    ITMessage msgs[MSG_BATCH_SIZE];
+    size_t count = m_MsgSwitch.ReadMessages(msgs, MSG_BATCH_SIZE, 0);
+    if (count < MSG_BATCH_SIZE && m_OverflowCount > 0) {
+        count += PopOverflow(msgs + count, MSG_BATCH_SIZE - count);
+    }
+    if (count > 0) {
+        m_RunnerObject.HandleMessages(msgs, count);
+        for (size_t i = 0; i < count; ++i) {
+            msgs[i].SignalSourceIfNeeded();
+            msgs[i].Destroy();
+        }
+    }
+
+    if (count == MSG_BATCH_SIZE) {
+        // Still scheduled, yield the worker to the other tasks.
+        m_pExecutor->Submit(&m_TaskObject, true);
+        return;
+    }
+
+    // The producer writes the message then checks the flag, here clears
+    // the flag then checks the message, so one of them will reschedule.
+    m_Scheduled = 0;
+    __sync_synchronize();
+    if ((!m_MsgSwitch.IsEmpty() || m_OverflowCount > 0) &&
+        AtomicCAS(&m_Scheduled, 0, 1)) {
+        m_pExecutor->Submit(&m_TaskObject);
+    }
+}
+
+bool CBoltRunner::ParkForCredit()
+{
+    m_bCreditWait = 1;
+    CForwardList& downStream(GetForwardNodes());
+    CForwardList::Iterator iter = downStream.Begin();
+    CForwardList::Iterator end = downStream.End();
+    while (iter != end) {
+        CBoltGroup* pGroup = reinterpret_cast<CBoltGroup*>(downStream.DataAt(iter));
+        for (size_t i = 0; i < pGroup->Count(); ++i) {
+            CBoltRunner* pRunner = pGroup->At(i);
+            if (pRunner->m_Credits > 0) {
+                continue;
+            }
+            // The downstream returns the credit then checks the waiters,
+            // here adds the waiter then checks the credit, so one of them
+            // will resume the task.
+            pRunner->AddCreditWaiter(this);
+            __sync_synchronize();
+            if (pRunner->m_Credits <= 0) {
+                return true;
+            }
+        }
+        ++iter;
+    }
+
+    // The credits are back meanwhile, unless the task is resumed already.
+    return !AtomicCAS(&m_bCreditWait, 1, 0);
+}
+
+void CBoltRunner::ResumeTask()
+{
+    if (AtomicCAS(&m_bCreditWait, 1, 0)) {
+        m_pExecutor->Submit(&m_TaskObject);
+    }
+}
+
+void CBoltRunner::AddCreditWaiter(CBoltRunner* pUpstream)
+{
+    ASSERT(pUpstream);
+
+    m_WaiterCS.Lock();
+    size_t count = m_CreditWaiters.size();
+    size_t i = 0;
+    while (i < count && m_CreditWaiters[i] != pUpstream) {
+        ++i;
+    }
+    if (i == count) {
+        m_CreditWaiters.push_back(pUpstream);
+        m_WaiterCount = static_cast<int32_t>(count + 1);
+    }
+    m_WaiterCS.Unlock();
+}
+
+void CBoltRunner::WakeCreditWaiters()
+{
+    vector<CBoltRunner*> waiters;
+    m_WaiterCS.Lock();
+    waiters.swap(m_CreditWaiters);
+    m_WaiterCount = 0;
+    m_WaiterCS.Unlock();
+
+    // The waiter resumed by its own check meanwhile is not submitted twice.
+    for (size_t i = 0; i < waiters.size(); ++i) {
+        waiters[i]->ResumeTask();
+    }
 }
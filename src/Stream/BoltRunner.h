@@ -9,33 +9,99 @@
 #ifndef __STREAM_BOLT_RUNNER_H__
 #define __STREAM_BOLT_RUNNER_H__
 
+#include <deque>
+#include <vector>
 #include "StreamRunner.h"
 #include "MsgDefs.h"
 #include "Common/Typedefs.h"
 #include "Thread/ArrayDataFrames.h"
-#include "Thread/QueueMsgSwitch.h"
+#include "Thread/RingMsgSwitch.h"
+#include "Thread/EventCount.h"
+#include "Thread/Lock.h"
+#include "Thread/TaskExecutor.h"
 #include "Tracker/Trace.h"
 
+using std::deque;
+using std::vector;
+
 class IBolt;
 class CLooper;
 
+/**
+ * @brief Run the bolt chain on the messages from the upstream runners.
+ *
+ * The runner has its own looper thread by default. If the executor is
+ * given, the runner is scheduled as a task of the executor whenever it
+ * has message, at most one task of the runner is scheduled or running
+ * at any time, so the messages are still processed one by one in order.
+ * The worker never blocks on the runner, the message pushed by the worker
+ * on the full ring is parked in the overflow list which is drained by the
+ * task after the ring, and the sync push from the worker is refused.
+ *
+ * The upstream gets a credit of the runner before push a message, the
+ * credit is returned after the message is processed. The upstream waits
+ * if there is no credit, and the spout stops reading (WaitCredit) until
+ * the downstream has credits, so the backpressure goes up to the spout.
+ * The upstream task on the executor does not wait, it overdraws the
+ * credits of the batch. If the downstream has no credit before its next
+ * batch, the task is parked on the downstream runner instead of being
+ * submitted, and is submitted again when the downstream returns a credit.
+ */
 class CBoltRunner : public CStreamRunner
 {
 public:
-    CBoltRunner(const char* pName, CBoltChain* pChain, size_t msgBufSize = 0);
+    /**
+     * @param msgBufSize The capacity of the message ring, also the credits
+     *        of the upstream. The queue is always bounded, an unbounded one
+     *        would defeat the backpressure.
+     * @param pExecutor Run on the executor instead of the own thread if not NULL.
+     * @param index The index in the parallel instances of the bolt.
+     */
+    CBoltRunner(
+        const char* pName,
+        CBoltChain* pChain,
+        size_t msgBufSize = CRingMsgSwitch::DEFAULT_CAPACITY,
+        CTaskExecutor* pExecutor = NULL,
+        size_t index = 0);
     ~CBoltRunner();
 
     // From CStreamRunner
     bool Start();
     bool Stop();
 
-    bool PushMessage(ITMessage* pMsg, bool bSync = false)
+    /**
+     * @brief Push the message, wait for the credit if there is none.
+     *        The worker of the executor overdraws the credit instead.
+     * @return false if the runner is stopped meanwhile.
+     */
+    bool PushMessage(ITMessage* pMsg, bool bSync = false);
+
+    /**
+     * @brief Wait until the runner has credit, the credit is not taken.
+     * @param timeout milli-seconds to wait, infinit wait if less than 0.
+     * @return false if timeout or the runner is stopped.
+     */
+    bool WaitCredit(int timeout = -1);
+
+    struct FlowStats {
+        size_t Capacity;        // The total credits
+        size_t QueueDepth;      // The messages pushed but not processed
+        uint64_t StallCount;    // The times the upstream waited for credit
+        uint64_t StallNanosec;  // The time the upstream waited for credit
+    };
+
+    void GetFlowStats(FlowStats* pOutStats) const;
+
+    size_t QueueDepth() const
     {
-        return bSync ?
-            m_MsgSwitch.WriteMessageSync(pMsg) :
-            m_MsgSwitch.WriteMessage(pMsg);
+        // The credits overdrawn by the workers are negative.
+        return static_cast<size_t>(
+            static_cast<int64_t>(m_MsgSwitch.Capacity()) - m_Credits);
     }
 
+    // The messages drained by the looper (or the task) in one round.
+    static const size_t MSG_BATCH_SIZE = 32;
+
 private:
     class CRunnerObject : public IRunner
     {
@@ -49,10 +115,61 @@ private:
         CBoltRunner* m_pContext;
     };
 
+    class CTaskObject : public ITask
+    {
+    public:
+        CTaskObject(CBoltRunner* pCxt) : m_pContext(pCxt) { ASSERT(pCxt); }
+
+        // From ITask
+        void Run() { m_pContext->RunTask(); }
+
+    private:
+        CBoltRunner* m_pContext;
+    };
+
+    bool PushTaskMessage(ITMessage* pMsg, bool bSync);
+    void RunTask();
+    size_t PopOverflow(ITMessage* pOutMsgs, size_t count);
+
+    // Park the task until the downstream runners have credits,
+    // false if they have credits meanwhile and the task shall go on.
+    bool ParkForCredit();
+    void ResumeTask();
+    void AddCreditWaiter(CBoltRunner* pUpstream);
+    void WakeCreditWaiters();
+
+    bool TryAcquireCredit();
+    bool AcquireCredit();
+    void ReturnCredit()
+    {
+        // Only the waiters on the exhausted credits need to be waked up.
+        int32_t credits = AtomicInc(&m_Credits);
+        if (credits == 1) {
+            m_CreditEvent.Notify(true);
+        }
+        if (credits > 0 && m_WaiterCount > 0) {
+            WakeCreditWaiters();
+        }
+    }
+
 private:
     CLooper* m_pLoop;
-    CQueueMsgSwitch m_MsgSwitch;
+    CMPSCRingMsgSwitch m_MsgSwitch;    // Fan-in from the upstream runners
     CRunnerObject m_RunnerObject;
+    CTaskExecutor* m_pExecutor;        // Not owned
+    CTaskObject m_TaskObject;
+    volatile int32_t m_Scheduled;     // The task is submitted or running.
+    CCriticalSection m_OverflowCS;
+    deque<ITMessage> m_Overflow;       // Pushed by the workers on the full ring
+    volatile int32_t m_OverflowCount;
+    volatile int32_t m_Credits;
+    CEventCount m_CreditEvent;
+    volatile int64_t m_StallCount;
+    volatile int64_t m_StallNanosec;
+    volatile int32_t m_bCreditWait;    // The task is parked for the credits.
+    CCriticalSection m_WaiterCS;
+    vector<CBoltRunner*> m_CreditWaiters;  // The parked upstream runners, not owned
+    volatile int32_t m_WaiterCount;
 
     DISALLOW_DEFAULT_CONSTRUCTOR(CBoltRunner);
     DISALLOW_COPY_CONSTRUCTOR(CBoltRunner);
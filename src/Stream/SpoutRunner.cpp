@@ -14,12 +14,15 @@
 #include "Thread/ArrayDataFrames.h"
 #include "Thread/ITMessage.h"
 #include "Thread/Thread.h"
+#include "Common/Arch.h"
+#include "Tracker/Time.h"
 
 CSpoutRunner::CSpoutRunner(
     const char* pName, ISpout& spout, CBoltChain* pChain) :
     CStreamRunner(pName, pChain),
     m_pThread(NULL),
-    m_Spout(spout)
+    m_Spout(spout),
+    m_ThrottleNanosec(0)
 {
 }
 
@@ -50,12 +53,27 @@ bool CSpoutRunner::Stop()
     return bRes;
 }
 
+bool CSpoutRunner::Throttle()
+{
+    if (WaitForwardCredit(0)) {
+        return true;
+    }
+
+    int64_t start = GetMonotonicNanosec();
+    bool bRes = WaitForwardCredit(THROTTLE_WAIT_MILLISEC);
+    AtomicAdd64(&m_ThrottleNanosec, GetMonotonicNanosec() - start);
+    return bRes;
+}
+
 void* CSpoutRunner::Running(void* pArg)
 {
     CSpoutRunner* pThis = reinterpret_cast<CSpoutRunner*>(pArg);
     bool bEof = false;
     while (!bEof) {
         pThis->m_pThread->CheckCancel();
+        if (!pThis->Throttle()) {
+            continue;   // Do not read while the downstream is busy.
+        }
         ArrayDataFrames* pMsg = NULL;
         bEof = pThis->m_Spout.Read(&pMsg);
         if (pMsg == NULL) {
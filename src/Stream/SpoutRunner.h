@@ -26,12 +26,24 @@ public:
     bool Start();
     bool Stop();
 
+    // The time the spout stopped reading for the downstream backpressure.
+    uint64_t ThrottleNanosec() const
+    {
+        return static_cast<uint64_t>(m_ThrottleNanosec);
+    }
+
+    // The milli-seconds to wait the credit before check the cancellation.
+    static const int THROTTLE_WAIT_MILLISEC = 100;
+
 private:
+    bool Throttle();
+
     static void* Running(void* pArg);
 
 private:
     CThread* m_pThread;
     ISpout& m_Spout;
+    volatile int64_t m_ThrottleNanosec;
 
     DISALLOW_DEFAULT_CONSTRUCTOR(CSpoutRunner);
     DISALLOW_COPY_CONSTRUCTOR(CSpoutRunner);
@@ -7,13 +7,15 @@
  */
 
 #include "StreamRunner.h"
-#include "BoltRunner.h"
+#include "BoltGroup.h"
 #include "MsgDefs.h"
 #include "Thread/ArrayDataFrames.h"
 
-CStreamRunner::CStreamRunner(const char* pName, CBoltChain* pChain) :
+CStreamRunner::CStreamRunner(
+    const char* pName, CBoltChain* pChain, size_t index /* = 0 */) :
     CDGNode(),
-    m_pBoltChain(pChain)
+    m_pBoltChain(pChain),
+    m_Index(index)
 {
     ASSERT(pName);
 
@@ -40,44 +42,34 @@ size_t CStreamRunner::ForwardMessage(ArrayDataFrames* pMsg)
     CForwardList::Iterator iter = downStream.Begin();
     --count;
     while (index < count) {
-        CBoltRunner* pBolt = reinterpret_cast<CBoltRunner*>(downStream.DataAt(iter));
-        ArrayDataFrames* pNewMsg =
-            reinterpret_cast<ArrayDataFrames*>(
-                ArrayDataFrames::Duplicate(pMsg, pMsg->Count));
-        if (pNewMsg) {
-            ITMessage msg(STREAM_USER_DATA);
-            msg.SetExtData(
-                pNewMsg,
-                pNewMsg->Count,
-                ArrayDataFrames::DeleteInstance,
-                ArrayDataFrames::Duplicate,
-                true);
-            if (pBolt->PushMessage(&msg)) {
-                ++sentCount;
-            } else {
-                ArrayDataFrames::DeleteInstance(pNewMsg);
-                OUTPUT_WARNING_TRACE("Push Message to bolt failed.\n");
-            }
+        CBoltGroup* pGroup = reinterpret_cast<CBoltGroup*>(downStream.DataAt(iter));
+        // Only the reference is shared, the frames are copied on write.
+        if (pGroup->Dispatch(pMsg->AddRef(), m_Index)) {
+            ++sentCount;
         }
         ++index;
         ++iter;
     }
 
-    // Handle the last bolt.
-    CBoltRunner* pLastBolt =
-        reinterpret_cast<CBoltRunner*>(downStream.DataAt(iter));
-    ITMessage msg(STREAM_USER_DATA);
-    msg.SetExtData(
-        pMsg,
-        pMsg->Count,
-        ArrayDataFrames::DeleteInstance,
-        ArrayDataFrames::Duplicate,
-        true);
-    if (pLastBolt->PushMessage(&msg)) {
+    // Handle the last bolt group.
+    CBoltGroup* pLastGroup = reinterpret_cast<CBoltGroup*>(downStream.DataAt(iter));
+    if (pLastGroup->Dispatch(pMsg, m_Index)) {
         ++sentCount;
-    } else {
-        ArrayDataFrames::DeleteInstance(pMsg);
-        OUTPUT_WARNING_TRACE("Push Message to bolt failed.\n");
     }
     return sentCount;
 }
+
+bool CStreamRunner::WaitForwardCredit(int timeout)
+{
+    CForwardList& downStream(GetForwardNodes());
+    CForwardList::Iterator iter = downStream.Begin();
+    CForwardList::Iterator end = downStream.End();
+    while (iter != end) {
+        CBoltGroup* pGroup = reinterpret_cast<CBoltGroup*>(downStream.DataAt(iter));
+        if (!pGroup->WaitCredit(timeout)) {
+            return false;
+        }
+        ++iter;
+    }
+    return true;
+}
@@ -29,13 +29,19 @@ public:
     virtual bool Stop() = 0;
 
     /**
-     * @brief Forward the message to the downstream node.
+     * @brief Forward the message to the downstream bolt groups.
      * @param pMsg the forwarded message.
      * @return The count of message (downstream) forwarded.
      * @warning The @pMsg will be transferred the ownship to the downstream
      */
     size_t ForwardMessage(ArrayDataFrames* pMsg);
 
+    /**
+     * @brief Wait until the downstream bolt groups have credits.
+     * @return false if timeout.
+     */
+    bool WaitForwardCredit(int timeout);
+
     /**
      * @warning The ownership of @pInData will be transferred to process
      *          as the bolt chain does
@@ -50,11 +56,18 @@ public:
 
     const char* GetName() const { return m_Name; }
 
+    // The index in the parallel instances.
+    size_t GetIndex() const { return m_Index; }
+
+    // Give up the ownership of the bolt chain.
+    void DetachBoltChain() { m_pBoltChain = NULL; }
+
 protected:
-    CStreamRunner(const char* pName, CBoltChain* pChain);
+    CStreamRunner(const char* pName, CBoltChain* pChain, size_t index = 0);
 
 private:
     CBoltChain* m_pBoltChain;   // Owned
+    const size_t m_Index;
     char m_Name[32];
 
     DISALLOW_DEFAULT_CONSTRUCTOR(CStreamRunner);
@@ -8,10 +8,12 @@
 
 #include "Topology.h"
 #include "Bolt.h"
+#include "Spout.h"
 #include "BoltChain.h"
 #include "BoltRunner.h"
 #include "SpoutRunner.h"
 #include "StreamRunner.h"
+#include "Thread/TaskExecutor.h"
 #include "Common/Macros.h"
 #include "Tracker/Trace.h"
 #include <utility>
@@ -20,28 +22,40 @@
 
 using std::pair;
 
-CTopology::CTopology() :
+CTopology::CTopology(
+    RunMode mode /* = RM_THREAD_PER_BOLT */, size_t threadCount /* = 0 */) :
     m_bRunning(false),
+    m_pExecutor(NULL),
     m_CS(),
     m_Cond(),
-    m_BoltRunners(),
-    m_SpoutRunners(),
-    m_AllRunners()
+    m_BoltGroups(),
+    m_SpoutRunners()
 {
+    if (mode == RM_EXECUTOR) {
+        m_pExecutor = CTaskExecutor::CreateInstance("topology", threadCount);
+        if (m_pExecutor == NULL) {
+            OUTPUT_WARNING_TRACE("Create executor failed, run bolts in own threads.\n");
+        }
+    }
 }
 
 CTopology::~CTopology()
 {
     Stop();
+    delete m_pExecutor;
 }
 
 bool CTopology::SetBolt(
     const char* pName,
     tTopologyID id,
     tTopologyID upStreamID,
-    CBoltChain* pBoltChain)
+    CBoltChain* pBoltChain,
+    size_t parallelism /* = 1 */,
+    CBoltGroup::Grouping grouping /* = CBoltGroup::GROUPING_SHUFFLE */,
+    size_t fieldIndex /* = 0 */)
 {
     ASSERT(pBoltChain);
+    ASSERT(parallelism > 0);
 
     CSectionLock lock(m_CS);
     if (m_bRunning) {
@@ -51,41 +65,41 @@ bool CTopology::SetBolt(
     }
 
     // Find if the ID is in use.
-    map<tTopologyID, CStreamRunner*>::iterator findIter = m_AllRunners.find(id);
-    if (findIter != m_AllRunners.end()) {
-        // Found.
+    if (IsRegistered(id)) {
         OUTPUT_ERROR_TRACE("The ID has been existed: %d\n", id);
         return false;
     }
 
     // Find the upstream node.
-    CStreamRunner* pUpStream = NULL;
-    findIter = m_AllRunners.find(upStreamID);
-    if (findIter != m_AllRunners.end()) {
-        pUpStream = findIter->second;
-    }
-    if (pUpStream == NULL) {
+    map<tTopologyID, CBoltGroup*>::iterator boltIter = m_BoltGroups.find(upStreamID);
+    map<tTopologyID, CSpoutRunner*>::iterator spoutIter = m_SpoutRunners.find(upStreamID);
+    if (boltIter == m_BoltGroups.end() && spoutIter == m_SpoutRunners.end()) {
         OUTPUT_ERROR_TRACE("The upstream ID has not been registered: %d\n", upStreamID);
-        return NULL;
+        return false;
     }
 
-    CBoltRunner* pRunner = new CBoltRunner(pName, pBoltChain);
-    if (pRunner == NULL) {
+    CBoltGroup* pGroup = CBoltGroup::CreateInstance(
+        pName, pBoltChain, parallelism, grouping, fieldIndex, m_pExecutor);
+    if (pGroup == NULL) {
         OUTPUT_WARNING_TRACE("Can not create bolt runner object for %d.\n", id);
         return false;
     }
-    if (!pUpStream->AddForwardNode(pRunner)) {
+    bool bRes = false;
+    if (boltIter != m_BoltGroups.end()) {
+        bRes = boltIter->second->AddForwardNode(pGroup);
+    } else {
+        bRes = spoutIter->second->AddForwardNode(pGroup);
+    }
+    if (!bRes) {
         OUTPUT_WARNING_TRACE("Can not follow the upstream object.\n");
-        delete pRunner;
+        pGroup->At(0)->DetachBoltChain();
+        delete pGroup;
         return false;
     }
 
-    pair<map<tTopologyID, CBoltRunner*>::const_iterator, bool> ret = 
-        m_BoltRunners.insert(map<tTopologyID, CBoltRunner*>::value_type(id, pRunner));
+    pair<map<tTopologyID, CBoltGroup*>::const_iterator, bool> ret =
+        m_BoltGroups.insert(map<tTopologyID, CBoltGroup*>::value_type(id, pGroup));
     ASSERT(ret.second);
-    pair<map<tTopologyID, CStreamRunner*>::const_iterator, bool> ret1 = 
-        m_AllRunners.insert(map<tTopologyID, CStreamRunner*>::value_type(id, pRunner));
-    ASSERT(ret1.second);
     return true;
 }
 
@@ -103,9 +117,7 @@ bool CTopology::SetSpout(
     }
 
     // Find if the ID is in use.
-    map<tTopologyID, CStreamRunner*>::iterator findIter = m_AllRunners.find(id);
-    if (findIter != m_AllRunners.end()) {
-        // Found.
+    if (IsRegistered(id)) {
         OUTPUT_ERROR_TRACE("The ID has been existed: %d\n", id);
         return false;
     }
@@ -119,9 +131,6 @@ bool CTopology::SetSpout(
     pair<map<tTopologyID, CSpoutRunner*>::const_iterator, bool> ret = 
         m_SpoutRunners.insert(map<tTopologyID, CSpoutRunner*>::value_type(id, pRunner));
     ASSERT(ret.second);
-    pair<map<tTopologyID, CStreamRunner*>::const_iterator, bool> ret1 = 
-        m_AllRunners.insert(map<tTopologyID, CStreamRunner*>::value_type(id, pRunner));
-    ASSERT(ret1.second);
     return true;
 }
 
@@ -143,6 +152,32 @@ bool CTopology::DeclareBolt(const char* pName, tTopologyID id, tTopologyID upStr
     return bRes;
 }
 
+bool CTopology::DeclareParallelBolt(
+    const char* pName,
+    tTopologyID id,
+    tTopologyID upStreamID,
+    size_t parallelism,
+    CBoltGroup::Grouping grouping,
+    size_t fieldIndex,
+    ...)
+{
+    va_list args;
+    va_start(args, fieldIndex);
+    CBoltChain* pBoltChain = CBoltChain::CreateInstance(args);
+    va_end(args);
+
+    bool bRes = false;
+    if (pBoltChain) {
+        bRes = SetBolt(
+            pName, id, upStreamID, pBoltChain, parallelism, grouping, fieldIndex);
+        if (!bRes) {
+            delete pBoltChain;
+            pBoltChain = NULL;
+        }
+    }
+    return bRes;
+}
+
 bool CTopology::DeclareSpout(const char* pName, tTopologyID id, ISpout& spout, ...)
 {
     va_list args;
@@ -158,7 +193,7 @@ bool CTopology::DeclareSpout(const char* pName, tTopologyID id, ISpout& spout, .
     return bRes;
 }
 
-CBoltRunner* CTopology::GetBoltRunner(tTopologyID id)
+CBoltRunner* CTopology::GetBoltRunner(tTopologyID id, size_t index /* = 0 */)
 {
     CSectionLock lock(m_CS);
     if (!m_bRunning) {
@@ -167,14 +202,18 @@ CBoltRunner* CTopology::GetBoltRunner(tTopologyID id)
     }
 
     // Find if the ID is in bolt runner.
-    map<tTopologyID, CBoltRunner*>::iterator findIter = m_BoltRunners.find(id);
-    if (findIter == m_BoltRunners.end()) {
+    map<tTopologyID, CBoltGroup*>::iterator findIter = m_BoltGroups.find(id);
+    if (findIter == m_BoltGroups.end()) {
         // Not Found.
         m_CS.Unlock();
         OUTPUT_ERROR_TRACE("The ID has not been registered as a Bolt: %d\n", id);
         return NULL;
     }
-    return findIter->second;
+    if (index >= findIter->second->Count()) {
+        OUTPUT_ERROR_TRACE("Bolt %d has %d instance(s) only.\n", id, findIter->second->Count());
+        return NULL;
+    }
+    return findIter->second->At(index);
 }
 
 bool CTopology::Start()
@@ -189,9 +228,14 @@ bool CTopology::Start()
         return false;
     }
 
+    if (m_pExecutor && !m_pExecutor->Start()) {
+        OUTPUT_WARNING_TRACE("Running executor failed.\n");
+        return false;
+    }
+
     bool bRes = true;
-    map<tTopologyID, CBoltRunner*>::iterator boltIter = m_BoltRunners.begin();
-    map<tTopologyID, CBoltRunner*>::iterator boltIterEnd = m_BoltRunners.end();
+    map<tTopologyID, CBoltGroup*>::iterator boltIter = m_BoltGroups.begin();
+    map<tTopologyID, CBoltGroup*>::iterator boltIterEnd = m_BoltGroups.end();
     while (boltIter != boltIterEnd) {
         if (!boltIter->second->Start()) {
             bRes = false;
@@ -244,8 +288,8 @@ bool CTopology::Stop()
         return false;
     }
 
-    map<tTopologyID, CBoltRunner*>::iterator boltIter = m_BoltRunners.begin();
-    map<tTopologyID, CBoltRunner*>::iterator boltIterEnd = m_BoltRunners.end();
+    map<tTopologyID, CBoltGroup*>::iterator boltIter = m_BoltGroups.begin();
+    map<tTopologyID, CBoltGroup*>::iterator boltIterEnd = m_BoltGroups.end();
     while (boltIter != boltIterEnd) {
         if (!boltIter->second->Stop()) {
             bRes = false;
@@ -257,6 +301,9 @@ bool CTopology::Stop()
         OUTPUT_WARNING_TRACE("Stop bolt failed.\n");
         return false;
     }
+    if (m_pExecutor) {
+        m_pExecutor->Stop();
+    }
 
     m_bRunning = false;
     m_Cond.Signal(&m_CS);
@@ -272,6 +319,12 @@ void CTopology::WaitStopped()
     }
 }
 
+bool CTopology::IsRegistered(tTopologyID id)
+{
+    return m_BoltGroups.find(id) != m_BoltGroups.end() ||
+        m_SpoutRunners.find(id) != m_SpoutRunners.end();
+}
+
 bool CTopology::CheckValidity()
 {
     // TODO: impl
@@ -12,6 +12,7 @@
 #include "Common/Typedefs.h"
 #include "Thread/Lock.h"
 #include "Thread/Condition.h"
+#include "BoltGroup.h"
 #include <map>
 
 using std::map;
@@ -32,24 +33,49 @@ typedef int16_t tTopologyID;
         ASSERT(bRes); \
     } while (0)
 
+#define DECLARE_PARALLEL_BOLT(topObj, name, id, upStreamId, parallelism, grouping, field, ...) \
+    do { \
+        bool bRes = topObj->DeclareParallelBolt( \
+            name, id, upStreamId, parallelism, grouping, field, ##__VA_ARGS__, NULL); \
+        ASSERT(bRes); \
+    } while (0)
+
 class IBolt;
 class ISpout;
 class CBoltChain;
 class CSpoutRunner;
 class CBoltRunner;
 class CStreamRunner;
+class CTaskExecutor;
 
 class CTopology
 {
 public:
-    CTopology();
+    enum RunMode {
+        RM_THREAD_PER_BOLT,     // Every bolt runs in its own thread.
+        RM_EXECUTOR             // The bolts run as the tasks of a shared thread pool.
+    };
+
+    /**
+     * @param mode How the bolts are run.
+     * @param threadCount The thread count of the executor, the CPU count if 0.
+     */
+    CTopology(RunMode mode = RM_THREAD_PER_BOLT, size_t threadCount = 0);
     ~CTopology();
 
+    /**
+     * @param parallelism The count of the instances of the bolt.
+     * @param grouping How the upstream messages are distributed to the instances.
+     * @param fieldIndex The frame to hash for CBoltGroup::GROUPING_FIELD.
+     */
     bool SetBolt(
         const char* pName,
         tTopologyID id,
         tTopologyID upStreamID,
-        CBoltChain* pBoltChain);
+        CBoltChain* pBoltChain,
+        size_t parallelism = 1,
+        CBoltGroup::Grouping grouping = CBoltGroup::GROUPING_SHUFFLE,
+        size_t fieldIndex = 0);
     bool SetSpout(
         const char* pName,
         tTopologyID id,
@@ -57,24 +83,33 @@ public:
         CBoltChain* pBoltChain);
 
     bool DeclareBolt(const char* pName, tTopologyID id, tTopologyID upStreamID, ...);
+    bool DeclareParallelBolt(
+        const char* pName,
+        tTopologyID id,
+        tTopologyID upStreamID,
+        size_t parallelism,
+        CBoltGroup::Grouping grouping,
+        size_t fieldIndex,
+        ...);
     bool DeclareSpout(const char* pName, tTopologyID id, ISpout& spout, ...);
 
-    CBoltRunner* GetBoltRunner(tTopologyID id);
+    CBoltRunner* GetBoltRunner(tTopologyID id, size_t index = 0);
 
     bool Start();
     bool Stop();
     void WaitStopped();
 
 private:
+    bool IsRegistered(tTopologyID id);
     bool CheckValidity();
 
 private:
     bool m_bRunning;
+    CTaskExecutor* m_pExecutor;     // Owned
     CCriticalSection m_CS;
     CCondition m_Cond;
-    map<tTopologyID, CBoltRunner*> m_BoltRunners;
+    map<tTopologyID, CBoltGroup*> m_BoltGroups;
     map<tTopologyID, CSpoutRunner*> m_SpoutRunners;
-    map<tTopologyID, CStreamRunner*> m_AllRunners;
 };
 
 #endif
\ No newline at end of file
@@ -20,7 +20,9 @@ using std::strerror;
 CCertManager::CCertManager() :
     m_pRootCA(".certs/RootCA.crt"),
     m_pMyCert(".certs/MyCert.pem"),
-    m_pMyPrivateKey(".certs/MyPrivate.key")
+    m_pMyPrivateKey(".certs/MyPrivate.key"),
+    m_pRootCACert(NULL),
+    m_pMyCertChain(NULL)
 {
     struct stat sb;
 
@@ -47,11 +49,18 @@ CCertManager::CCertManager() :
         return;
     }
     ASSERT((sb.st_mode & S_IFMT) == S_IFREG, "%s is not a regular file.\n", m_pMyPrivateKey);
+
+    m_pRootCACert = GetCertByFileName(m_pRootCA);
+    m_pMyCertChain = GetCertByFileName(m_pMyCert);
+}
+
+CCertManager::~CCertManager()
+{
+    delete m_pMyCertChain;
+    delete m_pRootCACert;
 }
 
-// TODO: impl
 CX509Cert* CCertManager::GetCertByFileName(const char* pCertName)
 {
-    ASSERT(false);
-    return NULL;
+    return CX509Cert::CreateInstance(pCertName);
 }
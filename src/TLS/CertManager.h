@@ -12,6 +12,11 @@
 #include "Common/Singleton.h"
 
 class CX509Cert;
+
+/**
+ * @brief The certificates of the process, parsed once when created and
+ *        shared by the TLS contexts of all the connections.
+ */
 class CCertManager : public CSingleton<CCertManager>
 {
 public:
@@ -19,16 +24,27 @@ public:
     const char* MyCert() const { return m_pMyCert; }
     const char* MyPrivateKey() const { return m_pMyPrivateKey; }
 
+    /**
+     * @return The parsed certificates, NULL if failed to load.
+     */
+    CX509Cert* RootCACert() const { return m_pRootCACert; }
+    CX509Cert* MyCertChain() const { return m_pMyCertChain; }
+
+    /**
+     * @brief Parse the certificate file, owned by the caller.
+     */
     static CX509Cert* GetCertByFileName(const char* pCertName);
 
 protected:
     CCertManager();
-    ~CCertManager() {}
+    ~CCertManager();
 
 private:
     const char* m_pRootCA;
     const char* m_pMyCert;
     const char* m_pMyPrivateKey;
+    CX509Cert* m_pRootCACert;   // Owned
+    CX509Cert* m_pMyCertChain;  // Owned
 
     friend class CSingleton<CCertManager>;
 };
@@ -0,0 +1,278 @@
+/*
+ * See the file LICENSE for redistribution information.
+ *
+ * Copyright (c) 2015-2018, Yuan Qin <yuanqin2000 at outlook dot com>
+ * All rights reserved.
+ *
+ */
+
+#include "SessionCache.h"
+#include "Tracker/Trace.h"
+#include <limits.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef __TLS_SESSION_PERSIST__
+#include "Config/EnvManager.h"
+#endif
+
+using std::FILE;
+using std::fclose;
+using std::fread;
+using std::fwrite;
+using std::malloc;
+using std::free;
+using std::memcpy;
+using std::strerror;
+
+const char* CTLSSessionCache::s_pFileName = "tls_sessions";
+
+CTLSSessionCache::CTLSSessionCache() : m_Entries(), m_CS()
+{
+#ifdef __TLS_SESSION_PERSIST__
+    Load(CEnvManager::Instance()->RootWorkPath(), s_pFileName);
+#endif
+}
+
+CTLSSessionCache::~CTLSSessionCache()
+{
+#ifdef __TLS_SESSION_PERSIST__
+    Save(CEnvManager::Instance()->RootWorkPath(), s_pFileName);
+#endif
+    Clear();
+}
+
+size_t CTLSSessionCache::Get(
+    const sockaddr* pPeer, bool bVerified, uint8_t* pBuf, size_t len)
+{
+    CSectionLock lock(m_CS);
+
+    map<CPointer, Entry*>::iterator iter = m_Entries.find(CPointer(pPeer, sizeof(sockaddr)));
+    if (iter == m_Entries.end()) {
+        return 0;
+    }
+    Entry* pEntry = iter->second;
+    if (pEntry->ExpireTime <= time(NULL)) {
+        m_Entries.erase(iter);
+        free(pEntry);
+        return 0;
+    }
+    if ((bVerified && !pEntry->bVerified) || pEntry->Length > len) {
+        return 0;
+    }
+    memcpy(pBuf, pEntry->Data, pEntry->Length);
+    return pEntry->Length;
+}
+
+bool CTLSSessionCache::Put(
+    const sockaddr* pPeer,
+    bool bVerified,
+    const uint8_t* pData,
+    size_t len,
+    unsigned int lifetime /* = DEFAULT_LIFETIME */)
+{
+    if (len == 0 || len > MAX_SESSION_SIZE || lifetime == 0) {
+        return false;
+    }
+
+    Entry* pEntry = reinterpret_cast<Entry*>(malloc(sizeof(Entry) + len));
+    if (pEntry == NULL) {
+        return false;
+    }
+    memcpy(&pEntry->Peer, pPeer, sizeof(sockaddr));
+    pEntry->ExpireTime = time(NULL) + lifetime;
+    pEntry->Length = len;
+    pEntry->bVerified = bVerified ? 1 : 0;
+    memcpy(pEntry->Data, pData, len);
+
+    CSectionLock lock(m_CS);
+    return DoPut(pEntry);
+}
+
+void CTLSSessionCache::Remove(const sockaddr* pPeer)
+{
+    CSectionLock lock(m_CS);
+
+    map<CPointer, Entry*>::iterator iter = m_Entries.find(CPointer(pPeer, sizeof(sockaddr)));
+    if (iter != m_Entries.end()) {
+        Entry* pEntry = iter->second;
+        m_Entries.erase(iter);
+        free(pEntry);
+    }
+}
+
+void CTLSSessionCache::Clear()
+{
+    CSectionLock lock(m_CS);
+
+    map<CPointer, Entry*>::iterator iter = m_Entries.begin();
+    map<CPointer, Entry*>::iterator iterEnd = m_Entries.end();
+    while (iter != iterEnd) {
+        free(iter->second);
+        ++iter;
+    }
+    m_Entries.clear();
+}
+
+size_t CTLSSessionCache::Count()
+{
+    CSectionLock lock(m_CS);
+    return m_Entries.size();
+}
+
+bool CTLSSessionCache::Load(const char* pPath, const char* pFileName)
+{
+    char fileName[PATH_MAX];
+    snprintf(fileName, sizeof(fileName), "%s/%s", pPath, pFileName);
+    int fd = open(fileName, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        if (errno != ENOENT) {
+            OUTPUT_WARNING_TRACE("open %s: %s\n", fileName, strerror(errno));
+        }
+        return false;
+    }
+
+    // The sessions are secrets, refuse the file others could have read
+    // or written.
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0 ||
+        fileStat.st_uid != geteuid() ||
+        (fileStat.st_mode & (S_IRWXG | S_IRWXO)) != 0) {
+        OUTPUT_WARNING_TRACE("%s is not private to the user, ignored.\n", fileName);
+        close(fd);
+        return false;
+    }
+    FILE* pFile = fdopen(fd, "rb");
+    if (pFile == NULL) {
+        OUTPUT_WARNING_TRACE("fdopen %s: %s\n", fileName, strerror(errno));
+        close(fd);
+        return false;
+    }
+
+    bool bRes = false;
+    uint32_t magic = 0;
+    if (fread(&magic, sizeof(magic), 1, pFile) == 1 && magic == FILE_MAGIC) {
+        CSectionLock lock(m_CS);
+        time_t now = time(NULL);
+        Entry header;
+        while (fread(&header, sizeof(header), 1, pFile) == 1) {
+            if (header.Length == 0 || header.Length > MAX_SESSION_SIZE) {
+                break;
+            }
+            Entry* pEntry = reinterpret_cast<Entry*>(malloc(sizeof(Entry) + header.Length));
+            if (pEntry == NULL) {
+                break;
+            }
+            memcpy(pEntry, &header, sizeof(header));
+            if (fread(pEntry->Data, header.Length, 1, pFile) != 1) {
+                free(pEntry);
+                break;
+            }
+            if (pEntry->ExpireTime <= now) {
+                free(pEntry);
+            } else {
+                DoPut(pEntry);
+            }
+        }
+        bRes = feof(pFile) != 0;
+    }
+    if (!bRes) {
+        OUTPUT_WARNING_TRACE("%s is corrupted.\n", fileName);
+    }
+    fclose(pFile);
+    return bRes;
+}
+
+bool CTLSSessionCache::Save(const char* pPath, const char* pFileName)
+{
+    char fileName[PATH_MAX];
+    char tmpFileName[PATH_MAX + sizeof(".tmp")];
+    snprintf(fileName, sizeof(fileName), "%s/%s", pPath, pFileName);
+    snprintf(tmpFileName, sizeof(tmpFileName), "%s.tmp", fileName);
+
+    // Write to the temporary file and rename it, the saved file is never
+    // left partially written. Only the user can read it, whatever the umask,
+    // so the stale one (which may have other modes) is never reused.
+    unlink(tmpFileName);
+    int fd = open(tmpFileName, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        OUTPUT_WARNING_TRACE("open %s: %s\n", tmpFileName, strerror(errno));
+        return false;
+    }
+    FILE* pFile = fdopen(fd, "wb");
+    if (pFile == NULL) {
+        OUTPUT_WARNING_TRACE("fdopen %s: %s\n", tmpFileName, strerror(errno));
+        close(fd);
+        unlink(tmpFileName);
+        return false;
+    }
+
+    uint32_t magic = FILE_MAGIC;
+    bool bRes = fwrite(&magic, sizeof(magic), 1, pFile) == 1;
+    if (bRes) {
+        CSectionLock lock(m_CS);
+        RemoveExpired(time(NULL));
+        map<CPointer, Entry*>::iterator iter = m_Entries.begin();
+        map<CPointer, Entry*>::iterator iterEnd = m_Entries.end();
+        while (bRes && iter != iterEnd) {
+            Entry* pEntry = iter->second;
+            bRes = fwrite(pEntry, sizeof(Entry) + pEntry->Length, 1, pFile) == 1;
+            ++iter;
+        }
+    }
+    if (fclose(pFile) != 0) {
+        bRes = false;
+    }
+    if (bRes && rename(tmpFileName, fileName) != 0) {
+        OUTPUT_WARNING_TRACE("rename %s: %s\n", tmpFileName, strerror(errno));
+        bRes = false;
+    }
+    if (!bRes) {
+        unlink(tmpFileName);
+    }
+    return bRes;
+}
+
+bool CTLSSessionCache::DoPut(Entry* pEntry)
+{
+    CPointer key(&pEntry->Peer, sizeof(sockaddr));
+    map<CPointer, Entry*>::iterator iter = m_Entries.find(key);
+    if (iter != m_Entries.end()) {
+        // The key points to the old entry, replace both.
+        free(iter->second);
+        m_Entries.erase(iter);
+    } else if (m_Entries.size() >= MAX_ENTRY_COUNT) {
+        RemoveExpired(time(NULL));
+        if (m_Entries.size() >= MAX_ENTRY_COUNT) {
+            // Drop the one expires first.
+            map<CPointer, Entry*>::iterator victim = m_Entries.begin();
+            for (iter = m_Entries.begin(); iter != m_Entries.end(); ++iter) {
+                if (iter->second->ExpireTime < victim->second->ExpireTime) {
+                    victim = iter;
+                }
+            }
+            free(victim->second);
+            m_Entries.erase(victim);
+        }
+    }
+    m_Entries.insert(map<CPointer, Entry*>::value_type(key, pEntry));
+    return true;
+}
+
+void CTLSSessionCache::RemoveExpired(time_t now)
+{
+    map<CPointer, Entry*>::iterator iter = m_Entries.begin();
+    while (iter != m_Entries.end()) {
+        if (iter->second->ExpireTime <= now) {
+            free(iter->second);
+            m_Entries.erase(iter++);
+        } else {
+            ++iter;
+        }
+    }
+}
@@ -0,0 +1,94 @@
+/*
+ * See the file LICENSE for redistribution information.
+ *
+ * Copyright (c) 2015-2018, Yuan Qin <yuanqin2000 at outlook dot com>
+ * All rights reserved.
+ *
+ */
+
+#ifndef __TLS_SESSION_CACHE_H__
+#define __TLS_SESSION_CACHE_H__
+
+#include <map>
+#include <ctime>
+#include <sys/socket.h>
+#include "Common/Typedefs.h"
+#include "Common/Macros.h"
+#include "Common/Pointer.h"
+#include "Common/Singleton.h"
+#include "Thread/Lock.h"
+
+using std::map;
+
+/**
+ * @brief The process-wide cache of the TLS client sessions (session ID or
+ *        ticket), keyed by the peer address, to resume the later handshakes.
+ *
+ * The session is kept as the serialized data of the TLS library, so the
+ * cache itself does not depend on the library. The cache is saved to the
+ * root work path when the process exits if __TLS_SESSION_PERSIST__ is
+ * defined, and loaded when it is created.
+ */
+class CTLSSessionCache : public CSingleton<CTLSSessionCache>
+{
+public:
+    /**
+     * @brief Copy the session of the peer.
+     * @param bVerified Only take the session whose peer certificate was verified.
+     * @return The length of the session, 0 if there is none, it is expired
+     *         or the buffer is too small.
+     */
+    size_t Get(const sockaddr* pPeer, bool bVerified, uint8_t* pBuf, size_t len);
+
+    /**
+     * @brief Add or replace the session of the peer.
+     * @param lifetime Seconds the session can be resumed.
+     */
+    bool Put(
+        const sockaddr* pPeer,
+        bool bVerified,
+        const uint8_t* pData,
+        size_t len,
+        unsigned int lifetime = DEFAULT_LIFETIME);
+
+    void Remove(const sockaddr* pPeer);
+    void Clear();
+    size_t Count();
+
+    bool Load(const char* pPath, const char* pFileName);
+    bool Save(const char* pPath, const char* pFileName);
+
+    static const size_t MAX_SESSION_SIZE = 8 * 1024;
+    static const size_t MAX_ENTRY_COUNT = 1024;
+    static const unsigned int DEFAULT_LIFETIME = 2 * 60 * 60;
+
+protected:
+    CTLSSessionCache();
+    ~CTLSSessionCache();
+
+private:
+    struct Entry {
+        sockaddr Peer;
+        int64_t ExpireTime;
+        uint32_t Length;
+        uint32_t bVerified;
+        uint8_t Data[0];
+    };
+
+    bool DoPut(Entry* pEntry);
+    void RemoveExpired(time_t now);
+
+    static const char* s_pFileName;
+    static const uint32_t FILE_MAGIC = 0x544c5353;    // "TLSS"
+
+private:
+    map<CPointer, Entry*> m_Entries;    // Owned, the key is Entry::Peer
+    CCriticalSection m_CS;
+
+    friend class CSingleton<CTLSSessionCache>;
+
+    DISALLOW_COPY_CONSTRUCTOR(CTLSSessionCache);
+    DISALLOW_ASSIGN_OPERATOR(CTLSSessionCache);
+};
+
+#endif
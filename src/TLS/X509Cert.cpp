@@ -8,6 +8,93 @@
 
 #include "X509Cert.h"
 #include "Tracker/Trace.h"
+#include <errno.h>
+#include <cstdio>
+#include <cstring>
+
+#if defined(__USE_OPEN_SSL__)
+#include "openssl/pem.h"
+#include "openssl/err.h"
+#endif
+
+using std::FILE;
+using std::fopen;
+using std::fclose;
+using std::strerror;
+
+CX509Cert::CX509Cert() :
+    m_Count(0)
+#if defined(__USE_OPEN_SSL__)
+    , m_pChain(NULL)
+#endif
+{
+#if defined(__USE_MBED_TLS__)
+    mbedtls_x509_crt_init(&m_Chain);
+#endif
+}
+
+CX509Cert::~CX509Cert()
+{
+#if defined(__USE_MBED_TLS__)
+    mbedtls_x509_crt_free(&m_Chain);
+#elif defined(__USE_OPEN_SSL__)
+    if (m_pChain) {
+        sk_X509_pop_free(m_pChain, X509_free);
+    }
+#endif
+}
+
+CX509Cert* CX509Cert::CreateInstance(const char* pFileName)
+{
+    CX509Cert* pInstance = new CX509Cert();
+    if (pInstance) {
+        if (!pInstance->Initialize(pFileName)) {
+            delete pInstance;
+            pInstance = NULL;
+        }
+    }
+    return pInstance;
+}
+
+bool CX509Cert::Initialize(const char* pFileName)
+{
+#if defined(__USE_MBED_TLS__)
+    int res = mbedtls_x509_crt_parse_file(&m_Chain, pFileName);
+    if (res < 0) {
+        OUTPUT_WARNING_TRACE("mbedtls_x509_crt_parse_file %s failed -0x%x\n", pFileName, -res);
+        return false;
+    }
+    for (const mbedtls_x509_crt* pCrt = &m_Chain; pCrt && pCrt->raw.p; pCrt = pCrt->next) {
+        ++m_Count;
+    }
+#elif defined(__USE_OPEN_SSL__)
+    FILE* pFile = fopen(pFileName, "r");
+    if (pFile == NULL) {
+        OUTPUT_WARNING_TRACE("fopen %s: %s\n", pFileName, strerror(errno));
+        return false;
+    }
+    m_pChain = sk_X509_new_null();
+    if (m_pChain) {
+        X509* pCert = NULL;
+        while ((pCert = PEM_read_X509(pFile, NULL, NULL, NULL)) != NULL) {
+            if (!sk_X509_push(m_pChain, pCert)) {
+                X509_free(pCert);
+                break;
+            }
+        }
+        // The end of the file is reported as an error.
+        ERR_clear_error();
+        m_Count = sk_X509_num(m_pChain);
+    }
+    fclose(pFile);
+#endif
+
+    if (m_Count == 0) {
+        OUTPUT_WARNING_TRACE("No certificate in %s\n", pFileName);
+        return false;
+    }
+    return true;
+}
 
 const char* CX509Cert::CertStatusPhrase(CertStatus status)
 {
@@ -19,4 +106,4 @@ const char* CX509Cert::CertStatusPhrase(CertStatus status)
 
     ASSERT(status >= 0 && status < CERT_STATUS_COUNT);
     return s_Phrase[status];
-}
\ No newline at end of file
+}
@@ -9,6 +9,21 @@
 #ifndef __TLS_X509_CERT_H__
 #define __TLS_X509_CERT_H__
 
+#include "Common/Typedefs.h"
+#include "Common/Macros.h"
+
+#if defined(__USE_MBED_TLS__)
+#include "mbedtls/x509_crt.h"
+#elif defined(__USE_OPEN_SSL__)
+#include "openssl/x509.h"
+#endif
+
+/**
+ * @brief The parsed X509 certificate chain of one PEM file.
+ *
+ * The chain is parsed once and referenced by the TLS context of the SSL
+ * library, it is not modified after created.
+ */
 class CX509Cert
 {
 public:
@@ -19,7 +34,33 @@ public:
         CERT_STATUS_COUNT
     };
 
+    ~CX509Cert();
+
+    size_t Count() const { return m_Count; }
+
+#if defined(__USE_MBED_TLS__)
+    mbedtls_x509_crt* GetData() { return &m_Chain; }
+#elif defined(__USE_OPEN_SSL__)
+    STACK_OF(X509)* GetData() { return m_pChain; }
+#endif
+
+    static CX509Cert* CreateInstance(const char* pFileName);
     static const char* CertStatusPhrase(CertStatus status);
+
+private:
+    CX509Cert();
+    bool Initialize(const char* pFileName);
+
+private:
+    size_t m_Count;
+#if defined(__USE_MBED_TLS__)
+    mbedtls_x509_crt m_Chain;
+#elif defined(__USE_OPEN_SSL__)
+    STACK_OF(X509)* m_pChain;
+#endif
+
+    DISALLOW_COPY_CONSTRUCTOR(CX509Cert);
+    DISALLOW_ASSIGN_OPERATOR(CX509Cert);
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -21,6 +21,7 @@ ArrayDataFrames* ArrayDataFrames::CreateInstance(size_t count)
     ArrayDataFrames* pInstance = reinterpret_cast<ArrayDataFrames*>(malloc(size));
     if (pInstance) {
         memset(pInstance, 0, size);
+        pInstance->RefCount = 1;
         pInstance->Count = count;
     }
     return pInstance;
@@ -31,6 +32,10 @@ void ArrayDataFrames::DeleteInstance(void* pData)
     ASSERT(pData);
 
     ArrayDataFrames* pFrames = reinterpret_cast<ArrayDataFrames*>(pData);
+    ASSERT(pFrames->RefCount > 0);
+    if (AtomicDec(&pFrames->RefCount) > 0) {
+        return;
+    }
     for (size_t i = 0; i < pFrames->Count; ++i) {
         DataFrame* pDataFrame = &pFrames->Frames[i];
         pDataFrame->CleanData();
@@ -63,9 +68,36 @@ void* ArrayDataFrames::Duplicate(void* pData, size_t len)
     return pDupFrames;
 }
 
+void* ArrayDataFrames::Share(void* pData, size_t len)
+{
+    ArrayDataFrames* pFrames = reinterpret_cast<ArrayDataFrames*>(pData);
+    if (len < pFrames->Count) {
+        return Duplicate(pData, len);
+    }
+    return pFrames->AddRef();
+}
+
+ArrayDataFrames* ArrayDataFrames::MakeWritable(ArrayDataFrames* pFrames)
+{
+    ASSERT(pFrames);
+
+    if (!pFrames->IsShared()) {
+        return pFrames;
+    }
+    ArrayDataFrames* pCopy = reinterpret_cast<ArrayDataFrames*>(
+        Duplicate(pFrames, pFrames->Count));
+    if (pCopy == NULL) {
+        OUTPUT_WARNING_TRACE("Copy %d shared frames failed.\n", pFrames->Count);
+        return NULL;
+    }
+    DeleteInstance(pFrames);
+    return pCopy;
+}
+
 bool ArrayDataFrames::SetFrame(size_t idx, DataFrame* pDesc, bool bDeepCopy /* = true */)
 {
     ASSERT(idx < Count);
+    ASSERT(!IsShared());
 
     DataFrame* pFrame = &Frames[idx];
     bool bRes = true;
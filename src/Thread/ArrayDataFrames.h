@@ -10,20 +10,39 @@
 #define __STREAM_DATA_FRAME_H__
 
 #include "Common/Typedefs.h"
+#include "Common/Arch.h"
 #include "Thread/DataFrame.h"
 #include "Tracker/Trace.h"
 
+/**
+ * @brief The frames are reference counted so the fan-out only shares them.
+ *        The shared frames are immutable, call MakeWritable before mutation
+ *        to get a private copy (copy on write).
+ */
 struct ArrayDataFrames
 {
+    volatile int32_t RefCount;
     uint16_t Count;
     DataFrame Frames[0];
 
     void ShrinkCount(size_t cnt)
     {
         ASSERT(cnt <= Count);
+        ASSERT(!IsShared());
         Count = cnt;
     }
 
+    bool IsShared() const
+    {
+        return RefCount > 1;
+    }
+
+    ArrayDataFrames* AddRef()
+    {
+        AtomicInc(&RefCount);
+        return this;
+    }
+
     bool IsValid()
     {
         for (size_t i = 0; i < Count; ++i) {
@@ -43,8 +62,30 @@ struct ArrayDataFrames
     bool SetFrame(size_t idx, DataFrame* pDesc, bool bDeepCopy = true);
 
     static ArrayDataFrames* CreateInstance(size_t count);
+
+    /**
+     * @brief Release one reference, the frames are freed with the last one.
+     */
     static void DeleteInstance(void* pData);
+
+    /**
+     * @brief Deep copy the first @len frames.
+     */
     static void* Duplicate(void* pData, size_t len);
+
+    /**
+     * @brief Share the frames if all of them are requested, copy otherwise.
+     *        It is the cloner of the message carrying the frames.
+     */
+    static void* Share(void* pData, size_t len);
+
+    /**
+     * @brief Get the frames which can be modified by the caller.
+     * @return @pFrames itself if it is not shared, otherwise a private copy
+     *         and the reference of @pFrames is released. NULL if the copy
+     *         failed while @pFrames is untouched.
+     */
+    static ArrayDataFrames* MakeWritable(ArrayDataFrames* pFrames);
 };
 
 #endif
@@ -18,6 +18,7 @@ using std::strerror;
 
 CCondition::CCondition() :
     m_bSignaled(false),
+    m_BroadcastSeq(0),
     m_CS()
 {
     pthread_condattr_t attr;
@@ -35,11 +36,13 @@ bool CCondition::Wait(CCriticalSection* pLockedCS, int millisec /* = -1 */)
         m_CS.Lock();
     }
     int res = 0;
+    unsigned int seq = m_BroadcastSeq;
+    (void) seq;
     if (!m_bSignaled) {
         if (millisec < 0) {
             // This will cause the mutex is unloked while the lock depth keep same.
             res = pthread_cond_wait(&m_CondVar, pCS->GetMutex());
-            ASSERT(m_bSignaled);
+            ASSERT(m_bSignaled || seq != m_BroadcastSeq);
         } else if (millisec > 0) {
             struct timespec absTime;
             CTimerManager::GetAbsoluteTime(millisec, &absTime);
@@ -79,6 +82,25 @@ bool CCondition::Signal(CCriticalSection* pLockedCS)
     return res == 0;
 }
 
+bool CCondition::Broadcast(CCriticalSection* pLockedCS)
+{
+    if (pLockedCS == NULL) {
+        m_CS.Lock();
+    }
+
+    ++m_BroadcastSeq;
+    int res = pthread_cond_broadcast(&m_CondVar);
+    if (res != 0) {
+        OUTPUT_WARNING_TRACE("pthread_cond_broadcast: %s\n", strerror(res));
+    }
+
+    if (pLockedCS == NULL) {
+       m_CS.Unlock();
+    }
+
+    return res == 0;
+}
+
 void CCondition::Reset(CCriticalSection* pLockedCS)
 {
     if (pLockedCS == NULL) {
@@ -40,10 +40,20 @@ public:
      */
     bool Signal(CCriticalSection* pLockedCS);
 
+    /**
+     * @brief Wake all the threads waiting on this condition variable.
+     *        Unlike Signal(), nothing is kept for the later Wait().
+     * @param pLockedCS The locked critical section, no locked critical section if null.
+     * @return true if success, otherwise false.
+     * @warning The locked critical section must be same as the one used in Wait()
+     */
+    bool Broadcast(CCriticalSection* pLockedCS);
+
     void Reset(CCriticalSection* pLockedCS);
 
 private:
     bool m_bSignaled;
+    unsigned int m_BroadcastSeq;
     CCriticalSection m_CS;
     pthread_cond_t m_CondVar;
 };
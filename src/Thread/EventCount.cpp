@@ -0,0 +1,49 @@
+/*
+ * See the file LICENSE for redistribution information.
+ *
+ * Copyright (c) 2015-2018, Yuan Qin <yuanqin2000 at outlook dot com>
+ * All rights reserved.
+ *
+ */
+
+#include "EventCount.h"
+#include <unistd.h>
+#include <time.h>
+#include <errno.h>
+#include <climits>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include "Tracker/Trace.h"
+
+static inline long Futex(
+    volatile uint32_t* pAddr, int op, uint32_t value, const struct timespec* pTimeout)
+{
+    return syscall(SYS_futex, pAddr, op, value, pTimeout, NULL, 0);
+}
+
+bool CEventCount::Wait(uint32_t key, int millisec /* = -1 */)
+{
+    bool bRes = true;
+    struct timespec timeout;
+    struct timespec* pTimeout = NULL;
+    if (millisec >= 0) {
+        timeout.tv_sec = millisec / 1000;
+        timeout.tv_nsec = (millisec % 1000) * 1000000L;
+        pTimeout = &timeout;
+    }
+
+    // Returned immediately if notified after PrepareWait (m_Epoch != key).
+    if (m_Epoch == key) {
+        long res = Futex(&m_Epoch, FUTEX_WAIT_PRIVATE, key, pTimeout);
+        if (res != 0 && errno == ETIMEDOUT) {
+            bRes = false;
+        }
+    }
+    AtomicDec(&m_Waiters);
+    return bRes;
+}
+
+void CEventCount::Wake(bool bAll)
+{
+    Futex(&m_Epoch, FUTEX_WAKE_PRIVATE, bAll ? INT_MAX : 1, NULL);
+}
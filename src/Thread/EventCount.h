@@ -0,0 +1,73 @@
+/*
+ * See the file LICENSE for redistribution information.
+ *
+ * Copyright (c) 2015-2018, Yuan Qin <yuanqin2000 at outlook dot com>
+ * All rights reserved.
+ *
+ */
+
+#ifndef __THREAD_EVENT_COUNT_H__
+#define __THREAD_EVENT_COUNT_H__
+
+#include "Common/Typedefs.h"
+#include "Common/Arch.h"
+#include "Common/Macros.h"
+
+/**
+ * @brief Event count based on futex, to block the thread of a lock-free
+ *        structure until the state it waits for may have changed.
+ *
+ * The waiter:
+ *     key = PrepareWait();
+ *     if (condition is true) { CancelWait(); } else { Wait(key, timeout); }
+ * The notifier:
+ *     make the condition true; Notify();
+ * Notify is only a memory barrier if there is no waiter.
+ */
+class CEventCount
+{
+public:
+    CEventCount() : m_Epoch(0), m_Waiters(0) {}
+    ~CEventCount() {}
+
+    uint32_t PrepareWait()
+    {
+        uint32_t key = m_Epoch;
+        AtomicInc(&m_Waiters);  // Full barrier
+        return key;
+    }
+
+    void CancelWait()
+    {
+        AtomicDec(&m_Waiters);
+    }
+
+    /**
+     * @brief Wait until notified or timeout.
+     * @param key The value returned by PrepareWait
+     * @param millisec milli-seconds to wait, infinit wait if less than 0.
+     * @return false if timeout.
+     */
+    bool Wait(uint32_t key, int millisec = -1);
+
+    void Notify(bool bAll = false)
+    {
+        __sync_synchronize();
+        if (m_Waiters > 0) {
+            AtomicInc(reinterpret_cast<volatile int32_t*>(&m_Epoch));
+            Wake(bAll);
+        }
+    }
+
+private:
+    void Wake(bool bAll);
+
+private:
+    volatile uint32_t m_Epoch;
+    volatile int32_t m_Waiters;
+
+    DISALLOW_COPY_CONSTRUCTOR(CEventCount);
+    DISALLOW_ASSIGN_OPERATOR(CEventCount);
+};
+
+#endif
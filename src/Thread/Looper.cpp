@@ -11,6 +11,28 @@
 #include "Condition.h"
 #include "Tracker/Trace.h"
 
+void IRunner::HandleMessages(ITMessage* pMsgs, size_t count)
+{
+    for (size_t i = 0; i < count; ++i) {
+        HandleMessage(&pMsgs[i]);
+    }
+}
+
+size_t CMsgSwitch::ReadMessages(
+    ITMessage* pOutMsgs, size_t count, int timeout /* = -1 */)
+{
+    ASSERT(count > 0);
+
+    if (!ReadMessage(pOutMsgs, timeout)) {
+        return 0;
+    }
+    size_t index = 1;
+    while (index < count && ReadMessage(&pOutMsgs[index], 0)) {
+        ++index;
+    }
+    return index;
+}
+
 bool CMsgSwitch::WriteMessageSync(ITMessage* pMsg)
 {
     if (pMsg->SetSync(true) && WriteMessage(pMsg)) {
@@ -20,11 +42,12 @@ bool CMsgSwitch::WriteMessageSync(ITMessage* pMsg)
     return false;
 }
 
-CLooper::CLooper(IRunner& runnerObj, CMsgSwitch& switchObj) :
+CLooper::CLooper(IRunner& runnerObj, CMsgSwitch& switchObj, size_t batchSize) :
     m_pThread(NULL),
     m_Runner(runnerObj),
     m_Switch(switchObj),
     m_TimerManager(),
+    m_BatchSize(batchSize),
     m_bExit(false)
 {
 }
@@ -35,9 +58,14 @@ CLooper::~CLooper()
 }
 
 CLooper* CLooper::CreateInstance(
-    const char* pName, IRunner& runnerObj, CMsgSwitch& switchObj)
+    const char* pName,
+    IRunner& runnerObj,
+    CMsgSwitch& switchObj,
+    size_t batchSize /* = 1 */)
 {
-    CLooper* pInstance = new CLooper(runnerObj, switchObj);
+    ASSERT(batchSize > 0 && batchSize <= MAX_BATCH_SIZE);
+
+    CLooper* pInstance = new CLooper(runnerObj, switchObj, batchSize);
     if (pInstance) {
         pInstance->m_pThread = CThread::CreateInstance(
             pName, Run, pInstance, CThread::PRIORITY_NORMAL);
@@ -135,18 +163,57 @@ void CLooper::HandleMessage(ITMessage* pMsg)
     }
 }
 
+void CLooper::HandleMessages(ITMessage* pMsgs, size_t count)
+{
+    // Pass the continuous user messages to the runner together,
+    // the control messages are handled in place to keep the order.
+    // The messages after the exit are dropped as the single mode does.
+    size_t begin = 0;
+    for (size_t i = 0; i < count && !m_bExit; ++i) {
+        if (pMsgs[i].MsgID < USER_MSGID_BEGIN) {
+            if (i > begin) {
+                m_Runner.HandleMessages(&pMsgs[begin], i - begin);
+            }
+            HandleMessage(&pMsgs[i]);
+            begin = i + 1;
+        }
+    }
+    if (!m_bExit && begin < count) {
+        m_Runner.HandleMessages(&pMsgs[begin], count - begin);
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        pMsgs[i].SignalSourceIfNeeded();
+        pMsgs[i].Destroy();
+    }
+}
+
 void* CLooper::Run(void* pArg)
 {
     ASSERT(pArg);
 
     int timeout = -1;
     CLooper* pInstance = reinterpret_cast<CLooper*>(pArg);
+    if (pInstance->m_BatchSize == 1) {
+        while (!pInstance->m_bExit) {
+            ITMessage msg;
+            if (pInstance->m_Switch.ReadMessage(&msg, timeout)) {
+                pInstance->HandleMessage(&msg);
+                msg.SignalSourceIfNeeded();
+                msg.Destroy();
+            }
+            timeout = pInstance->HandleTimeEvent();
+        }
+        return NULL;
+    }
+
+    // Drain mode: handle a batch of messages before refreshing the timers.
+    ITMessage msgs[MAX_BATCH_SIZE];
     while (!pInstance->m_bExit) {
-        ITMessage msg;
-        if (pInstance->m_Switch.ReadMessage(&msg, timeout)) {
-            pInstance->HandleMessage(&msg);
-            msg.SignalSourceIfNeeded();
-            msg.Destroy();
+        size_t count = pInstance->m_Switch.ReadMessages(
+            msgs, pInstance->m_BatchSize, timeout);
+        if (count > 0) {
+            pInstance->HandleMessages(msgs, count);
         }
         timeout = pInstance->HandleTimeEvent();
     }
@@ -27,6 +27,14 @@ public:
      * @warning This function is response to release the parameter message.
      */
     virtual void HandleMessage(ITMessage* pMsg) = 0;
+
+    /**
+     * @brief Handle the batch of messages, in the order of the array.
+     * @param pMsgs The array of the messages.
+     * @param count The count of the messages.
+     * @warning This function is response to release the parameter messages.
+     */
+    virtual void HandleMessages(ITMessage* pMsgs, size_t count);
 };
 
 class CLooper;
@@ -43,6 +51,15 @@ public:
      */
     virtual bool ReadMessage(ITMessage* pOutMsg, int timeout = -1) = 0;
 
+    /**
+     * @brief Consume at most count messages in one call.
+     * @param pOutMsgs Message array for fill the result.
+     * @param count The size of the array.
+     * @param timeout specify the time to wait for the first message.
+     * @return The count of the messages got.
+     */
+    virtual size_t ReadMessages(ITMessage* pOutMsgs, size_t count, int timeout = -1);
+
     /**
      * @brief Produce the message to message pool.
      * @param pMsg specify the message to write.
@@ -59,6 +76,8 @@ public:
         m_pContext = pContext;
     }
 
+    CLooper* GetContext() const { return m_pContext; }
+
 protected:
     CMsgSwitch() : m_pContext(NULL) {}
 
@@ -85,13 +104,28 @@ public:
         return CThread::GetCurrentThread() == m_pThread;
     }
 
+    bool SetAffinity(int cpu)
+    {
+        return m_pThread->SetAffinity(cpu);
+    }
+
+    /**
+     * @param batchSize The max count of the messages drained from the switch
+     *        before refreshing the timers, no more than MAX_BATCH_SIZE.
+     */
     static CLooper* CreateInstance(
-        const char* pName, IRunner& runnerObj, CMsgSwitch& switchObj);
+        const char* pName,
+        IRunner& runnerObj,
+        CMsgSwitch& switchObj,
+        size_t batchSize = 1);
+
+    static const size_t MAX_BATCH_SIZE = 64;
 
 private:
-    CLooper(IRunner& runnerObj, CMsgSwitch& switchObj);
+    CLooper(IRunner& runnerObj, CMsgSwitch& switchObj, size_t batchSize);
 
     void HandleMessage(ITMessage* pMsg);
+    void HandleMessages(ITMessage* pMsgs, size_t count);
     int HandleTimeEvent()
     {
         return m_TimerManager.RefreshTimer();
@@ -122,6 +156,7 @@ private:
     CMsgSwitch& m_Switch;
     const char* m_pName;    // Not owned
     CTimerManager m_TimerManager;
+    const size_t m_BatchSize;
     bool m_bExit;
 
     DISALLOW_DEFAULT_CONSTRUCTOR(CLooper);
@@ -20,7 +20,8 @@ CQueueMsgSwitch::CQueueMsgSwitch(size_t msgBufSize /* = 0 */) :
     m_ReadCond(),
     m_MemoryPool(CForwardList::ListNodeSize(sizeof(ITMessage))),
     m_MsgQueue(sizeof(ITMessage), &m_MemoryPool),
-    m_MaxCount(msgBufSize)
+    m_MaxCount(msgBufSize),
+    m_WaitingWriters(0)
 {
     if (msgBufSize == 0) {
         m_MaxCount = static_cast<size_t>(-1);
@@ -43,23 +44,49 @@ bool CQueueMsgSwitch::ReadMessage(ITMessage* pOutMsg, int timeout /* = -1 */)
         }
     }
 
-    // Consumed the full queue, to notify the blocking producer.
-    bool bNotify = (m_MsgQueue.Count() == m_MaxCount);
     memcpy(pOutMsg, m_MsgQueue.First(), sizeof(ITMessage));
     m_MsgQueue.PopFront();
-    if (bNotify) {
-        m_WriteCond.Signal(&m_MsgCS);
+
+    // The slot is freed, wake the blocking producers.
+    if (m_WaitingWriters > 0) {
+        m_WriteCond.Broadcast(&m_MsgCS);
     }
     m_MsgCS.Unlock();
     return true;
 }
 
+size_t CQueueMsgSwitch::ReadMessages(
+    ITMessage* pOutMsgs, size_t count, int timeout /* = -1 */)
+{
+    ASSERT(count > 0);
+
+    m_MsgCS.Lock();
+    if (m_MsgQueue.Count() == 0) {
+        m_ReadCond.Wait(&m_MsgCS, timeout);
+    }
+
+    size_t index = 0;
+    while (index < count && m_MsgQueue.Count() > 0) {
+        memcpy(&pOutMsgs[index], m_MsgQueue.First(), sizeof(ITMessage));
+        m_MsgQueue.PopFront();
+        ++index;
+    }
+
+    // The slots are freed, wake all the blocking producers to refill them.
+    if (index > 0 && m_WaitingWriters > 0) {
+        m_WriteCond.Broadcast(&m_MsgCS);
+    }
+    m_MsgCS.Unlock();
+    return index;
+}
+
 bool CQueueMsgSwitch::WriteMessage(ITMessage* pMsg)
 {
     m_MsgCS.Lock();
-    if (m_MsgQueue.Count() == m_MaxCount) {
+    while (m_MsgQueue.Count() == m_MaxCount) {
+        ++m_WaitingWriters;
         m_WriteCond.Wait(&m_MsgCS);
-        ASSERT(m_MsgQueue.Count() < m_MaxCount);
+        --m_WaitingWriters;
     }
     bool bNotify = (m_MsgQueue.Count() == 0);
     m_MsgQueue.PushBack(pMsg);
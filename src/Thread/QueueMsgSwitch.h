@@ -25,6 +25,7 @@ public:
     virtual ~CQueueMsgSwitch();
 
     bool ReadMessage(ITMessage* pOutMsg, int timeout = -1);
+    size_t ReadMessages(ITMessage* pOutMsgs, size_t count, int timeout = -1);
 
     /**
      * @warning The ownership of the message payload will be transferred
@@ -38,6 +39,7 @@ private:
     CMemoryPool m_MemoryPool;
     CForwardList m_MsgQueue;
     size_t m_MaxCount;
+    size_t m_WaitingWriters;
 
     DISALLOW_COPY_CONSTRUCTOR(CQueueMsgSwitch);
     DISALLOW_ASSIGN_OPERATOR(CQueueMsgSwitch);
@@ -0,0 +1,222 @@
+/*
+ * See the file LICENSE for redistribution information.
+ *
+ * Copyright (c) 2015-2018, Yuan Qin <yuanqin2000 at outlook dot com>
+ * All rights reserved.
+ *
+ */
+
+#include "RingMsgSwitch.h"
+#include <cstdlib>
+#include <cstring>
+#include "Tracker/Time.h"
+#include "Tracker/Trace.h"
+
+using std::memcpy;
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// CRingMsgSwitch Implemenation
+//
+///////////////////////////////////////////////////////////////////////////////
+CRingMsgSwitch::CRingMsgSwitch(size_t capacity, size_t slotSize) :
+    CMsgSwitch(),
+    m_Mask(RoundUpCapacity(capacity) - 1),
+    m_pBuffer(NULL),
+    m_NotEmpty(),
+    m_NotFull(),
+    m_bClosed(0)
+{
+    m_pBuffer = reinterpret_cast<uint8_t*>(calloc(m_Mask + 1, slotSize));
+    if (m_pBuffer == NULL) {
+        OUTPUT_ERROR_TRACE("Allocate %lu message slots failed.\n", m_Mask + 1);
+    }
+}
+
+CRingMsgSwitch::~CRingMsgSwitch()
+{
+    free(m_pBuffer);
+}
+
+size_t CRingMsgSwitch::ReadMessages(
+    ITMessage* pOutMsgs, size_t count, int timeout /* = -1 */)
+{
+    ASSERT(count > 0);
+
+    if (m_pBuffer == NULL) {
+        return 0;
+    }
+
+    bool bGot = false;
+    for (int i = 0; i < SPIN_COUNT && !bGot; ++i) {
+        bGot = TryRead(pOutMsgs);
+    }
+
+    int64_t deadline = timeout > 0 ? GetMonotonicMillisec() + timeout : 0;
+    int remain = timeout;
+    while (!bGot) {
+        uint32_t key = m_NotEmpty.PrepareWait();
+        if (TryRead(pOutMsgs)) {
+            m_NotEmpty.CancelWait();
+            break;
+        }
+        if (timeout > 0) {
+            remain = static_cast<int>(deadline - GetMonotonicMillisec());
+        }
+        if (m_bClosed || timeout == 0 || (timeout > 0 && remain <= 0)) {
+            m_NotEmpty.CancelWait();
+            return 0;
+        }
+        m_NotEmpty.Wait(key, remain);
+    }
+
+    // Drain the ready messages without blocking, wake the writers once.
+    size_t index = 1;
+    while (index < count && TryRead(&pOutMsgs[index])) {
+        ++index;
+    }
+    m_NotFull.Notify(index > 1);
+    return index;
+}
+
+bool CRingMsgSwitch::WriteMessage(ITMessage* pMsg)
+{
+    if (m_pBuffer == NULL || m_bClosed) {
+        return false;
+    }
+
+    for (int i = 0; i < SPIN_COUNT; ++i) {
+        if (TryWrite(pMsg)) {
+            m_NotEmpty.Notify();
+            return true;
+        }
+    }
+
+    while (true) {
+        uint32_t key = m_NotFull.PrepareWait();
+        if (TryWrite(pMsg)) {
+            m_NotFull.CancelWait();
+            m_NotEmpty.Notify();
+            return true;
+        }
+        if (m_bClosed) {
+            m_NotFull.CancelWait();
+            return false;
+        }
+        m_NotFull.Wait(key);
+    }
+}
+
+void CRingMsgSwitch::Close()
+{
+    if (AtomicCAS(&m_bClosed, 0, 1)) {
+        m_NotFull.Notify(true);
+        m_NotEmpty.Notify(true);
+    }
+}
+
+size_t CRingMsgSwitch::RoundUpCapacity(size_t capacity)
+{
+    if (capacity < 2) {
+        return 2;
+    }
+    return static_cast<size_t>(1) <<
+        ((sizeof(unsigned long) << 3) - __builtin_clzl(capacity - 1));
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// CSPSCRingMsgSwitch Implemenation
+//
+///////////////////////////////////////////////////////////////////////////////
+CSPSCRingMsgSwitch::CSPSCRingMsgSwitch(size_t capacity /* = DEFAULT_CAPACITY */) :
+    CRingMsgSwitch(capacity, sizeof(ITMessage)),
+    m_Head(0),
+    m_CachedTail(0),
+    m_Tail(0),
+    m_CachedHead(0)
+{
+}
+
+bool CSPSCRingMsgSwitch::TryRead(ITMessage* pOutMsg)
+{
+    size_t head = m_Head;
+    if (head == m_CachedTail) {
+        m_CachedTail = AtomicLoadAcquire(&m_Tail);
+        if (head == m_CachedTail) {
+            return false;
+        }
+    }
+    memcpy(pOutMsg, SlotAt(head), sizeof(ITMessage));
+    AtomicStoreRelease(&m_Head, head + 1);
+    return true;
+}
+
+bool CSPSCRingMsgSwitch::TryWrite(ITMessage* pMsg)
+{
+    size_t tail = m_Tail;
+    if (tail - m_CachedHead > m_Mask) {
+        m_CachedHead = AtomicLoadAcquire(&m_Head);
+        if (tail - m_CachedHead > m_Mask) {
+            return false;
+        }
+    }
+    memcpy(SlotAt(tail), pMsg, sizeof(ITMessage));
+    AtomicStoreRelease(&m_Tail, tail + 1);
+    return true;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// CMPSCRingMsgSwitch Implemenation
+//
+///////////////////////////////////////////////////////////////////////////////
+CMPSCRingMsgSwitch::CMPSCRingMsgSwitch(size_t capacity /* = DEFAULT_CAPACITY */) :
+    CRingMsgSwitch(capacity, sizeof(Slot)),
+    m_pSlots(reinterpret_cast<Slot*>(m_pBuffer)),
+    m_Head(0),
+    m_Tail(0)
+{
+    if (m_pSlots) {
+        for (size_t i = 0; i <= m_Mask; ++i) {
+            m_pSlots[i].Sequence = i;
+        }
+    }
+}
+
+bool CMPSCRingMsgSwitch::TryRead(ITMessage* pOutMsg)
+{
+    size_t head = m_Head;
+    Slot* pSlot = &m_pSlots[head & m_Mask];
+    if (AtomicLoadAcquire(&pSlot->Sequence) != head + 1) {
+        return false;   // Empty, or the producer has not finished the copy.
+    }
+    memcpy(pOutMsg, pSlot->Message, sizeof(ITMessage));
+    AtomicStoreRelease(&pSlot->Sequence, head + m_Mask + 1);
+    m_Head = head + 1;
+    return true;
+}
+
+bool CMPSCRingMsgSwitch::TryWrite(ITMessage* pMsg)
+{
+    size_t tail = m_Tail;
+    while (true) {
+        Slot* pSlot = &m_pSlots[tail & m_Mask];
+        size_t sequence = AtomicLoadAcquire(&pSlot->Sequence);
+        intptr_t diff = static_cast<intptr_t>(sequence - tail);
+        if (diff == 0) {
+            if (AtomicCASSize(&m_Tail, tail, tail + 1)) {
+                memcpy(pSlot->Message, pMsg, sizeof(ITMessage));
+                AtomicStoreRelease(&pSlot->Sequence, tail + 1);
+                return true;
+            }
+            tail = m_Tail;
+        } else if (diff < 0) {
+            return false;   // Full
+        } else {
+            tail = m_Tail;  // Claimed by other producer
+        }
+    }
+}
@@ -0,0 +1,183 @@
+/*
+ * See the file LICENSE for redistribution information.
+ *
+ * Copyright (c) 2015-2018, Yuan Qin <yuanqin2000 at outlook dot com>
+ * All rights reserved.
+ *
+ */
+
+#ifndef __THREAD_RING_MSG_SWITCH_H__
+#define __THREAD_RING_MSG_SWITCH_H__
+
+#include "Common/Typedefs.h"
+#include "Common/Arch.h"
+#include "Common/Macros.h"
+#include "ITMessage.h"
+#include "Looper.h"
+#include "EventCount.h"
+
+/**
+ * @brief Message switch based on the bounded lock-free ring buffer.
+ *        The message is copied into the ring, the reader and the writer
+ *        only sleep (on futex) when the ring is empty or full.
+ */
+class CRingMsgSwitch : public CMsgSwitch
+{
+public:
+    virtual ~CRingMsgSwitch();
+
+    // From CMsgSwitch
+    bool ReadMessage(ITMessage* pOutMsg, int timeout = -1)
+    {
+        return ReadMessages(pOutMsg, 1, timeout) > 0;
+    }
+    size_t ReadMessages(ITMessage* pOutMsgs, size_t count, int timeout = -1);
+
+    /**
+     * @return false if the switch is closed, even blocked on the full ring.
+     * @warning The ownership of the message payload will be transferred
+     */
+    bool WriteMessage(ITMessage* pMsg);
+
+    /**
+     * @brief Write the message without blocking.
+     * @return false if the ring is full or the switch is closed.
+     */
+    bool TryWriteMessage(ITMessage* pMsg)
+    {
+        if (m_pBuffer && !m_bClosed && TryWrite(pMsg)) {
+            m_NotEmpty.Notify();
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief Check if there is message to read, only for the reader.
+     */
+    virtual bool IsEmpty() = 0;
+
+    /**
+     * @brief Fail the writes and wake the blocked ones, once the reader
+     *        is stopped. The blocked reader gets nothing as well.
+     */
+    void Close();
+    void Open() { m_bClosed = 0; }
+    bool IsClosed() const { return m_bClosed != 0; }
+
+    size_t Capacity() const { return m_Mask + 1; }
+
+    static const size_t DEFAULT_CAPACITY = 1024;
+
+protected:
+    /**
+     * @param capacity The count of the slots, rounded up to power of 2.
+     * @param slotSize The size of each slot.
+     */
+    CRingMsgSwitch(size_t capacity, size_t slotSize);
+
+    virtual bool TryRead(ITMessage* pOutMsg) = 0;
+    virtual bool TryWrite(ITMessage* pMsg) = 0;
+
+    static size_t RoundUpCapacity(size_t capacity);
+
+    static const int SPIN_COUNT = 64;
+
+protected:
+    const size_t m_Mask;
+    uint8_t* m_pBuffer;     // Owned, the slots.
+    CEventCount m_NotEmpty;
+    CEventCount m_NotFull;
+    volatile int32_t m_bClosed;
+
+    DISALLOW_COPY_CONSTRUCTOR(CRingMsgSwitch);
+    DISALLOW_ASSIGN_OPERATOR(CRingMsgSwitch);
+    DISALLOW_DEFAULT_CONSTRUCTOR(CRingMsgSwitch);
+};
+
+
+/**
+ * @brief Single producer single consumer ring.
+ * @warning Only ONE thread can write the switch, including the control
+ *          messages of the looper (e.g. CLooper::Exit, CLooper::StartTimer)
+ *          which shall be issued from the producer thread as well.
+ */
+class CSPSCRingMsgSwitch : public CRingMsgSwitch
+{
+public:
+    CSPSCRingMsgSwitch(size_t capacity = DEFAULT_CAPACITY);
+    ~CSPSCRingMsgSwitch() {}
+
+    // From CRingMsgSwitch
+    bool IsEmpty()
+    {
+        return m_Head == AtomicLoadAcquire(&m_Tail);
+    }
+
+private:
+    // From CRingMsgSwitch
+    bool TryRead(ITMessage* pOutMsg);
+    bool TryWrite(ITMessage* pMsg);
+
+    ITMessage* SlotAt(size_t index)
+    {
+        return reinterpret_cast<ITMessage*>(m_pBuffer) + (index & m_Mask);
+    }
+
+private:
+    // The consumer and producer indices are kept in separate cache lines.
+    uint8_t m_Pad0[__OS_CACHE_LINE_SIZE__];
+    volatile size_t m_Head;
+    size_t m_CachedTail;    // Consumer's view of m_Tail
+    uint8_t m_Pad1[__OS_CACHE_LINE_SIZE__];
+    volatile size_t m_Tail;
+    size_t m_CachedHead;    // Producer's view of m_Head
+    uint8_t m_Pad2[__OS_CACHE_LINE_SIZE__];
+
+    DISALLOW_COPY_CONSTRUCTOR(CSPSCRingMsgSwitch);
+    DISALLOW_ASSIGN_OPERATOR(CSPSCRingMsgSwitch);
+};
+
+
+/**
+ * @brief Multiple producers single consumer ring, for the fan-in.
+ *        Every slot has a sequence number, the producers claim the slots
+ *        by CAS the tail index.
+ */
+class CMPSCRingMsgSwitch : public CRingMsgSwitch
+{
+public:
+    CMPSCRingMsgSwitch(size_t capacity = DEFAULT_CAPACITY);
+    ~CMPSCRingMsgSwitch() {}
+
+    // From CRingMsgSwitch
+    // The slot claimed by the producer but not written yet is not empty.
+    bool IsEmpty()
+    {
+        return m_pSlots == NULL || m_Head == AtomicLoadAcquire(&m_Tail);
+    }
+
+private:
+    // From CRingMsgSwitch
+    bool TryRead(ITMessage* pOutMsg);
+    bool TryWrite(ITMessage* pMsg);
+
+    struct Slot {
+        volatile size_t Sequence;
+        uint8_t Message[sizeof(ITMessage)];
+    };
+
+private:
+    Slot* m_pSlots;         // Not owned, point to m_pBuffer
+
+    uint8_t m_Pad0[__OS_CACHE_LINE_SIZE__];
+    volatile size_t m_Head;
+    uint8_t m_Pad1[__OS_CACHE_LINE_SIZE__];
+    volatile size_t m_Tail;
+    uint8_t m_Pad2[__OS_CACHE_LINE_SIZE__];
+
+    DISALLOW_COPY_CONSTRUCTOR(CMPSCRingMsgSwitch);
+    DISALLOW_ASSIGN_OPERATOR(CMPSCRingMsgSwitch);
+};
+
+#endif
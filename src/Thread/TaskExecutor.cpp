@@ -0,0 +1,191 @@
+/*
+ * See the file LICENSE for redistribution information.
+ *
+ * Copyright (c) 2015-2018, Yuan Qin <yuanqin2000 at outlook dot com>
+ * All rights reserved.
+ *
+ */
+
+#include "TaskExecutor.h"
+#include <unistd.h>
+#include <cstdio>
+#include "Thread.h"
+#include "Tracker/Trace.h"
+
+CLocalStorage CTaskExecutor::s_CurrentWorker;
+
+CTaskExecutor::CTaskExecutor(const char* pName, Worker* pWorkers, size_t count) :
+    m_pName(pName),
+    m_pWorkers(pWorkers),
+    m_WorkerCount(count),
+    m_Pending(0),
+    m_NextWorker(0),
+    m_bExit(false),
+    m_Event()
+{
+    for (size_t i = 0; i < count; ++i) {
+        m_pWorkers[i].pExecutor = this;
+        m_pWorkers[i].pThread = NULL;
+        m_pWorkers[i].Index = i;
+        snprintf(m_pWorkers[i].Name, sizeof(m_pWorkers[i].Name), "%s-%lu", pName, i);
+    }
+}
+
+CTaskExecutor::~CTaskExecutor()
+{
+    Stop();
+    delete [] m_pWorkers;
+}
+
+CTaskExecutor* CTaskExecutor::CreateInstance(
+    const char* pName, size_t threadCount /* = 0 */)
+{
+    ASSERT(pName);
+
+    if (threadCount == 0) {
+        long cpuCount = sysconf(_SC_NPROCESSORS_ONLN);
+        threadCount = cpuCount > 0 ? cpuCount : 1;
+    }
+
+    CTaskExecutor* pInstance = NULL;
+    Worker* pWorkers = new Worker[threadCount];
+    if (pWorkers) {
+        pInstance = new CTaskExecutor(pName, pWorkers, threadCount);
+        if (pInstance == NULL) {
+            delete [] pWorkers;
+        }
+    }
+    return pInstance;
+}
+
+bool CTaskExecutor::Start()
+{
+    m_bExit = false;
+    for (size_t i = 0; i < m_WorkerCount; ++i) {
+        Worker* pWorker = &m_pWorkers[i];
+        if (pWorker->pThread) {
+            continue;
+        }
+        pWorker->pThread = CThread::CreateInstance(
+            pWorker->Name, Running, pWorker, CThread::PRIORITY_NORMAL);
+        if (pWorker->pThread == NULL) {
+            OUTPUT_WARNING_TRACE("Create worker %s failed.\n", pWorker->Name);
+            Stop();
+            return false;
+        }
+    }
+    return true;
+}
+
+void CTaskExecutor::Stop()
+{
+    m_bExit = true;
+    m_Event.Notify(true);
+    for (size_t i = 0; i < m_WorkerCount; ++i) {
+        // Wait for the worker exited.
+        delete m_pWorkers[i].pThread;
+        m_pWorkers[i].pThread = NULL;
+    }
+}
+
+void CTaskExecutor::Submit(ITask* pTask, bool bYield /* = false */)
+{
+    ASSERT(pTask);
+
+    Worker* pWorker = CurrentWorker();
+    if (pWorker == NULL) {
+        size_t index = static_cast<uint32_t>(AtomicInc(&m_NextWorker)) % m_WorkerCount;
+        pWorker = &m_pWorkers[index];
+        bYield = false;
+    }
+    pWorker->CS.Lock();
+    if (bYield) {
+        // Popped last by the worker, stolen first by the others.
+        pWorker->Tasks.push_front(pTask);
+    } else {
+        pWorker->Tasks.push_back(pTask);
+    }
+    pWorker->CS.Unlock();
+    AtomicInc(&m_Pending);
+    m_Event.Notify();
+}
+
+bool CTaskExecutor::RunPendingTask()
+{
+    Worker* pWorker = CurrentWorker();
+    if (pWorker == NULL) {
+        return false;
+    }
+
+    ITask* pTask = PopTask(pWorker);
+    if (pTask == NULL) {
+        pTask = StealTask(pWorker);
+        if (pTask == NULL) {
+            return false;
+        }
+    }
+    AtomicDec(&m_Pending);
+    pTask->Run();
+    return true;
+}
+
+CTaskExecutor::Worker* CTaskExecutor::CurrentWorker()
+{
+    Worker* pWorker = reinterpret_cast<Worker*>(s_CurrentWorker.GetStorageData());
+    if (pWorker && pWorker->pExecutor == this) {
+        return pWorker;
+    }
+    return NULL;
+}
+
+ITask* CTaskExecutor::PopTask(Worker* pWorker)
+{
+    ITask* pTask = NULL;
+    pWorker->CS.Lock();
+    if (!pWorker->Tasks.empty()) {
+        pTask = pWorker->Tasks.back();
+        pWorker->Tasks.pop_back();
+    }
+    pWorker->CS.Unlock();
+    return pTask;
+}
+
+ITask* CTaskExecutor::StealTask(Worker* pWorker)
+{
+    for (size_t i = 1; i < m_WorkerCount; ++i) {
+        Worker* pVictim = &m_pWorkers[(pWorker->Index + i) % m_WorkerCount];
+        ITask* pTask = NULL;
+        pVictim->CS.Lock();
+        if (!pVictim->Tasks.empty()) {
+            pTask = pVictim->Tasks.front();
+            pVictim->Tasks.pop_front();
+        }
+        pVictim->CS.Unlock();
+        if (pTask) {
+            return pTask;
+        }
+    }
+    return NULL;
+}
+
+void* CTaskExecutor::Running(void* pArg)
+{
+    Worker* pWorker = reinterpret_cast<Worker*>(pArg);
+    CTaskExecutor* pThis = pWorker->pExecutor;
+    s_CurrentWorker.SetStorageData(pWorker);
+    // Drain the pending tasks on exit, the task may have been scheduled
+    // only once (e.g. the bolt runner) and shall not be lost on restart.
+    while (!pThis->m_bExit || pThis->m_Pending > 0) {
+        if (pThis->RunPendingTask()) {
+            continue;
+        }
+        uint32_t key = pThis->m_Event.PrepareWait();
+        if (pThis->m_Pending > 0 || pThis->m_bExit) {
+            pThis->m_Event.CancelWait();
+            continue;
+        }
+        pThis->m_Event.Wait(key);
+    }
+    s_CurrentWorker.SetStorageData(NULL);
+    return NULL;
+}
@@ -0,0 +1,103 @@
+/*
+ * See the file LICENSE for redistribution information.
+ *
+ * Copyright (c) 2015-2018, Yuan Qin <yuanqin2000 at outlook dot com>
+ * All rights reserved.
+ *
+ */
+
+#ifndef __THREAD_TASK_EXECUTOR_H__
+#define __THREAD_TASK_EXECUTOR_H__
+
+#include <deque>
+#include "Common/Typedefs.h"
+#include "Common/Macros.h"
+#include "Lock.h"
+#include "LocalStorage.h"
+#include "EventCount.h"
+
+using std::deque;
+
+class CThread;
+
+class ITask
+{
+public:
+    virtual ~ITask() {}
+
+    virtual void Run() = 0;
+};
+
+/**
+ * @brief Fixed size thread pool with work stealing.
+ *
+ * Every worker owns a task deque, the tasks submitted by a worker are
+ * pushed to its own deque and popped LIFO for cache locality, the others
+ * are distributed round robin. The idle worker steals the oldest task
+ * from the other workers before sleeping.
+ *
+ * The executor does not serialize the tasks, the task object shall not
+ * be submitted again before it starts running if it is not reentrant.
+ * The task running on the worker shall never block on the other tasks,
+ * it submits itself again (bYield) to wait instead.
+ *
+ * Stop runs all the pending tasks before the workers exit.
+ */
+class CTaskExecutor
+{
+public:
+    ~CTaskExecutor();
+
+    /**
+     * @param threadCount The count of the workers, the online CPU count if 0.
+     */
+    static CTaskExecutor* CreateInstance(const char* pName, size_t threadCount = 0);
+
+    bool Start();
+    void Stop();
+
+    /**
+     * @param bYield Run the other pending tasks of the calling worker first.
+     */
+    void Submit(ITask* pTask, bool bYield = false);
+
+    bool InWorker() { return CurrentWorker() != NULL; }
+
+    size_t ThreadCount() const { return m_WorkerCount; }
+
+private:
+    struct Worker {
+        CTaskExecutor* pExecutor;
+        CThread* pThread;       // Owned
+        size_t Index;
+        CCriticalSection CS;
+        deque<ITask*> Tasks;
+        char Name[32];
+    };
+
+    CTaskExecutor(const char* pName, Worker* pWorkers, size_t count);
+
+    Worker* CurrentWorker();
+    bool RunPendingTask();
+    ITask* PopTask(Worker* pWorker);
+    ITask* StealTask(Worker* pWorker);
+
+    static void* Running(void* pArg);
+
+private:
+    const char* m_pName;        // Not owned
+    Worker* m_pWorkers;         // Owned
+    const size_t m_WorkerCount;
+    volatile int32_t m_Pending;
+    volatile int32_t m_NextWorker;
+    volatile bool m_bExit;
+    CEventCount m_Event;
+
+    static CLocalStorage s_CurrentWorker;
+
+    DISALLOW_COPY_CONSTRUCTOR(CTaskExecutor);
+    DISALLOW_ASSIGN_OPERATOR(CTaskExecutor);
+    DISALLOW_DEFAULT_CONSTRUCTOR(CTaskExecutor);
+};
+
+#endif
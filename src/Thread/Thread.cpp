@@ -153,6 +153,21 @@ bool CThread::Cancel()
     return bRes;
 }
 
+bool CThread::SetAffinity(int cpu)
+{
+    ASSERT(cpu >= 0 && cpu < CPU_SETSIZE);
+
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    CPU_SET(cpu, &cpuSet);
+    int res = pthread_setaffinity_np(m_ID, sizeof(cpuSet), &cpuSet);
+    if (res != 0) {
+        OUTPUT_WARNING_TRACE("pthread_setaffinity_np: %s\n", strerror(res));
+        return false;
+    }
+    return true;
+}
+
 CThread* CThread::CreateInstance(
     const char* pName,
     tThreadRoutine routine,
@@ -73,6 +73,11 @@ public:
     }
 
     bool Cancel();
+
+    /**
+     * @brief Run the thread on the specified CPU only.
+     */
+    bool SetAffinity(int cpu);
     void CheckCancel()
     {
         pthread_testcancel();
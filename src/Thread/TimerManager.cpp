@@ -9,10 +9,17 @@
 #include "TimerManager.h"
 #include "Tracker/Trace.h"
 
-CTimerManager::CTimerManager() :
-    m_TimersData(8, sizeof(TimerItem)),
-    m_pRunningTimers(NULL)
+CTimerManager::CTimerManager(
+    unsigned int tickMillisec /* = DEFAULT_TICK_MILLISEC */) :
+    m_TimersData(64, sizeof(TimerItem)),
+    m_CurrentTick(0),
+    m_Count(0),
+    m_TickMillisec(tickMillisec > 0 ? tickMillisec : 1)
 {
+    for (size_t i = 0; i < COUNT_OF_ARRAY(m_Slots); ++i) {
+        m_Slots[i] = NIL;
+    }
+    m_CurrentTick = GetCurrentMillisec() / m_TickMillisec;
 }
 
 CTimerManager::~CTimerManager()
@@ -33,11 +40,16 @@ tTimerID CTimerManager::AddTimer(
     CTable::tIndex index = 0;
     TimerItem* pNode = reinterpret_cast<TimerItem*>(m_TimersData.Allocate(&index));
     if (pNode) {
-        pNode->ID = static_cast<tTimerID>(index);
-        pNode->Timeout = millisec;
+        uint64_t now = GetCurrentMillisec();
+        if (m_Count == 0) {
+            // Nothing to fire in the elapsed ticks.
+            m_CurrentTick = now / m_TickMillisec;
+        }
+        pNode->Expire = ExpireTick(now, millisec);
         pNode->Interval = bRepeat ? millisec : 0;
         pNode->pHandle = pContext;
-        InsertTimer(pNode);
+        Schedule(index, pNode);
+        ++m_Count;
         timerID = static_cast<tTimerID>(index);
     }
     if (bNotify) {
@@ -50,112 +62,170 @@ void CTimerManager::DeleteTimer(tTimerID timerID, bool bNotify /* = false */)
 {
     ASSERT(timerID != INVALID_TIMER_ID);
 
-    TimerItem* pNode = reinterpret_cast<TimerItem*>(
-        m_TimersData.At(static_cast<CTable::tIndex>(timerID)));
-    if (pNode == NULL) {
+    uint32_t index = static_cast<uint32_t>(timerID);
+    TimerItem* pNode = ItemAt(index);
+    if (pNode == NULL || pNode->Slot == SLOT_CANCELED) {
         ASSERT(false);
         return;
     }
 
-    if (pNode->pPrev) {
-        pNode->pPrev->pNext = pNode->pNext;
+    ITimerContext* pHandle = pNode->pHandle;
+    if (pNode->Slot == SLOT_FIRING) {
+        // Deleted in its own callback, released after the callback returns.
+        pNode->Slot = SLOT_CANCELED;
     } else {
-        m_pRunningTimers = pNode->pNext;
+        Unlink(pNode);
+        m_TimersData.Release(index);
+        --m_Count;
     }
-    if (pNode->pNext) {
-        pNode->pNext->pPrev = pNode->pPrev;
-    }
-    pNode->pHandle->OnTimerDeleted(timerID);
-    m_TimersData.Release(static_cast<CTable::tIndex>(timerID));
+    pHandle->OnTimerDeleted(timerID);
 }
 
 int CTimerManager::RefreshTimer()
 {
-    int nextTimeout = -1;
-    struct timespec now;
-    clock_gettime(CLOCK_MONOTONIC, &now);
-    uint64_t millisec = Convert2Millisec(&now);
+    if (m_Count == 0) {
+        return -1;
+    }
 
-    TimerItem* pCur = m_pRunningTimers;
-    TimerItem* pRepeatHead = NULL;
-    TimerItem* pRepeatTail = NULL;
-    while (pCur) {
-        if (millisec < pCur->Timeout) {
-            break;
-        }
-        // Timeout
-        TimerItem* pTmp = pCur;
-        pTmp->pHandle->OnTimeout(pTmp->ID);
-        pCur = pCur->pNext;
-        pCur->pPrev = NULL;
-        clock_gettime(CLOCK_MONOTONIC, &now);
-        millisec = Convert2Millisec(&now);
-        if (pTmp->Interval == 0) {
-            m_TimersData.Release(static_cast<CTable::tIndex>(pTmp->ID));
-        } else {
-            pTmp->Timeout = millisec + pTmp->Interval;
-            pTmp->pPrev = NULL;
-            pTmp->pNext = NULL;
-            if (pRepeatHead) {
-                ASSERT(pRepeatTail);
-                pRepeatTail->pNext = pTmp;
-                pTmp->pPrev = pRepeatTail;
-            } else {
-                ASSERT(!pRepeatTail);
-                pRepeatHead = pTmp;
-                pRepeatTail = pTmp;
-            }
+    uint64_t now = GetCurrentMillisec();
+    uint64_t nowTick = now / m_TickMillisec;
+    while (m_CurrentTick <= nowTick && m_Count > 0) {
+        size_t index = m_CurrentTick & SLOT_MASK;
+        for (size_t level = 1; index == 0 && level < LEVEL_COUNT; ++level) {
+            Cascade(level);
+            index = (m_CurrentTick >> (LEVEL_BITS * level)) & SLOT_MASK;
         }
+        uint32_t slot = m_CurrentTick & SLOT_MASK;
+        ++m_CurrentTick;
+        Expire(slot, now);
     }
-    m_pRunningTimers = pCur;
-    if (pRepeatTail) {
-        ASSERT(pRepeatTail->Timeout <= m_pRunningTimers->Timeout);
-        m_pRunningTimers->pPrev = pRepeatTail;
-        pRepeatTail->pNext = m_pRunningTimers;
-        m_pRunningTimers = pRepeatHead;
+    if (m_CurrentTick <= nowTick) {
+        m_CurrentTick = nowTick + 1;
     }
-    if (m_pRunningTimers) {
-        nextTimeout = m_pRunningTimers->Timeout - millisec;
+    return NextTimeout(now);
+}
+
+void CTimerManager::Schedule(uint32_t index, TimerItem* pItem)
+{
+    uint64_t expire = pItem->Expire;
+    if (expire < m_CurrentTick) {
+        expire = m_CurrentTick;
     }
-    return nextTimeout;
+
+    uint64_t delta = expire - m_CurrentTick;
+    size_t level = 0;
+    while (level < LEVEL_COUNT - 1 && delta >= (1ULL << (LEVEL_BITS * (level + 1)))) {
+        ++level;
+    }
+    uint64_t maxDelta = (1ULL << (LEVEL_BITS * LEVEL_COUNT)) - 1;
+    if (delta > maxDelta) {
+        expire = m_CurrentTick + maxDelta;
+        pItem->Expire = expire;
+    }
+    uint32_t slot = (expire >> (LEVEL_BITS * level)) & SLOT_MASK;
+    Link(level * SLOT_COUNT + slot, index, pItem);
 }
 
-void CTimerManager::InsertTimer(TimerItem* pTimer)
+void CTimerManager::Link(uint32_t slot, uint32_t index, TimerItem* pItem)
 {
-    ASSERT(pTimer);
+    pItem->Slot = slot;
+    pItem->Prev = NIL;
+    pItem->Next = m_Slots[slot];
+    if (pItem->Next != NIL) {
+        ItemAt(pItem->Next)->Prev = index;
+    }
+    m_Slots[slot] = index;
+}
 
-    struct timespec now;
-    clock_gettime(CLOCK_MONOTONIC, &now);
-    pTimer->Timeout += Convert2Millisec(&now);
-    TimerItem* pPrev = NULL;
-    TimerItem* pCur = m_pRunningTimers;
-    while (pCur) {
-        if (pTimer->Timeout < pCur->Timeout) {
-            pTimer->pNext = pCur;
-            pTimer->pPrev = pCur->pPrev;
-            if (pCur->pPrev) {
-                pCur->pPrev->pNext = pTimer;
-                pCur->pPrev = pTimer;
-            } else {
-                m_pRunningTimers = pTimer;
-            }
-            break;
-        }
-        pPrev = pCur;
-        pCur = pCur->pNext;
-    }
-    if (!pCur) {
-        // Not inserted.
-        pTimer->pPrev = pPrev;
-        pTimer->pNext = NULL;
-        if (pPrev) {
-            pPrev->pNext = pTimer;
+void CTimerManager::Unlink(TimerItem* pItem)
+{
+    ASSERT(pItem->Slot <= SLOT_EXPIRED);
+
+    if (pItem->Prev != NIL) {
+        ItemAt(pItem->Prev)->Next = pItem->Next;
+    } else {
+        m_Slots[pItem->Slot] = pItem->Next;
+    }
+    if (pItem->Next != NIL) {
+        ItemAt(pItem->Next)->Prev = pItem->Prev;
+    }
+    pItem->Next = NIL;
+    pItem->Prev = NIL;
+}
+
+void CTimerManager::Cascade(size_t level)
+{
+    uint32_t slot = level * SLOT_COUNT +
+        ((m_CurrentTick >> (LEVEL_BITS * level)) & SLOT_MASK);
+    uint32_t index = m_Slots[slot];
+    m_Slots[slot] = NIL;
+    while (index != NIL) {
+        TimerItem* pItem = ItemAt(index);
+        uint32_t next = pItem->Next;
+        Schedule(index, pItem);
+        index = next;
+    }
+}
+
+void CTimerManager::Expire(uint32_t slot, uint64_t nowMillisec)
+{
+    // Move the slot to the expired list, as the callbacks may add the timer
+    // into the same slot or delete the timers in this batch.
+    uint32_t index = m_Slots[slot];
+    m_Slots[slot] = NIL;
+    m_Slots[SLOT_EXPIRED] = index;
+    while (index != NIL) {
+        TimerItem* pItem = ItemAt(index);
+        pItem->Slot = SLOT_EXPIRED;
+        index = pItem->Next;
+    }
+
+    while (m_Slots[SLOT_EXPIRED] != NIL) {
+        index = m_Slots[SLOT_EXPIRED];
+        TimerItem* pItem = ItemAt(index);
+        Unlink(pItem);
+        pItem->Slot = SLOT_FIRING;
+        pItem->pHandle->OnTimeout(static_cast<tTimerID>(index));
+
+        // The table may be reallocated in the callback.
+        pItem = ItemAt(index);
+        if (pItem->Slot == SLOT_CANCELED || pItem->Interval == 0) {
+            m_TimersData.Release(index);
+            --m_Count;
         } else {
-            m_pRunningTimers = pTimer;
+            pItem->Expire = ExpireTick(nowMillisec, pItem->Interval);
+            Schedule(index, pItem);
         }
     }
 }
 
+int CTimerManager::NextTimeout(uint64_t nowMillisec)
+{
+    if (m_Count == 0) {
+        return -1;
+    }
+
+    // Find the next non-empty slot of level 0 till the wheel wraps,
+    // the higher levels are checked when they are cascaded.
+    uint64_t tick = m_CurrentTick;
+    do {
+        if (m_Slots[tick & SLOT_MASK] != NIL) {
+            break;
+        }
+        ++tick;
+    } while ((tick & SLOT_MASK) != 0);
+
+    uint64_t wakeup = tick * m_TickMillisec;
+    return wakeup > nowMillisec ? static_cast<int>(wakeup - nowMillisec) : 0;
+}
+
+uint64_t CTimerManager::GetCurrentMillisec()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<uint64_t>(now.tv_sec) * 1000 + now.tv_nsec / 1000000;
+}
+
 void CTimerManager::Accumulate(struct timespec* pRef, unsigned int millisec)
 {
     ASSERT(pRef);
@@ -23,10 +23,22 @@ public:
     virtual void OnTimerDeleted(tTimerID timerID) {}
 };
 
+/**
+ * @brief Hierarchical timing wheel.
+ *
+ * The timers are hashed into 4 levels of 256 slots by their expire tick,
+ * the level 0 slots are fired tick by tick, and the slots of the higher
+ * levels are cascaded to the lower level when the lower wheel wraps.
+ * Adding and deleting the timer are O(1).
+ *
+ * The timeout is rounded up to the tick, so the timers expired in the
+ * same tick are fired in one batch, never earlier than requested and
+ * at most one tick later.
+ */
 class CTimerManager
 {
 public:
-    CTimerManager();
+    CTimerManager(unsigned int tickMillisec = DEFAULT_TICK_MILLISEC);
     ~CTimerManager();
 
 public:
@@ -37,8 +49,15 @@ public:
         uint16_t sessionID = 0,
         bool bNotify = false);
     void DeleteTimer(tTimerID timerID, bool bNotify = false);
+
+    /**
+     * @brief Fire the expired timers.
+     * @return The milliseconds to call it again, -1 if no timer.
+     */
     int RefreshTimer();
 
+    size_t Count() const { return m_Count; }
+
     static void Accumulate(struct timespec* pRef, unsigned int millisec);
 
     static void GetAbsoluteTime(unsigned int millisecLater, struct timespec* pOut)
@@ -54,21 +73,55 @@ public:
         return pRef->tv_sec * 1000 + pRef->tv_nsec / 1000000LL;
     }
 
+    static const unsigned int DEFAULT_TICK_MILLISEC = 4;
+
 private:
     struct TimerItem {
-        tTimerID ID;
-        uint64_t Timeout;  // Milliseconds, happen time.
-        unsigned int Interval;
+        uint64_t Expire;    // Tick to fire.
+        unsigned int Interval;  // Milliseconds, 0 if not repeated.
         ITimerContext* pHandle;
-        TimerItem* pNext;
-        TimerItem* pPrev;
+        uint32_t Next;      // Index of the timer in the same slot.
+        uint32_t Prev;
+        uint32_t Slot;
     };
 
-    void InsertTimer(TimerItem* pTimer);
+    uint64_t ExpireTick(uint64_t nowMillisec, unsigned int millisec) const
+    {
+        return (nowMillisec + millisec + m_TickMillisec - 1) / m_TickMillisec;
+    }
+
+    TimerItem* ItemAt(uint32_t index)
+    {
+        return reinterpret_cast<TimerItem*>(m_TimersData.At(index));
+    }
+
+    void Schedule(uint32_t index, TimerItem* pItem);
+    void Link(uint32_t slot, uint32_t index, TimerItem* pItem);
+    void Unlink(TimerItem* pItem);
+    void Cascade(size_t level);
+    void Expire(uint32_t slot, uint64_t nowMillisec);
+    int NextTimeout(uint64_t nowMillisec);
+
+    static uint64_t GetCurrentMillisec();
+
+    static const uint32_t NIL = static_cast<uint32_t>(-1);
+    static const size_t LEVEL_BITS = 8;
+    static const size_t LEVEL_COUNT = 4;
+    static const size_t SLOT_COUNT = 1 << LEVEL_BITS;
+    static const size_t SLOT_MASK = SLOT_COUNT - 1;
+    static const uint32_t SLOT_EXPIRED = LEVEL_COUNT * SLOT_COUNT;
+    static const uint32_t SLOT_FIRING = SLOT_EXPIRED + 1;
+    static const uint32_t SLOT_CANCELED = SLOT_EXPIRED + 2;
 
 private:
     CTable m_TimersData;
-    TimerItem* m_pRunningTimers;
+    uint32_t m_Slots[LEVEL_COUNT * SLOT_COUNT + 1];  // The last one is the expired list.
+    uint64_t m_CurrentTick;     // The next tick to be processed.
+    size_t m_Count;
+    const unsigned int m_TickMillisec;
+
+    DISALLOW_COPY_CONSTRUCTOR(CTimerManager);
+    DISALLOW_ASSIGN_OPERATOR(CTimerManager);
 };
 
 #endif
\ No newline at end of file
@@ -9,8 +9,21 @@
 #ifndef __TRACKER_TIME_H__
 #define __TRACKER_TIME_H__
 #include <time.h>
+#include <stdint.h>
 
 struct timespec* GetProcessStartTime();
 void GetProcessElapseTime(struct timespec* pNow);
 
+inline int64_t GetMonotonicNanosec()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<int64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+}
+
+inline int64_t GetMonotonicMillisec()
+{
+    return GetMonotonicNanosec() / 1000000;
+}
+
 #endif
\ No newline at end of file
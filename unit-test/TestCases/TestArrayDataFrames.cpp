@@ -0,0 +1,77 @@
+/*
+ * See the file LICENSE for redistribution information.
+ *
+ * Copyright (c) 2015-2018, Yuan Qin <yuanqin2000 at outlook dot com>
+ * All rights reserved.
+ *
+ */
+
+#include "Thread/ArrayDataFrames.h"
+#include "Common/Macros.h"
+#include "Defines.h"
+#include "CppUTest/MemoryLeakDetectorNewMacros.h"
+#include "CppUTest/TestHarness.h"
+
+TEST_GROUP(ArrayDataFrames)
+{
+    ArrayDataFrames* m_pFrames;
+
+void setup()
+{
+    char data[] = "The payload is stored on heap.";
+    m_pFrames = ArrayDataFrames::CreateInstance(2);
+    CHECK(m_pFrames);
+
+    DataFrame frame(1);
+    CHECK(frame.SetData(data, sizeof(data)));
+    CHECK(m_pFrames->SetFrame(0, &frame));
+    CHECK(frame.SetData(data, 2));
+    CHECK(m_pFrames->SetFrame(1, &frame));
+    frame.CleanData();
+}
+
+void teardown()
+{
+}
+
+};
+
+TEST(ArrayDataFrames, TestShare)
+{
+    CHECK(!m_pFrames->IsShared());
+    ArrayDataFrames* pShared = reinterpret_cast<ArrayDataFrames*>(
+        ArrayDataFrames::Share(m_pFrames, m_pFrames->Count));
+    POINTERS_EQUAL(m_pFrames, pShared);
+    CHECK(m_pFrames->IsShared());
+
+    // Partial frames are copied.
+    ArrayDataFrames* pPart = reinterpret_cast<ArrayDataFrames*>(
+        ArrayDataFrames::Share(m_pFrames, 1));
+    CHECK(pPart != m_pFrames);
+    LONGS_EQUAL(1, pPart->Count);
+    ArrayDataFrames::DeleteInstance(pPart);
+
+    ArrayDataFrames::DeleteInstance(pShared);
+    CHECK(!m_pFrames->IsShared());
+    ArrayDataFrames::DeleteInstance(m_pFrames);
+}
+
+TEST(ArrayDataFrames, TestMakeWritable)
+{
+    POINTERS_EQUAL(m_pFrames, ArrayDataFrames::MakeWritable(m_pFrames));
+
+    ArrayDataFrames* pShared = m_pFrames->AddRef();
+    ArrayDataFrames* pWritable = ArrayDataFrames::MakeWritable(pShared);
+    CHECK(pWritable != m_pFrames);
+    CHECK(!pWritable->IsShared());
+    CHECK(!m_pFrames->IsShared());
+    CHECK(pWritable->Frames[0].GetData() != m_pFrames->Frames[0].GetData());
+    STRCMP_EQUAL(reinterpret_cast<char*>(m_pFrames->Frames[0].GetData()),
+                 reinterpret_cast<char*>(pWritable->Frames[0].GetData()));
+
+    // Modify the copy does not affect the origin.
+    pWritable->ShrinkCount(1);
+    LONGS_EQUAL(2, m_pFrames->Count);
+    ArrayDataFrames::DeleteInstance(pWritable);
+    ArrayDataFrames::DeleteInstance(m_pFrames);
+}
@@ -0,0 +1,386 @@
+/*
+ * See the file LICENSE for redistribution information.
+ *
+ * Copyright (c) 2015-2018, Yuan Qin <yuanqin2000 at outlook dot com>
+ * All rights reserved.
+ *
+ */
+
+#include <pthread.h>
+#include <unistd.h>
+#include <stdarg.h>
+#include <time.h>
+#include "Stream/BoltGroup.h"
+#include "Stream/BoltChain.h"
+#include "Stream/Bolt.h"
+#include "Stream/BoltRunner.h"
+#include "Thread/ArrayDataFrames.h"
+#include "Common/Arch.h"
+#include "Common/Macros.h"
+#include "Defines.h"
+#include "CppUTest/MemoryLeakDetectorNewMacros.h"
+#include "CppUTest/TestHarness.h"
+
+TEST_GROUP(BoltGroup)
+{
+    // Every instance runs in its own thread, record the thread of the key (frame 0).
+    class CKeyBolt : public IBolt
+    {
+    public:
+        CKeyBolt() : m_Total(0), m_Mismatched(0)
+        {
+            for (size_t i = 0; i < COUNT_OF_ARRAY(m_KeyOwner); ++i) {
+                m_KeyOwner[i] = NULL;
+            }
+        }
+
+        ArrayDataFrames* Process(ArrayDataFrames* pInData)
+        {
+            uint8_t key = *reinterpret_cast<uint8_t*>(pInData->Frames[0].GetData());
+            void* pSelf = reinterpret_cast<void*>(pthread_self());
+            if (!AtomicCASPtr(&m_KeyOwner[key], NULL, pSelf) && m_KeyOwner[key] != pSelf) {
+                AtomicInc(&m_Mismatched);
+            }
+            AtomicInc(&m_Total);
+            ArrayDataFrames::DeleteInstance(pInData);
+            return NULL;
+        }
+
+        void* volatile m_KeyOwner[16];
+        volatile int32_t m_Total;
+        volatile int32_t m_Mismatched;
+    };
+
+    // Block the processing until the gate is opened.
+    class CGateBolt : public IBolt
+    {
+    public:
+        CGateBolt() : m_bOpen(0), m_Total(0) {}
+
+        ArrayDataFrames* Process(ArrayDataFrames* pInData)
+        {
+            while (!m_bOpen) {
+                usleep(1000);
+            }
+            AtomicInc(&m_Total);
+            ArrayDataFrames::DeleteInstance(pInData);
+            return NULL;
+        }
+
+        volatile int32_t m_bOpen;
+        volatile int32_t m_Total;
+    };
+
+static void* PushRoutine(void* pArg)
+{
+    CBoltRunner* pRunner = reinterpret_cast<CBoltRunner*>(pArg);
+    ITMessage msg(STREAM_USER_DATA);
+    ArrayDataFrames* pFrames = ArrayDataFrames::CreateInstance(1);
+    msg.SetExtData(pFrames, pFrames->Count,
+        ArrayDataFrames::DeleteInstance, ArrayDataFrames::Share, true);
+    return reinterpret_cast<void*>(pRunner->PushMessage(&msg));
+}
+
+    // Forward the data to the downstream as it is.
+    class CPassBolt : public IBolt
+    {
+    public:
+        ArrayDataFrames* Process(ArrayDataFrames* pInData) { return pInData; }
+    };
+
+    struct PushTask {
+        CBoltRunner* pRunner;
+        int Count;
+    };
+
+static void* PushManyRoutine(void* pArg)
+{
+    PushTask* pTask = reinterpret_cast<PushTask*>(pArg);
+    for (int i = 0; i < pTask->Count; ++i) {
+        if (!PushRoutine(pTask->pRunner)) {
+            return NULL;
+        }
+    }
+    return pArg;
+}
+
+static double CpuMillisec()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now);
+    return now.tv_sec * 1000.0 + now.tv_nsec / 1000000.0;
+}
+
+    // Stateful, the count is not atomic, every instance runs its clone.
+    class CCountBolt : public IBolt
+    {
+    public:
+        CCountBolt(volatile int32_t* pTotal, volatile int32_t* pCloned) :
+            m_pTotal(pTotal), m_pCloned(pCloned), m_pOwner(NULL), m_Count(0), m_bShared(false) {}
+
+        ArrayDataFrames* Process(ArrayDataFrames* pInData)
+        {
+            void* pSelf = reinterpret_cast<void*>(pthread_self());
+            if (m_pOwner == NULL) {
+                m_pOwner = pSelf;
+            } else if (m_pOwner != pSelf) {
+                m_bShared = true;
+            }
+            ++m_Count;
+            AtomicInc(m_pTotal);
+            ArrayDataFrames::DeleteInstance(pInData);
+            return NULL;
+        }
+
+        IBolt* Clone()
+        {
+            AtomicInc(m_pCloned);
+            return new CCountBolt(m_pTotal, m_pCloned);
+        }
+
+        volatile int32_t* m_pTotal;
+        volatile int32_t* m_pCloned;
+        void* m_pOwner;
+        int m_Count;
+        bool m_bShared;
+    };
+
+    // Push the messages to the runner from the worker of the executor.
+    class CPushTask : public ITask
+    {
+    public:
+        CPushTask() : m_pRunner(NULL), m_Count(0), m_Pushed(0), m_bSyncRefused(false) {}
+
+        void Run()
+        {
+            for (int i = 0; i < m_Count; ++i) {
+                if (PushRoutine(m_pRunner)) {
+                    AtomicInc(&m_Pushed);
+                }
+            }
+            ITMessage msg(STREAM_USER_DATA);
+            m_bSyncRefused = !m_pRunner->PushMessage(&msg, true);
+        }
+
+        CBoltRunner* m_pRunner;
+        int m_Count;
+        volatile int32_t m_Pushed;
+        bool m_bSyncRefused;
+    };
+
+static CBoltChain* CreateChain(int dummy, ...)
+{
+    va_list args;
+    va_start(args, dummy);
+    CBoltChain* pChain = CBoltChain::CreateInstance(args);
+    va_end(args);
+    return pChain;
+}
+
+static void DispatchKeys(CBoltGroup* pGroup, int count)
+{
+    for (int i = 0; i < count; ++i) {
+        uint8_t key = i % 16;
+        ArrayDataFrames* pFrames = ArrayDataFrames::CreateInstance(1);
+        DataFrame frame;
+        frame.SetData(&key, sizeof(key));
+        pFrames->SetFrame(0, &frame);
+        CHECK(pGroup->Dispatch(pFrames, i));
+    }
+}
+
+static void WaitTotal(volatile int32_t* pTotal, int32_t expected)
+{
+    for (int i = 0; i < 5000 && *pTotal < expected; ++i) {
+        usleep(1000);
+    }
+}
+
+void setup()
+{
+}
+
+void teardown()
+{
+}
+
+};
+
+TEST(BoltGroup, TestFieldGrouping)
+{
+    CKeyBolt bolt;
+    CBoltGroup* pGroup = CBoltGroup::CreateInstance(
+        "key", CreateChain(0, &bolt, NULL), 4, CBoltGroup::GROUPING_FIELD, 0);
+    CHECK(pGroup != NULL);
+    LONGS_EQUAL(4, pGroup->Count());
+    CHECK(pGroup->Start());
+
+    DispatchKeys(pGroup, 10000);
+    WaitTotal(&bolt.m_Total, 10000);
+    LONGS_EQUAL(10000, bolt.m_Total);
+    LONGS_EQUAL(0, bolt.m_Mismatched);
+
+    CHECK(pGroup->Stop());
+    delete pGroup;
+}
+
+TEST(BoltGroup, TestBroadcastGrouping)
+{
+    CKeyBolt bolt;
+    CBoltGroup* pGroup = CBoltGroup::CreateInstance(
+        "all", CreateChain(0, &bolt, NULL), 3, CBoltGroup::GROUPING_BROADCAST);
+    CHECK(pGroup != NULL);
+    CHECK(pGroup->Start());
+
+    DispatchKeys(pGroup, 1000);
+    WaitTotal(&bolt.m_Total, 3000);
+    LONGS_EQUAL(3000, bolt.m_Total);
+
+    CHECK(pGroup->Stop());
+    delete pGroup;
+}
+
+TEST(BoltGroup, TestClonedBolt)
+{
+    volatile int32_t total = 0;
+    volatile int32_t cloned = 0;
+    CCountBolt bolt(&total, &cloned);
+    CKeyBolt sharedBolt;    // Not cloned, shared by the instances.
+    CBoltGroup* pGroup = CBoltGroup::CreateInstance(
+        "count", CreateChain(0, &bolt, &sharedBolt, NULL), 4);
+    CHECK(pGroup != NULL);
+    LONGS_EQUAL(3, cloned);
+    CHECK(pGroup->Start());
+
+    DispatchKeys(pGroup, 1000);
+    WaitTotal(&total, 1000);
+    LONGS_EQUAL(1000, total);
+    CHECK(!bolt.m_bShared);
+    // The shuffle gives every instance its share.
+    LONGS_EQUAL(250, bolt.m_Count);
+
+    CHECK(pGroup->Stop());
+    delete pGroup;
+}
+
+TEST(BoltGroup, TestBackpressure)
+{
+    CGateBolt bolt;
+    CBoltRunner runner("gate", CreateChain(0, &bolt, NULL), 4);
+    CHECK(runner.Start());
+
+    // The credits are returned after processed, so 4 messages exhaust them.
+    for (int i = 0; i < 4; ++i) {
+        CHECK(PushRoutine(&runner));
+    }
+    LONGS_EQUAL(4, runner.QueueDepth());
+    CHECK(!runner.WaitCredit(10));
+
+    pthread_t thread;
+    LONGS_EQUAL(0, pthread_create(&thread, NULL, PushRoutine, &runner));
+    usleep(20000);
+    bolt.m_bOpen = 1;
+    void* pRes = NULL;
+    LONGS_EQUAL(0, pthread_join(thread, &pRes));
+    CHECK(pRes);
+
+    WaitTotal(&bolt.m_Total, 5);
+    LONGS_EQUAL(5, bolt.m_Total);
+    // The credit is returned after the bolt counted the message.
+    for (int i = 0; i < 5000 && runner.QueueDepth() > 0; ++i) {
+        usleep(1000);
+    }
+    CHECK(runner.WaitCredit(0));
+
+    CBoltRunner::FlowStats stats;
+    runner.GetFlowStats(&stats);
+    LONGS_EQUAL(4, stats.Capacity);
+    LONGS_EQUAL(0, stats.QueueDepth);
+    LONGS_EQUAL(1, stats.StallCount);
+    CHECK(stats.StallNanosec >= 10000000);
+    CHECK(runner.Stop());
+
+    // The stopped runner refuses the messages instead of blocking.
+    for (int i = 0; i < 5; ++i) {
+        ITMessage msg(STREAM_USER_DATA);
+        ArrayDataFrames* pFrames = ArrayDataFrames::CreateInstance(1);
+        msg.SetExtData(pFrames, pFrames->Count,
+            ArrayDataFrames::DeleteInstance, ArrayDataFrames::Share, true);
+        CHECK(!runner.PushMessage(&msg));
+        msg.Destroy();
+    }
+}
+
+TEST(BoltGroup, TestPushFromWorker)
+{
+    CTaskExecutor* pExecutor = CTaskExecutor::CreateInstance("test", 1);
+    CHECK(pExecutor != NULL);
+    CHECK(pExecutor->Start());
+
+    // The only worker pushes more messages than the ring holds, while the
+    // consumer task is pending on the same worker.
+    CGateBolt bolt;
+    bolt.m_bOpen = 1;
+    CBoltRunner runner("worker", CreateChain(0, &bolt, NULL), 4, pExecutor);
+    CHECK(runner.Start());
+
+    CPushTask task;
+    task.m_pRunner = &runner;
+    task.m_Count = 64;
+    pExecutor->Submit(&task);
+    WaitTotal(&bolt.m_Total, 64);
+    LONGS_EQUAL(64, task.m_Pushed);
+    LONGS_EQUAL(64, bolt.m_Total);
+    CHECK(task.m_bSyncRefused);
+
+    pExecutor->Stop();
+    CHECK(runner.Stop());
+    delete pExecutor;
+}
+
+TEST(BoltGroup, TestParkWithoutCredit)
+{
+    CTaskExecutor* pExecutor = CTaskExecutor::CreateInstance("test", 3);
+    CHECK(pExecutor != NULL);
+    CHECK(pExecutor->Start());
+
+    // The downstream task holds one worker and all of its credits.
+    CGateBolt gateBolt;
+    CBoltGroup* pGroup = CBoltGroup::CreateInstance(
+        "gate", CreateChain(0, &gateBolt, NULL), 1,
+        CBoltGroup::GROUPING_SHUFFLE, 0, pExecutor);
+    CHECK(pGroup != NULL);
+    CHECK(pGroup->Start());
+    CPassBolt passBolt;
+    CBoltRunner runner("pass", CreateChain(0, &passBolt, NULL), 64, pExecutor);
+    CHECK(runner.AddForwardNode(pGroup));
+    CHECK(runner.Start());
+
+    const int total = static_cast<int>(CRingMsgSwitch::DEFAULT_CAPACITY) + 128;
+    PushTask task = { &runner, total };
+    pthread_t thread;
+    LONGS_EQUAL(0, pthread_create(&thread, NULL, PushManyRoutine, &task));
+    for (int i = 0; i < 5000 && pGroup->WaitCredit(0); ++i) {
+        usleep(1000);
+    }
+    CHECK(!pGroup->WaitCredit(0));
+
+    // The upstream task is parked, the other workers are idle.
+    usleep(20000);
+    double start = CpuMillisec();
+    usleep(200000);
+    CHECK(CpuMillisec() - start < 50);
+
+    gateBolt.m_bOpen = 1;
+    void* pRes = NULL;
+    LONGS_EQUAL(0, pthread_join(thread, &pRes));
+    CHECK(pRes);
+    WaitTotal(&gateBolt.m_Total, total);
+    LONGS_EQUAL(total, gateBolt.m_Total);
+
+    pExecutor->Stop();
+    CHECK(runner.Stop());
+    CHECK(pGroup->Stop());
+    delete pGroup;
+    delete pExecutor;
+}
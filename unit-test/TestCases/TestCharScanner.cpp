@@ -0,0 +1,111 @@
+/*
+ * See the file LICENSE for redistribution information.
+ *
+ * Copyright (c) 2015-2018, Yuan Qin <yuanqin2000 at outlook dot com>
+ * All rights reserved.
+ *
+ */
+
+#include "Common/Macros.h"
+#include "Common/CharScanner.h"
+#include "Defines.h"
+#include <cstring>
+#include <cctype>
+#include <stdlib.h>
+#include "CppUTest/MemoryLeakDetectorNewMacros.h"
+#include "CppUTest/TestHarness.h"
+
+using std::strchr;
+
+TEST_GROUP(CharScanner)
+{
+    char m_Data[256];
+    NSCharScanner::ScanLevel m_Level;
+
+void setup()
+{
+    m_Level = NSCharScanner::GetScanLevel();
+
+    // Mostly the token characters with CR, LF, SP and the delimiters.
+    static const char* s_pAlphabet = "abcXYZ019-_.!~ \r\n\t:;\"(),/<=>?@[\\]{}|\x7f\x80\xff";
+    size_t count = strlen(s_pAlphabet);
+    srandom(2018);
+    for (size_t i = 0; i < sizeof(m_Data); ++i) {
+        m_Data[i] = (random() % 4 == 0) ? s_pAlphabet[random() % count] : 'a' + random() % 26;
+    }
+    for (size_t i = 7; i + 1 < sizeof(m_Data); i += 13 + random() % 29) {
+        m_Data[i] = '\r';
+        m_Data[i + 1] = '\n';
+    }
+}
+
+void teardown()
+{
+    NSCharScanner::SetScanLevel(m_Level);
+}
+
+static const char* ReferenceFindCRLF(const char* pBegin, const char* pEnd)
+{
+    for (const char* pCur = pBegin; pCur + 1 < pEnd; ++pCur) {
+        if (pCur[0] == '\r' && pCur[1] == '\n') {
+            return pCur;
+        }
+    }
+    return NULL;
+}
+
+static const char* ReferenceFindNonTokenChar(const char* pBegin, const char* pEnd)
+{
+    const char* pCur = pBegin;
+    while (pCur < pEnd) {
+        unsigned char c = static_cast<unsigned char>(*pCur);
+        if (c >= 0x80 || !(isalnum(c) || (c != 0 && strchr("!#$%&'*+-.^_`|~", c)))) {
+            break;
+        }
+        ++pCur;
+    }
+    return pCur;
+}
+
+};
+
+TEST(CharScanner, TestTokenChar)
+{
+    for (int c = 0; c < 256; ++c) {
+        const char ch = static_cast<char>(c);
+        CHECK_EQUAL(ReferenceFindNonTokenChar(&ch, &ch + 1) == &ch + 1,
+                    NSCharScanner::IsTokenChar(ch));
+    }
+}
+
+TEST(CharScanner, TestAllLevels)
+{
+    for (int level = 0; level < NSCharScanner::SCAN_LEVEL_COUNT; ++level) {
+        NSCharScanner::SetScanLevel(static_cast<NSCharScanner::ScanLevel>(level));
+
+        // Every alignment and length, so both the blocks and the tails are checked.
+        for (size_t begin = 0; begin < 40; ++begin) {
+            for (size_t end = begin; end <= sizeof(m_Data); ++end) {
+                const char* pBegin = m_Data + begin;
+                const char* pEnd = m_Data + end;
+                POINTERS_EQUAL(ReferenceFindCRLF(pBegin, pEnd),
+                               NSCharScanner::FindCRLF(pBegin, pEnd));
+                POINTERS_EQUAL(ReferenceFindNonTokenChar(pBegin, pEnd),
+                               NSCharScanner::FindNonTokenChar(pBegin, pEnd));
+            }
+        }
+    }
+}
+
+TEST(CharScanner, TestHeaderLine)
+{
+    const char* pLine = "Content-Type-With-A-Long-Name-Beyond-32: text/html\r\nX-A: 1\r\n";
+    const char* pEnd = pLine + strlen(pLine);
+    for (int level = 0; level < NSCharScanner::SCAN_LEVEL_COUNT; ++level) {
+        NSCharScanner::SetScanLevel(static_cast<NSCharScanner::ScanLevel>(level));
+        POINTERS_EQUAL(pLine + 39, NSCharScanner::FindNonTokenChar(pLine, pEnd));
+        POINTERS_EQUAL(pLine + 50, NSCharScanner::FindCRLF(pLine, pEnd));
+        POINTERS_EQUAL(pLine + 58, NSCharScanner::FindCRLF(pLine + 52, pEnd));
+        POINTERS_EQUAL(NULL, NSCharScanner::FindCRLF(pLine + 60, pEnd));
+    }
+}
@@ -0,0 +1,158 @@
+/*
+ * See the file LICENSE for redistribution information.
+ *
+ * Copyright (c) 2015-2018, Yuan Qin <yuanqin2000 at outlook dot com>
+ * All rights reserved.
+ *
+ */
+
+#include <pthread.h>
+#include <unistd.h>
+#include <cstring>
+#include "Memory/ConcurrentMemoryPool.h"
+#include "Common/Arch.h"
+#include "Common/Macros.h"
+#include "Defines.h"
+#include "CppUTest/MemoryLeakDetectorNewMacros.h"
+#include "CppUTest/TestHarness.h"
+
+TEST_GROUP(ConcurrentMemoryPool)
+{
+    struct FreeTask {
+        CConcurrentMemoryPool* pPool;
+        void** pCells;
+        size_t Count;
+        volatile int32_t Cached;
+    };
+
+static void* FreeRoutine(void* pArg)
+{
+    FreeTask* pTask = reinterpret_cast<FreeTask*>(pArg);
+    for (size_t i = 0; i < pTask->Count; ++i) {
+        pTask->pPool->Free(pTask->pCells[i]);
+    }
+    return NULL;
+}
+
+// Free the cells to the cache of the thread, and keep it until told to exit.
+static void* CacheRoutine(void* pArg)
+{
+    FreeTask* pTask = reinterpret_cast<FreeTask*>(pArg);
+    FreeRoutine(pTask);
+    AtomicInc(&pTask->Cached);
+    while (pTask->Cached == 1) {
+        usleep(1000);
+    }
+    return NULL;
+}
+
+void setup()
+{
+}
+
+void teardown()
+{
+}
+
+};
+
+TEST(ConcurrentMemoryPool, TestMallocFree)
+{
+    CConcurrentMemoryPool pool(24, 0, 4);
+    void* pCells[300] = { NULL };
+
+    for (size_t i = 0; i < COUNT_OF_ARRAY(pCells); ++i) {
+        pCells[i] = pool.Malloc(24);
+        CHECK(pCells[i] != NULL);
+        uint8_t* pByte = reinterpret_cast<uint8_t*>(pCells[i]);
+        for (size_t j = 0; j < 24; ++j) {
+            LONGS_EQUAL(0, pByte[j]);
+        }
+        memset(pCells[i], 0xFF, 24);
+    }
+    for (size_t i = 0; i < COUNT_OF_ARRAY(pCells); ++i) {
+        for (size_t j = i + 1; j < COUNT_OF_ARRAY(pCells); ++j) {
+            CHECK(pCells[i] != pCells[j]);
+        }
+    }
+    for (size_t i = 0; i < COUNT_OF_ARRAY(pCells); ++i) {
+        pool.Free(pCells[i]);
+    }
+}
+
+TEST(ConcurrentMemoryPool, TestPoolSize)
+{
+    CConcurrentMemoryPool pool(1024, 4);
+    void* pCells[4] = { NULL };
+
+    for (size_t i = 0; i < COUNT_OF_ARRAY(pCells); ++i) {
+        pCells[i] = pool.Malloc(1024);
+        CHECK(pCells[i] != NULL);
+    }
+    CHECK(pool.Malloc(1024) == NULL);
+    pool.Free(pCells[0]);
+    pCells[0] = pool.Malloc(1024);
+    CHECK(pCells[0] != NULL);
+    for (size_t i = 0; i < COUNT_OF_ARRAY(pCells); ++i) {
+        pool.Free(pCells[i]);
+    }
+}
+
+TEST(ConcurrentMemoryPool, TestFreeOnOtherThread)
+{
+    CConcurrentMemoryPool pool(64, 64 * 4, 8);
+    void* pCells[64 * 4] = { NULL };
+
+    for (size_t i = 0; i < COUNT_OF_ARRAY(pCells); ++i) {
+        pCells[i] = pool.Malloc(64);
+        CHECK(pCells[i] != NULL);
+    }
+    CHECK(pool.Malloc(64) == NULL);
+
+    FreeTask task = { &pool, pCells, COUNT_OF_ARRAY(pCells) };
+    pthread_t thread;
+    LONGS_EQUAL(0, pthread_create(&thread, NULL, FreeRoutine, &task));
+    LONGS_EQUAL(0, pthread_join(thread, NULL));
+
+    // All cells were released to the global free list by the exited thread.
+    for (size_t i = 0; i < COUNT_OF_ARRAY(pCells); ++i) {
+        pCells[i] = pool.Malloc(64);
+        CHECK(pCells[i] != NULL);
+    }
+    for (size_t i = 0; i < COUNT_OF_ARRAY(pCells); ++i) {
+        pool.Free(pCells[i]);
+    }
+}
+
+TEST(ConcurrentMemoryPool, TestPoolSizeOfBlocks)
+{
+    // The size is rounded up to a whole block of 64 cells.
+    CConcurrentMemoryPool pool(64, 1, 8);
+    void* pCells[64] = { NULL };
+    for (size_t i = 0; i < COUNT_OF_ARRAY(pCells); ++i) {
+        pCells[i] = pool.Malloc(64);
+        CHECK(pCells[i] != NULL);
+    }
+    CHECK(pool.Malloc(64) == NULL);
+
+    // The cells cached by a living thread are not stolen.
+    FreeTask task = { &pool, pCells, 8, 0 };
+    pthread_t thread;
+    LONGS_EQUAL(0, pthread_create(&thread, NULL, CacheRoutine, &task));
+    for (int i = 0; i < 5000 && task.Cached == 0; ++i) {
+        usleep(1000);
+    }
+    LONGS_EQUAL(1, task.Cached);
+    CHECK(pool.Malloc(64) == NULL);
+
+    // They are back to the global list once the thread exits.
+    AtomicInc(&task.Cached);
+    LONGS_EQUAL(0, pthread_join(thread, NULL));
+    for (size_t i = 0; i < task.Count; ++i) {
+        pCells[i] = pool.Malloc(64);
+        CHECK(pCells[i] != NULL);
+    }
+    for (size_t i = 0; i < COUNT_OF_ARRAY(pCells); ++i) {
+        pool.Free(pCells[i]);
+    }
+}
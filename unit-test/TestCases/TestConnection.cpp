@@ -0,0 +1,80 @@
+/*
+ * See the file LICENSE for redistribution information.
+ *
+ * Copyright (c) 2015-2018, Yuan Qin <yuanqin2000 at outlook dot com>
+ * All rights reserved.
+ *
+ */
+
+#include <cstring>
+#include <unistd.h>
+#include <sys/socket.h>
+#include "DataCom/Connection.h"
+#include "DataCom/ConnectionRunner.h"
+#include "TestRequest.h"
+#include "Defines.h"
+#include "CppUTest/MemoryLeakDetectorNewMacros.h"
+#include "CppUTest/TestHarness.h"
+
+TEST_GROUP(Connection)
+{
+    CConnectionRunner* m_pRunner = NULL;
+    sockaddr m_Address;
+
+void setup()
+{
+    m_pRunner = CConnectionRunner::CreateInstance("test");
+    CTestRequest::MakeAddress(&m_Address, 1);
+}
+
+void teardown()
+{
+    // The idle connection is closed after the idle timeout.
+    for (int i = 0; i < 5000 && m_pRunner->ConnectionCount() > 0; ++i) {
+        usleep(1000);
+    }
+    LONGS_EQUAL(0, m_pRunner->ConnectionCount());
+    delete m_pRunner;
+}
+
+};
+
+TEST(Connection, TestReceiveBudget)
+{
+    // The response is buffered in the IO at once, the connection reads
+    // it in rounds with the budget. The edge-triggered poll reports it
+    // only once, the ready list of the poller schedules the later rounds.
+    const size_t length = CConnection::RECEIVE_BYTES_BUDGET * 2;
+    CTestConfigure configure(4096);
+    CTestRequest request(configure, length);
+    CHECK(m_pRunner->PushRequest(&request, &m_Address));
+    CHECK(request.WaitPeerIO());
+
+    int bufSize = length + 4096;
+    setsockopt(request.m_PeerIO, SOL_SOCKET, SO_SNDBUF, &bufSize, sizeof(bufSize));
+    uint8_t* pData = new uint8_t[length];
+    memset(pData, 'a', length);
+    CHECK(request.Respond(pData, length));
+    delete [] pData;
+
+    CHECK(request.WaitTerminated());
+    LONGS_EQUAL(EC_SUCCESS, request.m_Result);
+    LONGS_EQUAL(length, request.m_Received);
+}
+
+TEST(Connection, TestFullBuffer)
+{
+    // The response never fits in the buffer and nothing is consumed,
+    // the request fails instead of waiting for ever.
+    CTestConfigure configure(64);
+    CTestRequest request(configure);
+    CHECK(m_pRunner->PushRequest(&request, &m_Address));
+    CHECK(request.WaitPeerIO());
+
+    uint8_t data[128];
+    memset(data, 'a', sizeof(data));
+    CHECK(request.Respond(data, sizeof(data)));
+
+    CHECK(request.WaitTerminated());
+    LONGS_EQUAL(EC_PROTOCOL_ERROR, request.m_Result);
+}
@@ -56,4 +56,76 @@ TEST(HeaderField, InsertValue)
         CHECK(pValue != NULL);
         ++iter;
     }
-}
\ No newline at end of file
+}
+
+TEST(HeaderField, LazyDecode)
+{
+    CLazyBuffer buffer;
+    CHeaderField* pHeaderField = CHeaderField::CreateInstance(
+        CHttpHeaderFieldDefs::GetResponseGlobalConfig(), buffer, NULL, true);
+    CHECK(pHeaderField != NULL);
+
+    // The value is kept as a copy of the raw string.
+    char value[] = "1234";
+    CHECK(pHeaderField->SetFieldValue("Content-Length", value));
+    value[0] = '9';
+    CHECK(!pHeaderField->SetFieldValue("Content-Length", "5678"));
+    CHECK(pHeaderField->SetFieldValue("Connection", "keep-alive, Upgrade"));
+    CHECK(pHeaderField->SetFieldValue("X-Request-Id", "42"));
+    LONGS_EQUAL(2, pHeaderField->Count());
+
+    CForwardList* pValueList =
+        pHeaderField->GetFieldValueByID(CHttpHeaderFieldDefs::RESP_FN_CONTENT_LENGTH);
+    CHECK(pValueList != NULL);
+    LONGS_EQUAL(1, pValueList->Count());
+    CIntFieldValue* pLength =
+        reinterpret_cast<CIntFieldValue*>(pValueList->DataAt(pValueList->Begin()));
+    LONGS_EQUAL(1234, pLength->Value());
+
+    pValueList = pHeaderField->GetFieldValueByName("connection");
+    CHECK(pValueList != NULL);
+    LONGS_EQUAL(2, pValueList->Count());
+    POINTERS_EQUAL(pValueList, pHeaderField->GetFieldValueByName("Connection"));
+    POINTERS_EQUAL(NULL, pHeaderField->GetFieldValueByID(CHttpHeaderFieldDefs::RESP_FN_DATE));
+    LONGS_EQUAL(2, pHeaderField->Count());
+
+    delete pHeaderField;
+}
+
+TEST(HeaderField, ReferRawValues)
+{
+    CLazyBuffer buffer;
+    CHeaderField* pHeaderField = CHeaderField::CreateInstance(
+        CHttpHeaderFieldDefs::GetResponseGlobalConfig(), buffer, NULL, true);
+    CHECK(pHeaderField != NULL);
+    pHeaderField->ReferRawValues();
+
+    // The referred value is decoded from the caller's string.
+    char length[] = "1234";
+    char connection[] = "close";
+    char date[] = "Sun, 06 Nov 1994 08:49:37 GMT";
+    CHECK(pHeaderField->SetFieldValue("Content-Length", length));
+    CHECK(pHeaderField->SetFieldValue("Connection", connection));
+    CHECK(pHeaderField->SetFieldValue("Date", date));
+    length[0] = '9';
+    CForwardList* pValueList =
+        pHeaderField->GetFieldValueByID(CHttpHeaderFieldDefs::RESP_FN_CONTENT_LENGTH);
+    CHECK(pValueList != NULL);
+    LONGS_EQUAL(9234, reinterpret_cast<CIntFieldValue*>(
+        pValueList->DataAt(pValueList->Begin()))->Value());
+
+    // The detached value is not changed with the caller's string.
+    pHeaderField->DetachRawValues();
+    strcpy(connection, "xxxxx");
+    LONGS_EQUAL(3, pHeaderField->Count());
+    pValueList = pHeaderField->GetFieldValueByID(CHttpHeaderFieldDefs::RESP_FN_CONNECTION);
+    CHECK(pValueList != NULL);
+    LONGS_EQUAL(1, pValueList->Count());
+
+    // The dropped value is regarded as not set.
+    pHeaderField->DropRawValues();
+    POINTERS_EQUAL(NULL, pHeaderField->GetFieldValueByID(CHttpHeaderFieldDefs::RESP_FN_DATE));
+    LONGS_EQUAL(2, pHeaderField->Count());
+
+    delete pHeaderField;
+}
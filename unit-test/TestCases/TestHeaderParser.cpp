@@ -0,0 +1,139 @@
+/*
+ * See the file LICENSE for redistribution information.
+ *
+ * Copyright (c) 2015-2018, Yuan Qin <yuanqin2000 at outlook dot com>
+ * All rights reserved.
+ *
+ */
+
+#include "Common/Macros.h"
+#include "Common/Typedefs.h"
+#include "HTTPBase/HeaderParser.h"
+#include "HTTPBase/HeaderField.h"
+#include "HTTPBase/FieldValue.h"
+#include "HTTP/HttpHeaderFieldDefs.h"
+#include "Defines.h"
+#include <cstring>
+#include "CppUTest/MemoryLeakDetectorNewMacros.h"
+#include "CppUTest/TestHarness.h"
+
+using namespace std;
+
+static const char* s_pHeader =
+    "Content-Length: 1234\r\n"
+    "X-Folded: a\r\n"
+    "  b\r\n"
+    "Connection: close\r\n"
+    "\r\n";
+
+TEST_GROUP(HeaderParser)
+{
+    char m_Data[256];
+    size_t m_DataLength;
+    CLazyBuffer m_Buffer;
+    CHeaderField* m_pHeaderField = NULL;
+
+void setup()
+{
+    m_DataLength = strlen(s_pHeader);
+    memcpy(m_Data, s_pHeader, m_DataLength + 1);
+    m_pHeaderField = CHeaderField::CreateInstance(
+        CHttpHeaderFieldDefs::GetResponseGlobalConfig(), m_Buffer);
+}
+
+void teardown()
+{
+    delete m_pHeaderField;
+}
+
+// Feed the data as received by the connection, in pieces of fragment octets.
+ErrorCode Parse(size_t fragment, size_t* pCallCount)
+{
+    CHeaderParser::ResumeState state;
+    ErrorCode resErr = EC_INPROGRESS;
+    size_t consumed = 0;
+    size_t received = 0;
+
+    *pCallCount = 0;
+    while (resErr == EC_INPROGRESS && received < m_DataLength) {
+        received += fragment;
+        if (received > m_DataLength) {
+            received = m_DataLength;
+        }
+        CHeaderParser parser(m_Data + consumed, received - consumed, &m_Buffer, &state);
+        resErr = parser.BuildHeaderField(m_pHeaderField);
+        consumed += parser.GetConsumedSize();
+        CHECK(consumed + state.ScannedSize <= received);
+        ++*pCallCount;
+    }
+    if (resErr == EC_SUCCESS) {
+        LONGS_EQUAL(m_DataLength, consumed);
+    }
+    return resErr;
+}
+
+void CheckFields()
+{
+    CForwardList* pValueList =
+        m_pHeaderField->GetFieldValueByID(CHttpHeaderFieldDefs::RESP_FN_CONTENT_LENGTH);
+    CHECK(pValueList != NULL);
+    LONGS_EQUAL(1234, reinterpret_cast<CIntFieldValue*>(
+        pValueList->DataAt(pValueList->Begin()))->Value());
+    CHECK(m_pHeaderField->GetFieldValueByID(CHttpHeaderFieldDefs::RESP_FN_CONNECTION) != NULL);
+    STRCMP_EQUAL("a    b", m_pHeaderField->GetExtensions().GetValue("X-Folded"));
+}
+
+};
+
+TEST(HeaderParser, TestWhole)
+{
+    size_t callCount = 0;
+    LONGS_EQUAL(EC_SUCCESS, Parse(m_DataLength, &callCount));
+    LONGS_EQUAL(1, callCount);
+    CheckFields();
+}
+
+TEST(HeaderParser, TestFragmented)
+{
+    size_t callCount = 0;
+    LONGS_EQUAL(EC_SUCCESS, Parse(1, &callCount));
+    LONGS_EQUAL(m_DataLength, callCount);
+    CheckFields();
+}
+
+TEST(HeaderParser, TestFragmentedBy3)
+{
+    size_t callCount = 0;
+    LONGS_EQUAL(EC_SUCCESS, Parse(3, &callCount));
+    CheckFields();
+}
+
+TEST(HeaderParser, TestResumeState)
+{
+    CHeaderParser::ResumeState state;
+
+    // The complete line is consumed, the scanned part of the next is kept.
+    CHeaderParser parser(m_Data, 30, &m_Buffer, &state);
+    LONGS_EQUAL(EC_INPROGRESS, parser.BuildHeaderField(m_pHeaderField));
+    LONGS_EQUAL(22, parser.GetConsumedSize());
+    LONGS_EQUAL(8, state.ScannedSize);
+    LONGS_EQUAL(1, m_pHeaderField->Count());
+
+    // The CR may be followed by LF.
+    CHeaderParser parser1(m_Data + 22, 12, &m_Buffer, &state);
+    LONGS_EQUAL(EC_INPROGRESS, parser1.BuildHeaderField(m_pHeaderField));
+    LONGS_EQUAL(0, parser1.GetConsumedSize());
+    LONGS_EQUAL(11, state.ScannedSize);
+
+    // The line may be folded.
+    CHeaderParser parser2(m_Data + 22, 13, &m_Buffer, &state);
+    LONGS_EQUAL(EC_INPROGRESS, parser2.BuildHeaderField(m_pHeaderField));
+    LONGS_EQUAL(0, parser2.GetConsumedSize());
+    LONGS_EQUAL(11, state.ScannedSize);
+
+    CHeaderParser parser3(m_Data + 22, 20, &m_Buffer, &state);
+    LONGS_EQUAL(EC_INPROGRESS, parser3.BuildHeaderField(m_pHeaderField));
+    LONGS_EQUAL(18, parser3.GetConsumedSize());
+    LONGS_EQUAL(2, state.ScannedSize);
+    STRCMP_EQUAL("a    b", m_pHeaderField->GetExtensions().GetValue("X-Folded"));
+}
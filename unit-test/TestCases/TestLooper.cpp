@@ -0,0 +1,97 @@
+/*
+ * See the file LICENSE for redistribution information.
+ *
+ * Copyright (c) 2015-2018, Yuan Qin <yuanqin2000 at outlook dot com>
+ * All rights reserved.
+ *
+ */
+
+#include <pthread.h>
+#include <unistd.h>
+#include "Thread/Looper.h"
+#include "Thread/QueueMsgSwitch.h"
+#include "Thread/ITMessage.h"
+#include "Common/Arch.h"
+#include "Common/Macros.h"
+#include "Defines.h"
+#include "CppUTest/MemoryLeakDetectorNewMacros.h"
+#include "CppUTest/TestHarness.h"
+
+TEST_GROUP(Looper)
+{
+    class CCountRunner : public IRunner
+    {
+    public:
+        CCountRunner() : m_Handled(0), m_MaxBatch(0) {}
+
+        void HandleMessage(ITMessage* pMsg)
+        {
+            pMsg->Destroy();
+            AtomicInc(&m_Handled);
+        }
+
+        void HandleMessages(ITMessage* pMsgs, size_t count)
+        {
+            if (count > m_MaxBatch) {
+                m_MaxBatch = count;
+            }
+            IRunner::HandleMessages(pMsgs, count);
+        }
+
+        volatile int32_t m_Handled;
+        size_t m_MaxBatch;
+    };
+
+    struct WriteTask {
+        CMsgSwitch* pSwitch;
+        int Count;
+    };
+
+static void* WriteRoutine(void* pArg)
+{
+    WriteTask* pTask = reinterpret_cast<WriteTask*>(pArg);
+    for (int i = 0; i < pTask->Count; ++i) {
+        ITMessage msg(USER_MSGID_BEGIN);
+        pTask->pSwitch->WriteMessage(&msg);
+    }
+    return NULL;
+}
+
+void setup()
+{
+}
+
+void teardown()
+{
+}
+
+};
+
+TEST(Looper, TestBatchWithBlockedWriters)
+{
+    // Many producers are blocked on the small queue, every batch frees
+    // several slots and all the producers shall be woken to refill them.
+    CQueueMsgSwitch queueSwitch(4);
+    CCountRunner runner;
+    CLooper* pLooper = CLooper::CreateInstance("test-looper", runner, queueSwitch, 8);
+    CHECK(pLooper != NULL);
+
+    WriteTask task = { &queueSwitch, 2000 };
+    pthread_t threads[4];
+    for (size_t i = 0; i < COUNT_OF_ARRAY(threads); ++i) {
+        LONGS_EQUAL(0, pthread_create(&threads[i], NULL, WriteRoutine, &task));
+    }
+
+    const int32_t total = task.Count * COUNT_OF_ARRAY(threads);
+    for (int i = 0; i < 10000 && runner.m_Handled < total; ++i) {
+        usleep(1000);
+    }
+    LONGS_EQUAL(total, runner.m_Handled);
+    for (size_t i = 0; i < COUNT_OF_ARRAY(threads); ++i) {
+        LONGS_EQUAL(0, pthread_join(threads[i], NULL));
+    }
+    CHECK(runner.m_MaxBatch > 1);
+
+    CHECK(pLooper->Exit());
+    delete pLooper;
+}
@@ -0,0 +1,122 @@
+/*
+ * See the file LICENSE for redistribution information.
+ *
+ * Copyright (c) 2015-2018, Yuan Qin <yuanqin2000 at outlook dot com>
+ * All rights reserved.
+ *
+ */
+
+#include <cstring>
+#include "Memory/MemoryPool.h"
+#include "Memory/MemoryRegistry.h"
+#include "Memory/MemoryStats.h"
+#include "Defines.h"
+#include "CppUTest/MemoryLeakDetectorNewMacros.h"
+#include "CppUTest/TestHarness.h"
+
+using std::strstr;
+
+TEST_GROUP(MemoryStats)
+{
+void setup()
+{
+}
+
+void teardown()
+{
+}
+
+};
+
+TEST(MemoryStats, TestPoolStats)
+{
+    CMemoryPool pool(32, 2);
+    CHECK(pool.GetStats() == NULL);
+    CHECK(pool.EnableStats("TestPool"));
+
+    const CMemoryStats* pStats = pool.GetStats();
+    CHECK(pStats != NULL);
+
+    void* pMem1 = pool.Malloc(32);
+    void* pMem2 = pool.Malloc(20);
+    CHECK(pMem1 != NULL);
+    CHECK(pMem2 != NULL);
+    LONGS_EQUAL(64, pStats->LiveBytes());
+    LONGS_EQUAL(64, pStats->PeakBytes());
+    LONGS_EQUAL(2, pStats->AllocCount());
+
+    pool.Free(pMem1);
+    LONGS_EQUAL(32, pStats->LiveBytes());
+    LONGS_EQUAL(64, pStats->PeakBytes());
+    LONGS_EQUAL(1, pStats->FreeCount());
+    pool.Free(pMem2);
+    LONGS_EQUAL(0, pStats->LiveBytes());
+    LONGS_EQUAL(0, pStats->FailedCount());
+
+    pool.DisableStats();
+    CHECK(pool.GetStats() == NULL);
+}
+
+TEST(MemoryStats, TestRegistryDump)
+{
+    char buffer[1024];
+    CMemoryPool pool(100);
+    CHECK(pool.EnableStats("DumpedPool"));
+    void* pMem = pool.Malloc(100);
+    CHECK(pMem != NULL);
+
+    size_t len = CMemoryRegistry::Instance()->Dump(buffer, sizeof(buffer));
+    CHECK(len > 0);
+    CHECK(strstr(buffer, "DumpedPool: live 104") != NULL);
+    CHECK(strstr(buffer, "<= 128: 1") != NULL);
+    pool.Free(pMem);
+
+    // The statistics are kept after the allocator is gone.
+    pool.DisableStats();
+    CMemoryRegistry::Instance()->Dump(buffer, sizeof(buffer));
+    CHECK(strstr(buffer, "DumpedPool: live 0, peak 104") != NULL);
+    CHECK(strstr(buffer, "instances 0") != NULL);
+}
+
+TEST(MemoryStats, TestSharedByName)
+{
+    char buffer[1024];
+    CMemoryPool* pPool1 = new CMemoryPool(32, 2);
+    CMemoryPool* pPool2 = new CMemoryPool(32, 2);
+    CHECK(pPool1->EnableStats("SharedPool"));
+    CHECK(pPool2->EnableStats("SharedPool"));
+    CHECK(pPool1->GetStats() == pPool2->GetStats());
+    const CMemoryStats* pStats = pPool1->GetStats();
+    LONGS_EQUAL(2, pStats->InstanceCount());
+
+    // The first pool is used up, the second one has two cells.
+    int64_t count = 0;
+    while (pPool1->Malloc(32) != NULL) {
+        ++count;
+    }
+    void* pMem1 = pPool2->Malloc(32);
+    void* pMem2 = pPool2->Malloc(32);
+    CHECK(pMem1 != NULL && pMem2 != NULL);
+    LONGS_EQUAL((count + 2) * 32, pStats->LiveBytes());
+    LONGS_EQUAL(count + 2, pStats->AllocCount());
+    LONGS_EQUAL(1, pStats->FailedCount());
+
+    // The instance destroyed with live memory takes its part away,
+    // the peak and the failure are kept.
+    delete pPool1;
+    LONGS_EQUAL(64, pStats->LiveBytes());
+    LONGS_EQUAL((count + 2) * 32, pStats->PeakBytes());
+    LONGS_EQUAL(1, pStats->FailedCount());
+    LONGS_EQUAL(1, pStats->InstanceCount());
+    pPool2->Free(pMem1);
+    pPool2->Free(pMem2);
+    delete pPool2;
+    LONGS_EQUAL(0, pStats->LiveBytes());
+    LONGS_EQUAL(0, pStats->InstanceCount());
+
+    // One entry for the name.
+    CMemoryRegistry::Instance()->Dump(buffer, sizeof(buffer));
+    const char* pEntry = strstr(buffer, "SharedPool:");
+    CHECK(pEntry != NULL);
+    CHECK(strstr(pEntry + 1, "SharedPool:") == NULL);
+}
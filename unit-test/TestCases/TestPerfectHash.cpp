@@ -0,0 +1,104 @@
+/*
+ * See the file LICENSE for redistribution information.
+ *
+ * Copyright (c) 2015-2018, Yuan Qin <yuanqin2000 at outlook dot com>
+ * All rights reserved.
+ *
+ */
+
+#include "Common/Macros.h"
+#include "Common/PerfectHash.h"
+#include "Common/StringIndex.h"
+#include "HTTP/HttpHeaderFieldDefs.h"
+#include "Defines.h"
+#include <cstring>
+#include "CppUTest/MemoryLeakDetectorNewMacros.h"
+#include "CppUTest/TestHarness.h"
+
+using std::strlen;
+
+TEST_GROUP(PerfectHash)
+{
+    const char* m_Keys[8] = {
+        "gzip", "deflate", "compress", "identity", "br", "chunked", "x-gzip", "x-compress"
+    };
+
+void setup()
+{
+}
+
+void teardown()
+{
+}
+
+};
+
+TEST(PerfectHash, TestStrings)
+{
+    CPerfectHash hash(false);
+    CHECK(hash.Initialize(m_Keys, COUNT_OF_ARRAY(m_Keys)));
+    LONGS_EQUAL(COUNT_OF_ARRAY(m_Keys), hash.Count());
+
+    for (size_t i = 0; i < COUNT_OF_ARRAY(m_Keys); ++i) {
+        LONGS_EQUAL(i, hash.Find(m_Keys[i]));
+        LONGS_EQUAL(i, hash.Find(m_Keys[i], strlen(m_Keys[i])));
+    }
+    LONGS_EQUAL(0, hash.Find("GZip"));
+    LONGS_EQUAL(1, hash.Find("DEFLATE, gzip", 7));
+    LONGS_EQUAL(CPerfectHash::INVALID_VALUE, hash.Find("gz"));
+    LONGS_EQUAL(CPerfectHash::INVALID_VALUE, hash.Find("gzip", 2));
+    LONGS_EQUAL(CPerfectHash::INVALID_VALUE, hash.Find("gzipx"));
+    LONGS_EQUAL(CPerfectHash::INVALID_VALUE, hash.Find(""));
+}
+
+TEST(PerfectHash, TestCaseSensitive)
+{
+    static const CPerfectHash::KeyValue s_Entries[] = {
+        { "Host", 10 },
+        { "host", 20 },
+        { "Accept", 30 },
+    };
+    CPerfectHash hash(s_Entries, COUNT_OF_ARRAY(s_Entries), true);
+    LONGS_EQUAL(10, hash.Find("Host"));
+    LONGS_EQUAL(20, hash.Find("host"));
+    LONGS_EQUAL(30, hash.Find("Accept"));
+    LONGS_EQUAL(CPerfectHash::INVALID_VALUE, hash.Find("HOST"));
+
+    // The folded keys are duplicated.
+    CPerfectHash caseless(false);
+    CHECK(!caseless.Initialize(s_Entries, COUNT_OF_ARRAY(s_Entries)));
+    LONGS_EQUAL(CPerfectHash::INVALID_VALUE, caseless.Find("Host"));
+}
+
+TEST(PerfectHash, TestStringIndex)
+{
+    CStringIndex* pIndex = CStringIndex::CreateInstance(COUNT_OF_ARRAY(m_Keys), m_Keys, false);
+    CHECK(pIndex != NULL);
+    LONGS_EQUAL(3, pIndex->GetIndexByString("Identity"));
+    LONGS_EQUAL(4, pIndex->GetIndexByString("br;q=1", 2));
+    LONGS_EQUAL(-1, pIndex->GetIndexByString("unknown"));
+    delete pIndex;
+}
+
+TEST(PerfectHash, TestArrayStringIndex)
+{
+    // Less than 5 strings are indexed by the array, the length shall match.
+    const char* keys[] = { "keep-alive", "close" };
+    CStringIndex* pIndex = CStringIndex::CreateInstance(COUNT_OF_ARRAY(keys), keys, false);
+    CHECK(pIndex != NULL);
+    LONGS_EQUAL(1, pIndex->GetIndexByString("Close, TE", 5));
+    LONGS_EQUAL(-1, pIndex->GetIndexByString("keep", 4));
+    LONGS_EQUAL(-1, pIndex->GetIndexByString("closed", 6));
+    delete pIndex;
+}
+
+TEST(PerfectHash, TestFieldID)
+{
+    const CHeaderField::GlobalConfig* pConfig = CHttpHeaderFieldDefs::GetResponseGlobalConfig();
+    for (size_t i = 0; i < pConfig->ItemsCount; ++i) {
+        LONGS_EQUAL(i, pConfig->GetFieldID(pConfig->pItems[i].pItemName));
+    }
+    LONGS_EQUAL(CHttpHeaderFieldDefs::RESP_FN_CONTENT_TYPE, pConfig->GetFieldID("content-type"));
+    LONGS_EQUAL(CHttpHeaderFieldDefs::RESP_FN_SET_COOKIE2, pConfig->GetFieldID("SET-COOKIE2"));
+    LONGS_EQUAL(CHeaderField::INVALID_FIELD_ID, pConfig->GetFieldID("X-Request-Id"));
+}
@@ -0,0 +1,120 @@
+/*
+ * See the file LICENSE for redistribution information.
+ *
+ * Copyright (c) 2015-2018, Yuan Qin <yuanqin2000 at outlook dot com>
+ * All rights reserved.
+ *
+ */
+
+#include <unistd.h>
+#include <sys/socket.h>
+#include "IO/PollBackend.h"
+#include "Defines.h"
+#include "CppUTest/MemoryLeakDetectorNewMacros.h"
+#include "CppUTest/TestHarness.h"
+
+TEST_GROUP(PollBackend)
+{
+    int m_Pair[2];
+
+void setup()
+{
+    m_Pair[0] = m_Pair[1] = -1;
+}
+
+void teardown()
+{
+    ClosePair();
+}
+
+void OpenPair()
+{
+    CHECK(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, m_Pair) == 0);
+}
+
+void ClosePair()
+{
+    if (m_Pair[0] >= 0) {
+        close(m_Pair[0]);
+        close(m_Pair[1]);
+        m_Pair[0] = m_Pair[1] = -1;
+    }
+}
+
+// Count the events reported for the IO in the rounds.
+int CountEvents(CPollBackend* pBackend, tIOHandle hIO, uint32_t mask, int timeout)
+{
+    CPollBackend::Event events[16];
+    int count = 0;
+    int eventCount = pBackend->Wait(events, 16, timeout);
+    CHECK(eventCount >= 0);
+    for (int i = 0; i < eventCount; ++i) {
+        if (events[i].hIO == hIO && (events[i].Events & mask)) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+void TestReadable(CPollBackend::Type type)
+{
+    CPollBackend* pBackend = CPollBackend::CreateInstance(type);
+    CHECK(pBackend != NULL);
+    LONGS_EQUAL(type, pBackend->GetType());
+    OpenPair();
+    CHECK(pBackend->Add(m_Pair[0], EPOLLIN | EPOLLRDHUP | EPOLLET));
+    LONGS_EQUAL(0, CountEvents(pBackend, m_Pair[0], EPOLLIN, 10));
+
+    CHECK(write(m_Pair[1], "a", 1) == 1);
+    LONGS_EQUAL(1, CountEvents(pBackend, m_Pair[0], EPOLLIN, 1000));
+
+    // It is armed again after the IO is drained.
+    char buf[4];
+    CHECK(read(m_Pair[0], buf, sizeof(buf)) == 1);
+    CHECK(write(m_Pair[1], "b", 1) == 1);
+    LONGS_EQUAL(1, CountEvents(pBackend, m_Pair[0], EPOLLIN, 1000));
+
+    CHECK(pBackend->Remove(m_Pair[0]));
+    delete pBackend;
+}
+
+void TestReusedHandle(CPollBackend::Type type)
+{
+    CPollBackend* pBackend = CPollBackend::CreateInstance(type);
+    CHECK(pBackend != NULL);
+    LONGS_EQUAL(type, pBackend->GetType());
+
+    // The IO becomes readable and is removed before the event is reaped.
+    OpenPair();
+    tIOHandle hIO = m_Pair[0];
+    CHECK(write(m_Pair[1], "a", 1) == 1);
+    CHECK(pBackend->Add(hIO, EPOLLIN | EPOLLET));
+    usleep(10000);
+    CHECK(pBackend->Remove(hIO));
+    ClosePair();
+
+    // The handle is reused by another IO which has nothing to read.
+    OpenPair();
+    LONGS_EQUAL(hIO, m_Pair[0]);
+    CHECK(pBackend->Add(hIO, EPOLLIN | EPOLLET));
+    LONGS_EQUAL(0, CountEvents(pBackend, hIO, EPOLLIN, 0));
+    LONGS_EQUAL(0, CountEvents(pBackend, hIO, EPOLLIN, 10));
+
+    CHECK(write(m_Pair[1], "b", 1) == 1);
+    LONGS_EQUAL(1, CountEvents(pBackend, hIO, EPOLLIN, 1000));
+
+    CHECK(pBackend->Remove(hIO));
+    delete pBackend;
+}
+
+};
+
+TEST(PollBackend, TestEpollReadable)
+{
+    TestReadable(CPollBackend::PB_EPOLL);
+}
+
+TEST(PollBackend, TestEpollReusedHandle)
+{
+    TestReusedHandle(CPollBackend::PB_EPOLL);
+}
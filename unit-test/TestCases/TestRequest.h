@@ -0,0 +1,160 @@
+/*
+ * See the file LICENSE for redistribution information.
+ *
+ * Copyright (c) 2015-2018, Yuan Qin <yuanqin2000 at outlook dot com>
+ * All rights reserved.
+ *
+ */
+
+#ifndef __TEST_REQUEST_H__
+#define __TEST_REQUEST_H__
+
+#include <cstring>
+#include <unistd.h>
+#include <sys/socket.h>
+#include "DataCom/Configure.h"
+#include "DataCom/Request.h"
+#include "IO/UDSStream.h"
+#include "Common/Arch.h"
+
+class CTestConfigure : public CConfigure
+{
+public:
+    CTestConfigure(
+        size_t inBufSize,
+        unsigned int idleTimeout = 10,
+        size_t maxConnections = 1) :
+        CConfigure(inBufSize, 256, 0, 0, idleTimeout, maxConnections) {}
+
+    bool CreateController(CController** pOutController, CRequest* pRequest)
+    {
+        *pOutController = NULL;
+        return true;
+    }
+};
+
+/**
+ * The request sends one octet, its response is the next ResponseLength
+ * octets. The response never completes and nothing is consumed if the
+ * length is 0. The IO is one end of a socket pair, the test plays the
+ * server on the other end (PeerIO).
+ */
+class CTestRequest : public CRequest
+{
+public:
+    CTestRequest(CConfigure& configure, size_t respLength = 0) :
+        CRequest(true, false),
+        m_Configure(configure),
+        m_ResponseLength(respLength),
+        m_Received(0),
+        m_PeerIO(INVALID_IO_HANDLE),
+        m_Result(EC_UNKNOWN),
+        m_bTerminated(0) {}
+
+    ~CTestRequest()
+    {
+        ClosePeerIO();
+    }
+
+    // From CRequest
+    bool Serialize(uint8_t* pBuf, size_t bufLen, size_t* pOutLen)
+    {
+        pBuf[0] = 'Q';
+        *pOutLen = 1;
+        return true;
+    }
+
+    ErrorCode OnResponse(uint8_t* pData, size_t dataLen, size_t* pConsumedLen)
+    {
+        *pConsumedLen = 0;
+        if (m_ResponseLength == 0) {
+            return EC_INPROGRESS;
+        }
+        size_t len = m_ResponseLength - m_Received;
+        if (len > dataLen) {
+            len = dataLen;
+        }
+        m_Received += len;
+        *pConsumedLen = len;
+        return m_Received == m_ResponseLength ? EC_SUCCESS : EC_INPROGRESS;
+    }
+
+    ErrorCode OnPeerClosed() { return EC_SUCCESS; }
+
+    void OnTerminated(ErrorCode err)
+    {
+        m_Result = err;
+        AtomicInc(&m_bTerminated);
+    }
+
+    void OnReset() { m_Received = 0; }
+
+    CIOContext* CreateIOContext(const sockaddr* pTarget)
+    {
+        int fds[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+            return NULL;
+        }
+        CUDSStreamPeer* pIO = new CUDSStreamPeer(false, fds[0]);
+        pIO->Open();
+        m_PeerIO = fds[1];
+        return pIO;
+    }
+
+    CConfigure& GetConfigure() { return m_Configure; }
+
+    bool WaitTerminated()
+    {
+        for (int i = 0; i < 5000 && !m_bTerminated; ++i) {
+            usleep(1000);
+        }
+        return m_bTerminated != 0;
+    }
+
+    bool WaitPeerIO()
+    {
+        for (int i = 0; i < 5000 && m_PeerIO == INVALID_IO_HANDLE; ++i) {
+            usleep(1000);
+        }
+        return m_PeerIO != INVALID_IO_HANDLE;
+    }
+
+    // Write the response from the peer.
+    bool Respond(const uint8_t* pData, size_t len)
+    {
+        while (len > 0) {
+            ssize_t count = write(m_PeerIO, pData, len);
+            if (count <= 0) {
+                return false;
+            }
+            pData += count;
+            len -= count;
+        }
+        return true;
+    }
+
+    // Close the peer end, the idle connection is closed then.
+    void ClosePeerIO()
+    {
+        if (m_PeerIO != INVALID_IO_HANDLE) {
+            close(m_PeerIO);
+            m_PeerIO = INVALID_IO_HANDLE;
+        }
+    }
+
+    static void MakeAddress(sockaddr* pOutAddr, uint8_t id)
+    {
+        memset(pOutAddr, 0, sizeof(sockaddr));
+        pOutAddr->sa_family = AF_UNIX;
+        pOutAddr->sa_data[0] = id;
+    }
+
+    CConfigure& m_Configure;
+    const size_t m_ResponseLength;
+    size_t m_Received;
+    volatile tIOHandle m_PeerIO;
+    volatile ErrorCode m_Result;
+    volatile int32_t m_bTerminated;
+};
+
+#endif
@@ -0,0 +1,266 @@
+/*
+ * See the file LICENSE for redistribution information.
+ *
+ * Copyright (c) 2015-2018, Yuan Qin <yuanqin2000 at outlook dot com>
+ * All rights reserved.
+ *
+ */
+
+#include <unistd.h>
+#include <sys/socket.h>
+#include "DataCom/ConnectionRunner.h"
+#include "TestRequest.h"
+#include "Common/Arch.h"
+#include "Common/Macros.h"
+#include "Defines.h"
+#include "CppUTest/MemoryLeakDetectorNewMacros.h"
+#include "CppUTest/TestHarness.h"
+
+// Keep the idle connections, so only the scheduler closes them.
+static const unsigned int LONG_IDLE_TIMEOUT = 100000;
+
+TEST_GROUP(RequestScheduler)
+{
+    // The requests in the order they are sent, and the request which has
+    // created the IO of the latest connection.
+    struct SendLog {
+        CTestRequest* Sent[16];
+        volatile int32_t Count;
+        CTestRequest* volatile pPeer;
+    };
+
+    class COrderedRequest : public CTestRequest
+    {
+    public:
+        COrderedRequest(CConfigure& configure, SendLog& log, uint8_t origin) :
+            CTestRequest(configure, 1), m_Log(log), m_Origin(origin) {}
+
+        bool Serialize(uint8_t* pBuf, size_t bufLen, size_t* pOutLen)
+        {
+            m_Log.Sent[m_Log.Count] = this;
+            AtomicInc(&m_Log.Count);
+            return CTestRequest::Serialize(pBuf, bufLen, pOutLen);
+        }
+
+        CIOContext* CreateIOContext(const sockaddr* pTarget)
+        {
+            CIOContext* pIO = CTestRequest::CreateIOContext(pTarget);
+            m_Log.pPeer = this;
+            return pIO;
+        }
+
+        SendLog& m_Log;
+        const uint8_t m_Origin;
+    };
+
+    // The response closes the connection, e.g. "Connection: close".
+    class CClosingRequest : public COrderedRequest
+    {
+    public:
+        CClosingRequest(CConfigure& configure, SendLog& log, uint8_t origin) :
+            COrderedRequest(configure, log, origin) {}
+
+        ErrorCode OnResponse(uint8_t* pData, size_t dataLen, size_t* pConsumedLen)
+        {
+            ErrorCode error = COrderedRequest::OnResponse(pData, dataLen, pConsumedLen);
+            SetConnectionClose(error == EC_SUCCESS);
+            return error;
+        }
+    };
+
+    CConnectionRunner* m_pRunner = NULL;
+    SendLog m_Log;
+
+void setup()
+{
+    m_Log.Count = 0;
+    m_Log.pPeer = NULL;
+}
+
+void teardown()
+{
+    // The requests have closed their peer IOs, so the idle connections.
+    for (int i = 0; i < 5000 && m_pRunner->ConnectionCount() > 0; ++i) {
+        usleep(1000);
+    }
+    LONGS_EQUAL(0, m_pRunner->ConnectionCount());
+    delete m_pRunner;
+}
+
+bool WaitSent(int32_t count)
+{
+    for (int i = 0; i < 5000 && m_Log.Count < count; ++i) {
+        usleep(1000);
+    }
+    return m_Log.Count >= count;
+}
+
+// Complete the request on the connection of the latest sent one.
+void Complete(CTestRequest* pReq)
+{
+    CHECK(m_Log.pPeer != NULL);
+    CHECK(m_Log.pPeer->Respond(reinterpret_cast<const uint8_t*>("R"), 1));
+    CHECK(pReq->WaitTerminated());
+    LONGS_EQUAL(EC_SUCCESS, pReq->m_Result);
+}
+
+// Two origins in different shards of the runner.
+void MakeCrossShardAddresses(sockaddr* pAddrs)
+{
+    CTestRequest::MakeAddress(&pAddrs[0], 1);
+    uint8_t id = 2;
+    do {
+        CTestRequest::MakeAddress(&pAddrs[1], id++);
+    } while (m_pRunner->ShardIndexOf(&pAddrs[1]) == m_pRunner->ShardIndexOf(&pAddrs[0]));
+}
+
+};
+
+TEST(RequestScheduler, TestFairness)
+{
+    // One connection for the runner, the origins take it in turn by the
+    // weight, 3:1, instead of in the order the requests are pushed.
+    m_pRunner = CConnectionRunner::CreateInstance("test", 1, false, CPollBackend::PB_EPOLL, 1);
+    CTestConfigure configure(256, LONG_IDLE_TIMEOUT);
+    sockaddr addrs[3];
+    for (size_t i = 0; i < COUNT_OF_ARRAY(addrs); ++i) {
+        CTestRequest::MakeAddress(&addrs[i], i + 1);
+    }
+    CHECK(m_pRunner->SetPeerWeight(&addrs[0], 3));
+
+    // The blocker holds the connection until all the others are queued.
+    COrderedRequest blocker(configure, m_Log, 2);
+    CHECK(m_pRunner->PushRequest(&blocker, &addrs[2]));
+    CHECK(WaitSent(1));
+
+    COrderedRequest* pRequests[8];
+    for (size_t i = 0; i < COUNT_OF_ARRAY(pRequests); ++i) {
+        uint8_t origin = i < 6 ? 0 : 1;
+        pRequests[i] = new COrderedRequest(configure, m_Log, origin);
+        CHECK(m_pRunner->PushRequest(pRequests[i], &addrs[origin]));
+    }
+    usleep(50000);
+    LONGS_EQUAL(1, m_Log.Count);
+    Complete(&blocker);
+
+    // Every 4 requests sent, 3 are from the heavy origin.
+    int heavyCount[2] = { 0 };
+    for (int32_t i = 1; i <= 8; ++i) {
+        CHECK(WaitSent(i + 1));
+        COrderedRequest* pReq = reinterpret_cast<COrderedRequest*>(m_Log.Sent[i]);
+        if (pReq->m_Origin == 0) {
+            ++heavyCount[(i - 1) / 4];
+        }
+        Complete(pReq);
+    }
+    LONGS_EQUAL(3, heavyCount[0]);
+    LONGS_EQUAL(3, heavyCount[1]);
+    LONGS_EQUAL(1, m_pRunner->ConnectionCount());
+
+    for (size_t i = 0; i < COUNT_OF_ARRAY(pRequests); ++i) {
+        delete pRequests[i];
+    }
+}
+
+TEST(RequestScheduler, TestReclaimIdle)
+{
+    // The idle connection of the other origin gives its slot at once,
+    // instead of after its idle timeout.
+    m_pRunner = CConnectionRunner::CreateInstance("test", 1, false, CPollBackend::PB_EPOLL, 1);
+    CTestConfigure configure(256, LONG_IDLE_TIMEOUT);
+    sockaddr addrs[2];
+    CTestRequest::MakeAddress(&addrs[0], 1);
+    CTestRequest::MakeAddress(&addrs[1], 2);
+
+    COrderedRequest first(configure, m_Log, 0);
+    CHECK(m_pRunner->PushRequest(&first, &addrs[0]));
+    CHECK(WaitSent(1));
+    Complete(&first);
+    LONGS_EQUAL(1, m_pRunner->ConnectionCount());
+
+    COrderedRequest second(configure, m_Log, 1);
+    CHECK(m_pRunner->PushRequest(&second, &addrs[1]));
+    CHECK(WaitSent(2));
+    CHECK(m_Log.pPeer == &second);
+    Complete(&second);
+    LONGS_EQUAL(1, m_pRunner->ConnectionCount());
+}
+
+TEST(RequestScheduler, TestCappedWakeup)
+{
+    // The shard capped by the limit of the runner takes the slot of the
+    // idle connection in the other shard.
+    m_pRunner = CConnectionRunner::CreateInstance(
+        "test", 2, false, CPollBackend::PB_EPOLL, 1);
+    CTestConfigure configure(256, LONG_IDLE_TIMEOUT);
+    sockaddr addrs[2];
+    MakeCrossShardAddresses(addrs);
+
+    COrderedRequest first(configure, m_Log, 0);
+    CHECK(m_pRunner->PushRequest(&first, &addrs[0]));
+    CHECK(WaitSent(1));
+    Complete(&first);
+
+    COrderedRequest second(configure, m_Log, 1);
+    CHECK(m_pRunner->PushRequest(&second, &addrs[1]));
+    CHECK(WaitSent(2));
+    CHECK(m_Log.pPeer == &second);
+    Complete(&second);
+    LONGS_EQUAL(1, m_pRunner->ConnectionCount());
+}
+
+TEST(RequestScheduler, TestReclaimOnceIdle)
+{
+    // The connection in the other shard is busy when the shard is capped,
+    // it gives its slot as soon as it is idle.
+    m_pRunner = CConnectionRunner::CreateInstance(
+        "test", 2, false, CPollBackend::PB_EPOLL, 1);
+    CTestConfigure configure(256, LONG_IDLE_TIMEOUT);
+    sockaddr addrs[2];
+    MakeCrossShardAddresses(addrs);
+
+    COrderedRequest first(configure, m_Log, 0);
+    CHECK(m_pRunner->PushRequest(&first, &addrs[0]));
+    CHECK(WaitSent(1));
+
+    COrderedRequest second(configure, m_Log, 1);
+    CHECK(m_pRunner->PushRequest(&second, &addrs[1]));
+    for (int i = 0; i < 5000 && !m_pRunner->IsCapped(); ++i) {
+        usleep(1000);
+    }
+    CHECK(m_pRunner->IsCapped());
+    LONGS_EQUAL(1, m_Log.Count);
+
+    Complete(&first);
+    CHECK(WaitSent(2));
+    CHECK(m_Log.pPeer == &second);
+    Complete(&second);
+    LONGS_EQUAL(1, m_pRunner->ConnectionCount());
+}
+
+TEST(RequestScheduler, TestConnectionClose)
+{
+    // No more request goes to the connection closed by the response, the
+    // next one opens a new connection.
+    m_pRunner = CConnectionRunner::CreateInstance("test", 1, false, CPollBackend::PB_EPOLL, 2);
+    CTestConfigure configure(256, LONG_IDLE_TIMEOUT);
+    sockaddr addr;
+    CTestRequest::MakeAddress(&addr, 1);
+
+    CClosingRequest first(configure, m_Log, 0);
+    CHECK(m_pRunner->PushRequest(&first, &addr));
+    CHECK(WaitSent(1));
+    Complete(&first);
+
+    COrderedRequest second(configure, m_Log, 0);
+    CHECK(m_pRunner->PushRequest(&second, &addr));
+    CHECK(WaitSent(2));
+    CHECK(m_Log.pPeer == &second);
+    Complete(&second);
+
+    // The closed one is removed in its next tick, the new one is kept.
+    for (int i = 0; i < 5000 && m_pRunner->ConnectionCount() > 1; ++i) {
+        usleep(1000);
+    }
+    LONGS_EQUAL(1, m_pRunner->ConnectionCount());
+}
@@ -0,0 +1,153 @@
+/*
+ * See the file LICENSE for redistribution information.
+ *
+ * Copyright (c) 2015-2018, Yuan Qin <yuanqin2000 at outlook dot com>
+ * All rights reserved.
+ *
+ */
+
+#include <pthread.h>
+#include <unistd.h>
+#include "Thread/RingMsgSwitch.h"
+#include "Thread/ITMessage.h"
+#include "Common/Macros.h"
+#include "Defines.h"
+#include "CppUTest/MemoryLeakDetectorNewMacros.h"
+#include "CppUTest/TestHarness.h"
+
+TEST_GROUP(RingMsgSwitch)
+{
+    struct WriteTask {
+        CMsgSwitch* pSwitch;
+        uint32_t Producer;
+        uint32_t Count;
+    };
+
+// Return the count of the messages written.
+static void* WriteRoutine(void* pArg)
+{
+    WriteTask* pTask = reinterpret_cast<WriteTask*>(pArg);
+    uint32_t i = 0;
+    for (; i < pTask->Count; ++i) {
+        ITMessage msg(USER_MSGID_BEGIN);
+        uint32_t data[2] = { pTask->Producer, i };
+        msg.SetData(data, sizeof(data));
+        if (!pTask->pSwitch->WriteMessage(&msg)) {
+            msg.Destroy();
+            break;
+        }
+    }
+    return reinterpret_cast<void*>(static_cast<uintptr_t>(i));
+}
+
+void setup()
+{
+}
+
+void teardown()
+{
+}
+
+};
+
+TEST(RingMsgSwitch, TestCapacity)
+{
+    CSPSCRingMsgSwitch spsc(100);
+    LONGS_EQUAL(128, spsc.Capacity());
+    CMPSCRingMsgSwitch mpsc(64);
+    LONGS_EQUAL(64, mpsc.Capacity());
+
+    ITMessage msg;
+    CHECK(!spsc.ReadMessage(&msg, 0));
+    CHECK(!mpsc.ReadMessage(&msg, 10));
+}
+
+TEST(RingMsgSwitch, TestSPSC)
+{
+    CSPSCRingMsgSwitch ringSwitch(8);
+    WriteTask task = { &ringSwitch, 0, 10000 };
+    pthread_t thread;
+    LONGS_EQUAL(0, pthread_create(&thread, NULL, WriteRoutine, &task));
+
+    for (uint32_t i = 0; i < task.Count; ++i) {
+        ITMessage msg;
+        CHECK(ringSwitch.ReadMessage(&msg, 5000));
+        uint32_t* pData = reinterpret_cast<uint32_t*>(msg.GetData());
+        LONGS_EQUAL(i, pData[1]);
+        msg.Destroy();
+    }
+    LONGS_EQUAL(0, pthread_join(thread, NULL));
+}
+
+TEST(RingMsgSwitch, TestMPSC)
+{
+    CMPSCRingMsgSwitch ringSwitch(16);
+    WriteTask tasks[4];
+    pthread_t threads[COUNT_OF_ARRAY(tasks)];
+    uint32_t expected[COUNT_OF_ARRAY(tasks)] = { 0 };
+
+    for (size_t i = 0; i < COUNT_OF_ARRAY(tasks); ++i) {
+        tasks[i].pSwitch = &ringSwitch;
+        tasks[i].Producer = i;
+        tasks[i].Count = 5000;
+        LONGS_EQUAL(0, pthread_create(&threads[i], NULL, WriteRoutine, &tasks[i]));
+    }
+
+    // The messages from the same producer are kept in order.
+    for (size_t i = 0; i < COUNT_OF_ARRAY(tasks) * 5000; ++i) {
+        ITMessage msg;
+        CHECK(ringSwitch.ReadMessage(&msg, 5000));
+        uint32_t* pData = reinterpret_cast<uint32_t*>(msg.GetData());
+        CHECK(pData[0] < COUNT_OF_ARRAY(tasks));
+        LONGS_EQUAL(expected[pData[0]], pData[1]);
+        ++expected[pData[0]];
+        msg.Destroy();
+    }
+    for (size_t i = 0; i < COUNT_OF_ARRAY(tasks); ++i) {
+        LONGS_EQUAL(0, pthread_join(threads[i], NULL));
+    }
+}
+
+TEST(RingMsgSwitch, TestClose)
+{
+    // The writer blocked on the full ring is released by closing it.
+    CSPSCRingMsgSwitch ringSwitch(2);
+    ITMessage msg(USER_MSGID_BEGIN);
+    CHECK(ringSwitch.WriteMessage(&msg));
+    CHECK(ringSwitch.WriteMessage(&msg));
+
+    WriteTask task = { &ringSwitch, 0, 1 };
+    pthread_t thread;
+    LONGS_EQUAL(0, pthread_create(&thread, NULL, WriteRoutine, &task));
+    usleep(20000);
+    ringSwitch.Close();
+    void* pWritten = NULL;
+    LONGS_EQUAL(0, pthread_join(thread, &pWritten));
+    LONGS_EQUAL(0, reinterpret_cast<uintptr_t>(pWritten));
+
+    CHECK(!ringSwitch.TryWriteMessage(&msg));
+    ITMessage msgs[4];
+    LONGS_EQUAL(2, ringSwitch.ReadMessages(msgs, COUNT_OF_ARRAY(msgs), 0));
+    LONGS_EQUAL(0, ringSwitch.ReadMessages(msgs, COUNT_OF_ARRAY(msgs), -1));
+
+    ringSwitch.Open();
+    CHECK(ringSwitch.WriteMessage(&msg));
+}
+
+TEST(RingMsgSwitch, TestReadMessages)
+{
+    CSPSCRingMsgSwitch ringSwitch(16);
+    for (uint32_t i = 0; i < 10; ++i) {
+        ITMessage msg(USER_MSGID_BEGIN + i);
+        CHECK(ringSwitch.WriteMessage(&msg));
+    }
+
+    ITMessage msgs[4];
+    LONGS_EQUAL(4, ringSwitch.ReadMessages(msgs, COUNT_OF_ARRAY(msgs), 0));
+    LONGS_EQUAL(USER_MSGID_BEGIN, msgs[0].MsgID);
+    LONGS_EQUAL(USER_MSGID_BEGIN + 3, msgs[3].MsgID);
+    LONGS_EQUAL(4, ringSwitch.ReadMessages(msgs, COUNT_OF_ARRAY(msgs), 0));
+    LONGS_EQUAL(2, ringSwitch.ReadMessages(msgs, COUNT_OF_ARRAY(msgs), 0));
+    LONGS_EQUAL(USER_MSGID_BEGIN + 9, msgs[1].MsgID);
+    LONGS_EQUAL(0, ringSwitch.ReadMessages(msgs, COUNT_OF_ARRAY(msgs), 10));
+}
@@ -0,0 +1,85 @@
+/*
+ * See the file LICENSE for redistribution information.
+ *
+ * Copyright (c) 2015-2018, Yuan Qin <yuanqin2000 at outlook dot com>
+ * All rights reserved.
+ *
+ */
+
+#include <cstring>
+#include "Memory/SlabMemory.h"
+#include "Common/ForwardList.h"
+#include "Common/Macros.h"
+#include "Defines.h"
+#include "CppUTest/MemoryLeakDetectorNewMacros.h"
+#include "CppUTest/TestHarness.h"
+
+TEST_GROUP(SlabMemory)
+{
+void setup()
+{
+}
+
+void teardown()
+{
+}
+
+};
+
+TEST(SlabMemory, TestSizeClasses)
+{
+    CSlabMemory slab;
+    size_t sizes[] = { 1, 7, 8, 15, 16, 17, 23, 24, 33, 100, 1000, 4000, 65536, 262128, 300000 };
+    void* pMems[COUNT_OF_ARRAY(sizes)] = { NULL };
+
+    for (size_t i = 0; i < COUNT_OF_ARRAY(sizes); ++i) {
+        pMems[i] = slab.Malloc(sizes[i]);
+        CHECK(pMems[i] != NULL);
+        LONGS_EQUAL(0, reinterpret_cast<uintptr_t>(pMems[i]) % CSlabMemory::ALIGNMENT);
+        memset(pMems[i], static_cast<int>(i), sizes[i]);
+    }
+    for (size_t i = 0; i < COUNT_OF_ARRAY(sizes); ++i) {
+        uint8_t* pByte = reinterpret_cast<uint8_t*>(pMems[i]);
+        LONGS_EQUAL(i, pByte[0]);
+        LONGS_EQUAL(i, pByte[sizes[i] - 1]);
+        slab.Free(pMems[i]);
+    }
+    CHECK(slab.MappedSize() == slab.RetainedSize());
+}
+
+TEST(SlabMemory, TestRetainedLimit)
+{
+    CSlabMemory slab(0);
+    void* pMems[1000] = { NULL };
+
+    for (size_t i = 0; i < COUNT_OF_ARRAY(pMems); ++i) {
+        pMems[i] = slab.Malloc(40);
+        CHECK(pMems[i] != NULL);
+    }
+    CHECK(slab.MappedSize() > 0);
+    LONGS_EQUAL(0, slab.RetainedSize());
+    for (size_t i = 0; i < COUNT_OF_ARRAY(pMems); ++i) {
+        slab.Free(pMems[i]);
+    }
+    LONGS_EQUAL(0, slab.MappedSize());
+    LONGS_EQUAL(0, slab.RetainedSize());
+}
+
+TEST(SlabMemory, TestListAllocator)
+{
+    CSlabMemory slab;
+    CForwardList list(sizeof(int), &slab);
+
+    for (int i = 0; i < 100; ++i) {
+        CHECK(list.PushBack(&i));
+    }
+    LONGS_EQUAL(100, list.Count());
+    int expected = 0;
+    CForwardList::Iterator iter = list.Begin();
+    CForwardList::Iterator iterEnd = list.End();
+    while (iter != iterEnd) {
+        LONGS_EQUAL(expected, *reinterpret_cast<int*>(list.DataAt(iter)));
+        ++expected;
+        ++iter;
+    }
+}
@@ -0,0 +1,180 @@
+/*
+ * See the file LICENSE for redistribution information.
+ *
+ * Copyright (c) 2015-2018, Yuan Qin <yuanqin2000 at outlook dot com>
+ * All rights reserved.
+ *
+ */
+
+#include <cstring>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <errno.h>
+#include "Common/Source.h"
+#include "IO/IOHelper.h"
+#include "Common/ErrorNo.h"
+#include "Common/Macros.h"
+#include "Defines.h"
+#include "CppUTest/MemoryLeakDetectorNewMacros.h"
+#include "CppUTest/TestHarness.h"
+
+TEST_GROUP(Source)
+{
+    uint8_t m_Data[64];
+
+void setup()
+{
+    for (size_t i = 0; i < sizeof(m_Data); ++i) {
+        m_Data[i] = static_cast<uint8_t>(i);
+    }
+}
+
+void teardown()
+{
+}
+
+};
+
+TEST(Source, TestMemoryRead)
+{
+    CMemorySource source(m_Data, sizeof(m_Data));
+    uint8_t buffer[40];
+
+    LONGS_EQUAL(40, source.Read(buffer, sizeof(buffer)));
+    LONGS_EQUAL(0, memcmp(buffer, m_Data, 40));
+    LONGS_EQUAL(24, source.Read(buffer, sizeof(buffer)));
+    LONGS_EQUAL(0, memcmp(buffer, m_Data + 40, 24));
+    CHECK(source.IsEOF());
+
+    source.Reset();
+    CHECK(!source.IsEOF());
+}
+
+TEST(Source, TestMemoryPeekSkip)
+{
+    CMemorySource source(m_Data, sizeof(m_Data));
+    const uint8_t* pData = NULL;
+
+    LONGS_EQUAL(sizeof(m_Data), source.Peek(&pData));
+    POINTERS_EQUAL(m_Data, pData);
+    source.Skip(10);
+    LONGS_EQUAL(sizeof(m_Data) - 10, source.Peek(&pData));
+    POINTERS_EQUAL(m_Data + 10, pData);
+
+    uint8_t octet = 0;
+    LONGS_EQUAL(1, source.Read(&octet, 1));
+    LONGS_EQUAL(10, octet);
+    source.Skip(sizeof(m_Data) - 11);
+    LONGS_EQUAL(0, source.Peek(&pData));
+    CHECK(source.IsEOF());
+}
+
+TEST(Source, TestGatherWrite)
+{
+    int fds[2];
+    LONGS_EQUAL(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+
+    const char* pHeader = "POST / HTTP/1.1\r\n\r\n";
+    struct iovec ioVec[2];
+    ioVec[0].iov_base = const_cast<char*>(pHeader);
+    ioVec[0].iov_len = strlen(pHeader);
+    ioVec[1].iov_base = m_Data;
+    ioVec[1].iov_len = sizeof(m_Data);
+    LONGS_EQUAL(strlen(pHeader) + sizeof(m_Data), NSIOHelper::WriteV(fds[0], ioVec, 2));
+
+    uint8_t buffer[128];
+    LONGS_EQUAL(strlen(pHeader) + sizeof(m_Data), read(fds[1], buffer, sizeof(buffer)));
+    LONGS_EQUAL(0, memcmp(buffer, pHeader, strlen(pHeader)));
+    LONGS_EQUAL(0, memcmp(buffer + strlen(pHeader), m_Data, sizeof(m_Data)));
+
+    close(fds[0]);
+    close(fds[1]);
+}
+
+TEST(Source, TestFileRegion)
+{
+    char path[] = "/tmp/TestSourceXXXXXX";
+    int fd = mkstemp(path);
+    CHECK(fd >= 0);
+    LONGS_EQUAL(sizeof(m_Data), write(fd, m_Data, sizeof(m_Data)));
+    close(fd);
+
+    CFileSource source(path);
+    CHECK(source.Open());
+    LONGS_EQUAL(sizeof(m_Data), source.Length());
+
+    uint8_t octet = 0;
+    LONGS_EQUAL(1, source.Read(&octet, 1));
+    LONGS_EQUAL(0, octet);
+
+    tIOHandle hFile = INVALID_IO_HANDLE;
+    off_t offset = 0;
+    size_t len = 0;
+    CHECK(source.GetFileRegion(&hFile, &offset, &len));
+    LONGS_EQUAL(1, offset);
+    LONGS_EQUAL(sizeof(m_Data) - 1, len);
+
+    int fds[2];
+    LONGS_EQUAL(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+    LONGS_EQUAL(len, NSIOHelper::SendFile(fds[0], hFile, offset, len));
+    source.Skip(len);
+    CHECK(source.IsEOF());
+    CHECK(!source.GetFileRegion(&hFile, &offset, &len));
+
+    uint8_t buffer[128];
+    LONGS_EQUAL(sizeof(m_Data) - 1, read(fds[1], buffer, sizeof(buffer)));
+    LONGS_EQUAL(0, memcmp(buffer, m_Data + 1, sizeof(m_Data) - 1));
+
+    source.Close();
+    close(fds[0]);
+    close(fds[1]);
+    unlink(path);
+}
+
+TEST(Source, TestTruncatedFile)
+{
+    char path[] = "/tmp/TestSourceXXXXXX";
+    int fd = mkstemp(path);
+    CHECK(fd >= 0);
+    LONGS_EQUAL(sizeof(m_Data), write(fd, m_Data, sizeof(m_Data)));
+
+    CFileSource source(path);
+    CHECK(source.Open());
+    tIOHandle hFile = INVALID_IO_HANDLE;
+    off_t offset = 0;
+    size_t len = 0;
+    CHECK(source.GetFileRegion(&hFile, &offset, &len));
+    LONGS_EQUAL(sizeof(m_Data), len);
+
+    // The file shrinks after the length is taken, the rest is an error
+    // instead of an empty write retried for ever.
+    LONGS_EQUAL(0, ftruncate(fd, 10));
+    int fds[2];
+    LONGS_EQUAL(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+    LONGS_EQUAL(10, NSIOHelper::SendFile(fds[0], hFile, offset, len));
+    LONGS_EQUAL(0, NSIOHelper::SendFile(fds[0], hFile, offset + 10, len - 10));
+    LONGS_EQUAL(EIO, ERROR_CODE);
+
+    source.Close();
+    close(fds[0]);
+    close(fds[1]);
+    close(fd);
+    unlink(path);
+}
+
+TEST(Source, TestLargeFile)
+{
+    // The length of 2 GiB does not fit in Length().
+    char path[] = "/tmp/TestSourceXXXXXX";
+    int fd = mkstemp(path);
+    CHECK(fd >= 0);
+    LONGS_EQUAL(0, ftruncate(fd, 0x80000000LL));
+    close(fd);
+
+    CFileSource source(path);
+    CHECK(!source.Open());
+    CHECK(!source.IsReadable());
+    unlink(path);
+}
@@ -0,0 +1,135 @@
+/*
+ * See the file LICENSE for redistribution information.
+ *
+ * Copyright (c) 2015-2018, Yuan Qin <yuanqin2000 at outlook dot com>
+ * All rights reserved.
+ *
+ */
+
+#include <cstring>
+#include <limits.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "TLS/SessionCache.h"
+#include "Common/Macros.h"
+#include "Defines.h"
+#include "CppUTest/MemoryLeakDetectorNewMacros.h"
+#include "CppUTest/TestHarness.h"
+
+TEST_GROUP(TLSSessionCache)
+{
+    sockaddr m_Peer1;
+    sockaddr m_Peer2;
+    uint8_t m_Session[64];
+
+void InitAddress(sockaddr* pAddr, uint16_t port)
+{
+    memset(pAddr, 0, sizeof(sockaddr));
+    sockaddr_in* pAddrIn = reinterpret_cast<sockaddr_in*>(pAddr);
+    pAddrIn->sin_family = AF_INET;
+    pAddrIn->sin_port = htons(port);
+    pAddrIn->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+}
+
+void setup()
+{
+    InitAddress(&m_Peer1, 443);
+    InitAddress(&m_Peer2, 8443);
+    for (size_t i = 0; i < sizeof(m_Session); ++i) {
+        m_Session[i] = static_cast<uint8_t>(i);
+    }
+    CTLSSessionCache::Instance()->Clear();
+}
+
+void teardown()
+{
+    CTLSSessionCache::Instance()->Clear();
+}
+
+};
+
+TEST(TLSSessionCache, TestPutGet)
+{
+    CTLSSessionCache* pCache = CTLSSessionCache::Instance();
+    uint8_t buffer[128];
+
+    LONGS_EQUAL(0, pCache->Get(&m_Peer1, false, buffer, sizeof(buffer)));
+    CHECK(pCache->Put(&m_Peer1, true, m_Session, sizeof(m_Session)));
+    LONGS_EQUAL(sizeof(m_Session), pCache->Get(&m_Peer1, true, buffer, sizeof(buffer)));
+    LONGS_EQUAL(0, memcmp(buffer, m_Session, sizeof(m_Session)));
+    LONGS_EQUAL(0, pCache->Get(&m_Peer2, false, buffer, sizeof(buffer)));
+
+    // Replaced by the new session.
+    CHECK(pCache->Put(&m_Peer1, true, m_Session + 8, 16));
+    LONGS_EQUAL(1, pCache->Count());
+    LONGS_EQUAL(16, pCache->Get(&m_Peer1, true, buffer, sizeof(buffer)));
+    LONGS_EQUAL(0, memcmp(buffer, m_Session + 8, 16));
+
+    // The buffer is too small.
+    LONGS_EQUAL(0, pCache->Get(&m_Peer1, true, buffer, 8));
+
+    pCache->Remove(&m_Peer1);
+    LONGS_EQUAL(0, pCache->Count());
+    LONGS_EQUAL(0, pCache->Get(&m_Peer1, true, buffer, sizeof(buffer)));
+}
+
+TEST(TLSSessionCache, TestVerified)
+{
+    CTLSSessionCache* pCache = CTLSSessionCache::Instance();
+    uint8_t buffer[128];
+
+    CHECK(pCache->Put(&m_Peer1, false, m_Session, sizeof(m_Session)));
+    LONGS_EQUAL(0, pCache->Get(&m_Peer1, true, buffer, sizeof(buffer)));
+    LONGS_EQUAL(sizeof(m_Session), pCache->Get(&m_Peer1, false, buffer, sizeof(buffer)));
+    CHECK(!pCache->Put(&m_Peer2, false, m_Session, 0));
+    CHECK(!pCache->Put(&m_Peer2, false, m_Session, sizeof(m_Session), 0));
+}
+
+TEST(TLSSessionCache, TestSaveLoad)
+{
+    CTLSSessionCache* pCache = CTLSSessionCache::Instance();
+    uint8_t buffer[128];
+
+    char path[] = "/tmp/TestTLSSessionCacheXXXXXX";
+    CHECK(mkdtemp(path) != NULL);
+    char fileName[PATH_MAX];
+    snprintf(fileName, sizeof(fileName), "%s/sessions", path);
+    CHECK(pCache->Put(&m_Peer1, true, m_Session, sizeof(m_Session)));
+    CHECK(pCache->Put(&m_Peer2, false, m_Session, 32));
+    mode_t mask = umask(0);
+
+    // The stale temporary file readable by the others is not reused.
+    char tmpFileName[PATH_MAX + sizeof(".tmp")];
+    snprintf(tmpFileName, sizeof(tmpFileName), "%s.tmp", fileName);
+    int fd = open(tmpFileName, O_WRONLY | O_CREAT, 0644);
+    CHECK(fd >= 0);
+    close(fd);
+    CHECK(pCache->Save(path, "sessions"));
+    umask(mask);
+    CHECK(access(tmpFileName, F_OK) != 0);
+    struct stat fileStat;
+    LONGS_EQUAL(0, stat(fileName, &fileStat));
+    LONGS_EQUAL(0600, fileStat.st_mode & 0777);
+
+    pCache->Clear();
+    CHECK(pCache->Load(path, "sessions"));
+    LONGS_EQUAL(2, pCache->Count());
+    LONGS_EQUAL(sizeof(m_Session), pCache->Get(&m_Peer1, true, buffer, sizeof(buffer)));
+    LONGS_EQUAL(0, memcmp(buffer, m_Session, sizeof(m_Session)));
+    LONGS_EQUAL(0, pCache->Get(&m_Peer2, true, buffer, sizeof(buffer)));
+    LONGS_EQUAL(32, pCache->Get(&m_Peer2, false, buffer, sizeof(buffer)));
+
+    // The file readable by the others is refused.
+    pCache->Clear();
+    LONGS_EQUAL(0, chmod(fileName, 0644));
+    CHECK(!pCache->Load(path, "sessions"));
+    LONGS_EQUAL(0, pCache->Count());
+
+    unlink(fileName);
+    rmdir(path);
+    CHECK(!pCache->Load(path, "sessions"));
+}
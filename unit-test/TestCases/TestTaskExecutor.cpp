@@ -0,0 +1,100 @@
+/*
+ * See the file LICENSE for redistribution information.
+ *
+ * Copyright (c) 2015-2018, Yuan Qin <yuanqin2000 at outlook dot com>
+ * All rights reserved.
+ *
+ */
+
+#include <unistd.h>
+#include "Thread/TaskExecutor.h"
+#include "Common/Arch.h"
+#include "Common/Macros.h"
+#include "Defines.h"
+#include "CppUTest/MemoryLeakDetectorNewMacros.h"
+#include "CppUTest/TestHarness.h"
+
+TEST_GROUP(TaskExecutor)
+{
+    class CCountTask : public ITask
+    {
+    public:
+        CCountTask() : m_pExecutor(NULL), m_pTotal(NULL), m_Remain(0), m_Running(0), m_bOverlapped(false) {}
+
+        // Resubmit itself until m_Remain is 0, never run concurrently.
+        void Run()
+        {
+            if (AtomicInc(&m_Running) != 1) {
+                m_bOverlapped = true;
+            }
+            AtomicInc(m_pTotal);
+            bool bAgain = --m_Remain > 0;
+            AtomicDec(&m_Running);
+            if (bAgain) {
+                m_pExecutor->Submit(this);
+            }
+        }
+
+        CTaskExecutor* m_pExecutor;
+        volatile int32_t* m_pTotal;
+        int m_Remain;
+        volatile int32_t m_Running;
+        bool m_bOverlapped;
+    };
+
+void setup()
+{
+}
+
+void teardown()
+{
+}
+
+};
+
+TEST(TaskExecutor, TestRunTasks)
+{
+    CTaskExecutor* pExecutor = CTaskExecutor::CreateInstance("test", 4);
+    CHECK(pExecutor != NULL);
+    LONGS_EQUAL(4, pExecutor->ThreadCount());
+    CHECK(!pExecutor->InWorker());
+    CHECK(pExecutor->Start());
+
+    volatile int32_t total = 0;
+    CCountTask tasks[16];
+    for (size_t i = 0; i < COUNT_OF_ARRAY(tasks); ++i) {
+        tasks[i].m_pExecutor = pExecutor;
+        tasks[i].m_pTotal = &total;
+        tasks[i].m_Remain = 1000;
+        pExecutor->Submit(&tasks[i]);
+    }
+    for (int i = 0; i < 5000 && total < 16 * 1000; ++i) {
+        usleep(1000);
+    }
+    LONGS_EQUAL(16 * 1000, total);
+    for (size_t i = 0; i < COUNT_OF_ARRAY(tasks); ++i) {
+        CHECK(!tasks[i].m_bOverlapped);
+    }
+    pExecutor->Stop();
+    delete pExecutor;
+}
+
+TEST(TaskExecutor, TestDrainOnStop)
+{
+    CTaskExecutor* pExecutor = CTaskExecutor::CreateInstance("test", 2);
+    CHECK(pExecutor != NULL);
+    CHECK(pExecutor->Start());
+
+    volatile int32_t total = 0;
+    CCountTask tasks[4];
+    for (size_t i = 0; i < COUNT_OF_ARRAY(tasks); ++i) {
+        tasks[i].m_pExecutor = pExecutor;
+        tasks[i].m_pTotal = &total;
+        tasks[i].m_Remain = 1000;
+        pExecutor->Submit(&tasks[i], i % 2 == 0);
+    }
+    // All the pending tasks run before the workers exit.
+    pExecutor->Stop();
+    LONGS_EQUAL(4 * 1000, total);
+    delete pExecutor;
+}
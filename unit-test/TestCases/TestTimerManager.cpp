@@ -0,0 +1,118 @@
+/*
+ * See the file LICENSE for redistribution information.
+ *
+ * Copyright (c) 2015-2018, Yuan Qin <yuanqin2000 at outlook dot com>
+ * All rights reserved.
+ *
+ */
+
+#include <unistd.h>
+#include "Thread/TimerManager.h"
+#include "Common/Macros.h"
+#include "Defines.h"
+#include "CppUTest/MemoryLeakDetectorNewMacros.h"
+#include "CppUTest/TestHarness.h"
+
+TEST_GROUP(TimerManager)
+{
+    class CTestTimerContext : public ITimerContext
+    {
+    public:
+        CTestTimerContext() :
+            m_pManager(NULL), m_DeleteID(INVALID_TIMER_ID), m_Fired(0), m_Deleted(0) {}
+
+        void OnTimeout(tTimerID timerID)
+        {
+            ++m_Fired;
+            if (timerID == m_DeleteID) {
+                m_pManager->DeleteTimer(timerID);
+            }
+        }
+
+        void OnTimerDeleted(tTimerID timerID) { ++m_Deleted; }
+
+        CTimerManager* m_pManager;
+        tTimerID m_DeleteID;
+        int m_Fired;
+        int m_Deleted;
+    };
+
+static void RunFor(CTimerManager* pManager, unsigned int millisec)
+{
+    struct timespec start;
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    do {
+        int timeout = pManager->RefreshTimer();
+        if (timeout > 0) {
+            usleep((timeout < 5 ? timeout : 5) * 1000);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &now);
+    } while ((now.tv_sec - start.tv_sec) * 1000 +
+             (now.tv_nsec - start.tv_nsec) / 1000000 < millisec);
+}
+
+void setup()
+{
+}
+
+void teardown()
+{
+}
+
+};
+
+TEST(TimerManager, TestAddDelete)
+{
+    CTimerManager manager(1);
+    CTestTimerContext context;
+    tTimerID ids[1000];
+
+    LONGS_EQUAL(-1, manager.RefreshTimer());
+    for (size_t i = 0; i < COUNT_OF_ARRAY(ids); ++i) {
+        ids[i] = manager.AddTimer(&context, 1000 + i * 1000, false);
+        CHECK(ids[i] != INVALID_TIMER_ID);
+    }
+    LONGS_EQUAL(COUNT_OF_ARRAY(ids), manager.Count());
+    int timeout = manager.RefreshTimer();
+    CHECK(timeout > 0 && timeout <= 1000);
+    for (size_t i = 0; i < COUNT_OF_ARRAY(ids); ++i) {
+        manager.DeleteTimer(ids[i]);
+    }
+    LONGS_EQUAL(0, manager.Count());
+    LONGS_EQUAL(COUNT_OF_ARRAY(ids), context.m_Deleted);
+    LONGS_EQUAL(-1, manager.RefreshTimer());
+    LONGS_EQUAL(0, context.m_Fired);
+}
+
+TEST(TimerManager, TestFire)
+{
+    CTimerManager manager(1);
+    CTestTimerContext context;
+
+    manager.AddTimer(&context, 10, false);
+    manager.AddTimer(&context, 20, false);
+    manager.AddTimer(&context, 300, false);   // Cascaded from level 1
+    manager.AddTimer(&context, 5000, false);
+    RunFor(&manager, 400);
+    LONGS_EQUAL(3, context.m_Fired);
+    LONGS_EQUAL(1, manager.Count());
+}
+
+TEST(TimerManager, TestRepeat)
+{
+    CTimerManager manager;
+    CTestTimerContext context;
+    context.m_pManager = &manager;
+
+    tTimerID id = manager.AddTimer(&context, 20, true);
+    RunFor(&manager, 110);
+    CHECK(context.m_Fired >= 3);
+    LONGS_EQUAL(1, manager.Count());
+
+    // Delete the repeated timer in its callback.
+    context.m_DeleteID = id;
+    RunFor(&manager, 50);
+    LONGS_EQUAL(0, manager.Count());
+    LONGS_EQUAL(1, context.m_Deleted);
+}
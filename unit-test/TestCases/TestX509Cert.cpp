@@ -0,0 +1,43 @@
+/*
+ * See the file LICENSE for redistribution information.
+ *
+ * Copyright (c) 2015-2018, Yuan Qin <yuanqin2000 at outlook dot com>
+ * All rights reserved.
+ *
+ */
+
+#include "TLS/X509Cert.h"
+#include "Common/Macros.h"
+#include "Defines.h"
+#include "CppUTest/MemoryLeakDetectorNewMacros.h"
+#include "CppUTest/TestHarness.h"
+
+TEST_GROUP(X509Cert)
+{
+    const char* m_pCertFile = "../data/test-cert.pem";
+    const char* m_pTextFile = "../data/test-file.txt";
+
+void setup()
+{
+}
+
+void teardown()
+{
+}
+
+};
+
+TEST(X509Cert, TestParse)
+{
+    CX509Cert* pCert = CX509Cert::CreateInstance(m_pCertFile);
+    CHECK(pCert != NULL);
+    LONGS_EQUAL(1, pCert->Count());
+    CHECK(pCert->GetData() != NULL);
+    delete pCert;
+}
+
+TEST(X509Cert, TestInvalidFile)
+{
+    POINTERS_EQUAL(NULL, CX509Cert::CreateInstance("../data/no-such-cert.pem"));
+    POINTERS_EQUAL(NULL, CX509Cert::CreateInstance(m_pTextFile));
+}